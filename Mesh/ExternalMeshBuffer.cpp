@@ -0,0 +1,78 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ExternalMeshBuffer.h"
+#include <Util/Macros.h>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RENDERING_HAS_MMAP
+#endif
+
+namespace Rendering {
+
+//! (ctor)
+ExternalMeshBuffer::ExternalMeshBuffer(const uint8_t * _data, std::size_t _size, releaseFun_t _releaseFun) :
+		dataPtr(_data), dataSize(_size), releaseFun(std::move(_releaseFun)) {
+}
+
+//! (dtor)
+ExternalMeshBuffer::~ExternalMeshBuffer() {
+	if(releaseFun) {
+		releaseFun();
+	}
+}
+
+//! (static)
+std::shared_ptr<ExternalMeshBuffer> ExternalMeshBuffer::mapFile(const std::string & path) {
+#ifdef RENDERING_HAS_MMAP
+	const int fd = open(path.c_str(), O_RDONLY);
+	if(fd == -1) {
+		WARN("ExternalMeshBuffer::mapFile: Could not open file: " + path);
+		return nullptr;
+	}
+	struct stat fileStatus;
+	if(fstat(fd, &fileStatus) == -1 || fileStatus.st_size <= 0) {
+		close(fd);
+		WARN("ExternalMeshBuffer::mapFile: Invalid file: " + path);
+		return nullptr;
+	}
+	const std::size_t fileSize = static_cast<std::size_t>(fileStatus.st_size);
+	void * address = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after the descriptor has been closed.
+	close(fd);
+	if(address == MAP_FAILED) {
+		WARN("ExternalMeshBuffer::mapFile: Mapping failed: " + path);
+		return nullptr;
+	}
+	return std::make_shared<ExternalMeshBuffer>(static_cast<const uint8_t *>(address), fileSize,
+												[address, fileSize]() { munmap(address, fileSize); });
+#else
+	static_cast<void>(path);
+	return nullptr;
+#endif
+}
+
+//! (static)
+std::shared_ptr<ExternalMeshBuffer> ExternalMeshBuffer::createRange(const std::shared_ptr<ExternalMeshBuffer> & parent,
+																	std::size_t offset, std::size_t size) {
+	if(!parent || offset > parent->size() || size > parent->size() - offset) {
+		throw std::out_of_range("ExternalMeshBuffer::createRange: Invalid range.");
+	}
+	std::shared_ptr<ExternalMeshBuffer> keepAlive(parent);
+	return std::make_shared<ExternalMeshBuffer>(parent->data() + offset, size, [keepAlive]() {});
+}
+
+}
@@ -0,0 +1,64 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_EXTERNALMESHBUFFER_H
+#define RENDERING_EXTERNALMESHBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace Rendering {
+
+/*! Read-only block of memory that is not owned by a mesh, but can be used as its local
+	vertex or index data (see MeshVertexData::setExternalData(...) and MeshIndexData::setExternalData(...)).
+	The memory is released by calling the given release function when the last
+	reference to the buffer is removed.
+	A typical source is a memory mapped region of a mesh file: The pages are only loaded
+	by the operating system when the data is actually accessed (e.g. when uploading it).
+	\note The data must not be changed as long as the buffer exists. If a mesh needs to
+		modify its data, the data is copied into the mesh's own memory (copy-on-write).	*/
+class ExternalMeshBuffer {
+	public:
+		typedef std::function<void ()> releaseFun_t;
+
+		/*! Create a buffer for the memory block [@p data, @p data + @p size).
+			@p releaseFun is called when the buffer is destroyed (may be empty).	*/
+		ExternalMeshBuffer(const uint8_t * data, std::size_t size, releaseFun_t releaseFun);
+		~ExternalMeshBuffer();
+
+		ExternalMeshBuffer(const ExternalMeshBuffer &) = delete;
+		ExternalMeshBuffer(ExternalMeshBuffer &&) = delete;
+		ExternalMeshBuffer & operator=(const ExternalMeshBuffer &) = delete;
+		ExternalMeshBuffer & operator=(ExternalMeshBuffer &&) = delete;
+
+		const uint8_t * data()const				{	return dataPtr;	}
+		std::size_t size()const					{	return dataSize;	}
+
+		/*! (static) Map the file at @p path read-only into memory.
+			\return The mapped file or nullptr if memory mapping is not supported or failed.	*/
+		static std::shared_ptr<ExternalMeshBuffer> mapFile(const std::string & path);
+
+		/*! (static) Create a buffer referencing the range [@p offset, @p offset + @p size) of @p parent.
+			The parent is kept alive as long as the returned buffer exists.
+			\throw std::out_of_range if the range exceeds the parent buffer.	*/
+		static std::shared_ptr<ExternalMeshBuffer> createRange(const std::shared_ptr<ExternalMeshBuffer> & parent,
+																std::size_t offset, std::size_t size);
+	private:
+		const uint8_t * dataPtr;
+		std::size_t dataSize;
+		releaseFun_t releaseFun;
+};
+
+}
+
+#endif /* RENDERING_EXTERNALMESHBUFFER_H */
@@ -39,11 +39,21 @@ Mesh::Mesh(const VertexDescription & desc, uint32_t vertexCount, uint32_t indexC
 	vertexData.allocate(vertexCount, desc);
 }
 
+Mesh::~Mesh() {
+	if(dataStrategy != nullptr)
+		dataStrategy->forgetMesh(this);
+}
+
 Mesh * Mesh::clone()const{
 	return new Mesh(*this);
 }
 
 void Mesh::swap(Mesh & m){
+	// the data of both meshes changes, so strategies storing information about them have to re-read it
+	if(dataStrategy != nullptr)
+		dataStrategy->forgetMesh(this);
+	if(m.dataStrategy != nullptr)
+		m.dataStrategy->forgetMesh(&m);
 	_getIndexData().swap(m._getIndexData());
 	_getVertexData().swap(m._getVertexData());
 
@@ -59,7 +69,7 @@ size_t Mesh::getMainMemoryUsage() const {
 }
 
 size_t Mesh::getGraphicsMemoryUsage() const {
-	return 	(indexData.isUploaded() ? indexData.getIndexCount() * sizeof(uint32_t) : 0)
+	return 	(indexData.isUploaded() ? indexData.getIndexCount() * indexData.getIndexSize() : 0)
 			+ (vertexData.isUploaded() ? vertexData.getVertexCount() * vertexData.getVertexDescription().getVertexSize() : 0);
 }
 
@@ -99,6 +109,8 @@ MeshVertexData & Mesh::openVertexData(){
 }
 
 void Mesh::setDataStrategy(MeshDataStrategy * newStrategy) {
+	if(dataStrategy != nullptr && dataStrategy != newStrategy)
+		dataStrategy->forgetMesh(this);
 	dataStrategy = newStrategy;
 }
 
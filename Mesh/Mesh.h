@@ -71,7 +71,10 @@ class Mesh : public Util::ReferenceCounter<Mesh> {
 		Mesh(const VertexDescription & desc,uint32_t vertexCount,uint32_t indexCount);
 		Mesh(const Mesh &) = default;
 		Mesh(Mesh &&) = default;
+		~Mesh();
 
+		/*! Create a copy of the mesh. The vertex and index data (local data and buffers) is shared
+			with the original until one of the meshes accesses it for writing.	*/
 		Mesh* clone()const;
 
 		void swap(Mesh & m);
@@ -80,6 +83,9 @@ class Mesh : public Util::ReferenceCounter<Mesh> {
 		 * Return the amount of main memory currently occupied by this mesh.
 		 *
 		 * @note If the mesh data is currently not present in main memory, only a small number is returned (probably @c sizeof(Mesh)).
+		 * @note Data shared with copies of the mesh (see clone()) is counted for each of them, so the sum over
+		 * several meshes may exceed the memory actually used. Data in an external buffer is counted as well, even if
+		 * it is a memory mapped file that is not completely paged in.
 		 * @return Amount of memory in bytes
 		 */
 		size_t getMainMemoryUsage() const;
@@ -172,6 +178,8 @@ class Mesh : public Util::ReferenceCounter<Mesh> {
 
 		uint32_t getVertexCount()const   						{   return vertexData.getVertexCount(); }
 		const VertexDescription & getVertexDescription()const	{   return vertexData.getVertexDescription();	}
+		//! \see MeshVertexData::getVertexDescriptionId()
+		uint32_t getVertexDescriptionId()const					{   return vertexData.getVertexDescriptionId();	}
 		const Geometry::Box & getBoundingBox()const          	{   return vertexData.getBoundingBox();	}
 
 	private:
@@ -13,6 +13,7 @@
 #include "MeshIndexData.h"
 #include "MeshVertexData.h"
 #include "../GLHeader.h"
+#include "../UploadScheduler.h"
 #include <Util/Macros.h>
 #include <iostream>
 
@@ -120,27 +121,33 @@ void SimpleMeshDataStrategy::prepare(Mesh * m){
 		return;
 
 	MeshIndexData & id=m->_getIndexData();
+	MeshVertexData & vd=m->_getVertexData();
+	const bool uploadIndices = !id.empty() && (id.hasChanged() || !id.isUploaded()); // data has changed or is new
+	const bool uploadVertices = !vd.empty() && (vd.hasChanged() || !vd.isUploaded());
+	// the uploads of a mesh are done together, if the UploadScheduler allows it in this frame
+	const bool uploadAllowed = (!uploadIndices && !uploadVertices) ||
+			UploadScheduler::getInstance().requestUpload(m, (uploadIndices ? id.dataSize() : 0) + (uploadVertices ? vd.dataSize() : 0));
+
 	if( id.empty() && id.isUploaded() ){ // "old" VBO present, although data has been removed
 		if(getFlag(DEBUG_OUTPUT))	std::cout << " ~idxBO";
 		id.removeGlBuffer();
-	} else if( !id.empty() && (id.hasChanged() || !id.isUploaded()) ){ // data has changed or is new
+	} else if( uploadIndices && uploadAllowed ){
 		if(getFlag(DEBUG_OUTPUT))	std::cout << " +idxBO";
 		id.upload(GL_STATIC_DRAW);
 	}
-	if(!getFlag(PRESERVE_LOCAL_DATA) && id.isUploaded() && id.hasLocalData()){
+	if(!getFlag(PRESERVE_LOCAL_DATA) && id.isUploaded() && id.hasLocalData() && !id.hasChanged()){
 		if(getFlag(DEBUG_OUTPUT))	std::cout << " ~idxLD";
 		id.releaseLocalData();
 	}
 
-	MeshVertexData & vd=m->_getVertexData();
 	if( vd.empty() && vd.isUploaded() ){ // "old" VBO present, although data has been removed
 		if(getFlag(DEBUG_OUTPUT))	std::cout << " ~vBO";
 		vd.removeGlBuffer();
-	} else if( !vd.empty() && (vd.hasChanged() || !vd.isUploaded()) ){ // data has changed or is new
+	} else if( uploadVertices && uploadAllowed ){
 		if(getFlag(DEBUG_OUTPUT))	std::cout << " +vBO";
 		vd.upload( getFlag(DYNAMIC_VERTICES) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW );
 	}
-	if(!getFlag(PRESERVE_LOCAL_DATA) && vd.isUploaded() && vd.hasLocalData()){
+	if(!getFlag(PRESERVE_LOCAL_DATA) && vd.isUploaded() && vd.hasLocalData() && !vd.hasChanged()){
 		if(getFlag(DEBUG_OUTPUT))	std::cout << " ~vLD";
 		vd.releaseLocalData();
 	}
@@ -149,8 +156,19 @@ void SimpleMeshDataStrategy::prepare(Mesh * m){
 
 //! ---|> MeshDataStrategy
 void SimpleMeshDataStrategy::displayMesh(RenderingContext & context, Mesh * m,uint32_t startIndex,uint32_t indexCount){
+	// the upload has been postponed by the UploadScheduler: draw the old buffers, if they match the current indices
+	if( getFlag(USE_VBOS) && UploadScheduler::getInstance().isPending(m) ){
+		const MeshIndexData & id=m->_getIndexData();
+		if( !m->_getVertexData().isUploaded() || (m->isUsingIndexData() && (!id.isUploaded() || id.hasChanged())) )
+			return;
+	}
 	if( !m->empty() )
 		MeshDataStrategy::doDisplayMesh(context,m,startIndex,indexCount);
 }
 
+//! ---|> MeshDataStrategy
+void SimpleMeshDataStrategy::forgetMesh(Mesh * m){
+	UploadScheduler::getInstance().cancelUpload(m);
+}
+
 }
@@ -57,6 +57,11 @@ class MeshDataStrategy {
 		/*! Display the mesh as VBO or VertexArray.
 			---o	*/
 		virtual void displayMesh(RenderingContext & context, Mesh * m,uint32_t firstElement,uint32_t elementCount)=0;
+
+		/*! Called when the Mesh is destroyed or stops using this strategy.
+			Strategies that store information about their meshes have to remove the Mesh here.
+			---o	*/
+		virtual void forgetMesh(Mesh * /*m*/)	{}
 		
 	protected:
 		//! (internal) Actually bind the buffers and render the mesh.
@@ -107,7 +112,11 @@ class SimpleMeshDataStrategy : public MeshDataStrategy {
 		void assureLocalVertexData(Mesh * m) override;
 		void assureLocalIndexData(Mesh * m) override;
 		void prepare(Mesh * m) override;
+		/*! If the upload of the mesh's data has been postponed by the UploadScheduler, the previously
+			uploaded buffers are drawn. A mesh without such buffers is not drawn until its upload is done.	*/
 		void displayMesh(RenderingContext & context, Mesh * m,uint32_t startIndex,uint32_t indexCount) override;
+		//! Cancels a postponed upload of the mesh's data.
+		void forgetMesh(Mesh * m) override;
 };
 
 }
@@ -9,40 +9,120 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "MeshIndexData.h"
+#include "ExternalMeshBuffer.h"
 #include "../GLHeader.h"
 #include "../Helper.h"
+#include "internal/MinMaxKernels.h"
+#include "internal/ParallelFor.h"
 #include <Util/Macros.h>
+#include <Util/StringUtils.h>
 #include <algorithm>
 #include <limits>
+#include <cstdint>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 namespace Rendering {
 
+//! (internal) Read the @p index-th value of @p data stored with the given type.
+static inline uint32_t readIndex(const uint8_t * data, uint32_t type, uint32_t index) {
+	switch(type) {
+		case GL_UNSIGNED_BYTE:
+			return data[index];
+		case GL_UNSIGNED_SHORT:
+			return reinterpret_cast<const uint16_t *>(data)[index];
+		default:
+			return reinterpret_cast<const uint32_t *>(data)[index];
+	}
+}
+
+//! (internal) Convert @p count indices from @p srcType to @p dstType.
+template<typename dst_t>
+static void convertIndices(const uint8_t * source, uint32_t srcType, uint32_t count, dst_t * target) {
+	switch(srcType) {
+		case GL_UNSIGNED_BYTE:
+			std::copy(source, source + count, target);
+			break;
+		case GL_UNSIGNED_SHORT: {
+			const uint16_t * src = reinterpret_cast<const uint16_t *>(source);
+			std::copy(src, src + count, target);
+			break;
+		}
+		default: {
+			const uint32_t * src = reinterpret_cast<const uint32_t *>(source);
+			for(uint32_t i = 0; i < count; ++i) {
+				target[i] = static_cast<dst_t>(src[i]);
+			}
+			break;
+		}
+	}
+}
+
 /*! (ctor)  */
 MeshIndexData::MeshIndexData() :
 			indexCount(0), minIndex(0), maxIndex(0),
-			bufferObject(), dataChanged(false) {
+			bufferObject(), indexType(GL_UNSIGNED_INT), indexSize(sizeof(uint32_t)), dataChanged(false) {
 }
 
 /*! (ctor)  */
 MeshIndexData::MeshIndexData(const MeshIndexData & other) :
-			indexCount(other.getIndexCount()), 
+			indexCount(other.getIndexCount()), indexBytes(other.indexBytes), externalData(other.externalData),
 			minIndex(other.getMinIndex()), maxIndex(other.getMaxIndex()),
-			bufferObject(), dataChanged(true) {
-	if(other.hasLocalData()) {
-		indexArray = other.indexArray;
-	} else if(other.isUploaded()) {
-		other.downloadTo(indexArray);
-	} else {
-		WARN("Cannot access index data."); // should not happen
-	}
+			bufferObject(other.bufferObject), indexType(other.getIndexType()), indexSize(other.getIndexSize()), dataChanged(other.hasChanged()) {
 }
 
 //!(internal)
 void MeshIndexData::releaseLocalData(){
-	indexArray.clear();
-	indexArray.shrink_to_fit();
+	externalData.reset();
+	indexBytes.reset();
+}
+
+//!(internal)
+std::vector<uint8_t> & MeshIndexData::writableData(){
+	if(externalData) {
+		indexBytes = std::make_shared<std::vector<uint8_t>>(externalData->data(), externalData->data() + static_cast<std::size_t>(indexCount) * indexSize);
+		externalData.reset();
+	} else if(!indexBytes) {
+		indexBytes = std::make_shared<std::vector<uint8_t>>();
+	} else if(indexBytes.use_count() > 1) {
+		indexBytes = std::make_shared<std::vector<uint8_t>>(*indexBytes);
+	}
+	return *indexBytes;
+}
+
+const uint8_t * MeshIndexData::rawData() const {
+	return externalData ? externalData->data() : (indexBytes ? indexBytes->data() : nullptr);
+}
+
+void MeshIndexData::assertIndexSize(std::size_t size) const {
+	if(size != indexSize)
+		throw std::logic_error("MeshIndexData: The indices are stored with " + Util::StringUtils::toString(static_cast<uint32_t>(indexSize)) +
+				" bytes, but accessed with " + Util::StringUtils::toString(size) + " bytes.");
+}
+
+uint32_t MeshIndexData::operator[](uint32_t index) const {
+	return readIndex(rawData(), indexType, index);
+}
+
+void MeshIndexData::setIndex(uint32_t index, uint32_t value) {
+	if(!hasLocalData())
+		throw std::logic_error("MeshIndexData::setIndex: There is no local index data.");
+	if((indexType == GL_UNSIGNED_BYTE && value > std::numeric_limits<uint8_t>::max()) ||
+			(indexType == GL_UNSIGNED_SHORT && value > std::numeric_limits<uint16_t>::max()))
+		setIndexType(GL_UNSIGNED_INT);
+	uint8_t * data = writableData().data();
+	switch(indexType) {
+		case GL_UNSIGNED_BYTE:
+			data[index] = static_cast<uint8_t>(value);
+			break;
+		case GL_UNSIGNED_SHORT:
+			reinterpret_cast<uint16_t *>(data)[index] = static_cast<uint16_t>(value);
+			break;
+		default:
+			reinterpret_cast<uint32_t *>(data)[index] = value;
+			break;
+	}
 }
 
 void MeshIndexData::swap(MeshIndexData & other){
@@ -54,24 +134,123 @@ void MeshIndexData::swap(MeshIndexData & other){
 	swap(minIndex, other.minIndex);
 	swap(maxIndex, other.maxIndex);
 	swap(bufferObject, other.bufferObject);
+	swap(indexType, other.indexType);
+	swap(indexSize, other.indexSize);
 	swap(dataChanged, other.dataChanged);
-	swap(indexArray, other.indexArray);
+	swap(indexBytes, other.indexBytes);
+	swap(externalData, other.externalData);
 }
 
 void MeshIndexData::allocate(uint32_t count) {
 	indexCount = count;
-	indexArray.resize(indexCount, std::numeric_limits<uint32_t>::max());
+	externalData.reset();
+	indexType = GL_UNSIGNED_INT;
+	indexSize = sizeof(uint32_t);
+	indexBytes = std::make_shared<std::vector<uint8_t>>(static_cast<std::size_t>(indexCount) * sizeof(uint32_t), 0xFF); // initialize with std::numeric_limits<uint32_t>::max()
+	markAsChanged();
+}
+
+void MeshIndexData::setExternalData(uint32_t count, uint32_t type, std::shared_ptr<ExternalMeshBuffer> buffer) {
+	if(type != GL_UNSIGNED_INT && type != GL_UNSIGNED_SHORT && type != GL_UNSIGNED_BYTE)
+		throw std::invalid_argument("MeshIndexData::setExternalData: Unsupported index type.");
+	const uint8_t size = static_cast<uint8_t>(getGLTypeSize(type));
+	if(!buffer || buffer->size() != static_cast<std::size_t>(count) * size)
+		throw std::invalid_argument("MeshIndexData::setExternalData: Buffer size does not match the index count.");
+	if(reinterpret_cast<std::uintptr_t>(buffer->data()) % size != 0)
+		throw std::invalid_argument("MeshIndexData::setExternalData: Buffer is not aligned.");
+	indexCount = count;
+	indexType = type;
+	indexSize = size;
+	indexBytes.reset();
+	externalData = std::move(buffer);
 	markAsChanged();
 }
 
+void MeshIndexData::setIndexType(uint32_t type) {
+	if(type == indexType)
+		return;
+	uint32_t maxValue;
+	switch(type) {
+		case GL_UNSIGNED_INT:
+			maxValue = std::numeric_limits<uint32_t>::max();
+			break;
+		case GL_UNSIGNED_SHORT:
+			maxValue = std::numeric_limits<uint16_t>::max();
+			break;
+		case GL_UNSIGNED_BYTE:
+			maxValue = std::numeric_limits<uint8_t>::max();
+			break;
+		default:
+			throw std::invalid_argument("MeshIndexData::setIndexType: Unsupported index type.");
+	}
+	const uint8_t newSize = static_cast<uint8_t>(getGLTypeSize(type));
+	if(hasLocalData()) {
+		const uint8_t * oldData = rawData();
+		std::vector<uint8_t> newBytes(static_cast<std::size_t>(indexCount) * newSize);
+		if(newSize < indexSize) {
+			for(uint32_t i = 0; i < indexCount; ++i) {
+				if(readIndex(oldData, indexType, i) > maxValue)
+					throw std::invalid_argument("MeshIndexData::setIndexType: Index exceeds the range of the index type.");
+			}
+		}
+		switch(type) {
+			case GL_UNSIGNED_INT:
+				convertIndices(oldData, indexType, indexCount, reinterpret_cast<uint32_t *>(newBytes.data()));
+				break;
+			case GL_UNSIGNED_SHORT:
+				convertIndices(oldData, indexType, indexCount, reinterpret_cast<uint16_t *>(newBytes.data()));
+				break;
+			default:
+				convertIndices(oldData, indexType, indexCount, newBytes.data());
+				break;
+		}
+		externalData.reset();
+		indexBytes = std::make_shared<std::vector<uint8_t>>(std::move(newBytes));
+	} else if(isUploaded()) {
+		throw std::logic_error("MeshIndexData::setIndexType: Cannot convert index data that is only available in graphics memory.");
+	}
+	indexType = type;
+	indexSize = newSize;
+	markAsChanged();
+}
+
+//! (internal) Minimal number of indices per thread used by updateIndexRange().
+static const std::size_t minIndicesPerChunk = 1 << 18;
+
+//! (internal) Determine the minimum and maximum of the given indices; large arrays are processed in parallel.
+template<typename index_t>
+static void calculateIndexRange(const index_t * indices, uint32_t count, uint32_t & minIndex, uint32_t & maxIndex) {
+	const uint32_t chunkCount = ParallelFor::getChunkCount(count, minIndicesPerChunk);
+	std::vector<index_t> min(chunkCount, std::numeric_limits<index_t>::max());
+	std::vector<index_t> max(chunkCount, std::numeric_limits<index_t>::lowest());
+	ParallelFor::forEachChunk(count, chunkCount, [&](uint32_t chunk, std::size_t begin, std::size_t end) {
+		MinMaxKernels::accumulateMinMax(indices + begin, end - begin, min[chunk], max[chunk]);
+	});
+	minIndex = *std::min_element(min.begin(), min.end());
+	maxIndex = *std::max_element(max.begin(), max.end());
+}
+
 void MeshIndexData::updateIndexRange() {
-	if(indexArray.empty()) {
+	if(!hasLocalData() || indexCount == 0) {
 		minIndex = 1;
 		maxIndex = 0;
-	} else {
-		auto minMaxPair = std::minmax_element(indexArray.begin(), indexArray.end());
-		minIndex = *minMaxPair.first;
-		maxIndex = *minMaxPair.second;
+		return;
+	}
+	const uint8_t * indices = rawData();
+	switch(indexType) {
+		case GL_UNSIGNED_BYTE:
+			calculateIndexRange(indices, indexCount, minIndex, maxIndex);
+			break;
+		case GL_UNSIGNED_SHORT:
+			calculateIndexRange(reinterpret_cast<const uint16_t *>(indices), indexCount, minIndex, maxIndex);
+			break;
+		default:
+			calculateIndexRange(reinterpret_cast<const uint32_t *>(indices), indexCount, minIndex, maxIndex);
+			break;
+	}
+	// narrow to 16bit indices; external data is kept as it is to avoid copying it
+	if(indexType == GL_UNSIGNED_INT && !hasExternalData() && maxIndex <= std::numeric_limits<uint16_t>::max()) {
+		setIndexType(GL_UNSIGNED_SHORT);
 	}
 }
 
@@ -84,11 +263,12 @@ bool MeshIndexData::upload(uint32_t usageHint){
 	if( isUploaded() )
 		removeGlBuffer();
 
-	if(indexCount == 0 || indexArray.empty() )
+	if(indexCount == 0 || !hasLocalData() )
 		return false;
 
 	try {
-		bufferObject.uploadData(GL_ELEMENT_ARRAY_BUFFER, indexArray, usageHint);
+		bufferObject = new CountedBufferObject;
+		bufferObject->get().uploadData(GL_ELEMENT_ARRAY_BUFFER, rawData(), dataSize(), usageHint);
 		GET_GL_ERROR()
 	}
 	catch (...) {
@@ -104,15 +284,23 @@ bool MeshIndexData::upload(uint32_t usageHint){
 bool MeshIndexData::download(){
 	if(!isUploaded() || indexCount==0)
 		return false;
-	downloadTo(indexArray);
+#ifdef LIB_GL
+	externalData.reset();
+	indexBytes = std::make_shared<std::vector<uint8_t>>(bufferObject->get().downloadData<uint8_t>(GL_ELEMENT_ARRAY_BUFFER, dataSizeInBuffer()));
 	dataChanged = false;
 	return true;
+#else
+	WARN("download not supported.");
+	return false;
+#endif
 }
 
 //!	(internal)
 #ifdef LIB_GL
 void MeshIndexData::downloadTo(std::vector<uint32_t> & destination) const {
-	destination = bufferObject.downloadData<uint32_t>(GL_ELEMENT_ARRAY_BUFFER, getIndexCount());
+	const std::vector<uint8_t> bytes = bufferObject->get().downloadData<uint8_t>(GL_ELEMENT_ARRAY_BUFFER, dataSizeInBuffer());
+	destination.resize(indexCount);
+	convertIndices(bytes.data(), indexType, indexCount, destination.data());
 }
 #else
 void MeshIndexData::downloadTo(std::vector<uint32_t> & /*destination*/) const {
@@ -122,7 +310,15 @@ void MeshIndexData::downloadTo(std::vector<uint32_t> & /*destination*/) const {
 
 //!	(internal)
 void MeshIndexData::removeGlBuffer(){
-	bufferObject.destroy();
+	// the buffer is deleted when the last copy sharing it releases it
+	bufferObject = nullptr;
+}
+
+void MeshIndexData::_swapBufferObject(BufferObject & other){
+	if(bufferObject.isNull() || bufferObject->countReferences() > 1) {
+		bufferObject = new CountedBufferObject;
+	}
+	bufferObject->get().swap(other);
 }
 
 /*! (internal) */
@@ -132,19 +328,19 @@ void MeshIndexData::drawElements(bool useVBO,uint32_t drawMode,uint32_t startInd
 	
 #ifdef LIB_GL
 	if(useVBO && isUploaded()) { // VBO
-		bufferObject.bind(GL_ELEMENT_ARRAY_BUFFER);
-		glDrawRangeElements(drawMode, getMinIndex(), getMaxIndex(), numberOfIndices, GL_UNSIGNED_INT, reinterpret_cast<void*>(sizeof(GLuint)*startIndex));
-		bufferObject.unbind(GL_ELEMENT_ARRAY_BUFFER);
+		bufferObject->get().bind(GL_ELEMENT_ARRAY_BUFFER);
+		glDrawRangeElements(drawMode, getMinIndex(), getMaxIndex(), numberOfIndices, indexType, reinterpret_cast<void*>(static_cast<std::size_t>(indexSize)*startIndex));
+		bufferObject->get().unbind(GL_ELEMENT_ARRAY_BUFFER);
 	} else if(hasLocalData()) { // VertexArray
-		glDrawRangeElements(drawMode, getMinIndex(), getMaxIndex(), numberOfIndices, GL_UNSIGNED_INT, reinterpret_cast<void*>(data()+startIndex));
+		glDrawRangeElements(drawMode, getMinIndex(), getMaxIndex(), numberOfIndices, indexType, reinterpret_cast<const void*>(rawData()+static_cast<std::size_t>(indexSize)*startIndex));
 	}
 #else
 	if (useVBO && isUploaded()) { // VBO
-		bufferObject.bind(GL_ELEMENT_ARRAY_BUFFER);
-		glDrawElements(drawMode, numberOfIndices, GL_UNSIGNED_INT, reinterpret_cast<void*>(sizeof(GLuint)*startIndex));
-		bufferObject.unbind(GL_ELEMENT_ARRAY_BUFFER);
+		bufferObject->get().bind(GL_ELEMENT_ARRAY_BUFFER);
+		glDrawElements(drawMode, numberOfIndices, indexType, reinterpret_cast<void*>(static_cast<std::size_t>(indexSize)*startIndex));
+		bufferObject->get().unbind(GL_ELEMENT_ARRAY_BUFFER);
 	} else if (hasLocalData()) { // VertexArray
-		glDrawElements(drawMode, numberOfIndices, GL_UNSIGNED_INT, reinterpret_cast<void*>(data()+startIndex));
+		glDrawElements(drawMode, numberOfIndices, indexType, reinterpret_cast<const void*>(rawData()+static_cast<std::size_t>(indexSize)*startIndex));
 	}
 #endif
 }
@@ -12,18 +12,43 @@
 #define RENDERING_MESHINDEXDATA_H
 
 #include "../BufferObject.h"
+#include <Util/References.h>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace Rendering {
+class ExternalMeshBuffer;
 
 /*! IndexData-Class .
-	Part of the Mesh implementation containing all index specific data of a mesh. */
+	Part of the Mesh implementation containing all index specific data of a mesh.
+	The local index data may reside in an ExternalMeshBuffer (e.g. a memory mapped file);
+	it is copied into the object's own memory when it is accessed for writing.
+	The indices are stored as GL_UNSIGNED_INT, GL_UNSIGNED_SHORT or GL_UNSIGNED_BYTE values
+	(see getIndexType()). The same type is used for the index buffer and for drawing.
+	updateIndexRange() automatically narrows 32bit indices to 16bit if all indices fit.
+	Copies of a MeshIndexData object share the local data and the index buffer
+	until one of them accesses its data for writing (copy-on-write). */
 class MeshIndexData {
 	public:
+		/*! Reference to an index returned by the non-const operator[]. Reading it does not change the data;
+			an assigned value is written by MeshIndexData::setIndex(...).	*/
+		class IndexReference {
+			public:
+				operator uint32_t()const									{	return static_cast<const MeshIndexData &>(indexData)[index];	}
+				IndexReference & operator=(uint32_t value)					{	indexData.setIndex(index, value);	return *this;	}
+				IndexReference & operator=(const IndexReference & other)	{	return *this = static_cast<uint32_t>(other);	}
+			private:
+				friend class MeshIndexData;
+				IndexReference(MeshIndexData & _indexData, uint32_t _index) : indexData(_indexData), index(_index) {}
+				MeshIndexData & indexData;
+				const uint32_t index;
+		};
+
 		MeshIndexData();
-		//! Copy all data from @p other
+		/*! Share all data with @p other. This is cheap: The local data and the index buffer
+			are only copied when one of the objects accesses its data for writing.	*/
 		MeshIndexData(const MeshIndexData & other);
 		MeshIndexData(MeshIndexData &&) = default;
 
@@ -37,27 +62,74 @@ class MeshIndexData {
 		bool empty()const									{	return indexCount==0;	}
 
 		// data
+		//! Allocate @p count 32bit indices. The old data is freed.
 		void allocate(uint32_t count);
+		/*! Use the read-only memory of @p buffer as local index data. The old data is freed.
+			@p indexType is GL_UNSIGNED_INT, GL_UNSIGNED_SHORT or GL_UNSIGNED_BYTE.
+			\note Sets dataChanged.
+			\throw std::invalid_argument if the buffer does not contain @p count properly aligned indices.	*/
+		void setExternalData(uint32_t count, uint32_t indexType, std::shared_ptr<ExternalMeshBuffer> buffer);
+		//! Returns true iff the local data currently resides in an external buffer.
+		bool hasExternalData()const							{	return static_cast<bool>(externalData);	}
 		void releaseLocalData();
-		const uint32_t * data() const						{	return indexArray.data();	}
-		uint32_t * data() 									{	return indexArray.data();	}
-		std::size_t dataSize() const						{	return indexArray.size() * sizeof(uint32_t);	}
+		//! Read-only access to the local data as stored (see getIndexType()); does not copy external data.
+		const uint8_t * rawData() const;
+		/*! Writable access to the local data as stored; @p index_t (uint8_t, uint16_t or uint32_t) has to match getIndexType().
+			External data or data shared with a copy of this object is copied first. The indices are neither
+			converted nor marked as changed (see markAsChanged()).
+			\throw std::logic_error if the size of @p index_t does not match the index type.
+			\note The returned pointer is invalidated by updateIndexRange() and setIndexType(...).	*/
+		template<typename index_t>
+		index_t * typedData()								{	assertIndexSize(sizeof(index_t));	return reinterpret_cast<index_t *>(writableData().data());	}
+		/*! Writable access to the local data as 32bit indices (see typedData()).
+			\throw std::logic_error if the indices are stored with a smaller type; use typedData() or
+				convert them explicitly with setIndexType(GL_UNSIGNED_INT).	*/
+		uint32_t * data()									{	return typedData<uint32_t>();	}
+		std::size_t dataSize() const						{	return hasLocalData() ? static_cast<std::size_t>(indexCount) * getIndexSize() : 0;	}
 		void markAsChanged()								{  	dataChanged=true;	}
 		bool hasChanged()const								{  	return dataChanged;	}
-		bool hasLocalData()const							{  	return !indexArray.empty();	}
+		bool hasLocalData()const							{  	return (indexBytes && !indexBytes->empty()) || hasExternalData();	}
+		//! Returns true iff the local data is currently shared with a copy of this object.
+		bool hasSharedData()const							{	return indexBytes && indexBytes.use_count() > 1;	}
+
+		//! Read the index at position @p index (independent of the index type).
+		uint32_t operator[](uint32_t index) const;
+		//! Reference to the index at position @p index (see IndexReference).
+		IndexReference operator[](uint32_t index)			{	return IndexReference(*this, index);	}
+		/*! Write @p value at position @p index using the current index type. Only if the value does not fit
+			into the type, the indices are converted to 32bit (see setIndexType(...)).
+			\note Does not set dataChanged (see markAsChanged()).
+			\throw std::logic_error if there is no local data.	*/
+		void setIndex(uint32_t index, uint32_t value);
 
-		const uint32_t & operator[](uint32_t index) const	{	return indexArray[index]; }
-		uint32_t & operator[](uint32_t index) 				{	return indexArray[index]; }
+		// index type
+		//! GL type of the indices: GL_UNSIGNED_INT, GL_UNSIGNED_SHORT or GL_UNSIGNED_BYTE
+		uint32_t getIndexType() const						{	return indexType;	}
+		//! Size of a single index in bytes.
+		uint8_t getIndexSize() const						{	return indexSize;	}
+		/*! Convert the local indices to the given type (GL_UNSIGNED_INT, GL_UNSIGNED_SHORT or GL_UNSIGNED_BYTE).
+			\note 8bit indices are never chosen automatically and have to be requested explicitly.
+			\note Sets dataChanged if the type changes.
+			\throw std::invalid_argument if the type is not supported or an index does not fit into it.	*/
+		void setIndexType(uint32_t type);
 
 		// index range
 		inline uint32_t getMinIndex() const 				{   return minIndex;    }
 		inline uint32_t getMaxIndex() const 				{   return maxIndex;    }
 		/*! Recalculates the index range of the mesh.
+			If the indices are stored as 32bit values and all indices fit into 16bit, they are converted to 16bit
+			(external data is never converted).
 			\note Should be called whenever the vertices are changed.	*/
 		void updateIndexRange();
+		/*! Set the index range without reading the indices.
+			\note This function should not be used normally. It is needed when the range is known, e.g. stored in a file,
+				and reading the indices would be expensive (e.g. for mapped external data).	*/
+		void _setIndexRange(uint32_t newMinIndex, uint32_t newMaxIndex)	{	minIndex = newMinIndex;	maxIndex = newMaxIndex;	}
 
 		// vbo
-		inline bool isUploaded()const						{   return bufferObject.isValid();    }
+		inline bool isUploaded()const						{   return bufferObject.isNotNull() && bufferObject->get().isValid();    }
+		//! (internal) Identifies the index buffer; copies of this object sharing the buffer return the same value (nullptr if not uploaded).
+		const void * _getBufferId()const					{	return isUploaded() ? bufferObject.get() : nullptr;	}
 
 		//! Call @a upload() with default usage hint.
 		bool upload();
@@ -76,14 +148,29 @@ class MeshIndexData {
 		/*! Swap the internal BufferObject.
 			\note The local data is not changed!
 			\note the size of the new buffer must be equal to that of the old one.
+			\note If the buffer is shared with a copy of this object, it stays with the copy
+				and @p other receives an invalid BufferObject.
 			\note Use only if you know what you are doing!	*/
-		void _swapBufferObject(BufferObject & other)	{	bufferObject.swap(other);	}
+		void _swapBufferObject(BufferObject & other);
 	private:
+		/*! (internal) Make sure the local data is exclusively owned by this object by copying
+			external or shared data, and return it. Called before the local data is accessed for writing. */
+		std::vector<uint8_t> & writableData();
+		//! (internal) Throw a std::logic_error if @p size is not the size of the index type.
+		void assertIndexSize(std::size_t size)const;
+		//! (internal) Size of the index data in the buffer object.
+		std::size_t dataSizeInBuffer()const					{	return static_cast<std::size_t>(indexCount) * indexSize;	}
+
 		uint32_t indexCount;
-		std::vector<uint32_t> indexArray;
+		//! Local data; may be shared with copies of this object (nullptr if there is no local data).
+		std::shared_ptr<std::vector<uint8_t>> indexBytes;
+		std::shared_ptr<ExternalMeshBuffer> externalData;
 		uint32_t minIndex;
 		uint32_t maxIndex;
-		BufferObject bufferObject;
+		//! Index buffer; may be shared with copies of this object.
+		Util::Reference<CountedBufferObject> bufferObject;
+		uint32_t indexType;
+		uint8_t indexSize;
 		bool dataChanged;
 };
 }
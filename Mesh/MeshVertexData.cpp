@@ -9,18 +9,22 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "MeshVertexData.h"
+#include "ExternalMeshBuffer.h"
 #include "VertexAttributeIds.h"
 #include "VertexDescription.h"
 #include "../Shader/Shader.h"
 #include "../RenderingContext/RenderingContext.h"
 #include "../GLHeader.h"
 #include "../Helper.h"
+#include "internal/MinMaxKernels.h"
+#include "internal/ParallelFor.h"
+#include "internal/VertexDescriptionRegistry.h"
 #include <Util/Macros.h>
 #include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <memory>
-#include <mutex>
-#include <set>
+#include <stdexcept>
 #include <vector>
 #include <utility>
 
@@ -29,37 +33,47 @@ namespace Rendering{
 
 //! (internal)
 void MeshVertexData::setVertexDescription(const VertexDescription & vd){
-	static std::mutex mutex;
-	std::lock_guard<std::mutex> lock(mutex);
-
-	static std::set<VertexDescription> descriptionCollections;
-	std::pair<std::set<VertexDescription>::iterator,bool> result = descriptionCollections.insert(vd);
-	vertexDescription = &*(result.first);
+	vertexDescription = &VertexDescriptionRegistry::registerDescription(vd, vertexDescriptionId);
 }
 
 // ---------------------------
 
 //! (ctor)
 MeshVertexData::MeshVertexData() :
-	binaryData(), vertexDescription(nullptr), vertexCount(0), bufferObject(), bb(), dataChanged(false) {
+	binaryData(), externalData(), vertexDescription(nullptr), vertexDescriptionId(0), vertexCount(0), bufferObject(), layout(VertexLayout::INTERLEAVED), bb(), dataChanged(false) {
 	setVertexDescription(VertexDescription());
 }
 
 //! (ctor)
 MeshVertexData::MeshVertexData(const MeshVertexData & other) :
-	binaryData(), vertexDescription(other.vertexDescription), vertexCount(other.getVertexCount()), bufferObject(), bb(other.getBoundingBox()), dataChanged(true) {
-	if(other.hasLocalData()) {
-		binaryData = other.binaryData;
-	} else if(other.isUploaded()) {
-		other.downloadTo(binaryData);
-	} else {
-		WARN("Cannot access vertex data."); // should not happen
-	}
+	binaryData(other.binaryData), externalData(other.externalData), vertexDescription(other.vertexDescription), vertexDescriptionId(other.vertexDescriptionId), vertexCount(other.getVertexCount()),
+	bufferObject(other.bufferObject), layout(other.getLayout()), bb(other.getBoundingBox()), dataChanged(other.hasChanged()) {
 }
 
 void MeshVertexData::releaseLocalData(){
-	binaryData.resize(0);
-	binaryData.shrink_to_fit();
+	externalData.reset();
+	binaryData.reset();
+}
+
+//! (internal)
+std::vector<uint8_t> & MeshVertexData::writableData(){
+	if(externalData) {
+		binaryData = std::make_shared<std::vector<uint8_t>>(externalData->data(), externalData->data() + externalData->size());
+		externalData.reset();
+	} else if(!binaryData) {
+		binaryData = std::make_shared<std::vector<uint8_t>>();
+	} else if(binaryData.use_count() > 1) {
+		binaryData = std::make_shared<std::vector<uint8_t>>(*binaryData);
+	}
+	return *binaryData;
+}
+
+const uint8_t * MeshVertexData::data()const{
+	return externalData ? externalData->data() : (binaryData ? binaryData->data() : nullptr);
+}
+
+size_t MeshVertexData::dataSize()const{
+	return externalData ? externalData->size() : (binaryData ? binaryData->size() : 0);
 }
 
 void MeshVertexData::swap(MeshVertexData & other){
@@ -68,29 +82,98 @@ void MeshVertexData::swap(MeshVertexData & other){
 
 	using std::swap;
 	swap(vertexDescription, other.vertexDescription);
+	swap(vertexDescriptionId, other.vertexDescriptionId);
 	swap(vertexCount, other.vertexCount);
 	swap(bufferObject, other.bufferObject);
+	swap(layout, other.layout);
 	swap(bb, other.bb);
 	swap(dataChanged, other.dataChanged);
 	swap(binaryData, other.binaryData);
+	swap(externalData, other.externalData);
 }
 
 void MeshVertexData::allocate(uint32_t count, const VertexDescription & vd){
 	setVertexDescription(vd);
+	layout = VertexLayout::INTERLEAVED;
+	vertexCount = count;
+	externalData.reset();
+	const std::size_t newSize = static_cast<std::size_t>(vd.getVertexSize()) * count;
+	if(hasSharedData()) {
+		// keep the old data as far as possible (as resizing would), but do not touch the shared vector
+		const std::size_t keptSize = std::min(newSize, binaryData->size());
+		binaryData = std::make_shared<std::vector<uint8_t>>(binaryData->begin(), binaryData->begin() + keptSize);
+	}
+	writableData().resize(newSize);
+	markAsChanged();
+}
+
+void MeshVertexData::setExternalData(uint32_t count, const VertexDescription & vd, std::shared_ptr<ExternalMeshBuffer> buffer){
+	if(!buffer || buffer->size() != static_cast<std::size_t>(vd.getVertexSize()) * count)
+		throw std::invalid_argument("MeshVertexData::setExternalData: Buffer size does not match the vertex data.");
+	setVertexDescription(vd);
+	layout = VertexLayout::INTERLEAVED;
 	vertexCount = count;
-	binaryData.resize(vd.getVertexSize() * count);
+	binaryData.reset();
+	externalData = std::move(buffer);
 	markAsChanged();
 }
 
 const uint8_t * MeshVertexData::operator[](uint32_t index) const {
-	return binaryData.data() + index * vertexDescription->getVertexSize();
+	if(layout != VertexLayout::INTERLEAVED)
+		throw std::logic_error("MeshVertexData: Vertex access requires an interleaved layout.");
+	return data() + index * vertexDescription->getVertexSize();
 
 }
 
 uint8_t * MeshVertexData::operator[](uint32_t index) {
-	return binaryData.data() + index * vertexDescription->getVertexSize();
+	if(layout != VertexLayout::INTERLEAVED)
+		throw std::logic_error("MeshVertexData: Vertex access requires an interleaved layout.");
+	return data() + index * vertexDescription->getVertexSize();
+}
+
+std::size_t MeshVertexData::getAttributeOffset(const VertexAttribute & attr)const {
+	// As the attributes are tightly packed, the stream of an attribute starts behind the streams of all previous attributes.
+	return layout == VertexLayout::INTERLEAVED ? attr.getOffset() : static_cast<std::size_t>(vertexCount) * attr.getOffset();
+}
+
+std::size_t MeshVertexData::getAttributeStride(const VertexAttribute & attr)const {
+	return layout == VertexLayout::INTERLEAVED ? vertexDescription->getVertexSize() : attr.getDataSize();
+}
+
+void MeshVertexData::setLayout(VertexLayout newLayout) {
+	if(newLayout == layout)
+		return;
+	if(vertexCount > 0) {
+		if(!hasLocalData())
+			throw std::logic_error("MeshVertexData::setLayout: No local vertex data.");
+		const MeshVertexData & constThis = *this;
+		const uint8_t * source = constThis.data();
+		std::vector<uint8_t> converted(constThis.dataSize());
+		const std::size_t vertexSize = vertexDescription->getVertexSize();
+		for(const auto & attr : vertexDescription->getAttributes()) {
+			const std::size_t attrSize = attr.getDataSize();
+			const std::size_t streamOffset = static_cast<std::size_t>(vertexCount) * attr.getOffset();
+			// interleaved: vertex i at i * vertexSize + offset; separate: vertex i at streamOffset + i * attrSize
+			for(uint32_t i = 0; i < vertexCount; ++i) {
+				const std::size_t interleavedPos = i * vertexSize + attr.getOffset();
+				const std::size_t separatePos = streamOffset + i * attrSize;
+				if(newLayout == VertexLayout::SEPARATE) {
+					std::copy(source + interleavedPos, source + interleavedPos + attrSize, converted.data() + separatePos);
+				} else {
+					std::copy(source + separatePos, source + separatePos + attrSize, converted.data() + interleavedPos);
+				}
+			}
+		}
+		externalData.reset();
+		binaryData = std::make_shared<std::vector<uint8_t>>(std::move(converted));
+	}
+	layout = newLayout;
+	markAsChanged();
 }
 
+//! (internal) Minimal number of vertices per thread used by updateBoundingBox().
+static const std::size_t minVerticesPerChunk = 1 << 17;
+
 void MeshVertexData::updateBoundingBox() {
 	if (vertexCount == 0) {
 		bb = Geometry::Box();
@@ -108,25 +191,33 @@ void MeshVertexData::updateBoundingBox() {
 		return;
 	}
 
-	const uint8_t * vertices = data()+attr.getOffset();
-	const int vertexSize = vd.getVertexSize();
+	const uint8_t * vertices = static_cast<const MeshVertexData &>(*this).getAttributeData(attr);
+	const std::size_t vertexSize = getAttributeStride(attr);
 
 
 	// The following implementation calculates minima and maxima for the coordinates.
 	// This is faster than calling Geometry::Box::include for each vertex.
-	std::vector<float> min(vertexNum, std::numeric_limits<float>::max());
-	std::vector<float> max(vertexNum, std::numeric_limits<float>::lowest());
-	for (uint_fast32_t i = 0; i < vertexCount; ++i) {
-		const float * p = reinterpret_cast<const float *> (vertices);
-		for (uint_fast8_t dim = 0; dim < vertexNum; ++dim) {
-			if (p[dim] < min[dim]) {
-				min[dim] = p[dim];
+	// Large meshes are split into chunks that are processed in parallel. The partial results
+	// are reduced in chunk order using the same comparisons, so the result is independent of the chunk count.
+	const uint32_t chunkCount = ParallelFor::getChunkCount(vertexCount, minVerticesPerChunk);
+	std::vector<float> bounds(2 * chunkCount * vertexNum);
+	float * min = bounds.data();
+	float * max = bounds.data() + chunkCount * vertexNum;
+	std::fill(min, max, std::numeric_limits<float>::max());
+	std::fill(max, max + chunkCount * vertexNum, std::numeric_limits<float>::lowest());
+	ParallelFor::forEachChunk(vertexCount, chunkCount, [&](uint32_t chunk, std::size_t begin, std::size_t end) {
+		MinMaxKernels::accumulateMinMax(vertices + begin * vertexSize, end - begin, vertexSize, vertexNum,
+										min + chunk * vertexNum, max + chunk * vertexNum);
+	});
+	for(uint_fast32_t chunk = 1; chunk < chunkCount; ++chunk) {
+		for(uint_fast8_t dim = 0; dim < vertexNum; ++dim) {
+			if(min[chunk * vertexNum + dim] < min[dim]) {
+				min[dim] = min[chunk * vertexNum + dim];
 			}
-			if (p[dim] > max[dim]) {
-				max[dim] = p[dim];
+			if(max[chunk * vertexNum + dim] > max[dim]) {
+				max[dim] = max[chunk * vertexNum + dim];
 			}
 		}
-		vertices += vertexSize;
 	}
 
 	if (vertexNum == 1) {
@@ -146,11 +237,13 @@ bool MeshVertexData::upload(uint32_t usageHint){
 	if( isUploaded() )
 		removeGlBuffer();
 
-	if(vertexCount == 0 || binaryData.empty() )
+	if(vertexCount == 0 || !hasLocalData() )
 		return false;
 
 	try {
-		bufferObject.uploadData(GL_ARRAY_BUFFER, binaryData, usageHint);
+		const MeshVertexData & constThis = *this;
+		bufferObject = new CountedBufferObject;
+		bufferObject->get().uploadData(GL_ARRAY_BUFFER, constThis.data(), constThis.dataSize(), usageHint);
 		GET_GL_ERROR()
 	}
 	catch (...) {
@@ -165,7 +258,9 @@ bool MeshVertexData::upload(uint32_t usageHint){
 bool MeshVertexData::download(){
 	if(!isUploaded() || vertexCount==0)
 		return false;
-	downloadTo(binaryData);
+	externalData.reset();
+	binaryData = std::make_shared<std::vector<uint8_t>>();
+	downloadTo(*binaryData);
 	dataChanged = false;
 	return true;
 }
@@ -173,7 +268,7 @@ bool MeshVertexData::download(){
 #ifdef LIB_GL
 void MeshVertexData::downloadTo(std::vector<uint8_t> & destination) const {
 	const std::size_t numBytes = getVertexDescription().getVertexSize() * getVertexCount();
-	destination = bufferObject.downloadData<uint8_t>(GL_ARRAY_BUFFER, numBytes);
+	destination = bufferObject->get().downloadData<uint8_t>(GL_ARRAY_BUFFER, numBytes);
 }
 #else
 void MeshVertexData::downloadTo(std::vector<uint8_t> & /*destination*/) const {
@@ -182,7 +277,15 @@ void MeshVertexData::downloadTo(std::vector<uint8_t> & /*destination*/) const {
 #endif
 
 void MeshVertexData::removeGlBuffer(){
-	bufferObject.destroy();
+	// the buffer is deleted when the last copy sharing it releases it
+	bufferObject = nullptr;
+}
+
+void MeshVertexData::_swapBufferObject(BufferObject & other){
+	if(bufferObject.isNull() || bufferObject->countReferences() > 1) {
+		bufferObject = new CountedBufferObject;
+	}
+	bufferObject->get().swap(other);
 }
 
 void MeshVertexData::bind(RenderingContext & context, bool useVBO) {
@@ -190,13 +293,16 @@ void MeshVertexData::bind(RenderingContext & context, bool useVBO) {
 
 	const uint8_t * vertexPosition = nullptr;
 	if (useVBO && isUploaded()) { // use VBO
-		bufferObject.bind(GL_ARRAY_BUFFER);
+		bufferObject->get().bind(GL_ARRAY_BUFFER);
 	} else { // use Vertex array
-		vertexPosition = data();
+		vertexPosition = static_cast<const MeshVertexData &>(*this).data();
 	}
 
 	Shader * shader = context.getActiveShader();
-	const GLsizei vSize=vd.getVertexSize();
+	// RenderingContext::enableVertexAttribArray adds the attribute's (interleaved) offset to the given pointer.
+	auto enableAttribArray = [&](const VertexAttribute & attr) {
+		context.enableVertexAttribArray(attr, vertexPosition + getAttributeOffset(attr) - attr.getOffset(), static_cast<int32_t>(getAttributeStride(attr)));
+	};
 #ifdef LIB_GL
 	if (shader == nullptr || shader->usesClassicOpenGL()) {
 
@@ -207,39 +313,39 @@ void MeshVertexData::bind(RenderingContext & context, bool useVBO) {
 
 			if(nameId==VertexAttributeIds::POSITION) {
 				context.enableClientState(GL_VERTEX_ARRAY);
-				glVertexPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glVertexPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::NORMAL) {
 				context.enableClientState(GL_NORMAL_ARRAY);
-				glNormalPointer(attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glNormalPointer(attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::COLOR) {
 				context.enableClientState(GL_COLOR_ARRAY);
-				glColorPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glColorPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD0) {
 				context.enableTextureClientState(GL_TEXTURE0);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD1) {
 				context.enableTextureClientState(GL_TEXTURE1);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD2) {
 				context.enableTextureClientState(GL_TEXTURE2);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD3) {
 				context.enableTextureClientState(GL_TEXTURE3);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD4) {
 				context.enableTextureClientState(GL_TEXTURE4);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD5) {
 				context.enableTextureClientState(GL_TEXTURE5);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD6) {
 				context.enableTextureClientState(GL_TEXTURE6);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(nameId==VertexAttributeIds::TEXCOORD7) {
 				context.enableTextureClientState(GL_TEXTURE7);
-				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glTexCoordPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 			} else if(shader != nullptr) { // ????????does this work?????
-				context.enableVertexAttribArray(attr, vertexPosition, vSize);
+				enableAttribArray(attr);
 			}
 		}
 	}else if( shader != nullptr && context.useAMDAttrBugWorkaround() ){
@@ -248,7 +354,7 @@ void MeshVertexData::bind(RenderingContext & context, bool useVBO) {
 				continue;
 			if(attr.getNameId()==VertexAttributeIds::POSITION) {
 				context.enableClientState(GL_VERTEX_ARRAY);
-				glVertexPointer(attr.getNumValues(), attr.getDataType(), vSize, vertexPosition + attr.getOffset());
+				glVertexPointer(attr.getNumValues(), attr.getDataType(), getAttributeStride(attr), vertexPosition + getAttributeOffset(attr));
 				break;
 			}
 		}
@@ -257,7 +363,7 @@ void MeshVertexData::bind(RenderingContext & context, bool useVBO) {
 	if (shader != nullptr && shader->usesSGUniforms()) {
 		for(const auto & attr : vd.getAttributes()) {
 			if(!attr.empty()) {
-				context.enableVertexAttribArray(attr, vertexPosition, vSize);
+				enableAttribArray(attr);
 			}
 		}
 	}
@@ -275,7 +381,7 @@ void MeshVertexData::drawArray(RenderingContext & context,bool useVBO,uint32_t d
 
 void MeshVertexData::unbind(RenderingContext & context, bool useVBO) {
 	if (useVBO && isUploaded()) { // unbind vertex VBO
-		bufferObject.unbind(GL_ARRAY_BUFFER);
+		bufferObject->get().unbind(GL_ARRAY_BUFFER);
 	}
 	context.disableAllClientStates();
 	context.disableAllTextureClientStates();
@@ -12,43 +12,70 @@
 #define MeshVertexData_H
 
 #include "../BufferObject.h"
+#include <Util/References.h>
 #include <Geometry/Box.h>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace Rendering {
 
+class ExternalMeshBuffer;
 class RenderingContext;
+class VertexAttribute;
 class VertexDescription;
 
+//! Memory layout of the vertices of a MeshVertexData object.
+enum class VertexLayout : uint8_t {
+	//! All attributes of a vertex are stored together (array of structures; default).
+	INTERLEAVED,
+	/*! Each attribute is stored in its own tightly packed stream (structure of arrays).
+		The streams are stored one after another in the order of the VertexDescription's attributes. */
+	SEPARATE
+};
+
 /*! VertexData-Class.
 	Part of the Mesh implementation containing all vertex specific data of a mesh:
 	- VertexDescription: Data format of the vertices.
 	- The local storage for the vertex data (If the data is uploaded to
-		the graphics card, the local copy may be freed.)
+		the graphics card, the local copy may be freed.) The local data may
+		also reside in an ExternalMeshBuffer (e.g. a memory mapped file); it is
+		copied into the object's own memory when it is accessed for writing.
 	- The vertex buffer id, if the data has been uploaded to graphics memory.
-	- A bounding box enclosing all vertices.	*/
+	Copies of a MeshVertexData object share the local data and the vertex buffer
+	until one of them accesses its data for writing (copy-on-write).
+	- A bounding box enclosing all vertices.
+	The vertices are either stored interleaved or with a separate stream for each attribute (see VertexLayout).
+	Use getAttributeData(...) and getAttributeStride(...) to access an attribute independent of the layout.	*/
 class MeshVertexData {
-		std::vector<uint8_t> binaryData;
+		//! Local data; may be shared with copies of this object (nullptr if there is no local data).
+		std::shared_ptr<std::vector<uint8_t>> binaryData;
+		std::shared_ptr<ExternalMeshBuffer> externalData;
 		const VertexDescription * vertexDescription;
+		uint32_t vertexDescriptionId;
 		uint32_t vertexCount;
-		BufferObject bufferObject;
+		//! Vertex buffer; may be shared with copies of this object.
+		Util::Reference<CountedBufferObject> bufferObject;
+		VertexLayout layout;
 
 		Geometry::Box bb;
 		bool dataChanged;
 
-		/*! (internal) To save memory, the vertexDescription is stored in a static set
+		/*! (internal) To save memory, the vertexDescription is stored in a global registry
 			so that each MeshVertexData-Object having the same vertex description references the same
 			VertexDescription object. */
 		void setVertexDescription(const VertexDescription & vd);
+
+		/*! (internal) Make sure the local data is exclusively owned by this object by copying
+			external or shared data, and return it. Called before the local data is accessed for writing. */
+		std::vector<uint8_t> & writableData();
 	public:
 
 		// main
 		MeshVertexData();
-		/*! Copy all data from @p other.
-			\note If the other data is only available in the graphics card memory, this may
-				only be called from within the gl-thread.	*/
+		/*! Share all data with @p other. This is cheap: The local data and the vertex buffer
+			are only copied when one of the objects accesses its data for writing.	*/
 		MeshVertexData(const MeshVertexData & other);
 		MeshVertexData(MeshVertexData &&) = default;
 
@@ -58,6 +85,9 @@ class MeshVertexData {
 		MeshVertexData & operator=(MeshVertexData &&) = default;
 
 		const VertexDescription & getVertexDescription()const 	{	return *vertexDescription;	}
+		/*! Compact id of the vertex description. Two MeshVertexData objects have equal
+			vertex descriptions iff their ids are equal.	*/
+		uint32_t getVertexDescriptionId()const					{	return vertexDescriptionId;	}
 		uint32_t getVertexCount()const							{	return vertexCount;	}
 		bool empty()const										{	return vertexCount==0;	}
 		void swap(MeshVertexData & other);
@@ -66,16 +96,43 @@ class MeshVertexData {
 		/*! Set the local vertex data. The old data is freed.
 			\note Sets dataChanged. */
 		void allocate(uint32_t count, const VertexDescription & vd);
+		/*! Use the read-only memory of @p buffer as local vertex data. The old data is freed.
+			\note Sets dataChanged.
+			\throw std::invalid_argument if the size of the buffer does not match @p count vertices of @p vd.	*/
+		void setExternalData(uint32_t count, const VertexDescription & vd, std::shared_ptr<ExternalMeshBuffer> buffer);
+		//! Returns true iff the local data currently resides in an external buffer.
+		bool hasExternalData()const							{	return static_cast<bool>(externalData);	}
 		void releaseLocalData();
 		void markAsChanged()								{  	dataChanged=true;	}
 		bool hasChanged()const								{  	return dataChanged;	}
-		bool hasLocalData()const							{  	return !binaryData.empty();	}
-		const uint8_t * data()const							{	return binaryData.data();	}
-		uint8_t * data()									{	return binaryData.data();	}
-		size_t dataSize()const								{	return binaryData.size();	}
+		bool hasLocalData()const							{  	return (binaryData && !binaryData->empty()) || hasExternalData();	}
+		//! Returns true iff the local data is currently shared with a copy of this object.
+		bool hasSharedData()const							{	return binaryData && binaryData.use_count() > 1;	}
+		//! Read-only access to the local data; does not copy external or shared data.
+		const uint8_t * data()const;
+		/*! Writable access to the local data.
+			\note If the data resides in an external buffer or is shared with a copy of this object, it is copied first.	*/
+		uint8_t * data()									{	return writableData().data();	}
+		size_t dataSize()const;
+		/*! Pointer to the vertex at position @p index.
+			\note Only available for VertexLayout::INTERLEAVED; throws a std::logic_error otherwise. */
 		const uint8_t * operator[](uint32_t index) const;
 		uint8_t * operator[](uint32_t index);
 
+		// layout
+		VertexLayout getLayout()const						{	return layout;	}
+		/*! Convert the local vertex data into the given layout.
+			\note Sets dataChanged if the layout changes.
+			\throw std::logic_error if the data has to be converted but is not locally available. */
+		void setLayout(VertexLayout newLayout);
+		//! Byte offset of the first value of @p attr relative to data() (and to the begin of the vertex buffer).
+		std::size_t getAttributeOffset(const VertexAttribute & attr)const;
+		//! Distance in bytes between the values of @p attr of two consecutive vertices.
+		std::size_t getAttributeStride(const VertexAttribute & attr)const;
+		//! Pointer to the value of @p attr of the first vertex; the following values are getAttributeStride(attr) bytes apart.
+		const uint8_t * getAttributeData(const VertexAttribute & attr)const	{	return data() + getAttributeOffset(attr);	}
+		uint8_t * getAttributeData(const VertexAttribute & attr)			{	return data() + getAttributeOffset(attr);	}
+
 		// bounding box
 		void updateBoundingBox();
 		const Geometry::Box & getBoundingBox() const		{	return bb;	}
@@ -89,7 +146,9 @@ class MeshVertexData {
 
 
 		// vbo
-		inline bool isUploaded()const						{   return bufferObject.isValid();    }
+		inline bool isUploaded()const						{   return bufferObject.isNotNull() && bufferObject->get().isValid();    }
+		//! (internal) Identifies the vertex buffer; copies of this object sharing the buffer return the same value (nullptr if not uploaded).
+		const void * _getBufferId()const					{	return isUploaded() ? bufferObject.get() : nullptr;	}
 
 		/*! (internal) */
 		void bind(RenderingContext & context, bool useVBO);
@@ -114,8 +173,10 @@ class MeshVertexData {
 		/*! Swap the internal BufferObject. 
 			\note The local data is not changed!
 			\note the size of the new buffer must be equal to that of the old one.
+			\note If the buffer is shared with a copy of this object, it stays with the copy
+				and @p other receives an invalid BufferObject.
 			\note Use only if you know what you are doing!	*/		
-		void _swapBufferObject(BufferObject & other)	{	bufferObject.swap(other);	}
+		void _swapBufferObject(BufferObject & other);
 };
 
 
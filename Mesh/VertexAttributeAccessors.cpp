@@ -13,6 +13,7 @@
 #include <Geometry/Convert.h>
 #include <sstream>
 #include <exception>
+#include <stdexcept>
 
 namespace Rendering {
 
@@ -24,6 +25,18 @@ void VertexAttributeAccessor::throwRangeError(uint32_t index)const {
 	throw std::range_error(s.str());
 }
 
+//! (internal)
+void VertexAttributeAccessor::throwRangeError(uint32_t begin, uint32_t count)const {
+	std::ostringstream s;
+	s << "Trying to access " << count << " vertices beginning at vertex " << begin << " of overall " << vData.getVertexCount() << " vertices.";
+	throw std::range_error(s.str());
+}
+
+//! (internal)
+void VertexAttributeAccessor::throwReadOnlyError()const {
+	throw std::logic_error("Trying to write attribute '" + attribute.getName() + "' using a read-only accessor.");
+}
+
 //! (internal)
 void VertexAttributeAccessor::assertNumValues(uint32_t index, uint32_t count) const {
 	uint32_t num = this->getAttribute().getNumValues();
@@ -40,7 +53,7 @@ static const std::string noAttrErrorMsg("No attribute named '");
 static const std::string unimplementedFormatMsg("Attribute format not implemented for attribute '");
 
 //! (helper)
-static const VertexAttribute & assertAttribute(MeshVertexData & _vData, const Util::StringIdentifier name) {
+static const VertexAttribute & assertAttribute(const MeshVertexData & _vData, const Util::StringIdentifier name) {
 	const VertexAttribute & attr = _vData.getVertexDescription().getAttribute(name);
 	if(attr.empty())
 		throw std::invalid_argument(noAttrErrorMsg + name.toString() + '\'');
@@ -53,8 +66,8 @@ static const VertexAttribute & assertAttribute(MeshVertexData & _vData, const Ut
 /*! ColorAttributeAccessor3f ---|> ColorAttributeAccessor	*/
 class ColorAttributeAccessor3f : public ColorAttributeAccessor {
 	public:
-		ColorAttributeAccessor3f(MeshVertexData & _vData, const VertexAttribute & _attribute) :
-			ColorAttributeAccessor(_vData, _attribute) {}
+		ColorAttributeAccessor3f(const MeshVertexData & _vData, MeshVertexData * _writableVData, const VertexAttribute & _attribute) :
+			ColorAttributeAccessor(_vData, _writableVData, _attribute) {}
 		virtual ~ColorAttributeAccessor3f() {}
 
 		//! ---|> ColorAttributeAccessor
@@ -82,13 +95,31 @@ class ColorAttributeAccessor3f : public ColorAttributeAccessor {
 			float * v = _ptr<float>(index);
 			v[0] = c.getR() , v[1] = c.getG() , v[2] = c.getB();
 		}
+		//! ---|> ColorAttributeAccessor
+		void getColors(uint32_t begin, uint32_t count, Util::Color4f * target)const override {
+			assertRange(begin, count);
+			const float * data = _data<const float>();
+			for(uint32_t i = 0; i < count; ++i) {
+				const float * v = _ptr(data, begin + i);
+				target[i] = Util::Color4f(v[0], v[1], v[2], 1.0);
+			}
+		}
+		//! ---|> ColorAttributeAccessor
+		void setColors(uint32_t begin, uint32_t count, const Util::Color4f * source) override {
+			assertRange(begin, count);
+			float * data = _data<float>();
+			for(uint32_t i = 0; i < count; ++i) {
+				float * v = _ptr(data, begin + i);
+				v[0] = source[i].getR() , v[1] = source[i].getG() , v[2] = source[i].getB();
+			}
+		}
 };
 
 /*! ColorAttributeAccessor4f ---|> ColorAttributeAccessor	*/
 class ColorAttributeAccessor4f : public ColorAttributeAccessor {
 	public:
-		ColorAttributeAccessor4f(MeshVertexData & _vData, const VertexAttribute & _attribute) :
-			ColorAttributeAccessor(_vData, _attribute) {}
+		ColorAttributeAccessor4f(const MeshVertexData & _vData, MeshVertexData * _writableVData, const VertexAttribute & _attribute) :
+			ColorAttributeAccessor(_vData, _writableVData, _attribute) {}
 		virtual ~ColorAttributeAccessor4f() {}
 
 		//! ---|> ColorAttributeAccessor
@@ -116,13 +147,31 @@ class ColorAttributeAccessor4f : public ColorAttributeAccessor {
 			float * v = _ptr<float>(index);
 			v[0] = c.getR() , v[1] = c.getG() , v[2] = c.getB() , v[3] = c.getA();
 		}
+		//! ---|> ColorAttributeAccessor
+		void getColors(uint32_t begin, uint32_t count, Util::Color4f * target)const override {
+			assertRange(begin, count);
+			const float * data = _data<const float>();
+			for(uint32_t i = 0; i < count; ++i) {
+				const float * v = _ptr(data, begin + i);
+				target[i] = Util::Color4f(v[0], v[1], v[2], v[3]);
+			}
+		}
+		//! ---|> ColorAttributeAccessor
+		void setColors(uint32_t begin, uint32_t count, const Util::Color4f * source) override {
+			assertRange(begin, count);
+			float * data = _data<float>();
+			for(uint32_t i = 0; i < count; ++i) {
+				float * v = _ptr(data, begin + i);
+				v[0] = source[i].getR() , v[1] = source[i].getG() , v[2] = source[i].getB() , v[3] = source[i].getA();
+			}
+		}
 };
 
 /*! ColorAttributeAccessor4ub ---|> ColorAttributeAccessor	*/
 class ColorAttributeAccessor4ub : public ColorAttributeAccessor {
 	public:
-		ColorAttributeAccessor4ub(MeshVertexData & _vData, const VertexAttribute & _attribute) :
-			ColorAttributeAccessor(_vData, _attribute) {}
+		ColorAttributeAccessor4ub(const MeshVertexData & _vData, MeshVertexData * _writableVData, const VertexAttribute & _attribute) :
+			ColorAttributeAccessor(_vData, _writableVData, _attribute) {}
 		virtual ~ColorAttributeAccessor4ub() {}
 
 		//! ---|> ColorAttributeAccessor
@@ -150,18 +199,37 @@ class ColorAttributeAccessor4ub : public ColorAttributeAccessor {
 			uint8_t * v = _ptr<uint8_t>(index);
 			v[0] = c.getR() , v[1] = c.getG() , v[2] = c.getB() , v[3] = c.getA();
 		}
+		//! ---|> ColorAttributeAccessor
+		void getColors(uint32_t begin, uint32_t count, Util::Color4f * target)const override {
+			assertRange(begin, count);
+			const uint8_t * data = _data<const uint8_t>();
+			for(uint32_t i = 0; i < count; ++i) {
+				const uint8_t * v = _ptr(data, begin + i);
+				target[i] = Util::Color4ub(v[0], v[1], v[2], v[3]);
+			}
+		}
+		//! ---|> ColorAttributeAccessor
+		void setColors(uint32_t begin, uint32_t count, const Util::Color4f * source) override {
+			assertRange(begin, count);
+			uint8_t * data = _data<uint8_t>();
+			for(uint32_t i = 0; i < count; ++i) {
+				const Util::Color4ub c(source[i]);
+				uint8_t * v = _ptr(data, begin + i);
+				v[0] = c.getR() , v[1] = c.getG() , v[2] = c.getB() , v[3] = c.getA();
+			}
+		}
 };
 
 
 //! (static) Factory
-Util::Reference<ColorAttributeAccessor> ColorAttributeAccessor::create(MeshVertexData & _vData, Util::StringIdentifier name) {
+Util::Reference<ColorAttributeAccessor> ColorAttributeAccessor::create(const MeshVertexData & _vData, MeshVertexData * _writableVData, Util::StringIdentifier name) {
 	const VertexAttribute & attr = assertAttribute(_vData, name);
 	if(attr.getNumValues() >= 4 && attr.getDataType() == GL_FLOAT) {
-		return new ColorAttributeAccessor4f(_vData, attr);
+		return new ColorAttributeAccessor4f(_vData, _writableVData, attr);
 	} else if(attr.getNumValues() >= 3 && attr.getDataType() == GL_FLOAT) {
-		return new ColorAttributeAccessor3f(_vData, attr);
+		return new ColorAttributeAccessor3f(_vData, _writableVData, attr);
 	} else if(attr.getNumValues() >= 4 && attr.getDataType() == GL_UNSIGNED_BYTE) {
-		return new ColorAttributeAccessor4ub(_vData, attr);
+		return new ColorAttributeAccessor4ub(_vData, _writableVData, attr);
 	} else {
 		throw std::invalid_argument(unimplementedFormatMsg + name.toString() + '\'');
 	}
@@ -173,8 +241,8 @@ Util::Reference<ColorAttributeAccessor> ColorAttributeAccessor::create(MeshVerte
 /*! NormalAttributeAccessor4b ---|> NormalAttributeAccessor */
 class NormalAttributeAccessor4b : public NormalAttributeAccessor {
 	public:
-		NormalAttributeAccessor4b(MeshVertexData & _vData, const VertexAttribute & _attribute) :
-			NormalAttributeAccessor(_vData, _attribute) {}
+		NormalAttributeAccessor4b(const MeshVertexData & _vData, MeshVertexData * _writableVData, const VertexAttribute & _attribute) :
+			NormalAttributeAccessor(_vData, _writableVData, _attribute) {}
 		virtual ~NormalAttributeAccessor4b() {}
 
 		//! ---|> NormalAttributeAccessor
@@ -194,13 +262,37 @@ class NormalAttributeAccessor4b : public NormalAttributeAccessor {
 			v[1] = Geometry::Convert::toSigned<int8_t>(n.y());
 			v[2] = Geometry::Convert::toSigned<int8_t>(n.z());
 		}
+
+		//! ---|> NormalAttributeAccessor
+		void getNormals(uint32_t begin, uint32_t count, Geometry::Vec3 * target)const override {
+			assertRange(begin, count);
+			const int8_t * data = _data<const int8_t>();
+			for(uint32_t i = 0; i < count; ++i) {
+				const int8_t * v = _ptr(data, begin + i);
+				target[i] = Geometry::Vec3(Geometry::Convert::fromSignedTo<float>(v[0]),
+										   Geometry::Convert::fromSignedTo<float>(v[1]),
+										   Geometry::Convert::fromSignedTo<float>(v[2]));
+			}
+		}
+
+		//! ---|> NormalAttributeAccessor
+		void setNormals(uint32_t begin, uint32_t count, const Geometry::Vec3 * source) override {
+			assertRange(begin, count);
+			int8_t * data = _data<int8_t>();
+			for(uint32_t i = 0; i < count; ++i) {
+				int8_t * v = _ptr(data, begin + i);
+				v[0] = Geometry::Convert::toSigned<int8_t>(source[i].x());
+				v[1] = Geometry::Convert::toSigned<int8_t>(source[i].y());
+				v[2] = Geometry::Convert::toSigned<int8_t>(source[i].z());
+			}
+		}
 };
 
 /*! NormalAttributeAccessor3f ---|> NormalAttributeAccessor */
 class NormalAttributeAccessor3f : public NormalAttributeAccessor {
 	public:
-		NormalAttributeAccessor3f(MeshVertexData & _vData, const VertexAttribute & _attribute) :
-			NormalAttributeAccessor(_vData, _attribute) {}
+		NormalAttributeAccessor3f(const MeshVertexData & _vData, MeshVertexData * _writableVData, const VertexAttribute & _attribute) :
+			NormalAttributeAccessor(_vData, _writableVData, _attribute) {}
 		virtual ~NormalAttributeAccessor3f() {}
 
 		//! ---|> NormalAttributeAccessor
@@ -216,15 +308,35 @@ class NormalAttributeAccessor3f : public NormalAttributeAccessor {
 			float * v = _ptr<float>(index);
 			v[0] = n.x() , v[1] = n.y() , v[2] = n.z();
 		}
+
+		//! ---|> NormalAttributeAccessor
+		void getNormals(uint32_t begin, uint32_t count, Geometry::Vec3 * target)const override {
+			assertRange(begin, count);
+			const float * data = _data<const float>();
+			for(uint32_t i = 0; i < count; ++i) {
+				const float * v = _ptr(data, begin + i);
+				target[i] = Geometry::Vec3(v[0], v[1], v[2]);
+			}
+		}
+
+		//! ---|> NormalAttributeAccessor
+		void setNormals(uint32_t begin, uint32_t count, const Geometry::Vec3 * source) override {
+			assertRange(begin, count);
+			float * data = _data<float>();
+			for(uint32_t i = 0; i < count; ++i) {
+				float * v = _ptr(data, begin + i);
+				v[0] = source[i].x() , v[1] = source[i].y() , v[2] = source[i].z();
+			}
+		}
 };
 
 //! (static)
-Util::Reference<NormalAttributeAccessor> NormalAttributeAccessor::create(MeshVertexData & _vData, Util::StringIdentifier name) {
+Util::Reference<NormalAttributeAccessor> NormalAttributeAccessor::create(const MeshVertexData & _vData, MeshVertexData * _writableVData, Util::StringIdentifier name) {
 	const VertexAttribute & attr = assertAttribute(_vData, name);
 	if(attr.getNumValues() >= 3 && attr.getDataType() == GL_FLOAT) {
-		return new NormalAttributeAccessor3f(_vData, attr);
+		return new NormalAttributeAccessor3f(_vData, _writableVData, attr);
 	} else if(attr.getNumValues() >= 4 && attr.getDataType() == GL_BYTE) {
-		return new NormalAttributeAccessor4b(_vData, attr);
+		return new NormalAttributeAccessor4b(_vData, _writableVData, attr);
 	} else {
 		throw std::invalid_argument(unimplementedFormatMsg + name.toString() + '\'');
 	}
@@ -234,10 +346,10 @@ Util::Reference<NormalAttributeAccessor> NormalAttributeAccessor::create(MeshVer
 // Position
 
 //! (static)
-Util::Reference<PositionAttributeAccessor> PositionAttributeAccessor::create(MeshVertexData & _vData, Util::StringIdentifier name) {
+Util::Reference<PositionAttributeAccessor> PositionAttributeAccessor::create(const MeshVertexData & _vData, MeshVertexData * _writableVData, Util::StringIdentifier name) {
 	const VertexAttribute & attr = assertAttribute(_vData, name);
 	if(attr.getNumValues() >= 3 && attr.getDataType() == GL_FLOAT) {
-		return new PositionAttributeAccessor(_vData, attr);
+		return new PositionAttributeAccessor(_vData, _writableVData, attr);
 	} else {
 		throw std::invalid_argument(unimplementedFormatMsg + name.toString() + '\'');
 	}
@@ -247,10 +359,10 @@ Util::Reference<PositionAttributeAccessor> PositionAttributeAccessor::create(Mes
 // TexCoord
 
 //! (static)
-Util::Reference<TexCoordAttributeAccessor> TexCoordAttributeAccessor::create(MeshVertexData & _vData, Util::StringIdentifier name) {
+Util::Reference<TexCoordAttributeAccessor> TexCoordAttributeAccessor::create(const MeshVertexData & _vData, MeshVertexData * _writableVData, Util::StringIdentifier name) {
 	const VertexAttribute & attr = assertAttribute(_vData, name);
 	if(attr.getNumValues() == 2 && attr.getDataType() == GL_FLOAT) {
-		return new TexCoordAttributeAccessor(_vData, attr);
+		return new TexCoordAttributeAccessor(_vData, _writableVData, attr);
 	} else {
 		throw std::invalid_argument(unimplementedFormatMsg + name.toString() + '\'');
 	}
@@ -260,10 +372,10 @@ Util::Reference<TexCoordAttributeAccessor> TexCoordAttributeAccessor::create(Mes
 // Float
 
 //! (static)
-Util::Reference<FloatAttributeAccessor> FloatAttributeAccessor::create(MeshVertexData & _vData, Util::StringIdentifier name) {
+Util::Reference<FloatAttributeAccessor> FloatAttributeAccessor::create(const MeshVertexData & _vData, MeshVertexData * _writableVData, Util::StringIdentifier name) {
 	const VertexAttribute & attr = assertAttribute(_vData, name);
 	if(attr.getDataType() == GL_FLOAT) {
-		return new FloatAttributeAccessor(_vData, attr);
+		return new FloatAttributeAccessor(_vData, _writableVData, attr);
 	} else {
 		throw std::invalid_argument(unimplementedFormatMsg + name.toString() + '\'');
 	}
@@ -273,13 +385,24 @@ Util::Reference<FloatAttributeAccessor> FloatAttributeAccessor::create(MeshVerte
 // Unisigned Integer
 
 //! (static)
-Util::Reference<UIntAttributeAccessor> UIntAttributeAccessor::create(MeshVertexData & _vData, Util::StringIdentifier name) {
+Util::Reference<UIntAttributeAccessor> UIntAttributeAccessor::create(const MeshVertexData & _vData, MeshVertexData * _writableVData, Util::StringIdentifier name) {
 	const VertexAttribute & attr = assertAttribute(_vData, name);
 	if(attr.getDataType() == GL_UNSIGNED_INT) {
-		return new UIntAttributeAccessor(_vData, attr);
+		return new UIntAttributeAccessor(_vData, _writableVData, attr);
 	} else {
 		throw std::invalid_argument(unimplementedFormatMsg + name.toString() + '\'');
 	}
 }
 
+// ---------------------------------
+// Typed views
+
+template<> uint32_t getGLDataType<float>()		{	return GL_FLOAT;	}
+template<> uint32_t getGLDataType<int8_t>()		{	return GL_BYTE;	}
+template<> uint32_t getGLDataType<uint8_t>()	{	return GL_UNSIGNED_BYTE;	}
+template<> uint32_t getGLDataType<int16_t>()	{	return GL_SHORT;	}
+template<> uint32_t getGLDataType<uint16_t>()	{	return GL_UNSIGNED_SHORT;	}
+template<> uint32_t getGLDataType<int32_t>()	{	return GL_INT;	}
+template<> uint32_t getGLDataType<uint32_t>()	{	return GL_UNSIGNED_INT;	}
+
 }
@@ -20,35 +20,70 @@
 #include <Util/ReferenceCounter.h>
 #include <Util/References.h>
 #include <Util/Graphics/Color.h>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 namespace Rendering {
 
 /*! Base class of all VertexAttributeAccessor-classes.
+	An accessor created for a const MeshVertexData is read-only: it never copies shared or external data
+	(see MeshVertexData::data()), and its setters throw a std::logic_error. A writable accessor requests writable
+	access from the MeshVertexData once per call of a setter, so shared data is copied on the first write even if
+	the data has been shared after the accessor was created.
+	\note Writing through the same accessor from several threads requires data that is not shared (e.g. by calling
+		MeshVertexData::data() before).
 	\note A VertexAttributeAccessor only stays valid as long as the referenced MeshVertexData is not altered externally! */
 class VertexAttributeAccessor : public Util::ReferenceCounter<VertexAttributeAccessor>{
-		MeshVertexData & vData;
+		const MeshVertexData & vData;
+		//! nullptr for read-only accessors
+		MeshVertexData * const writableVData;
 		const VertexAttribute attribute;
-		const size_t vertexSize;
-		uint8_t * const dataPtr;
+		const size_t stride;
 	protected:
 
-		VertexAttributeAccessor(MeshVertexData & _vData,VertexAttribute _attribute) :
-				ReferenceCounter_t(),vData(_vData),attribute(std::move(_attribute)),
-				vertexSize(_vData.getVertexDescription().getVertexSize()),
-				dataPtr( vData.data() + attribute.getOffset() ) {}
+		//! @p _writableVData is nullptr for a read-only accessor and &_vData otherwise.
+		VertexAttributeAccessor(const MeshVertexData & _vData,MeshVertexData * _writableVData,VertexAttribute _attribute) :
+				ReferenceCounter_t(),vData(_vData),writableVData(_writableVData),attribute(std::move(_attribute)),
+				stride(_vData.getAttributeStride(attribute)) {}
 
 		void assertRange(uint32_t index)const			{	if(index>=vData.getVertexCount()) throwRangeError(index); }
+		void assertRange(uint32_t begin, uint32_t count)const	{	if(count>vData.getVertexCount() || begin>vData.getVertexCount()-count) throwRangeError(begin, count); }
 		void assertNumValues(uint32_t index, uint32_t count) const;
+		size_t getStride()const							{	return stride;	}
 	public:
 		virtual ~VertexAttributeAccessor() {}
 
 		bool checkRange(uint32_t index)const			{	return index<vData.getVertexCount();	}
 		const VertexAttribute & getAttribute()const		{	return attribute;	}
+		bool isReadOnly()const							{	return writableVData == nullptr;	}
 
+		/*! Pointer to the value of the first vertex. A pointer to 'const number_t' is used for reading;
+			a pointer to a non-const type requests writable access (see class description).
+			Functions accessing several vertices resolve the pointer once and use _ptr(data, index). */
 		template<typename number_t>
-		number_t * _ptr(uint32_t index)const			{	return reinterpret_cast<number_t*>(dataPtr+index*vertexSize); }
+		number_t * _data()const							{	return reinterpret_cast<number_t*>(getDataPtr(std::is_const<number_t>())); }
+		//! Pointer to the value of vertex @p index relative to the pointer @p data returned by _data().
+		template<typename number_t>
+		number_t * _ptr(number_t * data, uint32_t index)const {
+			typedef typename std::conditional<std::is_const<number_t>::value, const uint8_t, uint8_t>::type byte_t;
+			return reinterpret_cast<number_t*>(reinterpret_cast<byte_t*>(data)+index*stride);
+		}
+		//! Pointer to the value of vertex @p index (see _data()).
+		template<typename number_t>
+		number_t * _ptr(uint32_t index)const			{	return _ptr(_data<number_t>(), index); }
 	private:
-		void throwRangeError(uint32_t index)const;		
+		const uint8_t * getDataPtr(std::true_type)const	{	return vData.getAttributeData(attribute);	}
+		uint8_t * getDataPtr(std::false_type)const {
+			if(writableVData == nullptr)
+				throwReadOnlyError();
+			return writableVData->getAttributeData(attribute);
+		}
+		void throwRangeError(uint32_t index)const;
+		void throwRangeError(uint32_t begin, uint32_t count)const;
+		void throwReadOnlyError()const;
 };
 
 
@@ -59,13 +94,17 @@ class VertexAttributeAccessor : public Util::ReferenceCounter<VertexAttributeAcc
 	Abstract accessor for colors.*/
 class ColorAttributeAccessor : public VertexAttributeAccessor{
 	protected:
-		ColorAttributeAccessor(MeshVertexData & _vData,const VertexAttribute & _attribute) :
-				VertexAttributeAccessor(_vData,_attribute){}
+		ColorAttributeAccessor(const MeshVertexData & _vData,MeshVertexData * _writableVData,const VertexAttribute & _attribute) :
+				VertexAttributeAccessor(_vData,_writableVData,_attribute){}
+		static Util::Reference<ColorAttributeAccessor> create(const MeshVertexData & _vData,MeshVertexData * _writableVData,Util::StringIdentifier name);
 	public:
 		/*! (static factory)
 			Create a ColorAttributeAccessor for the given MeshVertexData's attribute having the given name.
 			If no Accessor can be created, an std::invalid_argument exception is thrown. */
-		static Util::Reference<ColorAttributeAccessor> create(MeshVertexData & _vData,Util::StringIdentifier name);
+		static Util::Reference<ColorAttributeAccessor> create(MeshVertexData & _vData,Util::StringIdentifier name)			{	return create(_vData,&_vData,name);	}
+		/*! (static factory)
+			Create a read-only ColorAttributeAccessor; it does not copy shared or external data. */
+		static Util::Reference<ColorAttributeAccessor> create(const MeshVertexData & _vData,Util::StringIdentifier name)	{	return create(_vData,nullptr,name);	}
 
 		virtual ~ColorAttributeAccessor(){}
 
@@ -73,6 +112,11 @@ class ColorAttributeAccessor : public VertexAttributeAccessor{
 		virtual Util::Color4ub getColor4ub(uint32_t index)const = 0;
 		virtual void setColor(uint32_t index,const Util::Color4f & c) = 0;
 		virtual void setColor(uint32_t index,const Util::Color4ub & c) = 0;
+
+		//! Read the colors of the vertices [@p begin, @p begin + @p count) into @p target.
+		virtual void getColors(uint32_t begin, uint32_t count, Util::Color4f * target)const = 0;
+		//! Set the colors of the vertices [@p begin, @p begin + @p count) from @p source.
+		virtual void setColors(uint32_t begin, uint32_t count, const Util::Color4f * source) = 0;
 };
 
 // ---------------------------------
@@ -82,18 +126,27 @@ class ColorAttributeAccessor : public VertexAttributeAccessor{
 	Abstract accessor for vertex normals (or tangents etc.)*/
 class NormalAttributeAccessor : public VertexAttributeAccessor{
 	protected:
-		NormalAttributeAccessor(MeshVertexData & _vData,const VertexAttribute & _attribute) :
-				VertexAttributeAccessor(_vData,_attribute){}
+		NormalAttributeAccessor(const MeshVertexData & _vData,MeshVertexData * _writableVData,const VertexAttribute & _attribute) :
+				VertexAttributeAccessor(_vData,_writableVData,_attribute){}
+		static Util::Reference<NormalAttributeAccessor> create(const MeshVertexData & _vData,MeshVertexData * _writableVData,Util::StringIdentifier name);
 	public:
 		/*! (static factory)
 			Create a NormalAttributeAccessor for the given MeshVertexData's attribute having the given name.
 			If no Accessor can be created, an std::invalid_argument exception is thrown. */
-		static Util::Reference<NormalAttributeAccessor> create(MeshVertexData & _vData,Util::StringIdentifier name);
+		static Util::Reference<NormalAttributeAccessor> create(MeshVertexData & _vData,Util::StringIdentifier name)			{	return create(_vData,&_vData,name);	}
+		/*! (static factory)
+			Create a read-only NormalAttributeAccessor; it does not copy shared or external data. */
+		static Util::Reference<NormalAttributeAccessor> create(const MeshVertexData & _vData,Util::StringIdentifier name)	{	return create(_vData,nullptr,name);	}
 
 		virtual ~NormalAttributeAccessor(){}
 
 		virtual Geometry::Vec3 getNormal(uint32_t index)const = 0;
 		virtual void setNormal(uint32_t index,const Geometry::Vec3 & vec) = 0;
+
+		//! Read the normals of the vertices [@p begin, @p begin + @p count) into @p target.
+		virtual void getNormals(uint32_t begin, uint32_t count, Geometry::Vec3 * target)const = 0;
+		//! Set the normals of the vertices [@p begin, @p begin + @p count) from @p source.
+		virtual void setNormals(uint32_t begin, uint32_t count, const Geometry::Vec3 * source) = 0;
 };
 
 // ---------------------------------
@@ -104,13 +157,17 @@ class NormalAttributeAccessor : public VertexAttributeAccessor{
 	\note If someday something else than vec3 is used for storing positions, this has to be implemented using new subclasses! */
 class PositionAttributeAccessor : public VertexAttributeAccessor{
 	protected:
-		PositionAttributeAccessor(MeshVertexData & _vData,const VertexAttribute & _attribute) :
-				VertexAttributeAccessor(_vData,_attribute){}
+		PositionAttributeAccessor(const MeshVertexData & _vData,MeshVertexData * _writableVData,const VertexAttribute & _attribute) :
+				VertexAttributeAccessor(_vData,_writableVData,_attribute){}
+		static Util::Reference<PositionAttributeAccessor> create(const MeshVertexData & _vData,MeshVertexData * _writableVData,Util::StringIdentifier name);
 	public:
 		/*! (static factory)
 			Create a PositionAttributeAccessor for the given MeshVertexData's attribute having the given name.
 			If no Accessor can be created, an std::invalid_argument exception is thrown. */
-		static Util::Reference<PositionAttributeAccessor> create(MeshVertexData & _vData,Util::StringIdentifier name);
+		static Util::Reference<PositionAttributeAccessor> create(MeshVertexData & _vData,Util::StringIdentifier name)			{	return create(_vData,&_vData,name);	}
+		/*! (static factory)
+			Create a read-only PositionAttributeAccessor; it does not copy shared or external data. */
+		static Util::Reference<PositionAttributeAccessor> create(const MeshVertexData & _vData,Util::StringIdentifier name)	{	return create(_vData,nullptr,name);	}
 
 		virtual ~PositionAttributeAccessor(){}
 
@@ -125,6 +182,26 @@ class PositionAttributeAccessor : public VertexAttributeAccessor{
 			float * v=_ptr<float>(index);
 			v[0] = p.x() , v[1] = p.y() , v[2] = p.z();
 		}
+
+		//! Read the positions of the vertices [@p begin, @p begin + @p count) into @p target.
+		void getPositions(uint32_t begin, uint32_t count, Geometry::Vec3 * target)const{
+			assertRange(begin, count);
+			const float * data = _data<const float>();
+			for(uint32_t i = 0; i < count; ++i) {
+				const float * v = _ptr(data, begin + i);
+				target[i] = Geometry::Vec3(v[0],v[1],v[2]);
+			}
+		}
+
+		//! Set the positions of the vertices [@p begin, @p begin + @p count) from @p source.
+		void setPositions(uint32_t begin, uint32_t count, const Geometry::Vec3 * source){
+			assertRange(begin, count);
+			float * data = _data<float>();
+			for(uint32_t i = 0; i < count; ++i) {
+				float * v = _ptr(data, begin + i);
+				v[0] = source[i].x() , v[1] = source[i].y() , v[2] = source[i].z();
+			}
+		}
 };
 
 // ---------------------------------
@@ -135,14 +212,18 @@ class PositionAttributeAccessor : public VertexAttributeAccessor{
 	\note If someday something else than vec2f is used for storing texture coordinates, this has to be implemented using new subclasses! */
 class TexCoordAttributeAccessor : public VertexAttributeAccessor{
 	protected:
-		TexCoordAttributeAccessor(MeshVertexData & _vData,const VertexAttribute & _attribute) :
-				VertexAttributeAccessor(_vData,_attribute){}
+		TexCoordAttributeAccessor(const MeshVertexData & _vData,MeshVertexData * _writableVData,const VertexAttribute & _attribute) :
+				VertexAttributeAccessor(_vData,_writableVData,_attribute){}
+		static Util::Reference<TexCoordAttributeAccessor> create(const MeshVertexData & _vData,MeshVertexData * _writableVData,Util::StringIdentifier name);
 
 	public:
 		/*! (static factory)
 			Create a TexCoordAttributeAccessor for the given MeshVertexData's attribute having the given name.
 			If no Accessor can be created, an std::invalid_argument exception is thrown. */
-		static Util::Reference<TexCoordAttributeAccessor> create(MeshVertexData & _vData,Util::StringIdentifier name);
+		static Util::Reference<TexCoordAttributeAccessor> create(MeshVertexData & _vData,Util::StringIdentifier name)			{	return create(_vData,&_vData,name);	}
+		/*! (static factory)
+			Create a read-only TexCoordAttributeAccessor; it does not copy shared or external data. */
+		static Util::Reference<TexCoordAttributeAccessor> create(const MeshVertexData & _vData,Util::StringIdentifier name)	{	return create(_vData,nullptr,name);	}
 
 		virtual ~TexCoordAttributeAccessor(){}
 
@@ -157,6 +238,26 @@ class TexCoordAttributeAccessor : public VertexAttributeAccessor{
 			float * v=_ptr<float>(index);
 			v[0] = p.x() , v[1] = p.y();
 		}
+
+		//! Read the coordinates of the vertices [@p begin, @p begin + @p count) into @p target.
+		void getCoordinates(uint32_t begin, uint32_t count, Geometry::Vec2 * target)const{
+			assertRange(begin, count);
+			const float * data = _data<const float>();
+			for(uint32_t i = 0; i < count; ++i) {
+				const float * v = _ptr(data, begin + i);
+				target[i] = Geometry::Vec2(v[0],v[1]);
+			}
+		}
+
+		//! Set the coordinates of the vertices [@p begin, @p begin + @p count) from @p source.
+		void setCoordinates(uint32_t begin, uint32_t count, const Geometry::Vec2 * source){
+			assertRange(begin, count);
+			float * data = _data<float>();
+			for(uint32_t i = 0; i < count; ++i) {
+				float * v = _ptr(data, begin + i);
+				v[0] = source[i].x() , v[1] = source[i].y();
+			}
+		}
 };
 
 
@@ -168,13 +269,17 @@ class TexCoordAttributeAccessor : public VertexAttributeAccessor{
 	Accessor for generic float vertex attributes. */
 class FloatAttributeAccessor : public VertexAttributeAccessor{
 	protected:
-		FloatAttributeAccessor(MeshVertexData & _vData,const VertexAttribute & _attribute) :
-				VertexAttributeAccessor(_vData,_attribute){}
+		FloatAttributeAccessor(const MeshVertexData & _vData,MeshVertexData * _writableVData,const VertexAttribute & _attribute) :
+				VertexAttributeAccessor(_vData,_writableVData,_attribute){}
+		static Util::Reference<FloatAttributeAccessor> create(const MeshVertexData & _vData,MeshVertexData * _writableVData,Util::StringIdentifier name);
 	public:
 		/*! (static factory)
 			Create a FloatAttributeAccessor for the given MeshVertexData's attribute having the given name.
 			If no Accessor can be created, an std::invalid_argument exception is thrown. */
-		static Util::Reference<FloatAttributeAccessor> create(MeshVertexData & _vData,Util::StringIdentifier name);
+		static Util::Reference<FloatAttributeAccessor> create(MeshVertexData & _vData,Util::StringIdentifier name)			{	return create(_vData,&_vData,name);	}
+		/*! (static factory)
+			Create a read-only FloatAttributeAccessor; it does not copy shared or external data. */
+		static Util::Reference<FloatAttributeAccessor> create(const MeshVertexData & _vData,Util::StringIdentifier name)	{	return create(_vData,nullptr,name);	}
 
 		virtual ~FloatAttributeAccessor(){}
 
@@ -211,13 +316,17 @@ class FloatAttributeAccessor : public VertexAttributeAccessor{
 	Accessor for generic float vertex attributes. */
 class UIntAttributeAccessor : public VertexAttributeAccessor{
 	protected:
-		UIntAttributeAccessor(MeshVertexData & _vData,const VertexAttribute & _attribute) :
-				VertexAttributeAccessor(_vData,_attribute){}
+		UIntAttributeAccessor(const MeshVertexData & _vData,MeshVertexData * _writableVData,const VertexAttribute & _attribute) :
+				VertexAttributeAccessor(_vData,_writableVData,_attribute){}
+		static Util::Reference<UIntAttributeAccessor> create(const MeshVertexData & _vData,MeshVertexData * _writableVData,Util::StringIdentifier name);
 	public:
 		/*! (static factory)
 			Create a UIntAttributeAccessor for the given MeshVertexData's attribute having the given name.
 			If no Accessor can be created, an std::invalid_argument exception is thrown. */
-		static Util::Reference<UIntAttributeAccessor> create(MeshVertexData & _vData,Util::StringIdentifier name);
+		static Util::Reference<UIntAttributeAccessor> create(MeshVertexData & _vData,Util::StringIdentifier name)			{	return create(_vData,&_vData,name);	}
+		/*! (static factory)
+			Create a read-only UIntAttributeAccessor; it does not copy shared or external data. */
+		static Util::Reference<UIntAttributeAccessor> create(const MeshVertexData & _vData,Util::StringIdentifier name)	{	return create(_vData,nullptr,name);	}
 
 		virtual ~UIntAttributeAccessor(){}
 
@@ -247,5 +356,75 @@ class UIntAttributeAccessor : public VertexAttributeAccessor{
 		}
 };
 
+// ---------------------------------
+// Typed views
+
+//! GL data type corresponding to @p number_t (available for float, int8_t, uint8_t, int16_t, uint16_t, int32_t and uint32_t).
+template<typename number_t> uint32_t getGLDataType();
+template<> uint32_t getGLDataType<float>();
+template<> uint32_t getGLDataType<int8_t>();
+template<> uint32_t getGLDataType<uint8_t>();
+template<> uint32_t getGLDataType<int16_t>();
+template<> uint32_t getGLDataType<uint16_t>();
+template<> uint32_t getGLDataType<int32_t>();
+template<> uint32_t getGLDataType<uint32_t>();
+
+/*! Typed, strided view onto the values of a single vertex attribute.
+	In contrast to the VertexAttributeAccessors, the data type, position and stride of the attribute are
+	resolved once when the view is created; accessing a vertex is a plain (non-virtual, unchecked) pointer computation.
+	Use 'const number_t' to create a read-only view of a const MeshVertexData.
+	\code
+		VertexAttributeView<float> positions(vertexData, vertexData.getVertexDescription().getAttribute(VertexAttributeIds::POSITION));
+		for(uint32_t i = 0; i < positions.size(); ++i)
+			positions[i][1] += 1.0f; // move vertex i up
+	\endcode
+	\note A view only stays valid as long as the referenced MeshVertexData is not altered externally! */
+template<typename number_t>
+class VertexAttributeView {
+		typedef typename std::remove_const<number_t>::type value_t;
+		typedef typename std::conditional<std::is_const<number_t>::value, const uint8_t, uint8_t>::type byte_t;
+
+		byte_t * dataPtr;
+		std::size_t stride;
+		uint32_t count;
+		uint8_t numValues;
+
+		static void assertType(const VertexAttribute & attr) {
+			if(attr.empty() || attr.getDataType() != getGLDataType<value_t>())
+				throw std::invalid_argument("VertexAttributeView: Attribute '" + attr.getName() + "' is missing or has a different data type.");
+		}
+		// read-only views use the const access to avoid copying external data (see MeshVertexData::data())
+		static uint8_t * getData(MeshVertexData & vData, const VertexAttribute & attr, std::false_type) {
+			return vData.getAttributeData(attr);
+		}
+		static const uint8_t * getData(MeshVertexData & vData, const VertexAttribute & attr, std::true_type) {
+			return static_cast<const MeshVertexData &>(vData).getAttributeData(attr);
+		}
+	public:
+		//! \throw std::invalid_argument if the attribute is empty or its data type does not match @p number_t.
+		VertexAttributeView(MeshVertexData & vData, const VertexAttribute & attr) :
+				dataPtr(nullptr), stride(vData.getAttributeStride(attr)), count(vData.getVertexCount()), numValues(attr.getNumValues()) {
+			assertType(attr);
+			dataPtr = getData(vData, attr, std::is_const<number_t>());
+		}
+		//! Read-only view; only available for 'const number_t'.
+		VertexAttributeView(const MeshVertexData & vData, const VertexAttribute & attr) :
+				dataPtr(nullptr), stride(vData.getAttributeStride(attr)), count(vData.getVertexCount()), numValues(attr.getNumValues()) {
+			static_assert(std::is_const<number_t>::value, "A view of a const MeshVertexData requires a const value type.");
+			assertType(attr);
+			dataPtr = vData.getAttributeData(attr);
+		}
+
+		//! Number of vertices
+		uint32_t size()const						{	return count;	}
+		//! Number of values of the attribute per vertex
+		uint8_t getNumValues()const					{	return numValues;	}
+		//! Distance in bytes between the values of two consecutive vertices
+		std::size_t getStride()const				{	return stride;	}
+
+		//! Pointer to the values of vertex @p index (unchecked).
+		number_t * operator[](uint32_t index)const	{	return reinterpret_cast<number_t *>(dataPtr + index * stride);	}
+};
+
 }
 #endif // VERTEXACCESSOR_H
@@ -0,0 +1,137 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MinMaxKernels.h"
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RENDERING_MINMAX_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RENDERING_MINMAX_NEON
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(__AVX2__)
+#define RENDERING_MINMAX_AVX2_DISPATCH
+#endif
+
+namespace Rendering {
+namespace MinMaxKernels {
+
+//! (internal) Scalar reference implementation for one vector.
+static inline void includeVector(const float * p, uint8_t numValues, float * min, float * max) {
+	for(uint_fast8_t dim = 0; dim < numValues; ++dim) {
+		if(p[dim] < min[dim]) {
+			min[dim] = p[dim];
+		}
+		if(p[dim] > max[dim]) {
+			max[dim] = p[dim];
+		}
+	}
+}
+
+void accumulateMinMax(const uint8_t * data, std::size_t count, std::size_t stride, uint8_t numValues, float * min, float * max) {
+	if(count == 0) {
+		return;
+	}
+	std::size_t i = 0;
+#if defined(RENDERING_MINMAX_SSE) || defined(RENDERING_MINMAX_NEON)
+	if(numValues <= 4) {
+		// Four floats are loaded per vector. Unused lanes are ignored, but they must not
+		// be read beyond the end of the data: the remaining vectors are handled by the scalar loop.
+		const std::size_t dataEnd = (count - 1) * stride + numValues * sizeof(float);
+		float minValues[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		float maxValues[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		std::memcpy(minValues, min, numValues * sizeof(float));
+		std::memcpy(maxValues, max, numValues * sizeof(float));
+#if defined(RENDERING_MINMAX_SSE)
+		// _mm_min_ps(a, b) returns (a < b ? a : b) per lane, which matches the scalar comparison.
+		__m128 minVec = _mm_loadu_ps(minValues);
+		__m128 maxVec = _mm_loadu_ps(maxValues);
+		for(; i * stride + 4 * sizeof(float) <= dataEnd; ++i) {
+			const __m128 p = _mm_loadu_ps(reinterpret_cast<const float *>(data + i * stride));
+			minVec = _mm_min_ps(p, minVec);
+			maxVec = _mm_max_ps(p, maxVec);
+		}
+		_mm_storeu_ps(minValues, minVec);
+		_mm_storeu_ps(maxValues, maxVec);
+#else
+		// vminq_f32 propagates NaNs, so the selection is done explicitly.
+		float32x4_t minVec = vld1q_f32(minValues);
+		float32x4_t maxVec = vld1q_f32(maxValues);
+		for(; i * stride + 4 * sizeof(float) <= dataEnd; ++i) {
+			const float32x4_t p = vld1q_f32(reinterpret_cast<const float *>(data + i * stride));
+			minVec = vbslq_f32(vcltq_f32(p, minVec), p, minVec);
+			maxVec = vbslq_f32(vcgtq_f32(p, maxVec), p, maxVec);
+		}
+		vst1q_f32(minValues, minVec);
+		vst1q_f32(maxValues, maxVec);
+#endif
+		std::memcpy(min, minValues, numValues * sizeof(float));
+		std::memcpy(max, maxValues, numValues * sizeof(float));
+	}
+#endif
+	for(; i < count; ++i) {
+		includeVector(reinterpret_cast<const float *>(data + i * stride), numValues, min, max);
+	}
+}
+
+//! (internal) Value based reduction; unlike std::minmax_element, this loop is vectorized by the compiler.
+template<typename index_t>
+static inline void minMaxLoop(const index_t * indices, std::size_t count, index_t & min, index_t & max) {
+	index_t minValue = min;
+	index_t maxValue = max;
+	for(std::size_t i = 0; i < count; ++i) {
+		const index_t value = indices[i];
+		minValue = value < minValue ? value : minValue;
+		maxValue = value > maxValue ? value : maxValue;
+	}
+	min = minValue;
+	max = maxValue;
+}
+
+#ifdef RENDERING_MINMAX_AVX2_DISPATCH
+template<typename index_t>
+__attribute__((target("avx2"))) static void minMaxLoopAVX2(const index_t * indices, std::size_t count, index_t & min, index_t & max) {
+	minMaxLoop(indices, count, min, max);
+}
+
+static bool hasAVX2() {
+	static const bool supported = __builtin_cpu_supports("avx2");
+	return supported;
+}
+#endif
+
+template<typename index_t>
+static void dispatchMinMax(const index_t * indices, std::size_t count, index_t & min, index_t & max) {
+#ifdef RENDERING_MINMAX_AVX2_DISPATCH
+	if(hasAVX2()) {
+		minMaxLoopAVX2(indices, count, min, max);
+		return;
+	}
+#endif
+	minMaxLoop(indices, count, min, max);
+}
+
+void accumulateMinMax(const uint8_t * indices, std::size_t count, uint8_t & min, uint8_t & max) {
+	dispatchMinMax(indices, count, min, max);
+}
+
+void accumulateMinMax(const uint16_t * indices, std::size_t count, uint16_t & min, uint16_t & max) {
+	dispatchMinMax(indices, count, min, max);
+}
+
+void accumulateMinMax(const uint32_t * indices, std::size_t count, uint32_t & min, uint32_t & max) {
+	dispatchMinMax(indices, count, min, max);
+}
+
+}
+}
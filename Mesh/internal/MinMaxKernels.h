@@ -0,0 +1,38 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MINMAXKERNELS_H_
+#define RENDERING_MINMAXKERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Rendering {
+namespace MinMaxKernels {
+
+/*! Update the per component minima and maxima with @a count strided float vectors.
+	@param data Pointer to the first component of the first vector
+	@param stride Distance in bytes between two consecutive vectors
+	@param numValues Number of float components per vector
+	@param min,max Arrays of @a numValues values that are updated in place
+	\note A value @c v replaces the current minimum @c m only if <code>v < m</code>
+		(and analogously for the maximum). Therefore, the result is bit-identical to a
+		simple scalar loop: NaNs are ignored and the first of two equal values (e.g. -0 and +0) is kept.	*/
+void accumulateMinMax(const uint8_t * data, std::size_t count, std::size_t stride, uint8_t numValues, float * min, float * max);
+
+//! Update @a min and @a max with @a count consecutive indices.
+void accumulateMinMax(const uint8_t * indices, std::size_t count, uint8_t & min, uint8_t & max);
+void accumulateMinMax(const uint16_t * indices, std::size_t count, uint16_t & min, uint16_t & max);
+void accumulateMinMax(const uint32_t * indices, std::size_t count, uint32_t & min, uint32_t & max);
+
+}
+}
+
+#endif /* RENDERING_MINMAXKERNELS_H_ */
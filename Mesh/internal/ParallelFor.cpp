@@ -0,0 +1,117 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ParallelFor.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Rendering {
+namespace ParallelFor {
+
+//! (internal) Set while the current thread processes a chunk; nested calls are then processed serially.
+static thread_local bool insideChunk = false;
+
+namespace {
+/*! (internal) Worker threads that are created once and process the chunks of one
+	forEachChunk call at a time together with the calling thread.	*/
+class WorkerPool {
+	private:
+		std::mutex callMutex; //!< Held by the thread whose chunks are currently processed
+		std::mutex mutex; //!< Protects the members below
+		std::condition_variable wakeUp;
+		std::condition_variable finished;
+		std::vector<std::thread> workers;
+		const std::function<void (uint32_t)> * job;
+		uint32_t chunkCount;
+		uint32_t nextChunk;
+		uint32_t pendingChunks;
+		bool quit;
+
+		//! Process chunks of the current job until all of them have been taken.
+		void work(std::unique_lock<std::mutex> & lock) {
+			while(job != nullptr && nextChunk < chunkCount) {
+				const uint32_t chunk = nextChunk++;
+				const auto & fun = *job;
+				lock.unlock();
+				insideChunk = true;
+				fun(chunk);
+				insideChunk = false;
+				lock.lock();
+				if(--pendingChunks == 0) {
+					finished.notify_all();
+				}
+			}
+		}
+
+		void workerLoop() {
+			std::unique_lock<std::mutex> lock(mutex);
+			while(true) {
+				wakeUp.wait(lock, [this] { return quit || (job != nullptr && nextChunk < chunkCount); });
+				if(quit) {
+					return;
+				}
+				work(lock);
+			}
+		}
+
+	public:
+		WorkerPool() : job(nullptr), chunkCount(0), nextChunk(0), pendingChunks(0), quit(false) {
+		}
+		~WorkerPool() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				quit = true;
+			}
+			wakeUp.notify_all();
+			for(auto & worker : workers) {
+				worker.join();
+			}
+		}
+
+		/*! Process the chunks [0, @a count) with the workers and the calling thread.
+			\return @c false without calling @a fun if the pool is in use by another thread.	*/
+		bool run(uint32_t count, const std::function<void (uint32_t)> & fun) {
+			std::unique_lock<std::mutex> callLock(callMutex, std::try_to_lock);
+			if(!callLock.owns_lock()) {
+				return false;
+			}
+			std::unique_lock<std::mutex> lock(mutex);
+			if(workers.empty()) {
+				const unsigned int workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+				for(unsigned int i = 0; i < workerCount; ++i) {
+					workers.emplace_back(&WorkerPool::workerLoop, this);
+				}
+			}
+			job = &fun;
+			chunkCount = count;
+			nextChunk = 0;
+			pendingChunks = count;
+			wakeUp.notify_all();
+			work(lock);
+			finished.wait(lock, [this] { return pendingChunks == 0; });
+			job = nullptr;
+			return true;
+		}
+};
+}
+
+void runChunks(uint32_t chunkCount, const std::function<void (uint32_t)> & fun) {
+	static WorkerPool pool;
+	if(insideChunk || !pool.run(chunkCount, fun)) {
+		for(uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+			fun(chunk);
+		}
+	}
+}
+
+}
+}
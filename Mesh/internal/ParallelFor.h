@@ -0,0 +1,68 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_PARALLELFOR_H_
+#define RENDERING_PARALLELFOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace Rendering {
+namespace ParallelFor {
+
+/*! Return the number of chunks a range of @a count items should be split into
+	so that every chunk contains at least @a minChunkSize items and there are not
+	more chunks than hardware threads. The result is at least one.	*/
+inline uint32_t getChunkCount(std::size_t count, std::size_t minChunkSize) {
+	const std::size_t maxChunks = std::max(1u, std::thread::hardware_concurrency());
+	return static_cast<uint32_t>(std::max<std::size_t>(1, std::min(maxChunks, count / std::max<std::size_t>(1, minChunkSize))));
+}
+
+/*! Call @a fun for every chunk index in [0, @a chunkCount) using the persistent worker
+	threads and the calling thread. Calls made from inside a chunk, or while the workers
+	are busy with the chunks of another thread, are processed serially by the calling thread.
+	@a fun must not throw.	*/
+void runChunks(uint32_t chunkCount, const std::function<void (uint32_t)> & fun);
+
+/*! Split the range [0, @a count) into @a chunkCount contiguous chunks and call
+	<code>fun(chunkIndex, begin, end)</code> for each of them (see runChunks()).
+	The chunk boundaries only depend on @a count and @a chunkCount, so callers can
+	store partial results per chunk and reduce them in a deterministic order.
+	If @a fun throws, the first exception is rethrown after all chunks have finished.	*/
+template<typename Fun>
+void forEachChunk(std::size_t count, uint32_t chunkCount, Fun fun) {
+	if(chunkCount <= 1) {
+		fun(0u, static_cast<std::size_t>(0), count);
+		return;
+	}
+	std::vector<std::exception_ptr> exceptions(chunkCount);
+	runChunks(chunkCount, [&](uint32_t chunk) {
+		try {
+			fun(chunk, count * chunk / chunkCount, count * (chunk + 1) / chunkCount);
+		} catch(...) {
+			exceptions[chunk] = std::current_exception();
+		}
+	});
+	for(const auto & exception : exceptions) {
+		if(exception) {
+			std::rethrow_exception(exception);
+		}
+	}
+}
+
+}
+}
+
+#endif /* RENDERING_PARALLELFOR_H_ */
@@ -0,0 +1,93 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TransformKernels.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RENDERING_TRANSFORM_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RENDERING_TRANSFORM_NEON
+#endif
+
+namespace Rendering {
+namespace TransformKernels {
+
+//! (internal) Scalar reference implementation; the translation is only added to positions.
+template<bool translate>
+static void transformScalar(uint8_t * data, std::size_t count, std::size_t stride, const float * rows) {
+	for(std::size_t i = 0; i < count; ++i) {
+		float * p = reinterpret_cast<float *>(data + i * stride);
+		const float x = p[0];
+		const float y = p[1];
+		const float z = p[2];
+		for(uint_fast8_t row = 0; row < 3; ++row) {
+			const float * m = rows + row * 4;
+			p[row] = translate ? m[0] * x + m[1] * y + m[2] * z + m[3] : m[0] * x + m[1] * y + m[2] * z;
+		}
+	}
+}
+
+template<bool translate>
+static void transform(uint8_t * data, std::size_t count, std::size_t stride, const float * rows) {
+#if defined(RENDERING_TRANSFORM_SSE)
+	// The vector is accumulated column by column (x * column0 + y * column1 + ...),
+	// which sums the products of every row in the same order as the scalar code.
+	const __m128 column0 = _mm_setr_ps(rows[0], rows[4], rows[8], 0.0f);
+	const __m128 column1 = _mm_setr_ps(rows[1], rows[5], rows[9], 0.0f);
+	const __m128 column2 = _mm_setr_ps(rows[2], rows[6], rows[10], 0.0f);
+	const __m128 column3 = _mm_setr_ps(rows[3], rows[7], rows[11], 0.0f);
+	for(std::size_t i = 0; i < count; ++i) {
+		float * p = reinterpret_cast<float *>(data + i * stride);
+		__m128 result = _mm_add_ps(_mm_mul_ps(column0, _mm_load1_ps(p)), _mm_mul_ps(column1, _mm_load1_ps(p + 1)));
+		result = _mm_add_ps(result, _mm_mul_ps(column2, _mm_load1_ps(p + 2)));
+		if(translate) {
+			result = _mm_add_ps(result, column3);
+		}
+		// Store exactly three floats, as the following bytes belong to other attributes.
+		_mm_storel_pi(reinterpret_cast<__m64 *>(p), result);
+		_mm_store_ss(p + 2, _mm_movehl_ps(result, result));
+	}
+#elif defined(RENDERING_TRANSFORM_NEON)
+	// Separate multiplications and additions (instead of vmlaq) keep the rounding of the scalar code.
+	const float column0Values[4] = {rows[0], rows[4], rows[8], 0.0f};
+	const float column1Values[4] = {rows[1], rows[5], rows[9], 0.0f};
+	const float column2Values[4] = {rows[2], rows[6], rows[10], 0.0f};
+	const float column3Values[4] = {rows[3], rows[7], rows[11], 0.0f};
+	const float32x4_t column0 = vld1q_f32(column0Values);
+	const float32x4_t column1 = vld1q_f32(column1Values);
+	const float32x4_t column2 = vld1q_f32(column2Values);
+	const float32x4_t column3 = vld1q_f32(column3Values);
+	for(std::size_t i = 0; i < count; ++i) {
+		float * p = reinterpret_cast<float *>(data + i * stride);
+		float32x4_t result = vaddq_f32(vmulq_n_f32(column0, p[0]), vmulq_n_f32(column1, p[1]));
+		result = vaddq_f32(result, vmulq_n_f32(column2, p[2]));
+		if(translate) {
+			result = vaddq_f32(result, column3);
+		}
+		vst1_f32(p, vget_low_f32(result));
+		vst1q_lane_f32(p + 2, result, 2);
+	}
+#else
+	transformScalar<translate>(data, count, stride, rows);
+#endif
+}
+
+void transformPositions(uint8_t * data, std::size_t count, std::size_t stride, const float * rows) {
+	transform<true>(data, count, stride, rows);
+}
+
+void transformDirections(uint8_t * data, std::size_t count, std::size_t stride, const float * rows) {
+	transform<false>(data, count, stride, rows);
+}
+
+}
+}
@@ -0,0 +1,35 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_TRANSFORMKERNELS_H_
+#define RENDERING_TRANSFORMKERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Rendering {
+namespace TransformKernels {
+
+/*! Transform @a count strided float positions (x,y,z) in place with an affine transformation.
+	@param data Pointer to the x component of the first position
+	@param stride Distance in bytes between two consecutive positions
+	@param rows The first three rows of a row-major 4x4 matrix (12 floats); the last row has to be (0,0,0,1)
+	\note Only the three components of each position are written; the bytes between them are not touched.
+		The products are summed in the same order as by Geometry::Matrix4x4::transformPosition(...).	*/
+void transformPositions(uint8_t * data, std::size_t count, std::size_t stride, const float * rows);
+
+/*! Transform @a count strided float directions (x,y,z) in place with the upper 3x3 part of a matrix.
+	The parameters are the same as for transformPositions(...); the translation column of @a rows is ignored.	*/
+void transformDirections(uint8_t * data, std::size_t count, std::size_t stride, const float * rows);
+
+}
+}
+
+#endif /* RENDERING_TRANSFORMKERNELS_H_ */
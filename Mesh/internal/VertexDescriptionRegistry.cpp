@@ -0,0 +1,86 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "VertexDescriptionRegistry.h"
+#include "../VertexDescription.h"
+#include "../../MeshUtils/MeshUtils.h"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+namespace Rendering {
+namespace VertexDescriptionRegistry {
+
+//! (internal) Registered description; entries are never changed or removed after they have been published.
+struct Entry {
+	Entry(const VertexDescription & _description, uint32_t _hash, uint32_t _id, const Entry * _next) :
+		description(_description), hash(_hash), id(_id), next(_next) {
+	}
+	const VertexDescription description;
+	const uint32_t hash;
+	const uint32_t id;
+	const Entry * const next;
+};
+
+static const std::size_t bucketCount = 64;
+
+//! (internal) Hash table with singly linked buckets. New entries are only prepended to a bucket.
+struct Registry {
+	std::atomic<const Entry *> buckets[bucketCount];
+	std::mutex insertMutex;
+	uint32_t nextId;
+
+	Registry() : insertMutex(), nextId(0) {
+		for(auto & bucket : buckets) {
+			bucket.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+};
+
+/*! (internal) The registry is intentionally never destroyed, because descriptions may still be
+	referenced by static MeshVertexData objects during program termination.	*/
+static Registry & getRegistry() {
+	static Registry * registry = new Registry;
+	return *registry;
+}
+
+static const Entry * findEntry(const Entry * entry, const Entry * end, const VertexDescription & vd, uint32_t hash) {
+	for(; entry != end; entry = entry->next) {
+		if(entry->hash == hash && entry->description == vd) {
+			return entry;
+		}
+	}
+	return nullptr;
+}
+
+const VertexDescription & registerDescription(const VertexDescription & vd, uint32_t & id) {
+	Registry & registry = getRegistry();
+	const uint32_t hash = MeshUtils::calculateHash(vd);
+	std::atomic<const Entry *> & bucket = registry.buckets[hash % bucketCount];
+
+	// fast path: the description is already registered
+	const Entry * head = bucket.load(std::memory_order_acquire);
+	const Entry * entry = findEntry(head, nullptr, vd, hash);
+	if(entry == nullptr) {
+		std::lock_guard<std::mutex> lock(registry.insertMutex);
+		// only the entries added since the first lookup have to be checked again
+		const Entry * newHead = bucket.load(std::memory_order_acquire);
+		entry = findEntry(newHead, head, vd, hash);
+		if(entry == nullptr) {
+			entry = new Entry(vd, hash, registry.nextId++, newHead);
+			bucket.store(entry, std::memory_order_release);
+		}
+	}
+	id = entry->id;
+	return entry->description;
+}
+
+}
+}
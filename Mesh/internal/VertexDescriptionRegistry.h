@@ -0,0 +1,34 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_VERTEXDESCRIPTIONREGISTRY_H_
+#define RENDERING_VERTEXDESCRIPTIONREGISTRY_H_
+
+#include <cstdint>
+
+namespace Rendering {
+class VertexDescription;
+
+/*! Global set of all vertex descriptions used by MeshVertexData objects.
+	Equal descriptions are stored only once, so that they can be compared by address or id.
+	Looking up a description that is already registered does not lock. Only adding a new
+	description takes a lock (this happens only a few times during a program's runtime).	*/
+namespace VertexDescriptionRegistry {
+
+/*! Return the registered description that is equal to @p vd and add a copy of @p vd if there is none.
+	@param id Receives the id of the description. Ids are consecutive numbers starting with zero;
+		two descriptions are equal iff their ids are equal.
+	\note The returned reference is valid until the end of the program.	*/
+const VertexDescription & registerDescription(const VertexDescription & vd, uint32_t & id);
+
+}
+}
+
+#endif /* RENDERING_VERTEXDESCRIPTIONREGISTRY_H_ */
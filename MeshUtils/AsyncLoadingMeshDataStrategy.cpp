@@ -0,0 +1,296 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "AsyncLoadingMeshDataStrategy.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Serialization/Serialization.h"
+#include "../Draw.h"
+#include "../GLHeader.h"
+#include <Util/IO/FileName.h>
+#include <Util/Macros.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Rendering {
+
+//! (internal) Loading of a single mesh file.
+struct LoadJob {
+	explicit LoadJob(Util::FileName _fileName) : fileName(std::move(_fileName)), failed(false), result(), finished(false), cancelled(false) {
+	}
+	const Util::FileName fileName;
+	//! Set by the gl-thread if the file could not be loaded
+	bool failed;
+	// the following members are guarded by Implementation::mutex
+	Util::Reference<Mesh> result;
+	bool finished;
+	bool cancelled;
+};
+
+struct AsyncLoadingMeshDataStrategy::Implementation {
+	typedef std::chrono::steady_clock clock_t;
+
+	mutable std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobFinished;
+	std::deque<std::shared_ptr<LoadJob>> queue;
+	bool stopWorkers;
+	std::vector<std::thread> workers;
+
+	// only accessed by the gl-thread
+	std::unordered_map<Mesh *, std::shared_ptr<LoadJob>> jobs;
+	//! Meshes handled by the strategy; they are set to the default strategy when the strategy is destroyed.
+	std::unordered_set<Mesh *> meshes;
+	std::size_t uploadBytesPerFrame;
+	clock_t::duration uploadTimePerFrame;
+	std::size_t uploadedBytes;
+	clock_t::duration uploadTime;
+	bool drawProxies;
+
+	Implementation() :
+		mutex(), jobAvailable(), jobFinished(), queue(), stopWorkers(false), workers(), jobs(), meshes(),
+		uploadBytesPerFrame(std::numeric_limits<std::size_t>::max()), uploadTimePerFrame(clock_t::duration::max()),
+		uploadedBytes(0), uploadTime(clock_t::duration::zero()), drawProxies(false) {
+	}
+
+	void workerLoop() {
+		std::unique_lock<std::mutex> lock(mutex);
+		while(true) {
+			jobAvailable.wait(lock, [this] { return stopWorkers || !queue.empty(); });
+			if(stopWorkers)
+				return;
+			std::shared_ptr<LoadJob> job = std::move(queue.front());
+			queue.pop_front();
+			if(job->cancelled)
+				continue;
+			lock.unlock();
+			Util::Reference<Mesh> loadedMesh;
+			try {
+				loadedMesh = Serialization::loadMesh(job->fileName);
+			} catch(const std::exception & e) {
+				WARN(std::string("Loading mesh \"") + job->fileName.toString() + "\" failed: " + e.what());
+			}
+			if(loadedMesh.isNull()) {
+				WARN(std::string("Could not load mesh \"") + job->fileName.toString() + '"');
+			}
+			lock.lock();
+			job->result = loadedMesh;
+			job->finished = true;
+			jobFinished.notify_all();
+		}
+	}
+
+	//! Returns true iff @p m has no data, but knows where to get it from.
+	static bool needsData(const Mesh * m) {
+		return m->_getVertexData().empty() && m->_getVertexData().dataSize() == 0 && !m->_getVertexData().isUploaded()
+				&& !m->getFileName().toString().empty();
+	}
+
+	//! Return the job of @p m; the job is created and enqueued if necessary.
+	std::shared_ptr<LoadJob> requestJob(Mesh * m) {
+		auto it = jobs.find(m);
+		if(it != jobs.end())
+			return it->second;
+		auto job = std::make_shared<LoadJob>(m->getFileName());
+		jobs.emplace(m, job);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(job);
+		}
+		jobAvailable.notify_one();
+		return job;
+	}
+
+	/*! If the job of @p m has finished, move the loaded data into @p m.
+		@param wait Block until the job has finished
+		@return true iff the mesh has no pending job anymore	*/
+	bool integrate(Mesh * m, bool wait) {
+		auto it = jobs.find(m);
+		if(it == jobs.end())
+			return true;
+		const std::shared_ptr<LoadJob> job = it->second;
+		Util::Reference<Mesh> loadedMesh;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if(wait)
+				jobFinished.wait(lock, [&job] { return job->finished; });
+			if(!job->finished)
+				return false;
+			loadedMesh = job->result;
+			job->result = nullptr;
+		}
+		if(loadedMesh.isNull()) { // keep the failed job to prevent loading the file again
+			job->failed = true;
+			return true;
+		}
+		jobs.erase(it);
+		m->_getVertexData().swap(loadedMesh->_getVertexData());
+		m->_getIndexData().swap(loadedMesh->_getIndexData());
+		m->setDrawMode(loadedMesh->getDrawMode());
+		m->setUseIndexData(loadedMesh->isUsingIndexData());
+		return true;
+	}
+
+	bool hasUploadBudget() const {
+		return uploadedBytes < uploadBytesPerFrame && uploadTime < uploadTimePerFrame;
+	}
+};
+
+AsyncLoadingMeshDataStrategy::AsyncLoadingMeshDataStrategy(uint32_t workerCount) :
+		MeshDataStrategy(), impl(new Implementation) {
+	for(uint32_t i = 0; i < std::max(1u, workerCount); ++i) {
+		impl->workers.emplace_back(&Implementation::workerLoop, impl.get());
+	}
+}
+
+AsyncLoadingMeshDataStrategy::~AsyncLoadingMeshDataStrategy() {
+	{
+		std::lock_guard<std::mutex> lock(impl->mutex);
+		impl->stopWorkers = true;
+		impl->queue.clear();
+	}
+	impl->jobAvailable.notify_all();
+	for(auto & worker : impl->workers) {
+		worker.join();
+	}
+	// the meshes would otherwise call forgetMesh(...) of a destroyed strategy
+	impl->jobs.clear();
+	const std::unordered_set<Mesh *> meshes(std::move(impl->meshes));
+	impl->meshes.clear();
+	for(const auto & m : meshes)
+		m->setDataStrategy(MeshDataStrategy::getDefaultStrategy());
+}
+
+void AsyncLoadingMeshDataStrategy::setUploadBudget(std::size_t bytesPerFrame, double millisecondsPerFrame) {
+	impl->uploadBytesPerFrame = bytesPerFrame;
+	impl->uploadTimePerFrame = std::chrono::duration_cast<Implementation::clock_t::duration>(std::chrono::duration<double, std::milli>(millisecondsPerFrame));
+}
+
+void AsyncLoadingMeshDataStrategy::setDrawProxies(bool b) {
+	impl->drawProxies = b;
+}
+
+bool AsyncLoadingMeshDataStrategy::getDrawProxies()const {
+	return impl->drawProxies;
+}
+
+void AsyncLoadingMeshDataStrategy::beginFrame() {
+	impl->uploadedBytes = 0;
+	impl->uploadTime = Implementation::clock_t::duration::zero();
+}
+
+void AsyncLoadingMeshDataStrategy::requestLoading(Mesh * m) {
+	impl->meshes.insert(m);
+	if(Implementation::needsData(m))
+		impl->requestJob(m);
+}
+
+std::size_t AsyncLoadingMeshDataStrategy::getPendingCount()const {
+	return static_cast<std::size_t>(std::count_if(impl->jobs.begin(), impl->jobs.end(),
+			[](const std::pair<Mesh * const, std::shared_ptr<LoadJob>> & entry) { return !entry.second->failed; }));
+}
+
+//! ---|> MeshDataStrategy
+void AsyncLoadingMeshDataStrategy::assureLocalVertexData(Mesh * m) {
+	impl->meshes.insert(m);
+	if(Implementation::needsData(m))
+		impl->requestJob(m);
+	impl->integrate(m, true);
+
+	MeshVertexData & vd = m->_getVertexData();
+	if(vd.dataSize() == 0 && vd.isUploaded())
+		vd.download();
+}
+
+//! ---|> MeshDataStrategy
+void AsyncLoadingMeshDataStrategy::assureLocalIndexData(Mesh * m) {
+	impl->meshes.insert(m);
+	if(Implementation::needsData(m))
+		impl->requestJob(m);
+	impl->integrate(m, true);
+
+	MeshIndexData & id = m->_getIndexData();
+	if(id.dataSize() == 0 && id.isUploaded())
+		id.download();
+}
+
+//! ---|> MeshDataStrategy
+void AsyncLoadingMeshDataStrategy::prepare(Mesh * m) {
+	impl->meshes.insert(m);
+	if(Implementation::needsData(m))
+		impl->requestJob(m);
+	if(!impl->integrate(m, false))
+		return;
+
+	MeshIndexData & id = m->_getIndexData();
+	MeshVertexData & vd = m->_getVertexData();
+	const bool uploadIndices = !id.empty() && (id.hasChanged() || !id.isUploaded());
+	const bool uploadVertices = !vd.empty() && (vd.hasChanged() || !vd.isUploaded());
+	if(id.empty() && id.isUploaded()) // "old" VBO present, although data has been removed
+		id.removeGlBuffer();
+	if(vd.empty() && vd.isUploaded())
+		vd.removeGlBuffer();
+	if((!uploadIndices && !uploadVertices) || !impl->hasUploadBudget())
+		return;
+
+	const auto start = Implementation::clock_t::now();
+	if(uploadIndices) {
+		impl->uploadedBytes += id.dataSize();
+		id.upload(GL_STATIC_DRAW);
+	}
+	if(uploadVertices) {
+		impl->uploadedBytes += vd.dataSize();
+		vd.upload(GL_STATIC_DRAW);
+	}
+	impl->uploadTime += Implementation::clock_t::now() - start;
+
+	if(id.isUploaded() && id.hasLocalData())
+		id.releaseLocalData();
+	if(vd.isUploaded() && vd.hasLocalData())
+		vd.releaseLocalData();
+}
+
+//! ---|> MeshDataStrategy
+void AsyncLoadingMeshDataStrategy::displayMesh(RenderingContext & context, Mesh * m, uint32_t startIndex, uint32_t indexCount) {
+	const bool ready = !m->empty() && (!m->isUsingIndexData() || m->_getIndexData().isUploaded()) && m->_getVertexData().isUploaded();
+	if(ready) {
+		MeshDataStrategy::doDisplayMesh(context, m, startIndex, indexCount);
+	} else if(impl->drawProxies) {
+		const auto it = impl->jobs.find(m);
+		if(it != impl->jobs.end() && !it->second->failed)
+			drawWireframeBox(context, m->getBoundingBox());
+	}
+}
+
+//! ---|> MeshDataStrategy
+void AsyncLoadingMeshDataStrategy::forgetMesh(Mesh * m) {
+	impl->meshes.erase(m);
+	auto it = impl->jobs.find(m);
+	if(it == impl->jobs.end())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(impl->mutex);
+		it->second->cancelled = true;
+	}
+	impl->jobs.erase(it);
+}
+
+}
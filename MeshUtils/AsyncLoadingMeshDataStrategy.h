@@ -0,0 +1,75 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_ASYNCLOADINGMESHDATASTRATEGY_H_
+#define RENDERING_ASYNCLOADINGMESHDATASTRATEGY_H_
+
+#include "../Mesh/MeshDataStrategy.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Rendering {
+
+/*! AsyncLoadingMeshDataStrategy ---|> MeshDataStrategy
+	Strategy for meshes whose data is loaded in the background when they are needed.
+	Such a mesh initially contains no data, only its file name (Mesh::setFileName(...)) and
+	its bounding box (Mesh::_setBoundingBox(...)). The first call of prepare(...) or requestLoading(...)
+	enqueues Serialization::loadMesh(...) for the file on one of the strategy's worker threads.
+	Until the data has arrived, nothing or the bounding box (see setDrawProxies(...)) is displayed.
+	The loaded data is moved into the mesh and uploaded on the gl-thread. To avoid stalls, the uploads
+	are limited per frame by a byte and a time budget (see setUploadBudget(...) and beginFrame()).
+	After the upload, the local data is released (as by SimpleMeshDataStrategy::getStaticDrawReleaseLocalStrategy()).
+
+	Meshes having data or not having a file name are handled like by the static draw strategy.
+	\note Except for the loading, all methods have to be called from the gl-thread.
+	\note Do not use this strategy as default strategy (MeshDataStrategy::setDefaultStrategy(...)),
+		because the worker threads create meshes that would then use this strategy as well. */
+class AsyncLoadingMeshDataStrategy : public MeshDataStrategy {
+	public:
+		//! @param workerCount Number of loader threads (at least one is created)
+		explicit AsyncLoadingMeshDataStrategy(uint32_t workerCount = 2);
+		/*! Cancels all pending loads and waits for the worker threads.
+			The meshes handled by the strategy are set to MeshDataStrategy::getDefaultStrategy(). */
+		virtual ~AsyncLoadingMeshDataStrategy();
+
+		/*! Limit the uploads per frame. A mesh is uploaded if the budget has not been used up
+			before, so at least one mesh is uploaded per frame.
+			@param bytesPerFrame Number of bytes uploaded per frame
+			@param millisecondsPerFrame Time spent for uploading per frame */
+		void setUploadBudget(std::size_t bytesPerFrame, double millisecondsPerFrame);
+		//! If enabled, the bounding box of a mesh is drawn as wireframe while its data is loaded.
+		void setDrawProxies(bool b);
+		bool getDrawProxies()const;
+
+		//! Reset the upload budget; has to be called once per frame.
+		void beginFrame();
+
+		//! Start loading the data of @p m (e.g. for prefetching) if it has no data yet.
+		void requestLoading(Mesh * m);
+		//! Number of meshes whose data has been requested, but has not been moved into the mesh yet.
+		std::size_t getPendingCount()const;
+
+		//! Waits until the data of the mesh has been loaded.
+		void assureLocalVertexData(Mesh * m) override;
+		//! Waits until the data of the mesh has been loaded.
+		void assureLocalIndexData(Mesh * m) override;
+		void prepare(Mesh * m) override;
+		void displayMesh(RenderingContext & context, Mesh * m, uint32_t startIndex, uint32_t indexCount) override;
+		void forgetMesh(Mesh * m) override;
+
+	private:
+		struct Implementation;
+		std::unique_ptr<Implementation> impl;
+};
+
+}
+
+#endif /* RENDERING_ASYNCLOADINGMESHDATASTRATEGY_H_ */
@@ -0,0 +1,189 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "BudgetMeshDataStrategy.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexDescription.h"
+#include "../GLHeader.h"
+
+namespace Rendering {
+
+BudgetMeshDataStrategy::BudgetMeshDataStrategy(std::size_t _mainMemoryBudget, std::size_t _graphicsMemoryBudget) :
+		MeshDataStrategy(), mainMemoryBudget(_mainMemoryBudget), graphicsMemoryBudget(_graphicsMemoryBudget),
+		mainMemoryUsage(0), graphicsMemoryUsage(0), lru(), entries(), chargedBuffers() {
+}
+
+BudgetMeshDataStrategy::~BudgetMeshDataStrategy() {
+	// the meshes would otherwise call forgetMesh(...) of a destroyed strategy
+	const std::list<Mesh *> meshes(std::move(lru));
+	entries.clear();
+	for(const auto & m : meshes)
+		m->setDataStrategy(MeshDataStrategy::getDefaultStrategy());
+}
+
+void BudgetMeshDataStrategy::setBudgets(std::size_t newMainMemoryBudget, std::size_t newGraphicsMemoryBudget) {
+	mainMemoryBudget = newMainMemoryBudget;
+	graphicsMemoryBudget = newGraphicsMemoryBudget;
+}
+
+//! (internal)
+BudgetMeshDataStrategy::Entry & BudgetMeshDataStrategy::getEntry(Mesh * m) {
+	auto it = entries.find(m);
+	if(it == entries.end()) {
+		Entry entry;
+		entry.lruPosition = lru.insert(lru.end(), m);
+		entry.buffers.fill(nullptr);
+		it = entries.emplace(m, entry).first;
+		mainMemoryUsage += sizeof(Mesh);
+	}
+	return it->second;
+}
+
+//! (internal)
+void BudgetMeshDataStrategy::chargeBuffer(BufferKind kind, const void * id, std::size_t size) {
+	if(id == nullptr)
+		return;
+	std::size_t & usage = (kind == LOCAL_VERTICES || kind == LOCAL_INDICES) ? mainMemoryUsage : graphicsMemoryUsage;
+	auto it = chargedBuffers.find(id);
+	if(it == chargedBuffers.end()) {
+		ChargedBuffer buffer;
+		buffer.size = 0;
+		buffer.meshCount = 0;
+		it = chargedBuffers.emplace(id, buffer).first;
+	}
+	// the size differs if the memory of a freed buffer has been reused
+	usage = usage - it->second.size + size;
+	it->second.size = size;
+	++it->second.meshCount;
+}
+
+//! (internal)
+void BudgetMeshDataStrategy::releaseBuffer(BufferKind kind, const void * id) {
+	if(id == nullptr)
+		return;
+	const auto it = chargedBuffers.find(id);
+	if(it == chargedBuffers.end() || --it->second.meshCount > 0)
+		return;
+	(kind == LOCAL_VERTICES || kind == LOCAL_INDICES ? mainMemoryUsage : graphicsMemoryUsage) -= it->second.size;
+	chargedBuffers.erase(it);
+}
+
+//! (internal)
+void BudgetMeshDataStrategy::updateUsage(Mesh * m) {
+	Entry & entry = getEntry(m);
+	const MeshVertexData & vd = m->_getVertexData();
+	const MeshIndexData & id = m->_getIndexData();
+	std::array<const void *, BUFFER_KIND_COUNT> buffers;
+	std::array<std::size_t, BUFFER_KIND_COUNT> sizes;
+	// copies of a mesh share the local data (and the buffers) until one of them is written
+	buffers[LOCAL_VERTICES] = vd.dataSize() > 0 ? static_cast<const void *>(vd.data()) : nullptr;
+	sizes[LOCAL_VERTICES] = vd.dataSize();
+	buffers[LOCAL_INDICES] = id.dataSize() > 0 ? static_cast<const void *>(id.rawData()) : nullptr;
+	sizes[LOCAL_INDICES] = id.dataSize();
+	buffers[VERTEX_BUFFER] = vd._getBufferId();
+	sizes[VERTEX_BUFFER] = static_cast<std::size_t>(vd.getVertexCount()) * vd.getVertexDescription().getVertexSize();
+	buffers[INDEX_BUFFER] = id._getBufferId();
+	sizes[INDEX_BUFFER] = static_cast<std::size_t>(id.getIndexCount()) * id.getIndexSize();
+	for(uint8_t kind = 0; kind < BUFFER_KIND_COUNT; ++kind) {
+		releaseBuffer(static_cast<BufferKind>(kind), entry.buffers[kind]);
+		chargeBuffer(static_cast<BufferKind>(kind), buffers[kind], sizes[kind]);
+		entry.buffers[kind] = buffers[kind];
+	}
+}
+
+void BudgetMeshDataStrategy::enforceBudgets(Mesh * keep) {
+	// walk from the least recently displayed mesh to the most recently displayed one
+	for(auto it = lru.rbegin(); it != lru.rend() && (mainMemoryUsage > mainMemoryBudget || graphicsMemoryUsage > graphicsMemoryBudget); ++it) {
+		Mesh * m = *it;
+		if(m == keep)
+			continue;
+		MeshVertexData & vd = m->_getVertexData();
+		MeshIndexData & id = m->_getIndexData();
+		if(mainMemoryUsage > mainMemoryBudget) {
+			// the local data can be restored from the VBO if it has not been changed since the upload
+			if(vd.hasLocalData() && vd.isUploaded() && !vd.hasChanged())
+				vd.releaseLocalData();
+			if(id.hasLocalData() && id.isUploaded() && !id.hasChanged())
+				id.releaseLocalData();
+			updateUsage(m);
+		}
+		if(graphicsMemoryUsage > graphicsMemoryBudget) {
+			// the VBO can be restored from the local data
+			if(vd.isUploaded() && vd.hasLocalData())
+				vd.removeGlBuffer();
+			if(id.isUploaded() && id.hasLocalData())
+				id.removeGlBuffer();
+			updateUsage(m);
+		}
+	}
+}
+
+//! ---|> MeshDataStrategy
+void BudgetMeshDataStrategy::assureLocalVertexData(Mesh * m) {
+	MeshVertexData & vd = m->_getVertexData();
+	if(vd.dataSize() == 0 && vd.isUploaded()) {
+		vd.download();
+		updateUsage(m);
+		enforceBudgets(m);
+	}
+}
+
+//! ---|> MeshDataStrategy
+void BudgetMeshDataStrategy::assureLocalIndexData(Mesh * m) {
+	MeshIndexData & id = m->_getIndexData();
+	if(id.dataSize() == 0 && id.isUploaded()) {
+		id.download();
+		updateUsage(m);
+		enforceBudgets(m);
+	}
+}
+
+//! ---|> MeshDataStrategy
+void BudgetMeshDataStrategy::prepare(Mesh * m) {
+	MeshIndexData & id = m->_getIndexData();
+	if(id.empty() && id.isUploaded()) { // "old" VBO present, although data has been removed
+		id.removeGlBuffer();
+	} else if(!id.empty() && id.hasLocalData() && (id.hasChanged() || !id.isUploaded())) { // data has changed, is new or has been evicted
+		id.upload(GL_STATIC_DRAW);
+	}
+
+	MeshVertexData & vd = m->_getVertexData();
+	if(vd.empty() && vd.isUploaded()) { // "old" VBO present, although data has been removed
+		vd.removeGlBuffer();
+	} else if(!vd.empty() && vd.hasLocalData() && (vd.hasChanged() || !vd.isUploaded())) { // data has changed, is new or has been evicted
+		vd.upload(GL_STATIC_DRAW);
+	}
+	updateUsage(m);
+}
+
+//! ---|> MeshDataStrategy
+void BudgetMeshDataStrategy::displayMesh(RenderingContext & context, Mesh * m, uint32_t startIndex, uint32_t indexCount) {
+	Entry & entry = getEntry(m);
+	lru.splice(lru.begin(), lru, entry.lruPosition);
+	if(!m->empty())
+		MeshDataStrategy::doDisplayMesh(context, m, startIndex, indexCount);
+	enforceBudgets(m);
+}
+
+//! ---|> MeshDataStrategy
+void BudgetMeshDataStrategy::forgetMesh(Mesh * m) {
+	const auto it = entries.find(m);
+	if(it == entries.end())
+		return;
+	for(uint8_t kind = 0; kind < BUFFER_KIND_COUNT; ++kind)
+		releaseBuffer(static_cast<BufferKind>(kind), it->second.buffers[kind]);
+	mainMemoryUsage -= sizeof(Mesh);
+	lru.erase(it->second.lruPosition);
+	entries.erase(it);
+}
+
+}
@@ -0,0 +1,101 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_BUDGETMESHDATASTRATEGY_H_
+#define RENDERING_BUDGETMESHDATASTRATEGY_H_
+
+#include "../Mesh/MeshDataStrategy.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+namespace Rendering {
+
+/*! BudgetMeshDataStrategy ---|> MeshDataStrategy
+	Strategy that bounds the memory used by the meshes using it.
+	Like SimpleMeshDataStrategy::getStaticDrawPreserveLocalStrategy(), the data of a mesh is uploaded
+	into a VBO when it is displayed and the local copy is preserved. The meshes are kept in a list
+	ordered by their last call of displayMesh(...). If the total memory usage exceeds a budget, the least
+	recently displayed meshes lose one of their copies:
+	- If the main memory budget is exceeded, the local data of uploaded meshes is released.
+		It is downloaded again when the local data is accessed (see Mesh::openVertexData()).
+	- If the graphics memory budget is exceeded, the VBOs of meshes that still have a local copy are removed.
+		They are uploaded again when the mesh is displayed the next time.
+	A mesh always keeps at least one copy of its data, so the budgets are soft limits.
+	\note The memory usage of a mesh is updated whenever the strategy handles the mesh.
+		Local data and buffers shared by copies of a mesh (see Mesh::clone()) are counted only once.
+	\note All gl-calls are issued from the methods of MeshDataStrategy, so this class has to be used from the gl-thread. */
+class BudgetMeshDataStrategy : public MeshDataStrategy {
+	public:
+		/*! @param mainMemoryBudget Maximum number of bytes of local mesh data
+			@param graphicsMemoryBudget Maximum number of bytes of mesh data in graphics memory */
+		BudgetMeshDataStrategy(std::size_t mainMemoryBudget, std::size_t graphicsMemoryBudget);
+		//! The meshes still using this strategy are set to MeshDataStrategy::getDefaultStrategy().
+		virtual ~BudgetMeshDataStrategy();
+
+		std::size_t getMainMemoryBudget()const				{	return mainMemoryBudget;	}
+		std::size_t getGraphicsMemoryBudget()const			{	return graphicsMemoryBudget;	}
+		//! Set new budgets; the memory usage is reduced when the next mesh is displayed.
+		void setBudgets(std::size_t newMainMemoryBudget, std::size_t newGraphicsMemoryBudget);
+
+		//! Size of the Mesh objects and their local data handled by this strategy (shared data is counted once).
+		std::size_t getMainMemoryUsage()const				{	return mainMemoryUsage;	}
+		//! Size of the buffers in graphics memory of the meshes handled by this strategy (shared buffers are counted once).
+		std::size_t getGraphicsMemoryUsage()const			{	return graphicsMemoryUsage;	}
+		//! Number of meshes handled by this strategy.
+		std::size_t getMeshCount()const						{	return entries.size();	}
+
+		/*! Reduce the memory usage until it fits into the budgets (as far as possible).
+			@param keep This mesh is not touched (may be nullptr) */
+		void enforceBudgets(Mesh * keep);
+
+		void assureLocalVertexData(Mesh * m) override;
+		void assureLocalIndexData(Mesh * m) override;
+		void prepare(Mesh * m) override;
+		void displayMesh(RenderingContext & context, Mesh * m, uint32_t startIndex, uint32_t indexCount) override;
+		void forgetMesh(Mesh * m) override;
+
+	private:
+		//! Local vertex data, local index data, vertex buffer and index buffer of a mesh.
+		enum BufferKind : uint8_t { LOCAL_VERTICES = 0, LOCAL_INDICES, VERTEX_BUFFER, INDEX_BUFFER, BUFFER_KIND_COUNT };
+		struct Entry {
+			std::list<Mesh *>::iterator lruPosition;
+			//! Identifiers of the buffers currently charged to the mesh (nullptr if there is none)
+			std::array<const void *, BUFFER_KIND_COUNT> buffers;
+		};
+		struct ChargedBuffer {
+			std::size_t size;
+			//! Number of handled meshes sharing the buffer
+			uint32_t meshCount;
+		};
+		std::size_t mainMemoryBudget;
+		std::size_t graphicsMemoryBudget;
+		std::size_t mainMemoryUsage;
+		std::size_t graphicsMemoryUsage;
+		//! Handled meshes; the most recently displayed mesh is at the front.
+		std::list<Mesh *> lru;
+		std::unordered_map<Mesh *, Entry> entries;
+		std::unordered_map<const void *, ChargedBuffer> chargedBuffers;
+
+		//! (internal) Return the entry of @p m; the mesh is added at the back of the list if it is new.
+		Entry & getEntry(Mesh * m);
+		//! (internal) Re-read the buffers of @p m and update the totals.
+		void updateUsage(Mesh * m);
+		//! (internal) Add @p size bytes for the buffer @p id, unless another mesh already shares it.
+		void chargeBuffer(BufferKind kind, const void * id, std::size_t size);
+		//! (internal) Remove the buffer @p id, unless another mesh still shares it.
+		void releaseBuffer(BufferKind kind, const void * id);
+};
+
+}
+
+#endif /* RENDERING_BUDGETMESHDATASTRATEGY_H_ */
@@ -9,17 +9,21 @@
 
 #include "ConnectivityAccessor.h"
 
+#include "../GLHeader.h"
 #include "../Mesh/Mesh.h"
 #include "../Mesh/MeshIndexData.h"
 #include "../Mesh/MeshVertexData.h"
 #include "../Mesh/VertexAttributeAccessors.h"
 #include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/internal/ParallelFor.h"
 
 #include <Util/StringUtils.h>
 
 #include <Geometry/Vec3.h>
 #include <Geometry/Triangle.h>
 
+#include <algorithm>
+#include <atomic>
 #include <limits>
 #include <set>
 
@@ -36,8 +40,8 @@ void ConnectivityAccessor::assertCornerRange(uint32_t cIndex) const {
 }
 
 void ConnectivityAccessor::assertVertexRange(uint32_t vIndex) const {
-	if(vIndex >= vertexCorners.size())
-		throw std::invalid_argument("Trying to access vertex " + Util::StringUtils::toString(vIndex) + " of overall " + Util::StringUtils::toString(vertexCorners.size()) + " vertices.");
+	if(vIndex >= vertexCount)
+		throw std::invalid_argument("Trying to access vertex " + Util::StringUtils::toString(vIndex) + " of overall " + Util::StringUtils::toString(vertexCount) + " vertices.");
 }
 
 void ConnectivityAccessor::assertTriangleRange(uint32_t tIndex) const {
@@ -45,32 +49,162 @@ void ConnectivityAccessor::assertTriangleRange(uint32_t tIndex) const {
 		throw std::invalid_argument("Trying to access triangle " + Util::StringUtils::toString(tIndex) + " of overall " + Util::StringUtils::toString(indices.getIndexCount()/3) + " triangles.");
 }
 
-ConnectivityAccessor::ConnectivityAccessor(Mesh* mesh) : indices(mesh->openIndexData()),
-		posAcc(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION)),
-		triAcc(TriangleAccessor::create(mesh)), meshDataHolder(new LocalMeshDataHolder(mesh)) {
-	vertexCorners.resize(mesh->getVertexCount(), INVALID);
-	triangleNextCorners.resize(indices.getIndexCount(), INVALID);
+//! (internal) Minimal number of triangles or vertices per thread when building the corner lists.
+static const std::size_t minItemsPerChunk = 1 << 15;
 
+/**
+ * (internal) Link all corners to circular lists of corners sharing a vertex.
+ * The corners are sorted by their vertex with a counting sort (count, prefix sum, scatter), so the
+ * lists are built in linear time instead of appending every corner at the end of its vertex's list.
+ * Every list is ordered by increasing corner index; if several threads scatter the corners, the
+ * short list of each vertex is sorted afterwards to keep that order.
+ */
+template<typename index_t>
+static void buildCornerLists(const index_t* indices, std::size_t triangleCount,
+							 std::vector<uint32_t>& vertexCorners, std::vector<uint32_t>& nextCorners) {
+	const uint32_t vertexCount = static_cast<uint32_t>(vertexCorners.size());
+	const uint32_t chunkCount = ParallelFor::getChunkCount(triangleCount, minItemsPerChunk);
+
+	// count the corners of every vertex
+	std::unique_ptr<std::atomic<uint32_t>[]> rowEnds(new std::atomic<uint32_t>[vertexCount]);
+	for(uint32_t v=0; v<vertexCount; ++v)
+		rowEnds[v].store(0, std::memory_order_relaxed);
+	ParallelFor::forEachChunk(triangleCount, chunkCount, [&](uint32_t, std::size_t begin, std::size_t end) {
+		for(std::size_t c=begin*3; c<end*3; ++c) {
+			if(indices[c] >= vertexCount)
+				throw std::invalid_argument("Corner " + Util::StringUtils::toString(c) + " references vertex " + Util::StringUtils::toString(indices[c]) + " of overall " + Util::StringUtils::toString(vertexCount) + " vertices.");
+			rowEnds[indices[c]].fetch_add(1, std::memory_order_relaxed);
+		}
+	});
+
+	// exclusive prefix sum: rowEnds[v] becomes the beginning of the row of v
+	uint32_t cornerCount = 0;
+	for(uint32_t v=0; v<vertexCount; ++v) {
+		const uint32_t count = rowEnds[v].load(std::memory_order_relaxed);
+		rowEnds[v].store(cornerCount, std::memory_order_relaxed);
+		cornerCount += count;
+	}
 
-	// TODO: do this lazy, on demand, and only partially.
-	for(uint32_t i=0; i<indices.getIndexCount(); ++i) {
-		uint32_t c = vertexCorners[indices[i]];
-		if(c == INVALID) {
-			vertexCorners[indices[i]] = i;
-			triangleNextCorners[i] = i;
-		} else {
-			uint32_t j = c;
-			uint32_t nvc = triangleNextCorners[j];
-			while(nvc != INVALID && nvc != c) {
-				j = nvc;
-				nvc = triangleNextCorners[j];
-			}
-			triangleNextCorners[j] = i;
-			triangleNextCorners[i] = c;
+	// scatter the corners into the rows; afterwards, rowEnds[v] is the end of the row of v
+	std::vector<uint32_t> rows(cornerCount);
+	ParallelFor::forEachChunk(triangleCount, chunkCount, [&](uint32_t, std::size_t begin, std::size_t end) {
+		for(std::size_t c=begin*3; c<end*3; ++c)
+			rows[rowEnds[indices[c]].fetch_add(1, std::memory_order_relaxed)] = static_cast<uint32_t>(c);
+	});
+
+	// link the corners of every row to a circular list
+	ParallelFor::forEachChunk(vertexCount, ParallelFor::getChunkCount(vertexCount, minItemsPerChunk), [&](uint32_t, std::size_t begin, std::size_t end) {
+		for(std::size_t v=begin; v<end; ++v) {
+			const uint32_t rowBegin = v == 0 ? 0 : rowEnds[v-1].load(std::memory_order_relaxed);
+			const uint32_t rowEnd = rowEnds[v].load(std::memory_order_relaxed);
+			if(rowBegin == rowEnd)
+				continue;
+			if(chunkCount > 1)
+				std::sort(rows.begin() + rowBegin, rows.begin() + rowEnd);
+			vertexCorners[v] = rows[rowBegin];
+			for(uint32_t r=rowBegin; r+1<rowEnd; ++r)
+				nextCorners[rows[r]] = rows[r+1];
+			nextCorners[rows[rowEnd-1]] = rows[rowBegin];
 		}
+	});
+}
+
+/**
+ * (internal) Link the corners of the given triangles to circular lists of corners sharing a vertex.
+ * Only the vertices used by these triangles get an entry: the (vertex, corner slot) pairs are sorted,
+ * which takes O(k log k) for k triangles, independent of the size of the mesh. Every list is ordered
+ * by increasing corner index.
+ * @param triangles sorted triangle indices; the corners of triangles[i] have the slots 3*i to 3*i+2
+ */
+template<typename index_t>
+static void buildRestrictedCornerLists(const index_t* indices, uint32_t vertexCount, const std::vector<uint32_t>& triangles,
+									   std::vector<uint32_t>& vertices, std::vector<uint32_t>& vertexCorners, std::vector<uint32_t>& nextCorners) {
+	std::vector<std::pair<uint32_t, uint32_t>> vertexSlots; // (vertex, corner slot)
+	vertexSlots.reserve(triangles.size() * 3);
+	for(uint32_t slot=0; slot<triangles.size()*3; ++slot) {
+		const uint32_t c = triangles[slot/3]*3 + slot%3;
+		if(indices[c] >= vertexCount)
+			throw std::invalid_argument("Corner " + Util::StringUtils::toString(c) + " references vertex " + Util::StringUtils::toString(indices[c]) + " of overall " + Util::StringUtils::toString(vertexCount) + " vertices.");
+		vertexSlots.emplace_back(indices[c], slot);
+	}
+	std::sort(vertexSlots.begin(), vertexSlots.end());
+
+	auto getCorner = [&triangles](uint32_t slot) { return triangles[slot/3]*3 + slot%3; };
+	nextCorners.resize(vertexSlots.size(), INVALID);
+	for(std::size_t rowBegin=0; rowBegin<vertexSlots.size(); ) {
+		const uint32_t v = vertexSlots[rowBegin].first;
+		std::size_t rowEnd = rowBegin + 1;
+		while(rowEnd < vertexSlots.size() && vertexSlots[rowEnd].first == v)
+			++rowEnd;
+		vertices.push_back(v);
+		vertexCorners.push_back(getCorner(vertexSlots[rowBegin].second));
+		for(std::size_t r=rowBegin; r+1<rowEnd; ++r)
+			nextCorners[vertexSlots[r].second] = getCorner(vertexSlots[r+1].second);
+		nextCorners[vertexSlots[rowEnd-1].second] = getCorner(vertexSlots[rowBegin].second);
+		rowBegin = rowEnd;
+	}
+}
+
+ConnectivityAccessor::ConnectivityAccessor(Mesh* mesh) : indices(mesh->openIndexData()),
+		posAcc(PositionAttributeAccessor::create(static_cast<const MeshVertexData&>(mesh->openVertexData()), VertexAttributeIds::POSITION)),
+		triAcc(TriangleAccessor::create(mesh)), meshDataHolder(new LocalMeshDataHolder(mesh)),
+		vertexCount(mesh->getVertexCount()), restricted(false) {
+	vertexCorners.resize(vertexCount, INVALID);
+	triangleNextCorners.resize(indices.getIndexCount(), INVALID);
+	// read the indices as stored, without converting them to 32bit
+	const uint8_t* data = indices.rawData();
+	const std::size_t triangleCount = indices.getIndexCount()/3;
+	switch(indices.getIndexType()) {
+		case GL_UNSIGNED_BYTE:
+			buildCornerLists(data, triangleCount, vertexCorners, triangleNextCorners);
+			break;
+		case GL_UNSIGNED_SHORT:
+			buildCornerLists(reinterpret_cast<const uint16_t*>(data), triangleCount, vertexCorners, triangleNextCorners);
+			break;
+		default:
+			buildCornerLists(reinterpret_cast<const uint32_t*>(data), triangleCount, vertexCorners, triangleNextCorners);
+			break;
+	}
+}
+
+ConnectivityAccessor::ConnectivityAccessor(Mesh* mesh, const std::set<uint32_t>& tIndices) : indices(mesh->openIndexData()),
+		posAcc(PositionAttributeAccessor::create(static_cast<const MeshVertexData&>(mesh->openVertexData()), VertexAttributeIds::POSITION)),
+		triAcc(TriangleAccessor::create(mesh)), meshDataHolder(new LocalMeshDataHolder(mesh)),
+		vertexCount(mesh->getVertexCount()), restrictedTriangles(tIndices.begin(), tIndices.end()), restricted(true) {
+	if(!tIndices.empty())
+		assertTriangleRange(*tIndices.rbegin());
+	const uint8_t* data = indices.rawData();
+	switch(indices.getIndexType()) {
+		case GL_UNSIGNED_BYTE:
+			buildRestrictedCornerLists(data, vertexCount, restrictedTriangles, restrictedVertices, vertexCorners, triangleNextCorners);
+			break;
+		case GL_UNSIGNED_SHORT:
+			buildRestrictedCornerLists(reinterpret_cast<const uint16_t*>(data), vertexCount, restrictedTriangles, restrictedVertices, vertexCorners, triangleNextCorners);
+			break;
+		default:
+			buildRestrictedCornerLists(reinterpret_cast<const uint32_t*>(data), vertexCount, restrictedTriangles, restrictedVertices, vertexCorners, triangleNextCorners);
+			break;
 	}
 }
 
+uint32_t ConnectivityAccessor::getVertexSlot(uint32_t vIndex) const {
+	if(!restricted)
+		return vIndex;
+	const auto it = std::lower_bound(restrictedVertices.begin(), restrictedVertices.end(), vIndex);
+	if(it == restrictedVertices.end() || *it != vIndex)
+		return INVALID;
+	return static_cast<uint32_t>(std::distance(restrictedVertices.begin(), it));
+}
+
+uint32_t ConnectivityAccessor::getCornerSlot(uint32_t cIndex) const {
+	if(!restricted)
+		return cIndex;
+	const auto it = std::lower_bound(restrictedTriangles.begin(), restrictedTriangles.end(), cIndex/3);
+	if(it == restrictedTriangles.end() || *it != cIndex/3)
+		return INVALID;
+	return static_cast<uint32_t>(std::distance(restrictedTriangles.begin(), it))*3 + cIndex%3;
+}
+
 //! (static)
 Util::Reference<ConnectivityAccessor> ConnectivityAccessor::create(Mesh* mesh) {
 	if(mesh->isUsingIndexData() && mesh->getDrawMode() == Mesh::DRAW_TRIANGLES) {
@@ -80,6 +214,15 @@ Util::Reference<ConnectivityAccessor> ConnectivityAccessor::create(Mesh* mesh) {
 	}
 }
 
+//! (static)
+Util::Reference<ConnectivityAccessor> ConnectivityAccessor::create(Mesh* mesh, const std::set<uint32_t>& tIndices) {
+	if(mesh->isUsingIndexData() && mesh->getDrawMode() == Mesh::DRAW_TRIANGLES) {
+		return new ConnectivityAccessor(mesh, tIndices);
+	} else {
+		throw std::invalid_argument(unimplementedFormatMsg + '\'');
+	}
+}
+
 Geometry::Vec3 ConnectivityAccessor::getVertex(uint32_t vIndex) const {
 	assertVertexRange(vIndex);
 	return posAcc->getPosition(vIndex);
@@ -93,15 +236,20 @@ TriangleAccessor::TriangleIndices_t ConnectivityAccessor::getTriangle(uint32_t t
 uint32_t ConnectivityAccessor::getCorner(uint32_t vIndex, uint32_t tIndex) const {
 	assertVertexRange(vIndex);
 	assertTriangleRange(tIndex);
-	uint32_t c = vertexCorners[vIndex];
-	while(c != INVALID && c/3 != tIndex)
-		c = triangleNextCorners[c];
+	const uint32_t first = getVertexCorner(vIndex);
+	uint32_t c = first;
+	while(c != INVALID && c/3 != tIndex) {
+		c = triangleNextCorners[getCornerSlot(c)];
+		if(c == first)
+			return INVALID;
+	}
 	return c;
 }
 
 uint32_t ConnectivityAccessor::getVertexCorner(uint32_t vIndex) const {
 	assertVertexRange(vIndex);
-	return vertexCorners[vIndex];
+	const uint32_t slot = getVertexSlot(vIndex);
+	return slot == INVALID ? INVALID : vertexCorners[slot];
 }
 
 uint32_t ConnectivityAccessor::getTriangleCorner(uint32_t tIndex) const {
@@ -121,7 +269,8 @@ uint32_t ConnectivityAccessor::getCornerTriangle(uint32_t cIndex) const {
 
 uint32_t ConnectivityAccessor::getNextVertexCorner(uint32_t cIndex) const {
 	assertCornerRange(cIndex);
-	return triangleNextCorners[cIndex];
+	const uint32_t slot = getCornerSlot(cIndex);
+	return slot == INVALID ? INVALID : triangleNextCorners[slot];
 }
 
 uint32_t ConnectivityAccessor::getNextTriangleCorner(uint32_t cIndex) const {
@@ -133,6 +282,8 @@ uint32_t ConnectivityAccessor::getNextTriangleCorner(uint32_t cIndex) const {
 std::vector<uint32_t> ConnectivityAccessor::getVertexAdjacentTriangles(uint32_t vIndex) const {
 	std::vector<uint32_t> out;
 	uint32_t c = getVertexCorner(vIndex);
+	if(c == INVALID)
+		return out; // vertex is not used (by the accessible triangles)
 	out.push_back(getCornerTriangle(c));
 	uint32_t nc = getNextVertexCorner(c);
 	while(nc != c && nc != INVALID) {
@@ -145,6 +296,8 @@ std::vector<uint32_t> ConnectivityAccessor::getVertexAdjacentTriangles(uint32_t
 std::vector<uint32_t> ConnectivityAccessor::getVertexAdjacentVertices(uint32_t vIndex) const {
 	std::set<uint32_t> out;
 	uint32_t c = getVertexCorner(vIndex);
+	if(c == INVALID)
+		return std::vector<uint32_t>();
 	out.insert(getCornerVertex(getNextTriangleCorner(c)));
 	out.insert(getCornerVertex(getNextTriangleCorner(getNextTriangleCorner(c))));
 	uint32_t nc = getNextVertexCorner(c);
@@ -178,6 +331,8 @@ std::vector<uint32_t> ConnectivityAccessor::getAdjacentTriangles(uint32_t tIndex
 bool ConnectivityAccessor::isBorderEdge(uint32_t vIndex1, uint32_t vIndex2) const {
 	// find an edge with vertex1 and vertex2
 	uint32_t c = getVertexCorner(vIndex1);
+	if(c == INVALID)
+		return false; // not an edge
 	uint32_t ntc = getNextTriangleCorner(c);
 	uint32_t nvc = getNextVertexCorner(c);
 	while(getCornerVertex(ntc) != vIndex2 && nvc != c) {
@@ -17,6 +17,7 @@
 #include <Util/ReferenceCounter.h>
 
 #include <tuple>
+#include <set>
 #include <vector>
 #include <memory>
 
@@ -59,26 +60,54 @@ namespace MeshUtils {
  * c1 - corner of t0 and next triangle corner of c0 (see getNextTriangleCorner)
  * c2 - corner of v1 and next vertex corner of c0 (see getNextVertexCorner)
  * @endverbatim
+ *
+ * The corners of each vertex are linked when the accessor is created; this takes linear time
+ * in the number of corners and uses several threads for large meshes. If only a part of the mesh is
+ * of interest (e.g. the triangles modified by an edit operation), the accessor can be restricted to a set
+ * of triangles. Then, only the corners of these triangles are linked, and all queries about vertex
+ * corners and adjacency ignore the other triangles. The restricted accessor only stores the touched
+ * vertices and corners, so its size and construction time do not depend on the size of the mesh.
  */
 class ConnectivityAccessor : public Util::ReferenceCounter<ConnectivityAccessor> {
 private:
-	MeshIndexData& indices;
+	const MeshIndexData& indices;
 	Util::Reference<PositionAttributeAccessor> posAcc;
 	Util::Reference<TriangleAccessor> triAcc;
 	std::unique_ptr<LocalMeshDataHolder> meshDataHolder;
+	uint32_t vertexCount;
+	//! One corner per vertex (or per entry of restrictedVertices).
 	std::vector<uint32_t> vertexCorners;
+	//! The next corner of the same vertex per corner (or per corner of restrictedTriangles).
 	std::vector<uint32_t> triangleNextCorners;
+	//! Sorted vertices and triangles the accessor is restricted to (only used if @a restricted is true).
+	std::vector<uint32_t> restrictedVertices;
+	std::vector<uint32_t> restrictedTriangles;
+	bool restricted;
+
+	//! (internal) Return the position of the vertex in vertexCorners, or INVALID if it is not accessible.
+	uint32_t getVertexSlot(uint32_t vIndex) const;
+	//! (internal) Return the position of the corner in triangleNextCorners, or INVALID if it is not accessible.
+	uint32_t getCornerSlot(uint32_t cIndex) const;
 protected:
 	void assertCornerRange(uint32_t cIndex) const;
 	void assertVertexRange(uint32_t vIndex) const;
 	void assertTriangleRange(uint32_t tIndex) const;
 	ConnectivityAccessor(Mesh* mesh);
+	ConnectivityAccessor(Mesh* mesh, const std::set<uint32_t>& tIndices);
 public:
 	/*! (static factory)
 		Create a ConnectivityAccessor for the given Mesh.
 		If no Accessor can be created, an std::invalid_argument exception is thrown. */
 	static Util::Reference<ConnectivityAccessor> create(Mesh* mesh);
 
+	/*! (static factory)
+		Create a ConnectivityAccessor for the triangles @a tIndices of the given Mesh.
+		getVertexCorner returns INVALID (0xffffffff) for vertices not used by these triangles,
+		and getNextVertexCorner returns INVALID for corners of other triangles. The adjacency
+		queries return empty lists for such vertices.
+		If no Accessor can be created, an std::invalid_argument exception is thrown. */
+	static Util::Reference<ConnectivityAccessor> create(Mesh* mesh, const std::set<uint32_t>& tIndices);
+
 	virtual ~ConnectivityAccessor() {}
 
 	/**
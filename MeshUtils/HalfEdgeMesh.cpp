@@ -0,0 +1,637 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "HalfEdgeMesh.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../GLHeader.h"
+
+#include <Geometry/Vec3.h>
+#include <Util/StringUtils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+namespace Rendering {
+namespace MeshUtils {
+
+const uint32_t HalfEdgeMesh::INVALID;
+
+//! (internal) Key of a directed edge in the map of border half-edges.
+static inline uint64_t getEdgeKey(uint32_t origin, uint32_t target) {
+	return (static_cast<uint64_t>(origin) << 32) | target;
+}
+
+//! (internal) Linearly interpolate @a count values of type T.
+template<typename T>
+static void interpolateValues(const uint8_t * a, const uint8_t * b, uint8_t * out, uint32_t count, float t) {
+	for(uint32_t i = 0; i < count; ++i) {
+		T valueA, valueB;
+		std::memcpy(&valueA, a + i * sizeof(T), sizeof(T));
+		std::memcpy(&valueB, b + i * sizeof(T), sizeof(T));
+		double value = static_cast<double>(valueA) * (1.0 - t) + static_cast<double>(valueB) * t;
+		if(std::is_integral<T>::value) {
+			value = std::round(value);
+		}
+		const T result = static_cast<T>(value);
+		std::memcpy(out + i * sizeof(T), &result, sizeof(T));
+	}
+}
+
+//! (internal) Interpolate all attributes of two vertices; attributes of unknown types are copied from @a a.
+static void interpolateVertex(const VertexDescription & vd, const uint8_t * a, const uint8_t * b, uint8_t * out, float t) {
+	std::copy(a, a + vd.getVertexSize(), out);
+	for(const auto & attr : vd.getAttributes()) {
+		if(attr.empty()) {
+			continue;
+		}
+		const uint8_t * valuesA = a + attr.getOffset();
+		const uint8_t * valuesB = b + attr.getOffset();
+		uint8_t * values = out + attr.getOffset();
+		switch(attr.getDataType()) {
+			case GL_FLOAT:
+				interpolateValues<GLfloat>(valuesA, valuesB, values, attr.getNumValues(), t);
+				break;
+			case GL_UNSIGNED_BYTE:
+				interpolateValues<GLubyte>(valuesA, valuesB, values, attr.getNumValues(), t);
+				break;
+			case GL_BYTE:
+				interpolateValues<GLbyte>(valuesA, valuesB, values, attr.getNumValues(), t);
+				break;
+			case GL_UNSIGNED_SHORT:
+				interpolateValues<GLushort>(valuesA, valuesB, values, attr.getNumValues(), t);
+				break;
+			case GL_SHORT:
+				interpolateValues<GLshort>(valuesA, valuesB, values, attr.getNumValues(), t);
+				break;
+			case GL_UNSIGNED_INT:
+				interpolateValues<GLuint>(valuesA, valuesB, values, attr.getNumValues(), t);
+				break;
+			case GL_INT:
+				interpolateValues<GLint>(valuesA, valuesB, values, attr.getNumValues(), t);
+				break;
+#ifdef LIB_GL
+			case GL_DOUBLE:
+				interpolateValues<GLdouble>(valuesA, valuesB, values, attr.getNumValues(), t);
+				break;
+#endif /* LIB_GL */
+			default:
+				break;
+		}
+	}
+}
+
+HalfEdgeMesh::HalfEdgeMesh(const VertexDescription & vd) :
+		Util::ReferenceCounter<HalfEdgeMesh>(), vertexDescription(vd), vertexSize(vd.getVertexSize()), positionOffset(0),
+		origins(), twins(), vertexHalfEdges(), vertexFaceCounts(), deletedVertices(), vertexData(), freeVertices(), freeFaces(), borderHalfEdges() {
+	const VertexAttribute & positionAttribute = vd.getAttribute(VertexAttributeIds::POSITION);
+	if(positionAttribute.empty() || positionAttribute.getDataType() != GL_FLOAT || positionAttribute.getNumValues() < 3) {
+		throw std::invalid_argument("HalfEdgeMesh: Vertex positions have to consist of three floats.");
+	}
+	positionOffset = positionAttribute.getOffset();
+}
+
+HalfEdgeMesh::~HalfEdgeMesh() = default;
+
+//! (static)
+Util::Reference<HalfEdgeMesh> HalfEdgeMesh::create(const VertexDescription & vd) {
+	return new HalfEdgeMesh(vd);
+}
+
+//! (static)
+Util::Reference<HalfEdgeMesh> HalfEdgeMesh::create(Mesh * mesh) {
+	if(mesh == nullptr || !mesh->isUsingIndexData() || mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+		throw std::invalid_argument("HalfEdgeMesh: Mesh is not a valid triangle mesh.");
+	}
+	Util::Reference<HalfEdgeMesh> heMesh = new HalfEdgeMesh(mesh->getVertexDescription());
+
+	// The vertex pool needs the vertices as contiguous bytes.
+	MeshVertexData interleavedCopy;
+	const MeshVertexData * sourceVertices = &mesh->openVertexData();
+	if(sourceVertices->getLayout() != VertexLayout::INTERLEAVED) {
+		interleavedCopy = MeshVertexData(*sourceVertices);
+		interleavedCopy.setLayout(VertexLayout::INTERLEAVED);
+		sourceVertices = &interleavedCopy;
+	}
+	const uint32_t vertexCount = sourceVertices->getVertexCount();
+	heMesh->vertexData.assign(sourceVertices->data(), sourceVertices->data() + vertexCount * heMesh->vertexSize);
+	heMesh->vertexHalfEdges.assign(vertexCount, INVALID);
+	heMesh->vertexFaceCounts.assign(vertexCount, 0);
+	heMesh->deletedVertices.assign(vertexCount, false);
+
+	const MeshIndexData & indices = mesh->openIndexData();
+	const uint32_t triangleCount = indices.getIndexCount() / 3;
+	heMesh->origins.assign(triangleCount * 3, INVALID);
+	heMesh->twins.assign(triangleCount * 3, INVALID);
+	for(uint32_t f = 0; f < triangleCount; ++f) {
+		const uint32_t a = indices[f * 3 + 0];
+		const uint32_t b = indices[f * 3 + 1];
+		const uint32_t c = indices[f * 3 + 2];
+		if(a >= vertexCount || b >= vertexCount || c >= vertexCount) {
+			throw std::invalid_argument("HalfEdgeMesh: Triangle " + Util::StringUtils::toString(f) + " references a vertex out of range.");
+		}
+		if(a == b || b == c || c == a) {
+			heMesh->freeFaces.push_back(f);
+			continue;
+		}
+		heMesh->origins[f * 3 + 0] = a;
+		heMesh->origins[f * 3 + 1] = b;
+		heMesh->origins[f * 3 + 2] = c;
+		heMesh->connectFace(f);
+	}
+	// the lowest free slots are reused first
+	std::reverse(heMesh->freeFaces.begin(), heMesh->freeFaces.end());
+	return heMesh;
+}
+
+void HalfEdgeMesh::writeToMesh(Mesh * mesh) const {
+	std::vector<uint32_t> newIndices(vertexHalfEdges.size(), INVALID);
+	uint32_t vertexCount = 0;
+	for(uint32_t v = 0; v < vertexHalfEdges.size(); ++v) {
+		if(!deletedVertices[v]) {
+			newIndices[v] = vertexCount++;
+		}
+	}
+	MeshVertexData & vertices = mesh->openVertexData();
+	vertices.allocate(vertexCount, vertexDescription);
+	uint8_t * targetData = vertices.data();
+	for(uint32_t v = 0; v < vertexHalfEdges.size(); ++v) {
+		if(!deletedVertices[v]) {
+			std::copy(getVertexData(v), getVertexData(v) + vertexSize, targetData + newIndices[v] * vertexSize);
+		}
+	}
+	vertices.updateBoundingBox();
+
+	MeshIndexData & indices = mesh->openIndexData();
+	indices.allocate(getFaceCount() * 3);
+	uint32_t * targetIndices = indices.data();
+	for(uint32_t h = 0; h < origins.size(); h += 3) {
+		if(origins[h] != INVALID) {
+			*targetIndices++ = newIndices[origins[h + 0]];
+			*targetIndices++ = newIndices[origins[h + 1]];
+			*targetIndices++ = newIndices[origins[h + 2]];
+		}
+	}
+	indices.updateIndexRange();
+	mesh->setDrawMode(Mesh::DRAW_TRIANGLES);
+	mesh->setUseIndexData(true);
+}
+
+Mesh * HalfEdgeMesh::buildMesh() const {
+	auto mesh = new Mesh;
+	writeToMesh(mesh);
+	return mesh;
+}
+
+void HalfEdgeMesh::assertVertex(uint32_t vIndex) const {
+	if(vIndex >= vertexHalfEdges.size() || deletedVertices[vIndex]) {
+		throw std::invalid_argument("HalfEdgeMesh: Vertex " + Util::StringUtils::toString(vIndex) + " does not exist.");
+	}
+}
+
+void HalfEdgeMesh::assertFace(uint32_t fIndex) const {
+	if(fIndex >= origins.size() / 3 || origins[fIndex * 3] == INVALID) {
+		throw std::invalid_argument("HalfEdgeMesh: Face " + Util::StringUtils::toString(fIndex) + " does not exist.");
+	}
+}
+
+std::vector<uint32_t> HalfEdgeMesh::getOutgoingHalfEdges(uint32_t vIndex) const {
+	assertVertex(vIndex);
+	std::vector<uint32_t> outgoing;
+	const uint32_t start = vertexHalfEdges[vIndex];
+	if(start == INVALID) {
+		return outgoing;
+	}
+	uint32_t h = start;
+	do {
+		outgoing.push_back(h);
+		h = twins[getPrev(h)];
+	} while(h != INVALID && h != start);
+	if(h == INVALID) {
+		// the fan is open: continue in the other direction
+		for(uint32_t t = twins[start]; t != INVALID; t = twins[h]) {
+			h = getNext(t);
+			outgoing.push_back(h);
+		}
+	}
+	return outgoing;
+}
+
+std::vector<uint32_t> HalfEdgeMesh::getAdjacentVertices(uint32_t vIndex) const {
+	std::vector<uint32_t> vertices;
+	for(const auto & h : getOutgoingHalfEdges(vIndex)) {
+		vertices.push_back(getTarget(h));
+		// the previous half-edge ends at the vertex; at a border, its origin is not the target of an outgoing half-edge
+		vertices.push_back(origins[getPrev(h)]);
+	}
+	std::sort(vertices.begin(), vertices.end());
+	vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+	return vertices;
+}
+
+uint32_t HalfEdgeMesh::findHalfEdge(uint32_t vIndex1, uint32_t vIndex2) const {
+	for(const auto & h : getOutgoingHalfEdges(vIndex1)) {
+		if(getTarget(h) == vIndex2) {
+			return h;
+		}
+	}
+	return INVALID;
+}
+
+bool HalfEdgeMesh::isManifoldVertex(uint32_t vIndex) const {
+	// every face of the fan contains exactly one outgoing half-edge
+	return getOutgoingHalfEdges(vIndex).size() == vertexFaceCounts[vIndex];
+}
+
+bool HalfEdgeMesh::isBorderVertex(uint32_t vIndex) const {
+	for(const auto & h : getOutgoingHalfEdges(vIndex)) {
+		if(twins[h] == INVALID || twins[getPrev(h)] == INVALID) {
+			return true;
+		}
+	}
+	return false;
+}
+
+Geometry::Vec3 HalfEdgeMesh::getPosition(uint32_t vIndex) const {
+	const float * position = reinterpret_cast<const float *>(getVertexData(vIndex) + positionOffset);
+	return Geometry::Vec3(position[0], position[1], position[2]);
+}
+
+void HalfEdgeMesh::setPosition(uint32_t vIndex, const Geometry::Vec3 & position) {
+	float * target = reinterpret_cast<float *>(getVertexData(vIndex) + positionOffset);
+	target[0] = position.getX();
+	target[1] = position.getY();
+	target[2] = position.getZ();
+}
+
+uint32_t HalfEdgeMesh::addVertex(const uint8_t * data) {
+	uint32_t vIndex;
+	if(!freeVertices.empty()) {
+		vIndex = freeVertices.back();
+		freeVertices.pop_back();
+		deletedVertices[vIndex] = false;
+	} else {
+		vIndex = static_cast<uint32_t>(vertexHalfEdges.size());
+		vertexHalfEdges.push_back(INVALID);
+		vertexFaceCounts.push_back(0);
+		deletedVertices.push_back(false);
+		vertexData.resize(vertexData.size() + vertexSize);
+	}
+	vertexHalfEdges[vIndex] = INVALID;
+	if(data != nullptr) {
+		std::copy(data, data + vertexSize, getVertexData(vIndex));
+	} else {
+		std::fill(getVertexData(vIndex), getVertexData(vIndex) + vertexSize, 0);
+	}
+	return vIndex;
+}
+
+uint32_t HalfEdgeMesh::allocateFace() {
+	if(!freeFaces.empty()) {
+		const uint32_t fIndex = freeFaces.back();
+		freeFaces.pop_back();
+		return fIndex;
+	}
+	const uint32_t fIndex = static_cast<uint32_t>(origins.size() / 3);
+	origins.resize(origins.size() + 3, INVALID);
+	twins.resize(twins.size() + 3, INVALID);
+	return fIndex;
+}
+
+void HalfEdgeMesh::releaseFace(uint32_t fIndex) {
+	for(uint32_t h = fIndex * 3; h < fIndex * 3 + 3; ++h) {
+		if(origins[h] != INVALID) {
+			--vertexFaceCounts[origins[h]];
+		}
+		origins[h] = INVALID;
+		twins[h] = INVALID;
+	}
+	freeFaces.push_back(fIndex);
+}
+
+void HalfEdgeMesh::registerBorder(uint32_t hIndex) {
+	// if there already is a border half-edge with the same vertices, the edge is not manifold and the first one is kept
+	borderHalfEdges.emplace(getEdgeKey(origins[hIndex], getTarget(hIndex)), hIndex);
+}
+
+void HalfEdgeMesh::unregisterBorder(uint32_t hIndex) {
+	if(twins[hIndex] != INVALID) {
+		return;
+	}
+	const auto it = borderHalfEdges.find(getEdgeKey(origins[hIndex], getTarget(hIndex)));
+	if(it != borderHalfEdges.end() && it->second == hIndex) {
+		borderHalfEdges.erase(it);
+	}
+}
+
+void HalfEdgeMesh::link(uint32_t hIndex1, uint32_t hIndex2) {
+	if(hIndex1 == INVALID) {
+		std::swap(hIndex1, hIndex2);
+	}
+	if(hIndex1 == INVALID) {
+		return;
+	}
+	twins[hIndex1] = hIndex2;
+	if(hIndex2 == INVALID) {
+		registerBorder(hIndex1);
+	} else {
+		twins[hIndex2] = hIndex1;
+	}
+}
+
+void HalfEdgeMesh::connectFace(uint32_t fIndex) {
+	for(uint32_t h = fIndex * 3; h < fIndex * 3 + 3; ++h) {
+		const uint32_t origin = origins[h];
+		const auto it = borderHalfEdges.find(getEdgeKey(getTarget(h), origin));
+		if(it != borderHalfEdges.end()) {
+			const uint32_t twin = it->second;
+			borderHalfEdges.erase(it);
+			link(h, twin);
+		} else {
+			link(h, INVALID);
+		}
+		if(vertexHalfEdges[origin] == INVALID) {
+			vertexHalfEdges[origin] = h;
+		}
+		++vertexFaceCounts[origin];
+	}
+}
+
+void HalfEdgeMesh::updateVertexHalfEdge(uint32_t vIndex, const std::vector<uint32_t> & candidates) {
+	if(vIndex == INVALID) {
+		return;
+	}
+	const uint32_t current = vertexHalfEdges[vIndex];
+	if(current != INVALID && origins[current] == vIndex) {
+		return;
+	}
+	vertexHalfEdges[vIndex] = INVALID;
+	for(const auto & h : candidates) {
+		if(h != INVALID && origins[h] == vIndex) {
+			vertexHalfEdges[vIndex] = h;
+			return;
+		}
+	}
+}
+
+uint32_t HalfEdgeMesh::addFace(uint32_t vIndex1, uint32_t vIndex2, uint32_t vIndex3) {
+	assertVertex(vIndex1);
+	assertVertex(vIndex2);
+	assertVertex(vIndex3);
+	if(vIndex1 == vIndex2 || vIndex2 == vIndex3 || vIndex3 == vIndex1) {
+		throw std::invalid_argument("HalfEdgeMesh: The vertices of a face have to be different.");
+	}
+	const uint32_t fIndex = allocateFace();
+	origins[fIndex * 3 + 0] = vIndex1;
+	origins[fIndex * 3 + 1] = vIndex2;
+	origins[fIndex * 3 + 2] = vIndex3;
+	connectFace(fIndex);
+	return fIndex;
+}
+
+void HalfEdgeMesh::deleteFace(uint32_t fIndex) {
+	assertFace(fIndex);
+	// the half-edges of the neighbouring faces starting at the vertices of the face
+	std::vector<uint32_t> candidates;
+	for(uint32_t h = fIndex * 3; h < fIndex * 3 + 3; ++h) {
+		candidates.push_back(twins[getPrev(h)]);
+		candidates.push_back(twins[h] != INVALID ? getNext(twins[h]) : INVALID);
+	}
+	const uint32_t vertices[3] = {origins[fIndex * 3 + 0], origins[fIndex * 3 + 1], origins[fIndex * 3 + 2]};
+	for(uint32_t h = fIndex * 3; h < fIndex * 3 + 3; ++h) {
+		unregisterBorder(h);
+		const uint32_t twin = twins[h];
+		if(twin != INVALID) {
+			twins[twin] = INVALID;
+			registerBorder(twin);
+		}
+	}
+	releaseFace(fIndex);
+	for(const auto & v : vertices) {
+		updateVertexHalfEdge(v, candidates);
+	}
+}
+
+uint32_t HalfEdgeMesh::splitEdge(uint32_t hIndex, float t) {
+	if(hIndex >= origins.size()) {
+		throw std::invalid_argument("HalfEdgeMesh: Half-edge " + Util::StringUtils::toString(hIndex) + " does not exist.");
+	}
+	assertFace(getFace(hIndex));
+	// face (a, b, c) and the face (b, a, d) on the other side
+	const uint32_t h1 = getNext(hIndex);
+	const uint32_t h2 = getPrev(hIndex);
+	const uint32_t a = origins[hIndex];
+	const uint32_t b = origins[h1];
+	const uint32_t c = origins[h2];
+	const uint32_t twin = twins[hIndex];
+	const uint32_t twinH1 = twins[h1];
+	unregisterBorder(hIndex);
+	unregisterBorder(h1);
+
+	const uint32_t m = addVertex(nullptr);
+	interpolateVertex(vertexDescription, getVertexData(a), getVertexData(b), getVertexData(m), t);
+
+	// (a, b, c) becomes (a, m, c); new face (m, b, c)
+	const uint32_t n0 = allocateFace() * 3;
+	origins[h1] = m;
+	origins[n0 + 0] = m;
+	origins[n0 + 1] = b;
+	origins[n0 + 2] = c;
+	link(h1, n0 + 2);
+	link(n0 + 1, twinH1);
+	vertexFaceCounts[m] += 2;
+	++vertexFaceCounts[c];
+	if(twin != INVALID) {
+		// (b, a, d) becomes (m, a, d); new face (b, m, d)
+		const uint32_t t2 = getPrev(twin);
+		const uint32_t d = origins[t2];
+		const uint32_t twinT2 = twins[t2];
+		unregisterBorder(t2);
+		const uint32_t k0 = allocateFace() * 3;
+		origins[twin] = m;
+		origins[k0 + 0] = b;
+		origins[k0 + 1] = m;
+		origins[k0 + 2] = d;
+		link(t2, k0 + 1);
+		link(k0 + 2, twinT2);
+		link(hIndex, twin);
+		link(n0, k0);
+		vertexFaceCounts[m] += 2;
+		++vertexFaceCounts[d];
+	} else {
+		link(hIndex, INVALID);
+		link(n0, INVALID);
+	}
+	vertexHalfEdges[m] = h1;
+	vertexHalfEdges[b] = n0 + 1;
+	return m;
+}
+
+bool HalfEdgeMesh::flipEdge(uint32_t hIndex) {
+	if(hIndex >= origins.size()) {
+		throw std::invalid_argument("HalfEdgeMesh: Half-edge " + Util::StringUtils::toString(hIndex) + " does not exist.");
+	}
+	assertFace(getFace(hIndex));
+	const uint32_t twin = twins[hIndex];
+	if(twin == INVALID) {
+		return false;
+	}
+	// faces (a, b, c) and (b, a, d) become (c, a, d) and (d, b, c)
+	const uint32_t h1 = getNext(hIndex);
+	const uint32_t h2 = getPrev(hIndex);
+	const uint32_t t1 = getNext(twin);
+	const uint32_t t2 = getPrev(twin);
+	const uint32_t a = origins[hIndex];
+	const uint32_t b = origins[h1];
+	const uint32_t c = origins[h2];
+	const uint32_t d = origins[t2];
+	if(c == d || findHalfEdge(c, d) != INVALID || findHalfEdge(d, c) != INVALID) {
+		return false;
+	}
+	const uint32_t twinH1 = twins[h1];
+	const uint32_t twinH2 = twins[h2];
+	const uint32_t twinT1 = twins[t1];
+	const uint32_t twinT2 = twins[t2];
+	for(const auto & h : {h1, h2, t1, t2}) {
+		unregisterBorder(h);
+	}
+	origins[hIndex] = c;
+	origins[h1] = a;
+	origins[h2] = d;
+	origins[twin] = d;
+	origins[t1] = b;
+	origins[t2] = c;
+	link(hIndex, twinH2);
+	link(h1, twinT1);
+	link(h2, t2);
+	link(twin, twinT2);
+	link(t1, twinH1);
+	vertexHalfEdges[a] = h1;
+	vertexHalfEdges[b] = t1;
+	vertexHalfEdges[c] = t2;
+	vertexHalfEdges[d] = h2;
+	--vertexFaceCounts[a];
+	--vertexFaceCounts[b];
+	++vertexFaceCounts[c];
+	++vertexFaceCounts[d];
+	return true;
+}
+
+bool HalfEdgeMesh::isCollapseAllowed(uint32_t hIndex) const {
+	if(hIndex >= origins.size()) {
+		throw std::invalid_argument("HalfEdgeMesh: Half-edge " + Util::StringUtils::toString(hIndex) + " does not exist.");
+	}
+	assertFace(getFace(hIndex));
+	const uint32_t a = origins[hIndex];
+	const uint32_t b = getTarget(hIndex);
+	const uint32_t c = origins[getPrev(hIndex)];
+	const uint32_t twin = twins[hIndex];
+	const uint32_t d = twin == INVALID ? INVALID : origins[getPrev(twin)];
+
+	// the half-edges of further fans could not be moved to the target
+	if(!isManifoldVertex(a) || !isManifoldVertex(b)) {
+		return false;
+	}
+	const std::vector<uint32_t> neighboursA = getAdjacentVertices(a);
+	const std::vector<uint32_t> neighboursB = getAdjacentVertices(b);
+	std::vector<uint32_t> commonNeighbours;
+	std::set_intersection(neighboursA.begin(), neighboursA.end(), neighboursB.begin(), neighboursB.end(), std::back_inserter(commonNeighbours));
+	for(const auto & v : commonNeighbours) {
+		if(v != c && v != d) {
+			return false;
+		}
+	}
+	if(twin != INVALID) {
+		// an inner edge between two border vertices would pinch the surface
+		if(isBorderVertex(a) && isBorderVertex(b)) {
+			return false;
+		}
+		// a tetrahedron would collapse into two faces on top of each other
+		if(neighboursA.size() == 3 && neighboursB.size() == 3) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool HalfEdgeMesh::collapseEdge(uint32_t hIndex) {
+	if(!isCollapseAllowed(hIndex)) {
+		return false;
+	}
+	// face (a, b, c) and the face (b, a, d) on the other side are removed
+	const uint32_t h1 = getNext(hIndex);
+	const uint32_t h2 = getPrev(hIndex);
+	const uint32_t a = origins[hIndex];
+	const uint32_t b = origins[h1];
+	const uint32_t c = origins[h2];
+	const uint32_t twin = twins[hIndex];
+	const uint32_t t1 = twin == INVALID ? INVALID : getNext(twin);
+	const uint32_t t2 = twin == INVALID ? INVALID : getPrev(twin);
+	const uint32_t d = twin == INVALID ? INVALID : origins[t2];
+	const uint32_t twinH1 = twins[h1];
+	const uint32_t twinH2 = twins[h2];
+	const uint32_t twinT1 = twin == INVALID ? INVALID : twins[t1];
+	const uint32_t twinT2 = twin == INVALID ? INVALID : twins[t2];
+
+	// the keys of the border half-edges starting or ending at a change
+	const std::vector<uint32_t> outgoing = getOutgoingHalfEdges(a);
+	for(const auto & h : outgoing) {
+		unregisterBorder(h);
+		unregisterBorder(getPrev(h));
+	}
+	unregisterBorder(h1);
+	if(twin != INVALID) {
+		unregisterBorder(t2);
+	}
+
+	for(const auto & h : outgoing) {
+		origins[h] = b;
+	}
+	vertexFaceCounts[b] += vertexFaceCounts[a];
+	vertexFaceCounts[a] = 0;
+	releaseFace(getFace(hIndex));
+	if(twin != INVALID) {
+		releaseFace(getFace(twin));
+	}
+	link(twinH1, twinH2);
+	link(twinT1, twinT2);
+	for(const auto & h : outgoing) {
+		if(origins[h] == INVALID) {
+			continue;
+		}
+		if(twins[h] == INVALID) {
+			registerBorder(h);
+		}
+		if(twins[getPrev(h)] == INVALID) {
+			registerBorder(getPrev(h));
+		}
+	}
+
+	deletedVertices[a] = true;
+	vertexHalfEdges[a] = INVALID;
+	freeVertices.push_back(a);
+	std::vector<uint32_t> candidates{twinH1, twinH2, twinT1, twinT2};
+	candidates.push_back(twinH2 != INVALID ? getNext(twinH2) : INVALID);
+	candidates.push_back(twinT2 != INVALID ? getNext(twinT2) : INVALID);
+	candidates.insert(candidates.end(), outgoing.begin(), outgoing.end());
+	updateVertexHalfEdge(b, candidates);
+	updateVertexHalfEdge(c, candidates);
+	updateVertexHalfEdge(d, candidates);
+	return true;
+}
+
+}
+}
@@ -0,0 +1,201 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_HALFEDGEMESH_H_
+#define RENDERING_HALFEDGEMESH_H_
+
+#include "../Mesh/VertexDescription.h"
+
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Vec3;
+typedef _Vec3<float> Vec3;
+}
+
+namespace Rendering {
+class Mesh;
+namespace MeshUtils {
+
+/**
+ * Editable triangle mesh in a compact, index based half-edge representation.
+ *
+ * The half-edges of face f have the indices 3f, 3f+1 and 3f+2, so the face, the next and the previous
+ * half-edge of a half-edge are computed from its index. Per half-edge, only its origin vertex and
+ * its opposite (twin) half-edge are stored; per vertex, one outgoing half-edge is stored.
+ * When created from a Mesh, the vertex and triangle indices are kept: half-edge 3t+i starts at the
+ * i-th vertex of triangle t.
+ *
+ * The vertex attributes are stored in one contiguous pool with the layout of the VertexDescription
+ * (like interleaved MeshVertexData). Deleted vertices and faces are only marked and their slots are
+ * reused by new elements, so an editing operation only touches the elements around the edited edge or face:
+ * addFace, deleteFace and splitEdge take constant (expected) time; flipEdge, collapseEdge and the
+ * queries about vertices take time linear in the valence of the involved vertices.
+ * buildMesh() and writeToMesh() skip the deleted elements.
+ *
+ * Only orientable, manifold parts are represented completely: a third face at an edge stays
+ * unconnected at that edge, and the outgoing half-edges of a vertex only cover one fan of faces
+ * (see isManifoldVertex()).
+ */
+class HalfEdgeMesh : public Util::ReferenceCounter<HalfEdgeMesh> {
+	public:
+		static const uint32_t INVALID = 0xffffffff;
+
+		/*! (static factory)
+			Create a half-edge mesh from the vertices and triangles of the given mesh.
+			Degenerate triangles become deleted faces.
+			If the mesh does not consist of indexed triangles with float positions, or if an index
+			is out of range, an std::invalid_argument exception is thrown. */
+		static Util::Reference<HalfEdgeMesh> create(Mesh * mesh);
+
+		/*! (static factory)
+			Create an empty half-edge mesh for vertices of the given description.
+			If the description has no float positions, an std::invalid_argument exception is thrown. */
+		static Util::Reference<HalfEdgeMesh> create(const VertexDescription & vd);
+
+		~HalfEdgeMesh();
+
+		//! Create a new mesh from the vertices and faces that are not deleted.
+		Mesh * buildMesh() const;
+
+		/*! Replace the vertex and index data of the given mesh by the vertices and faces that are not deleted.
+			The remaining vertices and faces keep their order, so the indices stay valid if nothing has been deleted. */
+		void writeToMesh(Mesh * mesh) const;
+
+		const VertexDescription & getVertexDescription() const	{	return vertexDescription;	}
+
+		//! Number of vertices that are not deleted.
+		uint32_t getVertexCount() const					{	return static_cast<uint32_t>(vertexHalfEdges.size() - freeVertices.size());	}
+		//! Number of faces that are not deleted.
+		uint32_t getFaceCount() const					{	return static_cast<uint32_t>(origins.size() / 3 - freeFaces.size());	}
+		//! Upper bound of the vertex indices (including deleted vertices).
+		uint32_t getVertexSlotCount() const				{	return static_cast<uint32_t>(vertexHalfEdges.size());	}
+		//! Upper bound of the face indices (including deleted faces).
+		uint32_t getFaceSlotCount() const				{	return static_cast<uint32_t>(origins.size() / 3);	}
+
+		bool isVertexDeleted(uint32_t vIndex) const		{	return deletedVertices.at(vIndex);	}
+		bool isFaceDeleted(uint32_t fIndex) const		{	return origins.at(fIndex * 3) == INVALID;	}
+
+		/*! @name Topology
+			The half-edge and face indices are not checked; they have to belong to faces that are not deleted. */
+		// @{
+		static uint32_t getFace(uint32_t hIndex)				{	return hIndex / 3;	}
+		static uint32_t getFaceHalfEdge(uint32_t fIndex)		{	return fIndex * 3;	}
+		static uint32_t getNext(uint32_t hIndex)				{	return hIndex % 3 == 2 ? hIndex - 2 : hIndex + 1;	}
+		static uint32_t getPrev(uint32_t hIndex)				{	return hIndex % 3 == 0 ? hIndex + 2 : hIndex - 1;	}
+		uint32_t getOrigin(uint32_t hIndex) const				{	return origins[hIndex];	}
+		uint32_t getTarget(uint32_t hIndex) const				{	return origins[getNext(hIndex)];	}
+		//! Opposite half-edge or INVALID at a border.
+		uint32_t getTwin(uint32_t hIndex) const					{	return twins[hIndex];	}
+		bool isBorder(uint32_t hIndex) const					{	return twins[hIndex] == INVALID;	}
+		//! One of the half-edges starting at the vertex or INVALID if the vertex is not used by a face.
+		uint32_t getVertexHalfEdge(uint32_t vIndex) const		{	return vertexHalfEdges[vIndex];	}
+		// @}
+
+		//! Return the half-edges starting at the vertex.
+		std::vector<uint32_t> getOutgoingHalfEdges(uint32_t vIndex) const;
+		//! Return the vertices sharing an edge with the vertex in increasing order.
+		std::vector<uint32_t> getAdjacentVertices(uint32_t vIndex) const;
+		//! Return the half-edge from @a vIndex1 to @a vIndex2 or INVALID.
+		uint32_t findHalfEdge(uint32_t vIndex1, uint32_t vIndex2) const;
+		//! Return true, if the outgoing half-edges of the vertex reach all of its faces (i.e. its faces form a single fan).
+		bool isManifoldVertex(uint32_t vIndex) const;
+		//! Return true, if the vertex is the origin or the target of a border half-edge.
+		bool isBorderVertex(uint32_t vIndex) const;
+
+		//! Attribute data of a vertex with the layout given by getVertexDescription().
+		uint8_t * getVertexData(uint32_t vIndex)				{	return vertexData.data() + vIndex * vertexSize;	}
+		const uint8_t * getVertexData(uint32_t vIndex) const	{	return vertexData.data() + vIndex * vertexSize;	}
+		Geometry::Vec3 getPosition(uint32_t vIndex) const;
+		void setPosition(uint32_t vIndex, const Geometry::Vec3 & position);
+
+		/*! @name Editing
+			If a vertex, face or half-edge given to one of these functions is deleted or out of range,
+			an std::invalid_argument exception is thrown. */
+		// @{
+		/*! Add a vertex that is not used by any face and return its index.
+			@param data Attribute data to copy (getVertexDescription().getVertexSize() bytes) or nullptr for zeros */
+		uint32_t addVertex(const uint8_t * data);
+
+		/*! Add the triangle (vIndex1, vIndex2, vIndex3) in counterclockwise order and return its face index.
+			It is connected to the existing faces at all edges without a face on the other side. */
+		uint32_t addFace(uint32_t vIndex1, uint32_t vIndex2, uint32_t vIndex3);
+
+		//! Delete a face. Its vertices are kept, even if they are not used by other faces.
+		void deleteFace(uint32_t fIndex);
+
+		/*! Split the edge of the given half-edge by inserting a new vertex, whose attributes are
+			interpolated between the origin (weight 1 - @a t) and the target (weight @a t) of the half-edge.
+			The face of the half-edge and the face on the other side are split into two faces each.
+			@return the index of the new vertex */
+		uint32_t splitEdge(uint32_t hIndex, float t = 0.5f);
+
+		/*! Replace the edge of the given half-edge by the other diagonal of the quadrilateral formed by its two faces.
+			@return false (and nothing is changed) if the edge is a border edge or the other diagonal already exists. */
+		bool flipEdge(uint32_t hIndex);
+
+		/*! Return true, if collapsing the edge of the given half-edge keeps the mesh manifold:
+			both vertices are manifold, the only common neighbours of its vertices are the opposite vertices of its faces, and an inner
+			edge does not connect two border vertices. */
+		bool isCollapseAllowed(uint32_t hIndex) const;
+
+		/*! Collapse the edge of the given half-edge by removing its origin and its faces. The edges of the
+			origin are moved to the target, whose attributes are kept; use getVertexData() or setPosition() to move it.
+			@return false (and nothing is changed) if isCollapseAllowed(hIndex) is false. */
+		bool collapseEdge(uint32_t hIndex);
+		// @}
+
+	private:
+		explicit HalfEdgeMesh(const VertexDescription & vd);
+
+		void assertVertex(uint32_t vIndex) const;
+		void assertFace(uint32_t fIndex) const;
+
+		//! Return a free face slot with three half-edges.
+		uint32_t allocateFace();
+		//! Mark the face as deleted without updating the neighbouring elements.
+		void releaseFace(uint32_t fIndex);
+		//! Connect the half-edges of a new face to the border half-edges of the adjacent faces.
+		void connectFace(uint32_t fIndex);
+		//! Make the half-edges twins of each other; if one of them is INVALID, the other one becomes a border half-edge.
+		void link(uint32_t hIndex1, uint32_t hIndex2);
+		void registerBorder(uint32_t hIndex);
+		void unregisterBorder(uint32_t hIndex);
+		/*! Make sure the stored outgoing half-edge of the vertex is valid by
+			choosing the first valid one of the candidates, if necessary. */
+		void updateVertexHalfEdge(uint32_t vIndex, const std::vector<uint32_t> & candidates);
+
+		VertexDescription vertexDescription;
+		std::size_t vertexSize;
+		std::size_t positionOffset;
+
+		//! Origin vertex of each half-edge; INVALID for the half-edges of deleted faces.
+		std::vector<uint32_t> origins;
+		std::vector<uint32_t> twins;
+		std::vector<uint32_t> vertexHalfEdges;
+		//! Number of faces using each vertex.
+		std::vector<uint32_t> vertexFaceCounts;
+		std::vector<bool> deletedVertices;
+		std::vector<uint8_t> vertexData;
+		std::vector<uint32_t> freeVertices;
+		std::vector<uint32_t> freeFaces;
+		//! Border half-edges by (origin, target); used to find the twins of the half-edges of new faces.
+		std::unordered_map<uint64_t, uint32_t> borderHalfEdges;
+};
+
+}
+}
+
+#endif /* RENDERING_HALFEDGEMESH_H_ */
@@ -0,0 +1,305 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MeshAnalysis.h"
+#include "LocalMeshDataHolder.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttribute.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
+
+#include <Geometry/Vec3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace Rendering {
+namespace MeshUtils {
+
+//! (internal) Size of a cache line for the vertex fetch simulation.
+static const uint32_t fetchCacheLineSize = 64;
+//! (internal) Number of cache lines for the vertex fetch simulation (16 KiB).
+static const uint32_t fetchCacheLineCount = 256;
+
+/*! (internal) Simulate the vertex fetch for the given index sequence with a FIFO cache of fetchCacheLineCount lines.
+	Each attribute is fetched from its own address, so this works for all vertex layouts. */
+static uint64_t simulateVertexFetch(const MeshVertexData & vertices, const std::vector<uint32_t> & indices) {
+	const VertexDescription & vd = vertices.getVertexDescription();
+	const std::size_t lineCount = vertices.dataSize() / fetchCacheLineSize + 1;
+	std::vector<uint32_t> lineTimes(lineCount, 0);
+	uint32_t stamp = fetchCacheLineCount + 1;
+	uint64_t fetchedBytes = 0;
+	for(const auto & index : indices) {
+		for(const auto & attr : vd.getAttributes()) {
+			if(attr.empty()) {
+				continue;
+			}
+			const std::size_t begin = vertices.getAttributeOffset(attr) + static_cast<std::size_t>(index) * vertices.getAttributeStride(attr);
+			const std::size_t end = begin + attr.getDataSize();
+			for(std::size_t line = begin / fetchCacheLineSize; line <= (end - 1) / fetchCacheLineSize && line < lineCount; ++line) {
+				if(stamp - lineTimes[line] > fetchCacheLineCount) {
+					lineTimes[line] = stamp;
+					++stamp;
+					fetchedBytes += fetchCacheLineSize;
+				}
+			}
+		}
+	}
+	return fetchedBytes;
+}
+
+//! (internal) Number of vertices whose data equals the data of a vertex with a smaller index.
+static uint32_t countDuplicateVertices(const MeshVertexData & vertices) {
+	const VertexDescription & vd = vertices.getVertexDescription();
+	const uint32_t vertexCount = vertices.getVertexCount();
+	auto forEachAttribute = [&](uint32_t vertex, const std::function<void(const uint8_t *, std::size_t)> & fun) {
+		for(const auto & attr : vd.getAttributes()) {
+			fun(vertices.getAttributeData(attr) + static_cast<std::size_t>(vertex) * vertices.getAttributeStride(attr), attr.getDataSize());
+		}
+	};
+	// sort the vertices by a hash of their data and compare the vertices with equal hashes
+	std::vector<std::pair<uint64_t, uint32_t>> hashes(vertexCount);
+	for(uint32_t v = 0; v < vertexCount; ++v) {
+		uint64_t hash = 14695981039346656037ull; // FNV-1a
+		forEachAttribute(v, [&hash](const uint8_t * data, std::size_t size) {
+			for(std::size_t i = 0; i < size; ++i) {
+				hash = (hash ^ data[i]) * 1099511628211ull;
+			}
+		});
+		hashes[v] = std::make_pair(hash, v);
+	}
+	std::sort(hashes.begin(), hashes.end());
+
+	std::vector<uint8_t> a(vd.getVertexSize()), b(vd.getVertexSize());
+	auto gather = [&](uint32_t vertex, std::vector<uint8_t> & target) {
+		std::size_t pos = 0;
+		forEachAttribute(vertex, [&](const uint8_t * data, std::size_t size) {
+			std::copy(data, data + size, target.begin() + pos);
+			pos += size;
+		});
+	};
+	uint32_t duplicates = 0;
+	for(std::size_t begin = 0; begin < hashes.size();) {
+		std::size_t end = begin + 1;
+		while(end < hashes.size() && hashes[end].first == hashes[begin].first) {
+			++end;
+		}
+		// the vertices of a group are compared to all previous vertices of the group
+		for(std::size_t i = begin + 1; i < end; ++i) {
+			gather(hashes[i].second, a);
+			for(std::size_t j = begin; j < i; ++j) {
+				gather(hashes[j].second, b);
+				if(a == b) {
+					++duplicates;
+					break;
+				}
+			}
+		}
+		begin = end;
+	}
+	return duplicates;
+}
+
+/*! (internal) Rasterize the triangles in the given order with depth test and backface culling
+	when looking into direction @p dir; counts the covered pixels and the fragments passing the depth test. */
+static void rasterizeView(const std::vector<Geometry::Vec3> & positions, const std::vector<uint32_t> & indices, const Geometry::Vec3 & dir,
+						  uint32_t resolution, uint64_t & coveredPixels, uint64_t & shadedFragments) {
+	// screen space basis; (u, v, dir) is right handed
+	const Geometry::Vec3 up = std::abs(dir.getY()) < 0.99f ? Geometry::Vec3(0.0f, 1.0f, 0.0f) : Geometry::Vec3(1.0f, 0.0f, 0.0f);
+	const Geometry::Vec3 u = up.cross(dir).getNormalized();
+	const Geometry::Vec3 v = dir.cross(u);
+
+	std::vector<float> screen(positions.size() * 3);
+	float min[2] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+	float max[2] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+	for(std::size_t i = 0; i < positions.size(); ++i) {
+		screen[i * 3 + 0] = positions[i].dot(u);
+		screen[i * 3 + 1] = positions[i].dot(v);
+		screen[i * 3 + 2] = positions[i].dot(dir);
+		for(uint_fast8_t a = 0; a < 2; ++a) {
+			min[a] = std::min(min[a], screen[i * 3 + a]);
+			max[a] = std::max(max[a], screen[i * 3 + a]);
+		}
+	}
+	const float extent = std::max(max[0] - min[0], max[1] - min[1]);
+	if(!(extent > 0.0f)) {
+		return;
+	}
+	const float scale = resolution / extent;
+	for(std::size_t i = 0; i < positions.size(); ++i) {
+		screen[i * 3 + 0] = (screen[i * 3 + 0] - min[0]) * scale;
+		screen[i * 3 + 1] = (screen[i * 3 + 1] - min[1]) * scale;
+	}
+
+	std::vector<float> depthBuffer(static_cast<std::size_t>(resolution) * resolution, std::numeric_limits<float>::infinity());
+	for(std::size_t t = 0; t + 2 < indices.size(); t += 3) {
+		const float * a = screen.data() + indices[t + 0] * 3;
+		const float * b = screen.data() + indices[t + 1] * 3;
+		const float * c = screen.data() + indices[t + 2] * 3;
+		// signed area; front faces (counter clockwise seen from the viewer) have a negative area in this basis
+		const float area = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+		if(!(area < 0.0f)) {
+			continue;
+		}
+		const int32_t maxCoordinate = static_cast<int32_t>(resolution) - 1;
+		const int32_t xBegin = std::max(0, static_cast<int32_t>(std::floor(std::min(std::min(a[0], b[0]), c[0]))));
+		const int32_t xEnd = std::min(maxCoordinate, static_cast<int32_t>(std::ceil(std::max(std::max(a[0], b[0]), c[0]))));
+		const int32_t yBegin = std::max(0, static_cast<int32_t>(std::floor(std::min(std::min(a[1], b[1]), c[1]))));
+		const int32_t yEnd = std::min(maxCoordinate, static_cast<int32_t>(std::ceil(std::max(std::max(a[1], b[1]), c[1]))));
+		for(int32_t y = yBegin; y <= yEnd; ++y) {
+			const float py = y + 0.5f;
+			for(int32_t x = xBegin; x <= xEnd; ++x) {
+				const float px = x + 0.5f;
+				// edge functions have the sign of the area for points inside the triangle
+				const float w0 = (c[0] - b[0]) * (py - b[1]) - (c[1] - b[1]) * (px - b[0]);
+				const float w1 = (a[0] - c[0]) * (py - c[1]) - (a[1] - c[1]) * (px - c[0]);
+				const float w2 = (b[0] - a[0]) * (py - a[1]) - (b[1] - a[1]) * (px - a[0]);
+				if(w0 > 0.0f || w1 > 0.0f || w2 > 0.0f) {
+					continue;
+				}
+				const float depth = (w0 * a[2] + w1 * b[2] + w2 * c[2]) / area;
+				float & storedDepth = depthBuffer[static_cast<std::size_t>(y) * resolution + x];
+				if(depth < storedDepth) {
+					storedDepth = depth;
+					++shadedFragments;
+				}
+			}
+		}
+	}
+	for(const auto & depth : depthBuffer) {
+		if(depth != std::numeric_limits<float>::infinity()) {
+			++coveredPixels;
+		}
+	}
+}
+
+//! (static)
+MeshAnalysis analyzeMesh(Mesh * mesh, const std::vector<uint32_t> & cacheSizes, uint32_t overdrawResolution) {
+	LocalMeshDataHolder localData(mesh);
+	const MeshVertexData & vertices = mesh->openVertexData();
+	const MeshIndexData & indexData = mesh->openIndexData();
+	const VertexDescription & vd = vertices.getVertexDescription();
+
+	MeshAnalysis analysis;
+	analysis.vertexCount = vertices.getVertexCount();
+	analysis.indexCount = mesh->isUsingIndexData() ? indexData.getIndexCount() : 0;
+	const bool isTriangleMesh = mesh->getDrawMode() == Mesh::DRAW_TRIANGLES;
+
+	// the vertices in drawing order; primitives referencing a non-existing vertex are skipped as a whole
+	std::vector<uint32_t> indices;
+	analysis.invalidPrimitives = 0;
+	if(mesh->isUsingIndexData()) {
+		const uint32_t primitiveSize = isTriangleMesh ? 3 : 1;
+		const uint32_t usedIndexCount = indexData.getIndexCount() - indexData.getIndexCount() % primitiveSize;
+		indices.reserve(usedIndexCount);
+		for(uint32_t i = 0; i < usedIndexCount; i += primitiveSize) {
+			bool valid = true;
+			for(uint32_t j = i; j < i + primitiveSize; ++j) {
+				valid = valid && indexData[j] < analysis.vertexCount;
+			}
+			if(!valid) {
+				++analysis.invalidPrimitives;
+				continue;
+			}
+			for(uint32_t j = i; j < i + primitiveSize; ++j) {
+				indices.push_back(indexData[j]);
+			}
+		}
+	} else {
+		indices.resize(analysis.vertexCount);
+		for(uint32_t i = 0; i < analysis.vertexCount; ++i) {
+			indices[i] = i;
+		}
+	}
+	analysis.triangleCount = isTriangleMesh ? static_cast<uint32_t>(indices.size() / 3) : 0;
+
+	// post-transform cache
+	if(isTriangleMesh && mesh->isUsingIndexData()) {
+		for(const auto & cacheSize : cacheSizes) {
+			analysis.vertexCache.emplace_back(cacheSize, calculateVertexCacheStatistics(indices, analysis.vertexCount, cacheSize));
+		}
+	}
+
+	// vertex fetch
+	std::vector<uint8_t> used(analysis.vertexCount, 0);
+	for(const auto & index : indices) {
+		used[index] = 1;
+	}
+	const uint32_t usedVertices = static_cast<uint32_t>(std::count(used.begin(), used.end(), 1));
+	analysis.unusedVertices = analysis.vertexCount - usedVertices;
+	analysis.fetchedVertexBytes = simulateVertexFetch(vertices, indices);
+	const std::size_t usedBytes = static_cast<std::size_t>(usedVertices) * vd.getVertexSize();
+	analysis.vertexFetchOverfetch = usedBytes > 0 ? static_cast<float>(analysis.fetchedVertexBytes) / usedBytes : 0.0f;
+
+	analysis.duplicateVertices = countDuplicateVertices(vertices);
+
+	// memory
+	for(const auto & attr : vd.getAttributes()) {
+		MeshAnalysis::AttributeCost cost;
+		cost.name = attr.getName();
+		cost.bytesPerVertex = attr.getDataSize();
+		cost.totalBytes = static_cast<std::size_t>(attr.getDataSize()) * analysis.vertexCount;
+		analysis.attributeCosts.push_back(cost);
+	}
+	analysis.vertexBytes = vd.getVertexSize() * analysis.vertexCount;
+	analysis.indexBytes = static_cast<std::size_t>(analysis.indexCount) * indexData.getIndexSize();
+
+	// triangles
+	analysis.degenerateTriangles = 0;
+	analysis.zeroAreaTriangles = 0;
+	analysis.overdraw = 0.0f;
+	analysis.coveredPixels = 0;
+	analysis.shadedFragments = 0;
+	if(!isTriangleMesh || vd.getAttribute(VertexAttributeIds::POSITION).empty()) {
+		return analysis;
+	}
+	std::vector<Geometry::Vec3> positions(analysis.vertexCount);
+	{
+		Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vertices, VertexAttributeIds::POSITION));
+		positionAccessor->getPositions(0, analysis.vertexCount, positions.data());
+	}
+	for(std::size_t t = 0; t + 2 < indices.size(); t += 3) {
+		const uint32_t a = indices[t], b = indices[t + 1], c = indices[t + 2];
+		if(a == b || b == c || c == a) {
+			++analysis.degenerateTriangles;
+		} else if((positions[b] - positions[a]).cross(positions[c] - positions[a]).isZero()) {
+			++analysis.zeroAreaTriangles;
+		}
+	}
+
+	// overdraw
+	if(overdrawResolution > 0) {
+		std::vector<Geometry::Vec3> directions;
+		for(int x = -1; x <= 1; ++x) {
+			for(int y = -1; y <= 1; ++y) {
+				for(int z = -1; z <= 1; ++z) {
+					const int nonZero = (x != 0 ? 1 : 0) + (y != 0 ? 1 : 0) + (z != 0 ? 1 : 0);
+					// the six axis directions and the eight diagonals
+					if(nonZero == 1 || nonZero == 3) {
+						directions.push_back(Geometry::Vec3(x, y, z).getNormalized());
+					}
+				}
+			}
+		}
+		for(const auto & dir : directions) {
+			rasterizeView(positions, indices, dir, overdrawResolution, analysis.coveredPixels, analysis.shadedFragments);
+		}
+		analysis.overdraw = analysis.coveredPixels > 0 ? static_cast<float>(analysis.shadedFragments) / analysis.coveredPixels : 0.0f;
+	}
+	return analysis;
+}
+
+}
+}
@@ -0,0 +1,89 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHANALYSIS_H_
+#define RENDERING_MESHANALYSIS_H_
+
+#include "MeshUtils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+class Mesh;
+namespace MeshUtils {
+
+/**
+ * Performance relevant properties of a mesh (see analyzeMesh(...)).
+ * Can be used to check the effect of optimizations like optimizeIndices(...),
+ * shrinkMesh(...) or eliminateDuplicateVertices(...).
+ */
+struct MeshAnalysis {
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	//! Number of valid triangles.
+	uint32_t triangleCount;
+	//! Triangles (or single indices of other meshes) that reference a non-existing vertex; they are ignored by the analysis.
+	uint32_t invalidPrimitives;
+
+	//! Post-transform vertex cache statistics of the valid triangles for each of the requested cache sizes.
+	std::vector<std::pair<uint32_t, VertexCacheStatistics>> vertexCache;
+
+	//! Bytes read from the vertex data by the vertex fetch (simulated with a cache of 64 byte lines).
+	uint64_t fetchedVertexBytes;
+	//! Fetched bytes relative to the size of the used vertices (optimal: 1).
+	float vertexFetchOverfetch;
+
+	//! Vertices not referenced by any index.
+	uint32_t unusedVertices;
+	//! Vertices whose data is identical to the data of another vertex.
+	uint32_t duplicateVertices;
+	//! Triangles that use the same vertex more than once.
+	uint32_t degenerateTriangles;
+	//! Triangles with distinct vertices but without area.
+	uint32_t zeroAreaTriangles;
+
+	//! Memory needed by a single attribute of the vertex description.
+	struct AttributeCost {
+		std::string name;
+		uint32_t bytesPerVertex;
+		std::size_t totalBytes;
+	};
+	std::vector<AttributeCost> attributeCosts;
+	std::size_t vertexBytes;
+	std::size_t indexBytes;
+
+	//! Rasterized fragments per covered pixel, averaged over all views (optimal: 1).
+	float overdraw;
+	//! Sum of the pixels covered by the mesh in all views.
+	uint64_t coveredPixels;
+	//! Sum of the fragments passing the depth test in all views.
+	uint64_t shadedFragments;
+};
+
+/**
+ * Analyze the given mesh.
+ * The overdraw is estimated by rasterizing the mesh in the order of its indices with depth test
+ * and backface culling from the six axis directions and the eight diagonal directions.
+ * Vertex cache statistics and overdraw are only calculated for triangle meshes.
+ *
+ * @param mesh Mesh to analyze; it is not changed.
+ * @param cacheSizes Sizes of the simulated post-transform vertex caches.
+ * @param overdrawResolution Resolution of the images used for the overdraw estimate; zero disables the estimate.
+ */
+MeshAnalysis analyzeMesh(Mesh * mesh, const std::vector<uint32_t> & cacheSizes = {16, 24, 32}, uint32_t overdrawResolution = 256);
+
+}
+}
+
+#endif /* RENDERING_MESHANALYSIS_H_ */
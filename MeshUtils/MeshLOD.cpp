@@ -0,0 +1,258 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MeshLOD.h"
+#include "LocalMeshDataHolder.h"
+#include "MeshUtils.h"
+#include "TriangleBVH.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
+#include "../Mesh/internal/ParallelFor.h"
+#include "../RenderingContext/RenderingContext.h"
+
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Rect.h>
+#include <Geometry/Vec3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <future>
+#include <limits>
+#include <stdexcept>
+
+namespace Rendering {
+namespace MeshUtils {
+
+//! (internal) Minimal number of distance queries per thread.
+static const std::size_t minQueriesPerChunk = 1024;
+
+//! (internal) Positions of the vertices referenced by the index data of the mesh.
+static std::vector<Geometry::Vec3> getUsedPositions(Mesh * mesh) {
+	const MeshVertexData & vertexData = mesh->openVertexData();
+	const MeshIndexData & indexData = mesh->openIndexData();
+	const uint32_t vertexCount = vertexData.getVertexCount();
+	std::vector<Geometry::Vec3> positions(vertexCount);
+	{
+		Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION));
+		positionAccessor->getPositions(0, vertexCount, positions.data());
+	}
+	std::vector<bool> used(vertexCount, false);
+	for(uint32_t i = 0; i < indexData.getIndexCount(); ++i) {
+		const uint32_t index = indexData[i];
+		if(index < vertexCount) {
+			used[index] = true;
+		}
+	}
+	uint32_t usedCount = 0;
+	for(uint32_t v = 0; v < vertexCount; ++v) {
+		if(used[v]) {
+			positions[usedCount++] = positions[v];
+		}
+	}
+	positions.resize(usedCount);
+	return positions;
+}
+
+//! (internal) Maximal distance between the given points and the triangles of the hierarchy.
+static float getMaxDistance(const std::vector<Geometry::Vec3> & points, const TriangleBVH & bvh, bool parallel) {
+	const uint32_t chunkCount = parallel ? ParallelFor::getChunkCount(points.size(), minQueriesPerChunk) : 1;
+	std::vector<float> chunkMaxima(chunkCount, 0.0f);
+	ParallelFor::forEachChunk(points.size(), chunkCount, [&](uint32_t chunk, std::size_t begin, std::size_t end) {
+		float maxDistance = 0.0f;
+		for(std::size_t i = begin; i < end; ++i) {
+			float distance;
+			if(bvh.getClosestTriangle(points[i], distance) != TriangleBVH::NO_HIT) {
+				maxDistance = std::max(maxDistance, distance);
+			}
+		}
+		chunkMaxima[chunk] = maxDistance;
+	});
+	return *std::max_element(chunkMaxima.begin(), chunkMaxima.end());
+}
+
+MeshLOD::MeshLOD() : Util::ReferenceCounter<MeshLOD>(), levels(), boundingBox(), sharedVertexData(false) {
+}
+
+MeshLOD::~MeshLOD() = default;
+
+//! (static)
+Util::Reference<MeshLOD> MeshLOD::create(Mesh * mesh, const Parameters & parameters) {
+	if(mesh == nullptr || !mesh->isUsingIndexData() || mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+		throw std::invalid_argument("MeshLOD: Mesh is not a valid triangle mesh.");
+	}
+	LocalMeshDataHolder localData(mesh);
+	Util::Reference<MeshLOD> lod = new MeshLOD;
+	lod->build(mesh, parameters, true);
+	return lod;
+}
+
+//! (static)
+std::vector<Util::Reference<MeshLOD>> MeshLOD::create(const std::vector<Mesh *> & meshes, const Parameters & parameters) {
+	// The data of all meshes is made local by the calling thread, as this may require the rendering context.
+	std::deque<LocalMeshDataHolder> localData;
+	for(const auto & mesh : meshes) {
+		if(mesh == nullptr || !mesh->isUsingIndexData() || mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+			throw std::invalid_argument("MeshLOD: Mesh is not a valid triangle mesh.");
+		}
+		localData.emplace_back(mesh);
+		mesh->openVertexData();
+		mesh->openIndexData();
+	}
+
+	std::vector<Util::Reference<MeshLOD>> lods(meshes.size());
+	for(auto & lod : lods) {
+		lod = new MeshLOD;
+	}
+	// The meshes differ in size, so the threads take the next unprocessed mesh instead of a fixed range.
+	std::atomic<std::size_t> nextMesh(0);
+	ParallelFor::forEachChunk(meshes.size(), ParallelFor::getChunkCount(meshes.size(), 1), [&](uint32_t, std::size_t, std::size_t) {
+		for(std::size_t i = nextMesh++; i < meshes.size(); i = nextMesh++) {
+			lods[i]->build(meshes[i], parameters, false);
+		}
+	});
+	return lods;
+}
+
+void MeshLOD::build(Mesh * mesh, const Parameters & parameters, bool parallel) {
+	boundingBox = mesh->getBoundingBox();
+	sharedVertexData = false;
+	levels.clear();
+
+	Level original;
+	original.mesh = mesh;
+	original.firstIndex = 0;
+	original.indexCount = mesh->getIndexCount();
+	original.error = 0.0f;
+	levels.push_back(original);
+
+	Simplification::weights_t weights = parameters.weights;
+	const float extent = boundingBox.getExtentMax();
+	if(extent > 0.0f) {
+		weights[Simplification::VERTEX_OFFSET] /= extent;
+	}
+
+	// The distances between consecutive levels are measured by other threads while the next level is simplified.
+	// The hierarchies and positions are owned by this thread until all measurements have finished.
+	std::deque<Util::Reference<TriangleBVH>> levelBVHs;
+	std::deque<std::vector<Geometry::Vec3>> levelPositions;
+	std::vector<std::future<float>> levelDistances;
+	levelBVHs.emplace_back(TriangleBVH::create(mesh, parallel));
+	levelPositions.emplace_back(getUsedPositions(mesh));
+	Util::Reference<Mesh> previous = mesh;
+	while(levels.size() < parameters.maxLevelCount) {
+		const uint32_t previousTriangleCount = previous->getPrimitiveCount();
+		const uint32_t targetTriangleCount = static_cast<uint32_t>(previousTriangleCount * parameters.reductionFactor);
+		if(targetTriangleCount < parameters.minTriangleCount || targetTriangleCount >= previousTriangleCount) {
+			break;
+		}
+		Util::Reference<Mesh> simplified = Simplification::simplifyMesh(previous.get(), targetTriangleCount, parameters.threshold,
+																		parameters.useOptimalPositioning, parameters.maxAngle, weights);
+		if(simplified.isNull() || simplified == previous || simplified->getPrimitiveCount() >= previousTriangleCount) {
+			break;
+		}
+
+		const TriangleBVH * previousBVH = levelBVHs.back().get();
+		const std::vector<Geometry::Vec3> * previousPositions = &levelPositions.back();
+		levelBVHs.emplace_back(TriangleBVH::create(simplified.get(), parallel));
+		levelPositions.emplace_back(getUsedPositions(simplified.get()));
+		const TriangleBVH * bvh = levelBVHs.back().get();
+		const std::vector<Geometry::Vec3> * positions = &levelPositions.back();
+		levelDistances.emplace_back(std::async(std::launch::async, [previousBVH, previousPositions, bvh, positions, parallel]() {
+			return std::max(getMaxDistance(*previousPositions, *bvh, parallel),
+							getMaxDistance(*positions, *previousBVH, parallel));
+		}));
+
+		Level level;
+		level.mesh = simplified;
+		level.firstIndex = 0;
+		level.indexCount = simplified->getIndexCount();
+		level.error = 0.0f;
+		levels.push_back(level);
+		previous = simplified;
+	}
+	for(std::size_t i = 0; i < levelDistances.size(); ++i) {
+		levels[i + 1].error = levels[i].error + levelDistances[i].get();
+	}
+
+	if(parameters.shareVertexData) {
+		// combineMeshes(...) skips meshes with another vertex description, which would shift the index ranges of the levels
+		std::deque<Mesh *> levelMeshes;
+		uint32_t indexCount = 0;
+		for(const auto & level : levels) {
+			if(!(level.mesh->getVertexDescription() == mesh->getVertexDescription())) {
+				throw std::logic_error("MeshLOD: The levels of detail have different vertex descriptions.");
+			}
+			levelMeshes.push_back(level.mesh.get());
+			indexCount += level.indexCount;
+		}
+		Util::Reference<Mesh> combinedMesh = combineMeshes(levelMeshes);
+		if(combinedMesh.isNull() || combinedMesh->getIndexCount() != indexCount) {
+			throw std::logic_error("MeshLOD: Combining the levels of detail failed.");
+		}
+		uint32_t firstIndex = 0;
+		for(auto & level : levels) {
+			level.mesh = combinedMesh;
+			level.firstIndex = firstIndex;
+			firstIndex += level.indexCount;
+		}
+		sharedVertexData = true;
+	}
+}
+
+//! (internal) Number of pixels covered by a length of one in the mesh's coordinate system at the point of its bounding box nearest to the camera.
+static float getPixelsPerUnit(const RenderingContext & rc, const Geometry::Box & boundingBox) {
+	const Geometry::Matrix4x4 & modelToCamera = rc.getMatrix_modelToCamera();
+	const Geometry::Matrix4x4 & cameraToClipping = rc.getMatrix_cameraToClipping();
+	const float scale = std::max(std::max(modelToCamera.transformDirection(Geometry::Vec3(1.0f, 0.0f, 0.0f)).length(),
+										  modelToCamera.transformDirection(Geometry::Vec3(0.0f, 1.0f, 0.0f)).length()),
+								 modelToCamera.transformDirection(Geometry::Vec3(0.0f, 0.0f, 1.0f)).length());
+	const Geometry::Vec3 center = modelToCamera.transformPosition(boundingBox.getCenter());
+	const float radius = 0.5f * boundingBox.getDiameter() * scale;
+	// the camera looks along the negative z axis; w is the clipping coordinate used for the perspective division
+	const float nearestZ = center.getZ() + radius;
+	const float w = cameraToClipping.at(3, 2) * nearestZ + cameraToClipping.at(3, 3);
+	if(w <= 0.0f) {
+		return std::numeric_limits<float>::infinity();
+	}
+	return scale * cameraToClipping.at(1, 1) * 0.5f * static_cast<float>(rc.getViewport().getHeight()) / w;
+}
+
+float MeshLOD::getProjectedError(const RenderingContext & rc, uint32_t level) const {
+	const float error = levels.at(level).error;
+	return error > 0.0f ? error * getPixelsPerUnit(rc, boundingBox) : 0.0f;
+}
+
+uint32_t MeshLOD::selectLevel(const RenderingContext & rc, float maxPixelError) const {
+	const float pixelsPerUnit = getPixelsPerUnit(rc, boundingBox);
+	for(uint32_t level = getLevelCount() - 1; level > 0; --level) {
+		if(levels[level].error * pixelsPerUnit <= maxPixelError) {
+			return level;
+		}
+	}
+	return 0;
+}
+
+uint32_t MeshLOD::display(RenderingContext & rc, float maxPixelError) const {
+	const uint32_t level = selectLevel(rc, maxPixelError);
+	if(sharedVertexData) {
+		rc.displayMesh(levels[level].mesh.get(), levels[level].firstIndex, levels[level].indexCount);
+	} else {
+		rc.displayMesh(levels[level].mesh.get());
+	}
+	return level;
+}
+
+}
+}
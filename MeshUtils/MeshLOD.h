@@ -0,0 +1,131 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHLOD_H_
+#define RENDERING_MESHLOD_H_
+
+#include "Simplification.h"
+
+#include <Geometry/Box.h>
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+namespace MeshUtils {
+
+/**
+ * Chain of levels of detail of a triangle mesh created by Simplification::simplifyMesh(...).
+ *
+ * Level zero is the original mesh; every further level is simplified from the previous level
+ * and has about Parameters::reductionFactor times its triangles. For every level, a geometric
+ * error in the mesh's coordinate system is stored: an estimate of the distance between the
+ * level's surface and the surface of the original mesh (accumulated from the symmetric vertex
+ * to surface distances of consecutive levels). As the distances are only measured at the vertices,
+ * the actual distance between the surfaces may be larger.
+ * At draw time, the coarsest level whose error projected to the screen stays below a given
+ * number of pixels is selected.
+ *
+ * If Parameters::shareVertexData is set, the vertices and indices of all levels are stored in a
+ * single mesh and the levels are drawn as ranges of its index data, so that only one vertex
+ * buffer is needed for all levels.
+ */
+class MeshLOD : public Util::ReferenceCounter<MeshLOD> {
+	public:
+		struct Parameters {
+			//! Maximal number of levels including the original mesh.
+			uint32_t maxLevelCount;
+			//! Requested number of triangles of a level relative to the previous level.
+			float reductionFactor;
+			//! Levels with less triangles are not created.
+			uint32_t minTriangleCount;
+
+			//! Parameters of Simplification::simplifyMesh(...).
+			float threshold;
+			bool useOptimalPositioning;
+			float maxAngle;
+			/*! The position weight is divided by the maximal extent of the mesh's bounding box
+				before the simplification, as recommended by Simplification::simplifyMesh(...). */
+			Simplification::weights_t weights;
+
+			//! Store all levels in a single mesh.
+			bool shareVertexData;
+
+			Parameters() :
+				maxLevelCount(8), reductionFactor(0.5f), minTriangleCount(32),
+				threshold(0.0f), useOptimalPositioning(true), maxAngle(-1.0f), weights(),
+				shareVertexData(false) {
+				weights.fill(1.0f);
+			}
+		};
+
+		/*! (static factory)
+			Create the levels of detail of the given mesh. The level meshes are simplified one after
+			another, while the error of a level is measured concurrently with the simplification of the next one.
+			If the mesh does not consist of indexed triangles, an std::invalid_argument exception is thrown. */
+		static Util::Reference<MeshLOD> create(Mesh * mesh, const Parameters & parameters = Parameters());
+
+		/*! (static factory)
+			Create the levels of detail of several meshes. The meshes are processed in parallel.
+			If any mesh does not consist of indexed triangles, an std::invalid_argument exception is thrown. */
+		static std::vector<Util::Reference<MeshLOD>> create(const std::vector<Mesh *> & meshes, const Parameters & parameters = Parameters());
+
+		~MeshLOD();
+
+		uint32_t getLevelCount() const							{	return static_cast<uint32_t>(levels.size());	}
+		bool isSharingVertexData() const						{	return sharedVertexData;	}
+
+		/*! Mesh of the given level. If the vertex data is shared, this is the same mesh for all levels
+			and only the range [getFirstIndex(level), getFirstIndex(level) + getIndexCount(level))
+			of its index data belongs to the level. */
+		Mesh * getMesh(uint32_t level) const					{	return levels.at(level).mesh.get();	}
+		uint32_t getFirstIndex(uint32_t level) const			{	return levels.at(level).firstIndex;	}
+		uint32_t getIndexCount(uint32_t level) const			{	return levels.at(level).indexCount;	}
+		uint32_t getTriangleCount(uint32_t level) const			{	return levels.at(level).indexCount / 3;	}
+		//! Geometric error of the given level in the coordinate system of the mesh.
+		float getError(uint32_t level) const					{	return levels.at(level).error;	}
+		//! Bounding box of the original mesh.
+		const Geometry::Box & getBoundingBox() const			{	return boundingBox;	}
+
+		/*! Return the number of pixels the given level's error covers at most on the screen, using
+			the current modelToCamera and cameraToClipping matrices and the viewport of @a rc.
+			If the bounding box of the mesh reaches the camera plane, infinity is returned. */
+		float getProjectedError(const RenderingContext & rc, uint32_t level) const;
+
+		//! Return the coarsest level whose projected error is at most @a maxPixelError.
+		uint32_t selectLevel(const RenderingContext & rc, float maxPixelError) const;
+
+		//! Draw the level selected by selectLevel(rc, maxPixelError) and return it.
+		uint32_t display(RenderingContext & rc, float maxPixelError) const;
+
+	private:
+		MeshLOD();
+
+		void build(Mesh * mesh, const Parameters & parameters, bool parallel);
+
+		struct Level {
+			Util::Reference<Mesh> mesh;
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			float error;
+		};
+		std::vector<Level> levels;
+		Geometry::Box boundingBox;
+		bool sharedVertexData;
+};
+
+}
+}
+
+#endif /* RENDERING_MESHLOD_H_ */
@@ -9,14 +9,18 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "MeshUtils.h"
+#include "ConnectivityAccessor.h"
 #include "../Mesh/Mesh.h"
 #include "../Mesh/VertexDescription.h"
 #include "../Mesh/VertexAttributeAccessors.h"
 #include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/internal/ParallelFor.h"
+#include "../Mesh/internal/TransformKernels.h"
 #include "../GLHeader.h"
 #include "../Helper.h"
 #include <Geometry/BoundingSphere.h>
 #include <Geometry/Box.h>
+#include <Geometry/Convert.h>
 #include <Geometry/Matrix4x4.h>
 #include <Geometry/Sphere.h>
 #include <Geometry/Tools.h>
@@ -30,15 +34,17 @@
 #include <Util/Macros.h>
 #include <Util/Utils.h>
 #include <Util/Numeric.h>
+#include <Util/StringUtils.h>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstring> /* for memcmp */
 #include <map>
 #include <memory>
 #include <queue>
 #include <deque>
+#include <limits>
 #include <set>
-#include <stack>
 #include <stdexcept>
 #include <vector>
 #include <unordered_map>
@@ -50,9 +56,68 @@ namespace Rendering {
 namespace MeshUtils {
 
 /**
- * Class which stores raw vertex data. Used in
- * @a eliminateDuplicateVertices().
+ * Contiguous vertex data of a mesh operation that creates new vertices.
+ * The vertices of the mesh are copied into a single buffer, and new vertices are appended to it,
+ * so no memory is allocated per vertex and the result is copied back into the mesh as a whole.
+ * Used in
  * @a splitLargeTriangles().
+ * @a cutMesh().
+ * @a extrudeTriangles().
+ */
+class RawVertexBuffer {
+public:
+	RawVertexBuffer(const MeshVertexData & vertices) : vertexSize(vertices.getVertexDescription().getVertexSize()), buffer() {
+		// The buffer needs the vertices as contiguous bytes.
+		if(vertices.getLayout() != VertexLayout::INTERLEAVED) {
+			MeshVertexData interleavedCopy(vertices);
+			interleavedCopy.setLayout(VertexLayout::INTERLEAVED);
+			const uint8_t * data = static_cast<const MeshVertexData &>(interleavedCopy).data();
+			buffer.assign(data, data + interleavedCopy.getVertexCount() * vertexSize);
+		} else {
+			buffer.assign(vertices.data(), vertices.data() + vertices.getVertexCount() * vertexSize);
+		}
+	}
+
+	uint32_t getVertexCount() const {
+		return static_cast<uint32_t>(buffer.size() / vertexSize);
+	}
+
+	size_t getVertexSize() const {
+		return vertexSize;
+	}
+
+	//! Return the data of a vertex. The pointer is only valid until the next call of appendVertex().
+	uint8_t * getVertex(uint32_t index) {
+		return buffer.data() + index * vertexSize;
+	}
+
+	const uint8_t * getVertex(uint32_t index) const {
+		return buffer.data() + index * vertexSize;
+	}
+
+	//! Append a vertex with uninitialized data and return its index.
+	uint32_t appendVertex() {
+		buffer.resize(buffer.size() + vertexSize);
+		return getVertexCount() - 1;
+	}
+
+	//! Replace the vertex data of the mesh by the vertices of this buffer.
+	void writeTo(MeshVertexData & vertices, const VertexDescription & vd) const {
+		vertices.allocate(getVertexCount(), vd);
+		std::copy(buffer.begin(), buffer.end(), vertices.data());
+		vertices.updateBoundingBox();
+	}
+
+private:
+	size_t vertexSize;
+	std::vector<uint8_t> buffer;
+};
+
+/**
+ * Class which references a vertex of a RawVertexBuffer. Used in
+ * @a splitLargeTriangles().
+ * @a cutMesh().
+ * @a extrudeTriangles().
  *
  * @author Benjamin Eikel
  * @author Ralf Petring
@@ -60,8 +125,10 @@ namespace MeshUtils {
  */
 class RawVertex {
 public:
-	RawVertex(const uint32_t vertexIndex, const uint8_t * vertexData, const size_t dataSize) :
-		index(vertexIndex), data(vertexData), size(dataSize) {
+	RawVertex(const uint32_t vertexIndex, RawVertexBuffer & vertexBuffer) :
+		index(vertexIndex), buffer(&vertexBuffer) {
+		if(index >= buffer->getVertexCount())
+			throw std::out_of_range("RawVertex: Vertex index out of range.");
 	}
 
 	//! Return the index in the mesh of the vertex.
@@ -69,14 +136,14 @@ public:
 		return index;
 	}
 
-	//! Return the byte position of the vertex data.
+	//! Return the byte position of the vertex data; it is only valid until a new vertex is created.
 	const uint8_t * getData() const {
-		return data;
+		return buffer->getVertex(index);
 	}
 
 	//! Return the number of bytes of the vertex data.
 	size_t getSize() const {
-		return size;
+		return buffer->getVertexSize();
 	}
 
 	/**
@@ -87,48 +154,44 @@ public:
 	 * @c false otherwise.
 	 */
 	bool operator<(const RawVertex & other) const {
-		size_t min = std::min(size, other.size);
-		int result = memcmp(data, other.data, min);
+		size_t min = std::min(getSize(), other.getSize());
+		int result = memcmp(getData(), other.getData(), min);
 		if (result < 0) {
 			return true;
 		} else if (result > 0) {
 			return false;
 		}
-		return size < other.size;
+		return getSize() < other.getSize();
 	}
 
 	/**
 	 * @param rwa first RawVertex for interpolation
 	 * @param rwb second RawVertex for interpolation
-	 * @param newIndex the index of the created RawVertex
 	 * @param vd the VertexDescription of both RawVertices
-	 * @return a linear interpolated RawVertex in the middle of rwa and rwb
+	 * @return a linear interpolated RawVertex in the middle of rwa and rwb, appended to the buffer of both RawVertices
 	 * @author Ralf Petring
 	 */
-	static RawVertex midPoint(const RawVertex & rwa, const RawVertex & rwb, const uint32_t & newIndex, const VertexDescription & vd);
+	static RawVertex midPoint(const RawVertex & rwa, const RawVertex & rwb, const VertexDescription & vd);
 
 	/**
 	 * @param rwa first RawVertex for interpolation
 	 * @param rwb second RawVertex for interpolation
 	 * @param a interpolation factor (between 0.0 and 1.0)
-	 * @param newIndex the index of the created RawVertex
 	 * @param vd the VertexDescription of both RawVertices
-	 * @return a linear interpolated RawVertex in the middle of rwa and rwb
+	 * @return a linear interpolated RawVertex between rwa and rwb, appended to the buffer of both RawVertices
 	 * @author Sascha Brandt
 	 */
-	static RawVertex interpolate(const RawVertex & rwa, const RawVertex & rwb, float a, const uint32_t & newIndex, const VertexDescription & vd);
+	static RawVertex interpolate(const RawVertex & rwa, const RawVertex & rwb, float a, const VertexDescription & vd);
 
-	static RawVertex move(const RawVertex & rw, const Geometry::Vec3 & dir, const uint32_t & newIndex, const VertexDescription & vd);
+	//! Return a copy of @a rw moved by @a dir, appended to the buffer of @a rw.
+	static RawVertex move(const RawVertex & rw, const Geometry::Vec3 & dir, const VertexDescription & vd);
 
 private:
 	//! Index of the vertex in the mesh.
 	uint32_t index;
 
-	//! Byte position of beginning of vertex data.
-	const uint8_t * data;
-
-	//! Number of bytes of vertex data.
-	size_t size;
+	//! Buffer containing the vertex data.
+	RawVertexBuffer * buffer;
 };
 
 /**
@@ -193,10 +256,11 @@ public:
 };
 
 
-RawVertex RawVertex::midPoint(const RawVertex & rwa, const RawVertex & rwb, const uint32_t & newIndex, const VertexDescription & vd) {
-	FAIL_IF(rwa.getSize()!=rwb.getSize());
-	auto data = new uint8_t[rwa.getSize()];
-	RawVertex ret(newIndex, data, rwa.getSize());
+RawVertex RawVertex::midPoint(const RawVertex & rwa, const RawVertex & rwb, const VertexDescription & vd) {
+	FAIL_IF(rwa.buffer!=rwb.buffer);
+	RawVertex ret(rwa.buffer->appendVertex(), *rwa.buffer);
+	// the data pointers are determined after appending the new vertex
+	uint8_t * data = rwa.buffer->getVertex(ret.getIndex());
 	for(const auto & attr : vd.getAttributes()) {
 		if (attr.empty())
 			continue;
@@ -270,10 +334,11 @@ void interpolateValue(uint8_t* data, const RawVertex & rwa, const RawVertex & rw
 	(reinterpret_cast<GLType *> (data + attr.getOffset() + j * sizeof(GLType)))[0] = static_cast<GLType>(f);
 }
 
-RawVertex RawVertex::interpolate(const RawVertex & rwa, const RawVertex & rwb, float a, const uint32_t & newIndex, const VertexDescription & vd) {
-	FAIL_IF(rwa.getSize()!=rwb.getSize());
-	auto data = new uint8_t[rwa.getSize()];
-	RawVertex ret(newIndex, data, rwa.getSize());
+RawVertex RawVertex::interpolate(const RawVertex & rwa, const RawVertex & rwb, float a, const VertexDescription & vd) {
+	FAIL_IF(rwa.buffer!=rwb.buffer);
+	RawVertex ret(rwa.buffer->appendVertex(), *rwa.buffer);
+	// the data pointers are determined after appending the new vertex
+	uint8_t * data = rwa.buffer->getVertex(ret.getIndex());
 	float a_inv = 1.0f - a;
 	for(const auto & attr : vd.getAttributes()) {
 		if (attr.empty())
@@ -315,8 +380,9 @@ RawVertex RawVertex::interpolate(const RawVertex & rwa, const RawVertex & rwb, f
 	return ret;
 }
 
-RawVertex RawVertex::move(const RawVertex & rw, const Geometry::Vec3 & dir, const uint32_t & newIndex, const VertexDescription & vd) {
-	auto data = new uint8_t[rw.getSize()];
+RawVertex RawVertex::move(const RawVertex & rw, const Geometry::Vec3 & dir, const VertexDescription & vd) {
+	RawVertex ret(rw.buffer->appendVertex(), *rw.buffer);
+	uint8_t * data = rw.buffer->getVertex(ret.getIndex());
 	std::copy(rw.getData(), rw.getData() + rw.getSize(), data);
 	const VertexAttribute & attr = vd.getAttribute(VertexAttributeIds::POSITION);
 	// assume float
@@ -324,8 +390,6 @@ RawVertex RawVertex::move(const RawVertex & rw, const Geometry::Vec3 & dir, cons
 	posData[0] += dir.x();
 	posData[1] += dir.y();
 	posData[2] += dir.z();
-
-	RawVertex ret(newIndex, data, rw.getSize());
 	return ret;
 }
 
@@ -334,12 +398,8 @@ Geometry::Sphere_f calculateBoundingSphere(Mesh * mesh) {
 	Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION));
 
 	const uint32_t vertexCount = vertexData.getVertexCount();
-	std::vector<Geometry::Vec3f> positions;
-	positions.reserve(vertexCount);
-
-	for(uint_fast32_t v = 0; v < vertexCount; ++v) {
-		positions.push_back(positionAccessor->getPosition(v));
-	}
+	std::vector<Geometry::Vec3f> positions(vertexCount);
+	positionAccessor->getPositions(0, vertexCount, positions.data());
 
 	const auto sphere = Geometry::BoundingSphere::computeMiniball(positions);
 	if(!(sphere.getRadius() > 0)) {
@@ -353,17 +413,22 @@ Geometry::Sphere_f calculateBoundingSphere(const std::vector<std::pair<Mesh *, G
 	for(const auto & meshTransformationPair : meshesAndTransformations) {
 		sumVertexCount += meshTransformationPair.first->openVertexData().getVertexCount();
 	}
-	std::vector<Geometry::Vec3f> positions;
-	positions.reserve(sumVertexCount);
+	std::vector<Geometry::Vec3f> positions(sumVertexCount);
+	std::size_t offset = 0;
 	for(const auto & meshTransformationPair : meshesAndTransformations) {
-		MeshVertexData & vertexData = meshTransformationPair.first->openVertexData();
+		const MeshVertexData & vertexData = meshTransformationPair.first->openVertexData();
+		const uint32_t vertexCount = vertexData.getVertexCount();
+		if(vertexCount == 0) // an empty mesh at the end would otherwise dereference positions.end()
+			continue;
 		Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION));
 
 		const auto & transformation = meshTransformationPair.second;
-		const uint32_t vertexCount = vertexData.getVertexCount();
-		for(uint_fast32_t v = 0; v < vertexCount; ++v) {
-			positions.emplace_back(transformation.transformPosition(positionAccessor->getPosition(v)));
+		Geometry::Vec3f * meshPositions = positions.data() + offset;
+		positionAccessor->getPositions(0, vertexCount, meshPositions);
+		for(uint32_t i = 0; i < vertexCount; ++i) {
+			meshPositions[i] = transformation.transformPosition(meshPositions[i]);
 		}
+		offset += vertexCount;
 	}
 
 	const auto sphere = Geometry::BoundingSphere::computeEPOS98(positions);
@@ -378,10 +443,14 @@ uint32_t calculateHash( Mesh * mesh ){
 	if(mesh==nullptr)
 		return 0;
 
-	MeshIndexData & iData = mesh->openIndexData();
-	uint32_t h = Util::calcHash( reinterpret_cast<const uint8_t*>(iData.data()),iData.dataSize() );
+	// hash the indices as 32bit values to be independent of the index type
+	const MeshIndexData & iData = mesh->openIndexData();
+	std::vector<uint32_t> indices(iData.getIndexCount());
+	for(uint32_t i = 0; i < iData.getIndexCount(); ++i)
+		indices[i] = iData[i];
+	uint32_t h = Util::calcHash( reinterpret_cast<const uint8_t*>(indices.data()),indices.size()*sizeof(uint32_t) );
 
-	MeshVertexData & vData = mesh->openVertexData();
+	const MeshVertexData & vData = mesh->openVertexData();
 	h ^= Util::calcHash( vData.data(),vData.dataSize() );
 
 	h ^= calculateHash( vData.getVertexDescription() );
@@ -393,7 +462,9 @@ uint32_t calculateHash( Mesh * mesh ){
 uint32_t calculateHash( const VertexDescription & vd ){
 	uint32_t h = 0;
 	for(const auto & attr : vd.getAttributes()) {
-		h ^= Util::calcHash(reinterpret_cast<const uint8_t*>(&attr), sizeof(VertexAttribute));
+		// only hash the values compared by VertexAttribute::operator== (the raw object contains a std::string)
+		const uint32_t values[] = {attr.getNameId().getValue(), attr.getOffset(), attr.getNumValues(), attr.getDataType(), attr.getNormalize() ? 1u : 0u};
+		h ^= Util::calcHash(reinterpret_cast<const uint8_t*>(values), sizeof(values));
 	}
 	return h;
 }
@@ -408,13 +479,16 @@ bool compareMeshes( Mesh * mesh1,Mesh * mesh2 ){
 	// properties
 	if(mesh1->getIndexCount() != mesh2->getIndexCount() ||
 			mesh1->getVertexCount() != mesh2->getVertexCount() ||
-			!(mesh1->getVertexDescription() == mesh2->getVertexDescription()) )
+			mesh1->getVertexDescriptionId() != mesh2->getVertexDescriptionId() )
 		return false;
 
 	// indices
 	const MeshIndexData & iData1 = mesh1->openIndexData();
-	if(!std::equal(iData1.data(),iData1.data()+iData1.getIndexCount(),mesh2->openIndexData().data()) )
-		return false;
+	const MeshIndexData & iData2 = mesh2->openIndexData();
+	for(uint32_t i = 0; i < iData1.getIndexCount(); ++i) {
+		if(iData1[i] != iData2[i])
+			return false;
+	}
 
 	// vertices
 	const MeshVertexData & vData1 = mesh1->openVertexData();
@@ -428,27 +502,21 @@ float getLongestSideLength(Mesh * m){
 	float maxSideLength = 0.0;
 	const VertexDescription & vd = m->getVertexDescription();
 	const VertexAttribute & posAttr = vd.getAttribute(VertexAttributeIds::POSITION);
-	std::vector<RawVertex> vertexArray;
 	if (posAttr.getDataType() != GL_FLOAT || m->getDrawMode() != Mesh::DRAW_TRIANGLES) {
 		WARN("splitLargeTriangles: Unsupported vertex format.");
 		return -1;
 	}
-	MeshVertexData & vertices = m->openVertexData();
-	MeshIndexData & indices = m->openIndexData();
+	const MeshVertexData & vertices = m->openVertexData();
+	const MeshIndexData & indices = m->openIndexData();
+	Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(vertices, VertexAttributeIds::POSITION));
 
-	// extract triangles
-	size_t vertexSize = vd.getVertexSize();
-	for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-		auto tmpData = new uint8_t[vertexSize];
-		std::copy(vertices[i], vertices[i] + vertexSize, tmpData);
-		vertexArray.emplace_back(i, tmpData, vertexSize);
-	}
-	uint32_t * iData = indices.data();
-	for (unsigned i = 0; i < indices.getIndexCount(); i += 3){
-		float tmp = (SplitTriangle(vertexArray.at(iData[i + 0]), vertexArray.at(iData[i + 1]), vertexArray.at(iData[i + 2]))).longestSideLength;
+	for (unsigned i = 0; i + 2 < indices.getIndexCount(); i += 3){
+		const Geometry::Vec3 a = posAcc->getPosition(indices[i + 0]);
+		const Geometry::Vec3 b = posAcc->getPosition(indices[i + 1]);
+		const Geometry::Vec3 c = posAcc->getPosition(indices[i + 2]);
+		const float tmp = std::max((a - b).length(), std::max((b - c).length(), (c - a).length()));
 		if(tmp > maxSideLength)
 			maxSideLength = tmp;
-
 	}
 	return maxSideLength;
 }
@@ -484,23 +552,19 @@ void splitLargeTriangles(Mesh * m, float maxSideLength) {
 		WARN("splitLargeTriangles: Unsupported vertex format.");
 		return;
 	}
+	if(m->getIndexCount() < 3) // nothing to split
+		return;
 
 	std::priority_queue<SplitTriangle> triangles; // todo: ?? use external comparator.
-	std::vector<RawVertex> vertexArray;
 
 	MeshVertexData & vertices = m->openVertexData();
 	MeshIndexData & indices = m->openIndexData();
 
 	// extract triangles
-	size_t vertexSize = vd.getVertexSize();
-	for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-		auto tmpData = new uint8_t[vertexSize];
-		std::copy(vertices[i], vertices[i] + vertexSize, tmpData);
-		vertexArray.emplace_back(i, tmpData, vertexSize);
-	}
-	uint32_t * iData = indices.data();
-	for (unsigned i = 0; i < indices.getIndexCount(); i += 3)
-		triangles.push(SplitTriangle(vertexArray.at(iData[i + 0]), vertexArray.at(iData[i + 1]), vertexArray.at(iData[i + 2])));
+	RawVertexBuffer vertexBuffer(vertices);
+	const MeshIndexData & sourceIndices = indices; // read without converting the index type
+	for (unsigned i = 0; i + 2 < sourceIndices.getIndexCount(); i += 3)
+		triangles.push(SplitTriangle(RawVertex(sourceIndices[i + 0], vertexBuffer), RawVertex(sourceIndices[i + 1], vertexBuffer), RawVertex(sourceIndices[i + 2], vertexBuffer)));
 
 	// split large triangles
 	while (triangles.top().longestSideLength > maxSideLength) {
@@ -509,8 +573,7 @@ void splitLargeTriangles(Mesh * m, float maxSideLength) {
 		RawVertex a = t.getRawVertex(t.longestSideIndex + 0);
 		RawVertex b = t.getRawVertex(t.longestSideIndex + 1);
 		RawVertex c = t.getRawVertex(t.longestSideIndex + 2);
-		RawVertex d = RawVertex::midPoint(a, b, vertexArray.size(), vd);
-		vertexArray.push_back(d);
+		RawVertex d = RawVertex::midPoint(a, b, vd);
 		triangles.push(SplitTriangle(a, d, c));
 		triangles.push(SplitTriangle(d, b, c));
 	}
@@ -529,16 +592,7 @@ void splitLargeTriangles(Mesh * m, float maxSideLength) {
 	indices.updateIndexRange();
 
 	// - vertices
-	vertices.allocate(vertexArray.size(), vd);
-	for (size_t i = 0; i < vertexArray.size(); i++) {
-		std::copy(vertexArray.at(i).getData(), vertexArray.at(i).getData() + vertexSize, vertices[i]);
-	}
-	vertices.updateBoundingBox();
-
-	// cleanup
-	for (auto & rawVertex : vertexArray) {
-		delete[] rawVertex.getData();
-	}
+	vertexBuffer.writeTo(vertices, vd);
 }
 
 //! (static)
@@ -589,6 +643,9 @@ void shrinkMesh(Mesh * m) {
 	oldVertices.updateBoundingBox();
 }
 
+//! (internal) Number of vertices transformed per batch by transformCoordinates(...) and transformNormals(...).
+static const uint32_t transformChunkSize = 4096;
+
 //! (internal) Transforms a range of vertices with the given matrix.
 static void transformVertexData(MeshVertexData & vData, const Matrix4x4f & transMat, uint32_t begin, uint32_t numVerts) {
 	transformCoordinates(vData, VertexAttributeIds::POSITION, transMat, begin, numVerts);
@@ -608,8 +665,14 @@ void transformCoordinates(MeshVertexData & vData, Util::StringIdentifier attrNam
 
 	Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vData,attrName));
 	const uint32_t end = begin+numVerts;
-	for(uint32_t i=begin;i<end;++i)
-		positionAccessor->setPosition(i,transMat.transformPosition(positionAccessor->getPosition(i)));
+	std::vector<Geometry::Vec3> buffer(std::min(numVerts, transformChunkSize));
+	for(uint32_t i=begin;i<end;i+=transformChunkSize) {
+		const uint32_t count = std::min(transformChunkSize, end-i);
+		positionAccessor->getPositions(i, count, buffer.data());
+		for(uint32_t j=0;j<count;++j)
+			buffer[j] = transMat.transformPosition(buffer[j]);
+		positionAccessor->setPositions(i, count, buffer.data());
+	}
 	vData.markAsChanged();
 }
 
@@ -619,11 +682,58 @@ void transformNormals(MeshVertexData & vData, Util::StringIdentifier attrName, c
 
 	Util::Reference<NormalAttributeAccessor> normalAccessor(NormalAttributeAccessor::create(vData,attrName));
 	const uint32_t end = begin+numVerts;
-	for(uint32_t i=begin;i<end;++i)
-		normalAccessor->setNormal(i, (transMat * Geometry::Vec4(normalAccessor->getNormal(i),0)).xyz());
+	std::vector<Geometry::Vec3> buffer(std::min(numVerts, transformChunkSize));
+	for(uint32_t i=begin;i<end;i+=transformChunkSize) {
+		const uint32_t count = std::min(transformChunkSize, end-i);
+		normalAccessor->getNormals(i, count, buffer.data());
+		for(uint32_t j=0;j<count;++j)
+			buffer[j] = (transMat * Geometry::Vec4(buffer[j],0)).xyz();
+		normalAccessor->setNormals(i, count, buffer.data());
+	}
 	vData.markAsChanged();
 }
 
+//! (internal) Copy @p count vertices from @p source (with any layout) to the interleaved vertex data at @p target.
+static void copyVertices(const MeshVertexData & source, uint32_t sourceBegin, uint8_t * target, uint32_t count) {
+	const VertexDescription & vd = source.getVertexDescription();
+	const std::size_t vertexSize = vd.getVertexSize();
+	if(source.getLayout() == VertexLayout::INTERLEAVED) {
+		const uint8_t * begin = source.data() + sourceBegin * vertexSize;
+		std::copy(begin, begin + count * vertexSize, target);
+		return;
+	}
+	for(const auto & attr : vd.getAttributes()) {
+		const std::size_t sourceStride = source.getAttributeStride(attr);
+		const uint8_t * src = source.getAttributeData(attr) + sourceBegin * sourceStride;
+		uint8_t * dst = target + attr.getOffset();
+		for(uint32_t i = 0; i < count; ++i) {
+			std::copy(src, src + attr.getDataSize(), dst);
+			src += sourceStride;
+			dst += vertexSize;
+		}
+	}
+}
+
+//! (internal) Copy @p count vertices from @p source to @p target (both having the same vertex description) independent of their layouts.
+static void copyVertices(const MeshVertexData & source, uint32_t sourceBegin, MeshVertexData & target, uint32_t targetBegin, uint32_t count) {
+	const VertexDescription & vd = source.getVertexDescription();
+	if(target.getLayout() == VertexLayout::INTERLEAVED) {
+		copyVertices(source, sourceBegin, target.data() + targetBegin * vd.getVertexSize(), count);
+		return;
+	}
+	for(const auto & attr : vd.getAttributes()) {
+		const std::size_t sourceStride = source.getAttributeStride(attr);
+		const std::size_t targetStride = target.getAttributeStride(attr);
+		const uint8_t * src = source.getAttributeData(attr) + sourceBegin * sourceStride;
+		uint8_t * dst = target.getAttributeData(attr) + targetBegin * targetStride;
+		for(uint32_t i = 0; i < count; ++i) {
+			std::copy(src, src + attr.getDataSize(), dst);
+			src += sourceStride;
+			dst += targetStride;
+		}
+	}
+}
+
 //! (static)
 MeshVertexData * convertVertices(const MeshVertexData & oldVertices, const VertexDescription & newVertexDescription) {
 
@@ -638,8 +748,6 @@ MeshVertexData * convertVertices(const MeshVertexData & oldVertices, const Verte
 	// Initialize the data with zero.
 	std::fill_n(newVertices->data(), newVertices->dataSize(), 0);
 
-	const std::size_t oldVertexSize = oldVertexDescription.getVertexSize();
-	const std::size_t newVertexSize = newVertexDescription.getVertexSize();
 	for(const auto & oldAttr : oldVertexDescription.getAttributes()) {
 		const VertexAttribute & newAttr = newVertexDescription.getAttribute(oldAttr.getNameId());
 
@@ -647,8 +755,10 @@ MeshVertexData * convertVertices(const MeshVertexData & oldVertices, const Verte
 			continue;
 		}
 		uint32_t dataSize = std::min(oldAttr.getDataSize(), newAttr.getDataSize());
-		const uint8_t * source = oldVertices.data() + oldAttr.getOffset();
-		uint8_t * target = newVertices->data() + newAttr.getOffset();
+		const std::size_t oldVertexSize = oldVertices.getAttributeStride(oldAttr);
+		const std::size_t newVertexSize = newVertices->getAttributeStride(newAttr);
+		const uint8_t * source = oldVertices.getAttributeData(oldAttr);
+		uint8_t * target = newVertices->getAttributeData(newAttr);
 		for (uint32_t i = 0; i < numVertices; ++i) {
 			std::copy(source, source + dataSize, target);
 			source += oldVertexSize;
@@ -690,8 +800,152 @@ void removeColorData(Mesh * m) {
 	vertices.swap(*newVertices.get());
 }
 
+//! (internal) Number of triangles processed together by calculateFaceNormals(...).
+static const uint32_t faceNormalBlockSize = 16;
+
+/*! (internal) Calculate the face normals (three floats per triangle) of the triangles [@p begin, @p end).
+	For NormalWeighting::AREA, the length of a normal is twice the triangle's area; otherwise, it is normalized.
+	For NormalWeighting::ANGLE, the interior angles of the triangle's corners are stored in @p cornerAngles.
+	The positions of a block of triangles are gathered into separate coordinate arrays first,
+	so that the arithmetic on the blocks can be vectorized by the compiler. */
+static void calculateFaceNormals(const std::vector<uint32_t> & indices, const std::vector<Geometry::Vec3> & positions, NormalWeighting weighting,
+								 std::size_t begin, std::size_t end, float * faceNormals, float * cornerAngles) {
+	const uint32_t B = faceNormalBlockSize;
+	float ax[B], ay[B], az[B], bx[B], by[B], bz[B], cx[B], cy[B], cz[B];
+	float nx[B], ny[B], nz[B], length[B];
+	for(std::size_t blockBegin = begin; blockBegin < end; blockBegin += B) {
+		const uint32_t count = static_cast<uint32_t>(std::min<std::size_t>(B, end - blockBegin));
+		for(uint32_t i = 0; i < count; ++i) {
+			const std::size_t corner = (blockBegin + i) * 3;
+			const Geometry::Vec3 & a = positions[indices[corner + 0]];
+			const Geometry::Vec3 & b = positions[indices[corner + 1]];
+			const Geometry::Vec3 & c = positions[indices[corner + 2]];
+			ax[i] = a.getX(), ay[i] = a.getY(), az[i] = a.getZ();
+			bx[i] = b.getX(), by[i] = b.getY(), bz[i] = b.getZ();
+			cx[i] = c.getX(), cy[i] = c.getY(), cz[i] = c.getZ();
+		}
+		// The arithmetic runs on whole blocks; the tail of the last block is set to degenerate triangles.
+		for(uint32_t i = count; i < B; ++i) {
+			ax[i] = ay[i] = az[i] = bx[i] = by[i] = bz[i] = cx[i] = cy[i] = cz[i] = 0.0f;
+		}
+		// n = cb x ab
+		for(uint32_t i = 0; i < B; ++i) {
+			const float ux = cx[i] - bx[i], uy = cy[i] - by[i], uz = cz[i] - bz[i];
+			const float vx = ax[i] - bx[i], vy = ay[i] - by[i], vz = az[i] - bz[i];
+			nx[i] = uy * vz - uz * vy;
+			ny[i] = uz * vx - ux * vz;
+			nz[i] = ux * vy - uy * vx;
+			length[i] = std::sqrt(nx[i] * nx[i] + ny[i] * ny[i] + nz[i] * nz[i]);
+		}
+		if(weighting != NormalWeighting::AREA) {
+			for(uint32_t i = 0; i < B; ++i) {
+				const float scale = length[i] > 0.0f ? 1.0f / length[i] : 0.0f;
+				nx[i] *= scale;
+				ny[i] *= scale;
+				nz[i] *= scale;
+			}
+		}
+		for(uint32_t i = 0; i < count; ++i) {
+			float * n = faceNormals + (blockBegin + i) * 3;
+			n[0] = nx[i], n[1] = ny[i], n[2] = nz[i];
+		}
+		if(weighting == NormalWeighting::ANGLE) {
+			// angle = atan2(|e1 x e2|, e1 * e2); the length of the cross product is the same for all corners
+			for(uint32_t i = 0; i < count; ++i) {
+				const float abx = bx[i] - ax[i], aby = by[i] - ay[i], abz = bz[i] - az[i];
+				const float bcx = cx[i] - bx[i], bcy = cy[i] - by[i], bcz = cz[i] - bz[i];
+				const float cax = ax[i] - cx[i], cay = ay[i] - cy[i], caz = az[i] - cz[i];
+				float * angles = cornerAngles + (blockBegin + i) * 3;
+				angles[0] = std::atan2(length[i], -(abx * cax + aby * cay + abz * caz));
+				angles[1] = std::atan2(length[i], -(bcx * abx + bcy * aby + bcz * abz));
+				angles[2] = std::atan2(length[i], -(cax * bcx + cay * bcy + caz * bcz));
+			}
+		}
+	}
+}
+
+/*! (internal) Triangle corners using each vertex in compressed rows: the corners of vertex v are
+	vertexCorners[cornerBegin[v] .. cornerBegin[v+1]). Corner c belongs to triangle c/3.
+	Allows accumulating per vertex values of the adjacent triangles in parallel without synchronization. */
+struct VertexCornerMap {
+	//! Vertex index of each corner (the index data as 32bit values).
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> cornerBegin;
+	std::vector<uint32_t> vertexCorners;
+
+	//! Returns false if the index data references a vertex that does not exist.
+	bool build(const MeshIndexData & indexData, uint32_t vertexCount) {
+		const std::size_t cornerCount = static_cast<std::size_t>(indexData.getIndexCount() / 3) * 3;
+		indices.resize(cornerCount);
+		cornerBegin.assign(static_cast<std::size_t>(vertexCount) + 1, 0);
+		for(uint32_t corner = 0; corner < cornerCount; ++corner) {
+			const uint32_t index = indexData[corner];
+			if(index >= vertexCount) {
+				return false;
+			}
+			indices[corner] = index;
+			++cornerBegin[index + 1];
+		}
+		for(uint32_t v = 0; v < vertexCount; ++v) {
+			cornerBegin[v + 1] += cornerBegin[v];
+		}
+		vertexCorners.resize(cornerCount);
+		std::vector<uint32_t> fill(cornerBegin.begin(), cornerBegin.end() - 1);
+		for(uint32_t corner = 0; corner < cornerCount; ++corner) {
+			vertexCorners[fill[indices[corner]]++] = corner;
+		}
+		return true;
+	}
+	uint32_t getTriangleCount() const	{	return static_cast<uint32_t>(indices.size() / 3);	}
+};
+
+//! (internal) Minimal number of triangles or vertices per thread for calculateNormals(...) and calculateTangentVectors(...).
+static const uint32_t minTangentSpaceChunkSize = 1 << 14;
+
+//! (internal) Weighted sum of the face normals adjacent to vertex @p v (see calculateFaceNormals(...)); not normalized.
+static inline void accumulateVertexNormal(const VertexCornerMap & corners, uint32_t v, NormalWeighting weighting,
+										  const std::vector<float> & faceNormals, const std::vector<float> & cornerAngles, float * n) {
+	n[0] = n[1] = n[2] = 0.0f;
+	for(uint32_t i = corners.cornerBegin[v]; i < corners.cornerBegin[v + 1]; ++i) {
+		const uint32_t corner = corners.vertexCorners[i];
+		const float * faceNormal = faceNormals.data() + (corner / 3) * 3;
+		const float weight = weighting == NormalWeighting::ANGLE ? cornerAngles[corner] : 1.0f;
+		n[0] += faceNormal[0] * weight;
+		n[1] += faceNormal[1] * weight;
+		n[2] += faceNormal[2] * weight;
+	}
+}
+
+//! (internal)
+static inline void normalizeIfNotZero(float * v) {
+	const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	if(length > 0.0f) {
+		v[0] /= length, v[1] /= length, v[2] /= length;
+	}
+}
+
+/*! (internal) Throw an std::invalid_argument if the normals cannot be written by storeNormal(...)
+	(the formats supported by the NormalAttributeAccessor). */
+static void assertNormalFormat(const VertexAttribute & normalAttr, const std::string & functionName) {
+	if(!(normalAttr.getDataType() == GL_FLOAT && normalAttr.getNumValues() >= 3) && !(normalAttr.getDataType() == GL_BYTE && normalAttr.getNumValues() >= 4))
+		INVALID_ARGUMENT_EXCEPTION(functionName + ": Unsupported normal format.");
+}
+
+//! (internal) Store the normal @p n at @p target as three floats or as normalized signed bytes (like the NormalAttributeAccessor).
+static inline void storeNormal(const VertexAttribute & normalAttr, const float * n, uint8_t * target) {
+	if(normalAttr.getDataType() == GL_FLOAT) {
+		float * v = reinterpret_cast<float *>(target);
+		v[0] = n[0], v[1] = n[1], v[2] = n[2];
+	} else {
+		int8_t * v = reinterpret_cast<int8_t *>(target);
+		v[0] = Geometry::Convert::toSigned<int8_t>(n[0]);
+		v[1] = Geometry::Convert::toSigned<int8_t>(n[1]);
+		v[2] = Geometry::Convert::toSigned<int8_t>(n[2]);
+	}
+}
+
 //! (static)
-void calculateNormals(Mesh * m) {
+void calculateNormals(Mesh * m, NormalWeighting weighting) {
 	MeshVertexData & vData = m->openVertexData();
 
 	// add normals to vData if necessary
@@ -702,81 +956,114 @@ void calculateNormals(Mesh * m) {
 		vData.swap(*newVertices.get());
 	}
 
-	const uint32_t vertexCount = vData.getVertexCount();
+	const VertexAttribute & normalAttr = vData.getVertexDescription().getAttribute(VertexAttributeIds::NORMAL);
+	assertNormalFormat(normalAttr, "calculateNormals");
 
-	std::vector<Geometry::Vec3> normals(vertexCount);
+	const uint32_t vertexCount = vData.getVertexCount();
+	std::vector<Geometry::Vec3> positions(vertexCount);
+	{
+		Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vData, VertexAttributeIds::POSITION));
+		positionAccessor->getPositions(0, vertexCount, positions.data());
+	}
 
-	// accumulate normals
-	const MeshIndexData & indices = m->openIndexData();
-	const uint32_t indexCount = m->getIndexCount();
-	Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vData,VertexAttributeIds::POSITION));
-	for (uint32_t i = 0; i < indexCount-2; i += 3) {
-		// n = cb x ab
-		const Geometry::Vec3 a( positionAccessor->getPosition(indices[i + 0]) );
-		const Geometry::Vec3 b( positionAccessor->getPosition(indices[i + 1]) );
-		const Geometry::Vec3 c( positionAccessor->getPosition(indices[i + 2]) );
-
-		Geometry::Vec3 n( (c-b).cross(a-b) );
-		const float length = n.length();
-		if(length>0)
-			n.normalize();
-		normals[indices[i+0]] += n;
-		normals[indices[i+1]] += n;
-		normals[indices[i+2]] += n;
-	}
-
-	// set normals
-	Util::Reference<NormalAttributeAccessor> normalAccessor(NormalAttributeAccessor::create(vData,VertexAttributeIds::NORMAL));
-	for(uint32_t i=0;i<vertexCount;++i){
-		const Geometry::Vec3 n = normals[i];
-		const float length = n.length();
-		normalAccessor->setNormal(i, length>0 ? n/length : n);
+	VertexCornerMap corners;
+	if(!corners.build(m->openIndexData(), vertexCount)) {
+		WARN("calculateNormals: Invalid vertex index.");
+		return;
 	}
+	const uint32_t triangleCount = corners.getTriangleCount();
+
+	// face normals
+	std::vector<float> faceNormals(static_cast<std::size_t>(triangleCount) * 3);
+	std::vector<float> cornerAngles(weighting == NormalWeighting::ANGLE ? corners.indices.size() : 0);
+	ParallelFor::forEachChunk(triangleCount, ParallelFor::getChunkCount(triangleCount, minTangentSpaceChunkSize), [&](uint32_t, std::size_t begin, std::size_t end) {
+		calculateFaceNormals(corners.indices, positions, weighting, begin, end, faceNormals.data(), cornerAngles.data());
+	});
+
+	// Requesting writable access copies shared or external data (once, before the threads write); the pointer
+	// stays valid while the threads write the normals of their vertices.
+	uint8_t * const base = vData.data();
+	uint8_t * const normalData = base + vData.getAttributeOffset(normalAttr);
+	const std::size_t normalStride = vData.getAttributeStride(normalAttr);
+
+	// accumulate and store the normals
+	ParallelFor::forEachChunk(vertexCount, ParallelFor::getChunkCount(vertexCount, minTangentSpaceChunkSize), [&](uint32_t, std::size_t begin, std::size_t end) {
+		for(std::size_t v = begin; v < end; ++v) {
+			float n[3];
+			accumulateVertexNormal(corners, static_cast<uint32_t>(v), weighting, faceNormals, cornerAngles, n);
+			normalizeIfNotZero(n);
+			storeNormal(normalAttr, n, normalData + v * normalStride);
+		}
+	});
 	vData.markAsChanged();
 }
-/**
- * [static]
- * Combines the meshes from meshArray to a single mesh.
- * Must have identical VertexDescription.
- */
-Mesh * combineMeshes(const std::deque<Mesh *> & meshArray) {
-	return combineMeshes(meshArray, std::deque<Geometry::Matrix4x4>());
+//! (internal) Minimal number of vertices per thread used by combineMeshes(...).
+static const std::size_t minCombineVerticesPerChunk = 1 << 15;
+
+//! (internal) A mesh taking part in combineMeshes(...) and the position of its data in the combined mesh.
+struct CombineSource {
+	const MeshVertexData * vertices;
+	const MeshIndexData * indices;
+	const Geometry::Matrix4x4 * transformation; //!< nullptr if the vertices are copied unchanged
+	uint32_t firstVertex;
+	uint32_t firstIndex;
+	bool transformPositionsLater;
+	bool transformNormalsLater;
+};
+
+//! (internal) Copy @p count indices of type index_t and add @p offset to each of them.
+template<typename index_t>
+static void copyIndices(const uint8_t * source, uint32_t count, uint32_t offset, uint32_t * target) {
+	const index_t * sourceIndices = reinterpret_cast<const index_t *>(source);
+	for(uint32_t i = 0; i < count; ++i)
+		target[i] = static_cast<uint32_t>(sourceIndices[i]) + offset;
 }
-Mesh * combineMeshes(const std::deque<Mesh *> & meshArray, const std::deque<Geometry::Matrix4x4> & transformations) {
-	if (meshArray.empty()) {
+
+/*! (internal) Combine the meshes of the given (mesh, transformation or nullptr) entries.
+	The sizes of the result are computed in advance, so its data is allocated once. Afterwards, every
+	thread copies (and transforms) whole meshes into their ranges of the result, taking the next
+	mesh from a shared counter. Affine transformations of float positions and float normals are
+	applied by the TransformKernels; other cases use the accessors after the parallel part.	*/
+static Mesh * combineMeshEntries(const std::vector<std::pair<Mesh *, const Geometry::Matrix4x4 *>> & entries) {
+	if (entries.empty()) {
 		return nullptr;
 	}
 
-	Mesh * firstMesh = meshArray.front();
+	Mesh * firstMesh = entries.front().first;
 	if (!firstMesh)
 		FAIL();
 
 	const VertexDescription & vd = firstMesh->getVertexDescription();
+	const Geometry::Matrix4x4 noTrans;
 
-	std::deque<Mesh *> meshArray2; //< collect meshes which have the same vertexDescription
-	std::deque<Geometry::Matrix4x4> transformations2; //< collect meshes which have the same vertexDescription
-
-	//count vertices and indices, check if Meshes exist and have the same vertexDescription
+	// collect the meshes which have the same vertexDescription and count their vertices and indices
+	std::vector<CombineSource> sources;
+	sources.reserve(entries.size());
 	uint32_t indexCount = 0;
 	uint32_t vertexCount = 0;
-	{
-		auto tIt = transformations.begin();
-		for (auto it = meshArray.begin(); it != meshArray.end(); ++it, (tIt != transformations.end() ? ++tIt : tIt)) {
-			if (!(*it)) {
-				WARN("combineMeshes: No Mesh");
-				continue;
-			}
-			if (!((*it)->getVertexDescription() == vd)) {
-				WARN("combineMeshes: can't combine meshes with different vertex descriptions.");
-				std::cout << (*it)->getVertexDescription().toString() << ":" << vd.toString() << "\n";
-				continue;
-			}
-			meshArray2.push_back(*it);
-			if (tIt != transformations.end())
-				transformations2.push_back(*tIt);
-			indexCount += (*it)->getIndexCount();
-			vertexCount += (*it)->getVertexCount();
+	for(const auto & entry : entries) {
+		Mesh * currentMesh = entry.first;
+		if (!currentMesh) {
+			WARN("combineMeshes: No Mesh");
+			continue;
+		}
+		if (currentMesh->getVertexDescriptionId() != firstMesh->getVertexDescriptionId()) {
+			WARN("combineMeshes: can't combine meshes with different vertex descriptions.");
+			std::cout << currentMesh->getVertexDescription().toString() << ":" << vd.toString() << "\n";
+			continue;
 		}
+		// The data is opened here, as opening may download it from the GPU.
+		CombineSource source;
+		source.vertices = &currentMesh->openVertexData();
+		source.indices = &currentMesh->openIndexData();
+		source.transformation = (entry.second != nullptr && *entry.second != noTrans) ? entry.second : nullptr;
+		source.firstVertex = vertexCount;
+		source.firstIndex = indexCount;
+		source.transformPositionsLater = false;
+		source.transformNormalsLater = false;
+		sources.push_back(source);
+		indexCount += source.indices->getIndexCount();
+		vertexCount += source.vertices->getVertexCount();
 	}
 	// create mesh
 	auto mesh = new Mesh;
@@ -785,29 +1072,72 @@ Mesh * combineMeshes(const std::deque<Mesh *> & meshArray, const std::deque<Geom
 	MeshIndexData & indices = mesh->openIndexData();
 	indices.allocate(indexCount);
 
-	// copy data
-
-	uint32_t indexPointer = 0;
-	uint32_t vertexPointer = 0;
+	uint8_t * targetVertices = vertices.data();
+	uint32_t * targetIndices = indices.data();
+	const std::size_t vertexSize = vd.getVertexSize();
+	const VertexAttribute & posAttr = vd.getAttribute(VertexAttributeIds::POSITION);
+	const bool floatPositions = !posAttr.empty() && posAttr.getDataType() == GL_FLOAT && posAttr.getNumValues() >= 3;
+	const bool hasNormals = vd.hasAttribute(VertexAttributeIds::NORMAL);
+	const VertexAttribute & normalAttr = vd.getAttribute(VertexAttributeIds::NORMAL);
+	const bool floatNormals = hasNormals && normalAttr.getDataType() == GL_FLOAT && normalAttr.getNumValues() >= 3;
 
-	Geometry::Matrix4x4 noTrans;
-	auto tIt2 = transformations2.cbegin();
-	for (auto it = meshArray2.cbegin(); it != meshArray2.cend(); ++it, (tIt2 != transformations2.cend() ? ++tIt2 : tIt2)) {
-		Mesh * currentMesh = *it;
-		// add modified indices
-		MeshIndexData & currentIndices = currentMesh->openIndexData();
-		for (uint32_t j = 0; j < currentIndices.getIndexCount(); ++j)
-			indices[indexPointer + j] = currentIndices[j] + vertexPointer;
-		indexPointer += currentIndices.getIndexCount();
+	// copy data
+	std::atomic<std::size_t> nextSource(0);
+	const uint32_t chunkCount = std::min<uint32_t>(ParallelFor::getChunkCount(vertexCount, minCombineVerticesPerChunk), static_cast<uint32_t>(sources.size()));
+	ParallelFor::forEachChunk(sources.size(), chunkCount, [&](uint32_t, std::size_t, std::size_t) {
+		for(std::size_t s = nextSource++; s < sources.size(); s = nextSource++) {
+			CombineSource & source = sources[s];
+
+			// add modified indices
+			const MeshIndexData & currentIndices = *source.indices;
+			const uint32_t currentIndexCount = currentIndices.getIndexCount();
+			if(currentIndexCount > 0) {
+				uint32_t * target = targetIndices + source.firstIndex;
+				switch(currentIndices.getIndexType()) {
+					case GL_UNSIGNED_BYTE:
+						copyIndices<uint8_t>(currentIndices.rawData(), currentIndexCount, source.firstVertex, target);
+						break;
+					case GL_UNSIGNED_SHORT:
+						copyIndices<uint16_t>(currentIndices.rawData(), currentIndexCount, source.firstVertex, target);
+						break;
+					default:
+						copyIndices<uint32_t>(currentIndices.rawData(), currentIndexCount, source.firstVertex, target);
+				}
+			}
 
-		// add vertices
-		MeshVertexData & currentVertices = currentMesh->openVertexData();
-		std::copy(currentVertices.data(), currentVertices.data() + currentVertices.dataSize(), vertices[vertexPointer]);
+			// add vertices
+			const MeshVertexData & currentVertices = *source.vertices;
+			const uint32_t currentVertexCount = currentVertices.getVertexCount();
+			if(currentVertexCount == 0)
+				continue;
+			uint8_t * target = targetVertices + source.firstVertex * vertexSize;
+			copyVertices(currentVertices, 0, target, currentVertexCount);
 
-		if (tIt2 != transformations2.cend() && (*tIt2) != noTrans) {
-			transformVertexData(vertices, (*tIt2), vertexPointer, currentVertices.getVertexCount());
+			if(source.transformation == nullptr)
+				continue;
+			const Geometry::Matrix4x4 & transMat = *source.transformation;
+			float rows[12];
+			for(uint_fast8_t row = 0; row < 3; ++row) {
+				for(uint_fast8_t column = 0; column < 4; ++column)
+					rows[row * 4 + column] = transMat.at(row, column);
+			}
+			const bool affine = transMat.at(3, 0) == 0.0f && transMat.at(3, 1) == 0.0f && transMat.at(3, 2) == 0.0f && transMat.at(3, 3) == 1.0f;
+			if(floatPositions && affine)
+				TransformKernels::transformPositions(target + posAttr.getOffset(), currentVertexCount, vertexSize, rows);
+			else
+				source.transformPositionsLater = true;
+			if(floatNormals)
+				TransformKernels::transformDirections(target + normalAttr.getOffset(), currentVertexCount, vertexSize, rows);
+			else if(hasNormals)
+				source.transformNormalsLater = true;
 		}
-		vertexPointer += currentVertices.getVertexCount();
+	});
+
+	for(const auto & source : sources) {
+		if(source.transformPositionsLater)
+			transformCoordinates(vertices, VertexAttributeIds::POSITION, *source.transformation, source.firstVertex, source.vertices->getVertexCount());
+		if(source.transformNormalsLater)
+			transformNormals(vertices, VertexAttributeIds::NORMAL, *source.transformation, source.firstVertex, source.vertices->getVertexCount());
 	}
 	vertices.updateBoundingBox();
 	indices.updateIndexRange();
@@ -815,6 +1145,33 @@ Mesh * combineMeshes(const std::deque<Mesh *> & meshArray, const std::deque<Geom
 	return mesh;
 }
 
+/**
+ * [static]
+ * Combines the meshes from meshArray to a single mesh.
+ * Must have identical VertexDescription.
+ */
+Mesh * combineMeshes(const std::deque<Mesh *> & meshArray) {
+	std::vector<std::pair<Mesh *, const Geometry::Matrix4x4 *>> entries;
+	entries.reserve(meshArray.size());
+	for(const auto & currentMesh : meshArray)
+		entries.emplace_back(currentMesh, nullptr);
+	return combineMeshEntries(entries);
+}
+Mesh * combineMeshes(const std::deque<Mesh *> & meshArray, const std::deque<Geometry::Matrix4x4> & transformations) {
+	std::vector<std::pair<Mesh *, const Geometry::Matrix4x4 *>> entries;
+	entries.reserve(meshArray.size());
+	for(std::size_t i = 0; i < meshArray.size(); ++i)
+		entries.emplace_back(meshArray[i], i < transformations.size() ? &transformations[i] : nullptr);
+	return combineMeshEntries(entries);
+}
+Mesh * combineMeshes(const std::vector<std::pair<Mesh *, Geometry::Matrix4x4>> & meshes) {
+	std::vector<std::pair<Mesh *, const Geometry::Matrix4x4 *>> entries;
+	entries.reserve(meshes.size());
+	for(const auto & entry : meshes)
+		entries.emplace_back(entry.first, &entry.second);
+	return combineMeshEntries(entries);
+}
+
 /**
  * [static]
  * Splits a meshs vertex data into several data chunks of the given size.
@@ -839,11 +1196,7 @@ std::deque<MeshVertexData> splitVertexData(Mesh * mesh, uint32_t chunkSize){
 		MeshVertexData currentVertices;
 		currentVertices.allocate(currentChunkSize, desc);
 
-		uint32_t chunkFront = vertexPointer * desc.getVertexSize();
-		uint32_t chunkEnd = chunkFront + currentChunkSize * desc.getVertexSize();
-
-
-		std::copy(meshVertices.data() + chunkFront, meshVertices.data() + chunkEnd, currentVertices.data());
+		copyVertices(meshVertices, vertexPointer, currentVertices, 0, currentChunkSize);
 
 		result.emplace_back(std::move(currentVertices));
 
@@ -869,70 +1222,72 @@ MeshVertexData * extractVertexData(Mesh * mesh, uint32_t begin, uint32_t length)
 	auto result = new MeshVertexData;
 	result->allocate(length, desc);
 
-	uint32_t front = begin*desc.getVertexSize();
-	uint32_t end = front + length*desc.getVertexSize();
-
-	std::copy(meshVertices.data() + front, meshVertices.data() + end, result->data());
+	copyVertices(meshVertices, begin, *result, 0, length);
 
 	return result;
 
 }
 
-//! (static)
-void eliminateDuplicateVertices(Mesh * mesh) {
-	const VertexDescription & desc = mesh->getVertexDescription();
-	const uint32_t indexCount = mesh->getIndexCount();
-
-	// Set of vertices used to create unique vertices.
-	std::set<RawVertex> rawVertices;
-	// Mapping from old index to new index.
-	std::map<uint32_t, uint32_t> indexReplace;
-
-	// Simply go over the indices and add one vertex after another.
-	{
-		const MeshVertexData & vertices = mesh->openVertexData();
-		const MeshIndexData & indices = mesh->openIndexData();
-		const std::size_t vertexSize = desc.getVertexSize();
-
-		for (uint32_t counter = 0; counter < indexCount; ++counter) {
-			const uint32_t index = indices[counter];
-			const uint8_t * vertex = vertices[index];
-			RawVertex raw(index, vertex, vertexSize);
-			auto it = rawVertices.insert(raw).first;
-			indexReplace.insert(std::make_pair(index, it->getIndex()));
+//! (internal) Marker for unused entries in the index tables of eliminateDuplicateVertices(...) and mergeCloseVertices(...).
+static const uint32_t NO_VERTEX = 0xffffffff;
+
+/*! (internal) Collect the vertices referenced by @p indices in the order of their first use.
+	@param positionOfVertex Receives the position of each vertex in @p usedVertices (or NO_VERTEX if it is not used)
+	\throw std::out_of_range if an index references a vertex that does not exist. */
+static void collectUsedVertices(const MeshIndexData & indices, uint32_t vertexCount, std::vector<uint32_t> & positionOfVertex, std::vector<uint32_t> & usedVertices) {
+	positionOfVertex.assign(vertexCount, NO_VERTEX);
+	usedVertices.clear();
+	usedVertices.reserve(vertexCount);
+	for(uint32_t counter = 0; counter < indices.getIndexCount(); ++counter) {
+		const uint32_t index = indices[counter];
+		if(index >= vertexCount)
+			throw std::out_of_range("Index " + Util::StringUtils::toString(counter) + " references vertex " + Util::StringUtils::toString(index) + " of overall " + Util::StringUtils::toString(vertexCount) + " vertices.");
+		if(positionOfVertex[index] == NO_VERTEX) {
+			positionOfVertex[index] = static_cast<uint32_t>(usedVertices.size());
+			usedVertices.push_back(index);
 		}
 	}
+}
+
+/*! (internal) Replace the data of @p mesh by the representative vertices.
+	@param usedVertices,positionOfVertex Result of collectUsedVertices(...)
+	@param representatives For each position in @p usedVertices, the smallest position of a vertex
+		that replaces it (a representative is its own representative). */
+static void replaceByRepresentatives(Mesh * mesh, const std::vector<uint32_t> & usedVertices, const std::vector<uint32_t> & positionOfVertex,
+										const std::vector<uint32_t> & representatives) {
+	const std::size_t usedCount = usedVertices.size();
+	const uint32_t indexCount = mesh->getIndexCount();
 
-	// Mapping from new index to vertex position.
-	std::map<uint32_t, uint32_t> indexPosition;
+	// Number the representatives in the order of their first use.
+	std::vector<uint32_t> newIndexOfPosition(usedCount);
+	uint32_t newVertexCount = 0;
+	for(std::size_t k = 0; k < usedCount; ++k) {
+		newIndexOfPosition[k] = representatives[k] == k ? newVertexCount++ : newIndexOfPosition[representatives[k]];
+	}
 
-	// Create the new mesh and add the rawVertices.
+	// Create the new mesh and add the representatives.
 	Util::Reference<Mesh> result = new Mesh;
 	result->setDataStrategy(mesh->getDataStrategy());
+	result->setDrawMode(mesh->getDrawMode());
+	result->setFileName(mesh->getFileName());
 
 	MeshVertexData & vertices = result->openVertexData();
-	vertices.allocate(rawVertices.size(), desc);
+	vertices.allocate(newVertexCount, mesh->getVertexDescription());
 
 	MeshIndexData & indices = result->openIndexData();
 	indices.allocate(indexCount);
 
 	{
-		uint8_t * data = vertices.data();
-		uint32_t vertexPos = 0;
-		for(const auto & vertex : rawVertices) {
-			std::copy(vertex.getData(), vertex.getData() + vertex.getSize(), data);
-			data += vertex.getSize();
-			indexPosition.insert(std::make_pair(vertex.getIndex(), vertexPos));
-			++vertexPos;
+		const MeshVertexData & sourceVertices = mesh->openVertexData();
+		for(std::size_t k = 0; k < usedCount; ++k) {
+			if(representatives[k] == k)
+				copyVertices(sourceVertices, usedVertices[k], vertices, newIndexOfPosition[k], 1);
 		}
 		// Translate the indices.
-		const uint32_t * srcIndex = mesh->openIndexData().data();
+		const MeshIndexData & sourceIndices = mesh->openIndexData();
 		uint32_t * dstIndex = indices.data();
-		for (uint32_t counter = 0; counter < indexCount; ++counter) {
-			const uint32_t newIndex = indexReplace.find(*srcIndex)->second;
-			*dstIndex = indexPosition.find(newIndex)->second;
-			++srcIndex;
-			++dstIndex;
+		for(uint32_t counter = 0; counter < indexCount; ++counter) {
+			dstIndex[counter] = newIndexOfPosition[positionOfVertex[sourceIndices[counter]]];
 		}
 	}
 
@@ -942,6 +1297,104 @@ void eliminateDuplicateVertices(Mesh * mesh) {
 	mesh->swap(*result.get());
 }
 
+//! (internal) Hash of the raw bytes of a vertex (processed word-wise).
+static uint32_t hashVertexBytes(const uint8_t * data, std::size_t size) {
+	uint64_t h = 0xcbf29ce484222325ull ^ size;
+	std::size_t i = 0;
+	for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+		uint64_t word;
+		std::memcpy(&word, data + i, sizeof(uint64_t));
+		h = (h ^ word) * 0x100000001b3ull;
+		h ^= h >> 29;
+	}
+	for(; i < size; ++i) {
+		h = (h ^ data[i]) * 0x100000001b3ull;
+	}
+	h ^= h >> 32;
+	return static_cast<uint32_t>(h);
+}
+
+/*! (internal) Find the first of several equal vertices.
+	For each position k in @p vertexIds (only considering the positions k with @p partitionOfPosition[k] == @p partition),
+	@p representatives[k] is set to the smallest position having the same vertex data. An open addressing
+	hash table of positions is used.
+	@param partitionSize Number of positions in the partition; the table has at least twice as many slots,
+		so the probing always finds a free slot. */
+static void findRepresentatives(const uint8_t * vertexData, std::size_t vertexSize, const std::vector<uint32_t> & vertexIds,
+								const std::vector<uint32_t> & hashes, const std::vector<uint32_t> & partitionOfPosition, uint32_t partition,
+								std::size_t partitionSize, std::vector<uint32_t> & representatives) {
+	static const uint32_t EMPTY = 0xffffffff;
+	std::size_t capacity = 16;
+	while(capacity < 2 * partitionSize)
+		capacity <<= 1;
+	const std::size_t mask = capacity - 1;
+	std::vector<uint32_t> table(capacity, EMPTY);
+	for(uint32_t k = 0; k < vertexIds.size(); ++k) {
+		if(partitionOfPosition[k] != partition)
+			continue;
+		const uint32_t hash = hashes[k];
+		const uint8_t * vertex = vertexData + static_cast<std::size_t>(vertexIds[k]) * vertexSize;
+		std::size_t slot = hash & mask;
+		while(true) {
+			const uint32_t other = table[slot];
+			if(other == EMPTY) {
+				table[slot] = k;
+				representatives[k] = k;
+				break;
+			}
+			if(hashes[other] == hash && std::memcmp(vertexData + static_cast<std::size_t>(vertexIds[other]) * vertexSize, vertex, vertexSize) == 0) {
+				representatives[k] = other;
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+}
+
+//! (static)
+void eliminateDuplicateVertices(Mesh * mesh, bool parallel) {
+	const std::size_t vertexSize = mesh->getVertexDescription().getVertexSize();
+
+	// The comparison needs the vertices as contiguous bytes.
+	MeshVertexData interleavedCopy;
+	const MeshVertexData * sourceVertices = &mesh->openVertexData();
+	if(sourceVertices->getLayout() != VertexLayout::INTERLEAVED) {
+		interleavedCopy = MeshVertexData(*sourceVertices);
+		interleavedCopy.setLayout(VertexLayout::INTERLEAVED);
+		sourceVertices = &interleavedCopy;
+	}
+	const uint8_t * vertexData = sourceVertices->data();
+
+	std::vector<uint32_t> positionOfVertex;
+	std::vector<uint32_t> usedVertices;
+	collectUsedVertices(mesh->openIndexData(), sourceVertices->getVertexCount(), positionOfVertex, usedVertices);
+	const std::size_t usedCount = usedVertices.size();
+
+	// Hash the vertices and find the first occurrence of each distinct vertex.
+	// Equal vertices have equal hashes, so the partitions can be processed independently.
+	// The partition is selected by the upper bits, the table slots by the lower bits of the hash.
+	std::vector<uint32_t> hashes(usedCount);
+	std::vector<uint32_t> partitionOfPosition(usedCount);
+	std::vector<uint32_t> representatives(usedCount);
+	const uint32_t chunkCount = parallel ? ParallelFor::getChunkCount(usedCount, 1 << 16) : 1;
+	ParallelFor::forEachChunk(usedCount, chunkCount, [&](uint32_t, std::size_t begin, std::size_t end) {
+		for(std::size_t k = begin; k < end; ++k) {
+			hashes[k] = hashVertexBytes(vertexData + static_cast<std::size_t>(usedVertices[k]) * vertexSize, vertexSize);
+			partitionOfPosition[k] = static_cast<uint32_t>((static_cast<uint64_t>(hashes[k] >> 16) * chunkCount) >> 16);
+		}
+	});
+	// The partitions are not balanced (e.g. many equal vertices), so every table is sized by its actual number of entries.
+	std::vector<std::size_t> partitionSizes(chunkCount, 0);
+	for(const auto & partition : partitionOfPosition)
+		++partitionSizes[partition];
+	ParallelFor::forEachChunk(chunkCount, chunkCount, [&](uint32_t partition, std::size_t, std::size_t) {
+		findRepresentatives(vertexData, vertexSize, usedVertices, hashes, partitionOfPosition,
+							partition, partitionSizes[partition], representatives);
+	});
+
+	replaceByRepresentatives(mesh, usedVertices, positionOfVertex, representatives);
+}
+
 //! (static)
 Mesh * eliminateUnusedVertices(Mesh * mesh) {
 	const VertexDescription & desc = mesh->getVertexDescription();
@@ -976,10 +1429,9 @@ Mesh * eliminateUnusedVertices(Mesh * mesh) {
 
 	const MeshVertexData & oldVertexData = mesh->openVertexData();
 	MeshVertexData & newVertexData = newMesh->openVertexData();
-	const size_t vSize = desc.getVertexSize();
 	uint32_t i = 0;
 	for(const auto & oldIndex : usedOldVertices) {
-		std::copy(oldVertexData[oldIndex], oldVertexData[oldIndex] + vSize, newVertexData[i++]);
+		copyVertices(oldVertexData, oldIndex, newVertexData, i++, 1);
 	}
 	newVertexData.updateBoundingBox();
 
@@ -990,13 +1442,14 @@ Mesh * eliminateUnusedVertices(Mesh * mesh) {
 Mesh * eliminateLongTriangles(Mesh * mesh, float ratio) {
 	const MeshIndexData & originalIndices = mesh->openIndexData();
 	const MeshVertexData & vertexData = mesh->openVertexData();
+	Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION));
 	std::deque<uint32_t> newIndices;
 	const uint32_t indexCount = mesh->getIndexCount();
 
 	for (uint32_t counter = 0; counter < indexCount; counter += 3) {
-		Geometry::Vec3 p1(reinterpret_cast<const float*> (vertexData[originalIndices[counter]]));
-		Geometry::Vec3 p2(reinterpret_cast<const float*> (vertexData[originalIndices[counter + 1]]));
-		Geometry::Vec3 p3(reinterpret_cast<const float*> (vertexData[originalIndices[counter + 2]]));
+		const Geometry::Vec3 p1 = positionAccessor->getPosition(originalIndices[counter]);
+		const Geometry::Vec3 p2 = positionAccessor->getPosition(originalIndices[counter + 1]);
+		const Geometry::Vec3 p3 = positionAccessor->getPosition(originalIndices[counter + 2]);
 
 		float a2 = (p1 - p2).lengthSquared();
 		float b2 = (p2 - p3).lengthSquared();
@@ -1027,27 +1480,28 @@ Mesh * eliminateLongTriangles(Mesh * mesh, float ratio) {
 Mesh * eliminateTrianglesBehindPlane(Mesh * mesh, const Geometry::Plane & plane) {
 	const MeshIndexData & originalIndices = mesh->openIndexData();
 	const MeshVertexData & vertexData = mesh->openVertexData();
+	Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION));
 	std::deque<uint32_t> newIndices;
 	const uint32_t indexCount = mesh->getIndexCount();
 
 	for (uint_fast32_t counter = 0; counter < indexCount; counter += 3) {
-		const uint32_t & indexA = originalIndices[counter];
-		const uint32_t & indexB = originalIndices[counter + 1];
-		const uint32_t & indexC = originalIndices[counter + 2];
+		const uint32_t indexA = originalIndices[counter];
+		const uint32_t indexB = originalIndices[counter + 1];
+		const uint32_t indexC = originalIndices[counter + 2];
 		{
-			const Geometry::Vec3 vertex(reinterpret_cast<const float *> (vertexData[indexA]));
+			const Geometry::Vec3 vertex = positionAccessor->getPosition(indexA);
 			if (plane.planeTest(vertex) < 0.0f) {
 				continue;
 			}
 		}
 		{
-			const Geometry::Vec3 vertex(reinterpret_cast<const float *> (vertexData[indexB]));
+			const Geometry::Vec3 vertex = positionAccessor->getPosition(indexB);
 			if (plane.planeTest(vertex) < 0.0f) {
 				continue;
 			}
 		}
 		{
-			const Geometry::Vec3 vertex(reinterpret_cast<const float *> (vertexData[indexC]));
+			const Geometry::Vec3 vertex = positionAccessor->getPosition(indexC);
 			if (plane.planeTest(vertex) < 0.0f) {
 				continue;
 			}
@@ -1066,18 +1520,18 @@ Mesh * eliminateTrianglesBehindPlane(Mesh * mesh, const Geometry::Plane & plane)
 Mesh * eliminateZeroAreaTriangles(Mesh * mesh) {
 	const MeshIndexData & originalIndices = mesh->openIndexData();
 	const MeshVertexData & vertexData = mesh->openVertexData();
+	Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION));
 	const uint32_t indexCount = mesh->getIndexCount();
 	std::vector<uint32_t> newIndices;
 	newIndices.reserve(indexCount);
 
 	for (uint_fast32_t counter = 0; counter < indexCount; counter += 3) {
-		const uint32_t & indexA = originalIndices[counter];
-		const uint32_t & indexB = originalIndices[counter + 1];
-		const uint32_t & indexC = originalIndices[counter + 2];
-		const Geometry::Triangle<Geometry::Vec3f> triangle(
-						Geometry::Vec3f(reinterpret_cast<const float *>(vertexData[indexA])),
-						Geometry::Vec3f(reinterpret_cast<const float *>(vertexData[indexB])),
-						Geometry::Vec3f(reinterpret_cast<const float *>(vertexData[indexC])));
+		const uint32_t indexA = originalIndices[counter];
+		const uint32_t indexB = originalIndices[counter + 1];
+		const uint32_t indexC = originalIndices[counter + 2];
+		const Geometry::Triangle<Geometry::Vec3f> triangle(positionAccessor->getPosition(indexA),
+														   positionAccessor->getPosition(indexB),
+														   positionAccessor->getPosition(indexC));
 
 		if (!triangle.isDegenerate()) {
 			newIndices.push_back(indexA);
@@ -1130,14 +1584,19 @@ Mesh * removeSkinsWithHoleCovering(Mesh * mesh, float maxNormalZ, float covering
 	std::deque<uint32_t> newIndices;
 	const MeshVertexData & vertexData = mesh->openVertexData();
 	MeshVertexData newVertexData = vertexData;
+	Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION));
+	Util::Reference<PositionAttributeAccessor> newPositionAccessor(PositionAttributeAccessor::create(newVertexData, VertexAttributeIds::POSITION));
 
 	for (uint32_t counter = 0; counter < indexCount; counter += 3) {
-		const uint32_t & indexA = originalIndices[counter];
-		const uint32_t & indexB = originalIndices[counter + 1];
-		const uint32_t & indexC = originalIndices[counter + 2];
-		const float * vertexA = reinterpret_cast<const float *> (vertexData[indexA]);
-		const float * vertexB = reinterpret_cast<const float *> (vertexData[indexB]);
-		const float * vertexC = reinterpret_cast<const float *> (vertexData[indexC]);
+		const uint32_t indexA = originalIndices[counter];
+		const uint32_t indexB = originalIndices[counter + 1];
+		const uint32_t indexC = originalIndices[counter + 2];
+		const Geometry::Vec3 positionA = positionAccessor->getPosition(indexA);
+		const Geometry::Vec3 positionB = positionAccessor->getPosition(indexB);
+		const Geometry::Vec3 positionC = positionAccessor->getPosition(indexC);
+		const float vertexA[3] = { positionA.x(), positionA.y(), positionA.z() };
+		const float vertexB[3] = { positionB.x(), positionB.y(), positionB.z() };
+		const float vertexC[3] = { positionC.x(), positionC.y(), positionC.z() };
 
 		float normal[3];
 		calcNormal(vertexA, vertexB, vertexC, normal);
@@ -1151,19 +1610,16 @@ Mesh * removeSkinsWithHoleCovering(Mesh * mesh, float maxNormalZ, float covering
 			// Move the vertices lying in the background.
 			const float halfZ = (maxZ + minZ) / 2.0f;
 			if (vertexA[2] > halfZ) {
-				float * newVertexA = reinterpret_cast<float *> (newVertexData[indexA]);
-				newVertexA[0] += coveringMovement * depthRange * normal[0];
-				newVertexA[1] += coveringMovement * depthRange * normal[1];
+				const Geometry::Vec3 newVertexA = newPositionAccessor->getPosition(indexA);
+				newPositionAccessor->setPosition(indexA, newVertexA + Geometry::Vec3(normal[0], normal[1], 0.0f) * (coveringMovement * depthRange));
 			}
 			if (vertexB[2] > halfZ) {
-				float * newVertexB = reinterpret_cast<float *> (newVertexData[indexB]);
-				newVertexB[0] += coveringMovement * depthRange * normal[0];
-				newVertexB[1] += coveringMovement * depthRange * normal[1];
+				const Geometry::Vec3 newVertexB = newPositionAccessor->getPosition(indexB);
+				newPositionAccessor->setPosition(indexB, newVertexB + Geometry::Vec3(normal[0], normal[1], 0.0f) * (coveringMovement * depthRange));
 			}
 			if (vertexC[2] > halfZ) {
-				float * newVertexC = reinterpret_cast<float *> (newVertexData[indexC]);
-				newVertexC[0] += coveringMovement * depthRange * normal[0];
-				newVertexC[1] += coveringMovement * depthRange * normal[1];
+				const Geometry::Vec3 newVertexC = newPositionAccessor->getPosition(indexC);
+				newPositionAccessor->setPosition(indexC, newVertexC + Geometry::Vec3(normal[0], normal[1], 0.0f) * (coveringMovement * depthRange));
 			}
 			// Remove face by not inserting its indices.
 			continue;
@@ -1180,7 +1636,81 @@ Mesh * removeSkinsWithHoleCovering(Mesh * mesh, float maxNormalZ, float covering
 	return new Mesh(newIndexData, newVertexData);
 }
 
-void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
+//! (internal) The index data as 32bit values.
+static std::vector<uint32_t> readIndices(const MeshIndexData & indexData) {
+	std::vector<uint32_t> indices(indexData.getIndexCount());
+	for(uint32_t i = 0; i < indexData.getIndexCount(); ++i) {
+		indices[i] = indexData[i];
+	}
+	return indices;
+}
+
+//! (internal) Replace the index data of @p mesh by @p indices.
+static void writeIndices(Mesh * mesh, const std::vector<uint32_t> & indices) {
+	MeshIndexData newIndices;
+	newIndices.allocate(static_cast<uint32_t>(indices.size()));
+	std::copy(indices.begin(), indices.end(), newIndices.data());
+	newIndices.markAsChanged();
+	newIndices.updateIndexRange();
+	mesh->openIndexData().swap(newIndices);
+}
+
+/*! (internal) Simulation of a FIFO post-transform vertex cache using time stamps
+	(the same model as used by optimizeIndices(...)). */
+class VertexCacheSimulation {
+		std::vector<uint32_t> cacheTimes;
+		uint32_t stamp;
+		const uint32_t cacheSize;
+	public:
+		VertexCacheSimulation(uint32_t vertexCount, uint32_t _cacheSize) :
+				cacheTimes(vertexCount, 0), stamp(_cacheSize + 1), cacheSize(_cacheSize) {}
+
+		//! Returns true iff the vertex is not in the cache and has to be transformed.
+		bool access(uint32_t vertex) {
+			if(stamp - cacheTimes[vertex] > cacheSize) {
+				cacheTimes[vertex] = stamp;
+				++stamp;
+				return true;
+			}
+			return false;
+		}
+		//! Returns the number of vertices of the triangle that have to be transformed.
+		uint32_t accessTriangle(const uint32_t * triangle) {
+			return (access(triangle[0]) ? 1 : 0) + (access(triangle[1]) ? 1 : 0) + (access(triangle[2]) ? 1 : 0);
+		}
+		void flush() {
+			stamp += cacheSize + 1;
+		}
+};
+
+//! (static)
+VertexCacheStatistics calculateVertexCacheStatistics(const std::vector<uint32_t> & indices, uint32_t vertexCount, uint32_t cacheSize) {
+	// The simulation indexes its time stamps by vertex. The optimization passes call this function
+	// before they use the indices, so they are protected by this check as well.
+	for(std::size_t i = 0; i < indices.size(); ++i) {
+		if(indices[i] >= vertexCount)
+			throw std::out_of_range("Index " + Util::StringUtils::toString(i) + " references vertex " + Util::StringUtils::toString(indices[i]) + " of overall " + Util::StringUtils::toString(vertexCount) + " vertices.");
+	}
+	VertexCacheStatistics statistics;
+	statistics.transformedVertices = 0;
+	VertexCacheSimulation cache(vertexCount, cacheSize);
+	for(const auto & index : indices) {
+		if(cache.access(index)) {
+			++statistics.transformedVertices;
+		}
+	}
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	statistics.acmr = triangleCount > 0 ? static_cast<float>(statistics.transformedVertices) / triangleCount : 0.0f;
+	statistics.atvr = vertexCount > 0 ? static_cast<float>(statistics.transformedVertices) / vertexCount : 0.0f;
+	return statistics;
+}
+
+//! (static)
+VertexCacheStatistics calculateVertexCacheStatistics(Mesh * mesh, const uint_fast8_t cacheSize) {
+	return calculateVertexCacheStatistics(readIndices(mesh->openIndexData()), mesh->getVertexCount(), cacheSize);
+}
+
+OptimizationReport optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 	struct Inner {
 		/**
 		 * Consider all 1-ring candidates and select the best for fanning.
@@ -1196,13 +1726,14 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 		 * @param cursor Passed from caller.
 		 * @return Number of next vertex.
 		 */
-		static uint32_t getNextVertex(bool & stop, const std::set<uint32_t> & nextCand, const uint32_t stamp, const uint8_t cacheSize,
-				const uint32_t * cacheTimes, const uint_fast16_t * liveTriangles, std::stack<uint32_t> & deadEndStack, const uint32_t numVertices,
-				uint32_t & cursor) {
+		static uint32_t getNextVertex(bool & stop, const std::vector<uint32_t> & nextCand, const uint32_t stamp, const uint8_t cacheSize,
+				const std::vector<uint32_t> & cacheTimes, const std::vector<uint32_t> & liveTriangles, std::vector<uint32_t> & deadEndStack,
+				const uint32_t numVertices, uint32_t & cursor) {
 			// Best candidate and priority.
 			bool found = false;
 			uint32_t n = 0;
 			uint32_t maxPriority = 0; // m
+			// The candidates may contain duplicates; ties are broken by the smaller vertex number.
 			for(const auto & v : nextCand) {
 				// Must have live triangles.
 				if (liveTriangles[v] > 0) {
@@ -1214,7 +1745,7 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 						p = stamp - cacheTimes[v];
 					}
 					// Keep best candidate.
-					if (p > maxPriority) {
+					if (p > maxPriority || (found && p == maxPriority && v < n)) {
 						maxPriority = p;
 						n = v;
 						found = true;
@@ -1239,12 +1770,12 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 		 * @param cursor Passed from caller.
 		 * @return Number of non-local vertex.
 		 */
-		static uint32_t skipDeadEnd(bool & stop, const uint_fast16_t * liveTriangles, std::stack<uint32_t> & deadEndStack,
+		static uint32_t skipDeadEnd(bool & stop, const std::vector<uint32_t> & liveTriangles, std::vector<uint32_t> & deadEndStack,
 				const uint32_t numVertices, uint32_t & cursor) {
 			while (!deadEndStack.empty()) {
 				// Next in dead-end stack.
-				uint32_t d = deadEndStack.top();
-				deadEndStack.pop();
+				uint32_t d = deadEndStack.back();
+				deadEndStack.pop_back();
 				// Check for live triangles.
 				if (liveTriangles[d] > 0) {
 					return d;
@@ -1264,58 +1795,54 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 			return 0;
 		}
 	};
+	OptimizationReport report;
 	if (mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
 		WARN("This function only works with meshes with a triangle list.");
-		return;
+		report.before = report.after = calculateVertexCacheStatistics(mesh, _cacheSize);
+		return report;
 	}
 	uint32_t numVertices = mesh->getVertexCount();
-	uint32_t numIndices = mesh->getIndexCount();
+	const std::vector<uint32_t> indices = readIndices(mesh->openIndexData());
+	uint32_t numIndices = static_cast<uint32_t>(indices.size());
 	uint32_t numTriangles = numIndices / 3;
-	MeshIndexData & indices = mesh->openIndexData();
+	report.before = calculateVertexCacheStatistics(indices, numVertices, _cacheSize);
 
 	// Build vertex-triangle adjacency.
 	// First pass: Count occurrences.
-	auto occurrences = new uint_fast16_t[numVertices];
-	std::fill_n(occurrences, numVertices, 0);
+	std::vector<uint32_t> occurrences(numVertices, 0);
 	for (uint32_t i = 0; i < numIndices; ++i) {
 		++occurrences[indices[i]];
 	}
 	// Second pass: Create the offset map.
-	auto offsetMap = new uint32_t[numVertices];
+	std::vector<uint32_t> offsetMap(numVertices);
 	uint32_t sum = 0;
 	for (uint32_t v = 0; v < numVertices; ++v) {
 		offsetMap[v] = sum;
 		sum += occurrences[v];
 	}
 	// Third pass: Construct triangle lists.
-	auto triangleLists = new uint32_t[sum]; // A
-	auto tmpOffsetMap = new uint32_t[numVertices];
-	std::copy(offsetMap, offsetMap + numVertices, tmpOffsetMap);
-	for (uint32_t i = 0; i < numIndices; ++i) {
-		uint32_t vertex = indices[i];
-		uint32_t offset = tmpOffsetMap[vertex];
-		triangleLists[offset] = i / 3;
-		++tmpOffsetMap[vertex];
+	std::vector<uint32_t> triangleLists(sum); // A
+	{
+		std::vector<uint32_t> tmpOffsetMap(offsetMap);
+		for (uint32_t i = 0; i < numIndices; ++i) {
+			triangleLists[tmpOffsetMap[indices[i]]++] = i / 3;
+		}
 	}
-	delete[] tmpOffsetMap;
 
 	// Create per-vertex live triangle count.
-	auto liveTriangles = new uint_fast16_t[numVertices]; // L
-	std::copy(occurrences, occurrences + numVertices, liveTriangles);
+	std::vector<uint32_t> liveTriangles(occurrences); // L
 	// Create per-vertex caching time stamps.
-	auto cacheTimes = new uint32_t[numVertices]; // C
-	std::fill_n(cacheTimes, numVertices, 0);
+	std::vector<uint32_t> cacheTimes(numVertices, 0); // C
 	// Create dead-end vertex stack.
-	std::stack<uint32_t> deadEndStack; // D
+	std::vector<uint32_t> deadEndStack; // D
+	deadEndStack.reserve(numIndices);
 	// Create per-triangles emitted flags.
-	auto emitted = new bool[numTriangles]; // E
-	for (uint32_t t = 0; t < numTriangles; ++t) {
-		emitted[t] = false;
-	}
+	std::vector<uint8_t> emitted(numTriangles, 0); // E
 	// Create output buffer.
-	MeshIndexData newIndices;
-	newIndices.allocate(numIndices);
-	uint32_t * output = newIndices.data();
+	std::vector<uint32_t> output;
+	output.reserve(numTriangles * 3);
+	// 1-ring of next candidates.
+	std::vector<uint32_t> nextCand; // N
 	// Initialize fanning vertex.
 	uint32_t fanVertex = 0; // f
 	// Initialize time stamp.
@@ -1323,12 +1850,11 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 	// Initialize the cursor.
 	uint32_t cursor = 1; // i
 
-	bool stop = false;
+	bool stop = numVertices == 0;
 	while (!stop) {
-		// 1-ring of next candidates.
-		std::set<uint32_t> nextCand; // N
-		uint_fast16_t numNeighbors = occurrences[fanVertex];
-		for (uint_fast16_t i = 0; i < numNeighbors; ++i) {
+		nextCand.clear();
+		uint32_t numNeighbors = occurrences[fanVertex];
+		for (uint32_t i = 0; i < numNeighbors; ++i) {
 			uint32_t t = triangleLists[offsetMap[fanVertex] + i];
 			if (emitted[t])
 				continue;
@@ -1336,12 +1862,11 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 			for (uint_fast8_t ii = 0; ii < 3; ++ii) {
 				uint32_t v = indices[3 * t + ii];
 				// Output vertex.
-				*output = v;
-				++output;
+				output.push_back(v);
 				// Add to dead-end stack.
-				deadEndStack.push(v);
+				deadEndStack.push_back(v);
 				// Register as candidate.
-				nextCand.insert(v);
+				nextCand.push_back(v);
 				// Decrease live triangle count.
 				--liveTriangles[v];
 				// If not in cache
@@ -1353,25 +1878,164 @@ void optimizeIndices(Mesh * mesh, const uint_fast8_t _cacheSize) {
 				}
 			}
 			// Flag triangle as emitted.
-			emitted[t] = true;
+			emitted[t] = 1;
 
 		}
 		fanVertex = Inner::getNextVertex(stop, nextCand, stamp, _cacheSize, cacheTimes, liveTriangles, deadEndStack, numVertices, cursor);
 	}
 
-	// Clean up.
-	delete[] occurrences;
-	delete[] offsetMap;
-	delete[] triangleLists;
-	delete[] liveTriangles;
-	delete[] cacheTimes;
-	delete[] emitted;
+	// Modify the mesh.
+	writeIndices(mesh, output);
+	report.after = calculateVertexCacheStatistics(output, numVertices, _cacheSize);
+	return report;
+}
 
-	newIndices.markAsChanged();
-	newIndices.updateIndexRange();
+//! (static)
+OptimizationReport optimizeVertexFetch(Mesh * mesh, const uint_fast8_t cacheSize) {
+	OptimizationReport report;
+	report.before = calculateVertexCacheStatistics(mesh, cacheSize);
+
+	std::vector<uint32_t> positionOfVertex;
+	std::vector<uint32_t> usedVertices;
+	collectUsedVertices(mesh->openIndexData(), mesh->getVertexCount(), positionOfVertex, usedVertices);
+	// every used vertex represents itself
+	std::vector<uint32_t> representatives(usedVertices.size());
+	for(uint32_t k = 0; k < representatives.size(); ++k) {
+		representatives[k] = k;
+	}
+	replaceByRepresentatives(mesh, usedVertices, positionOfVertex, representatives);
+
+	report.after = calculateVertexCacheStatistics(mesh, cacheSize);
+	return report;
+}
 
-	// Modify the mesh.
-	indices.swap(newIndices);
+//! (internal) A cluster of consecutive triangles for optimizeOverdraw(...).
+struct TriangleCluster {
+	uint32_t begin;
+	uint32_t end;
+	//! Signed distance of the cluster's centroid from the mesh's centroid in direction of the cluster's normal.
+	float sortKey;
+};
+
+//! (static)
+OptimizationReport optimizeOverdraw(Mesh * mesh, const uint_fast8_t cacheSize, float threshold) {
+	OptimizationReport report;
+	report.before = calculateVertexCacheStatistics(mesh, cacheSize);
+	report.after = report.before;
+	if (mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+		WARN("This function only works with meshes with a triangle list.");
+		return report;
+	}
+	const uint32_t vertexCount = mesh->getVertexCount();
+	const std::vector<uint32_t> indices = readIndices(mesh->openIndexData());
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	if(triangleCount == 0) {
+		return report;
+	}
+	std::vector<Geometry::Vec3> positions(vertexCount);
+	PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION)->getPositions(0, vertexCount, positions.data());
+
+	// Hard boundaries: the cache optimization starts a new fan (all vertices are transformed).
+	std::vector<uint32_t> hardBoundaries;
+	{
+		VertexCacheSimulation cache(vertexCount, cacheSize);
+		for(uint32_t t = 0; t < triangleCount; ++t) {
+			if(cache.accessTriangle(&indices[t * 3]) == 3 || t == 0) {
+				hardBoundaries.push_back(t);
+			}
+		}
+		hardBoundaries.push_back(triangleCount);
+	}
+
+	// Soft boundaries: split the clusters as long as the cache miss ratio of the part stays
+	// below the threshold relative to the whole cluster.
+	std::vector<TriangleCluster> clusters;
+	{
+		VertexCacheSimulation cache(vertexCount, cacheSize);
+		for(std::size_t h = 0; h + 1 < hardBoundaries.size(); ++h) {
+			const uint32_t begin = hardBoundaries[h];
+			const uint32_t end = hardBoundaries[h + 1];
+			cache.flush();
+			uint32_t clusterMisses = 0;
+			for(uint32_t t = begin; t < end; ++t) {
+				clusterMisses += cache.accessTriangle(&indices[t * 3]);
+			}
+			const float maxAcmr = threshold * clusterMisses / (end - begin);
+
+			cache.flush();
+			uint32_t partBegin = begin;
+			uint32_t partMisses = 0;
+			for(uint32_t t = begin; t < end; ++t) {
+				partMisses += cache.accessTriangle(&indices[t * 3]);
+				if(t + 1 == end || partMisses <= maxAcmr * (t + 1 - partBegin)) {
+					clusters.push_back({partBegin, t + 1, 0.0f});
+					partBegin = t + 1;
+					partMisses = 0;
+					cache.flush();
+				}
+			}
+		}
+	}
+
+	// Sort the clusters front to back, seen from outside: clusters facing away from the mesh's center first.
+	{
+		float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+		float meshArea = 0.0f;
+		std::vector<float> clusterData(clusters.size() * 6); // centroid, normal
+		for(std::size_t c = 0; c < clusters.size(); ++c) {
+			float * centroid = clusterData.data() + c * 6;
+			float * normal = centroid + 3;
+			std::fill(centroid, centroid + 6, 0.0f);
+			float clusterArea = 0.0f;
+			for(uint32_t t = clusters[c].begin; t < clusters[c].end; ++t) {
+				const Geometry::Vec3 & a = positions[indices[t * 3 + 0]];
+				const Geometry::Vec3 & b = positions[indices[t * 3 + 1]];
+				const Geometry::Vec3 & cc = positions[indices[t * 3 + 2]];
+				const Geometry::Vec3 n = (b - a).cross(cc - a);
+				const float area = n.length();
+				for(uint_fast8_t i = 0; i < 3; ++i) {
+					centroid[i] += (a[i] + b[i] + cc[i]) / 3.0f * area;
+					normal[i] += n[i];
+				}
+				clusterArea += area;
+			}
+			for(uint_fast8_t i = 0; i < 3; ++i) {
+				meshCentroid[i] += centroid[i];
+				centroid[i] = clusterArea > 0.0f ? centroid[i] / clusterArea : 0.0f;
+			}
+			meshArea += clusterArea;
+			normalizeIfNotZero(normal);
+		}
+		for(uint_fast8_t i = 0; i < 3; ++i) {
+			meshCentroid[i] = meshArea > 0.0f ? meshCentroid[i] / meshArea : 0.0f;
+		}
+		for(std::size_t c = 0; c < clusters.size(); ++c) {
+			const float * centroid = clusterData.data() + c * 6;
+			const float * normal = centroid + 3;
+			clusters[c].sortKey = (centroid[0] - meshCentroid[0]) * normal[0]
+								+ (centroid[1] - meshCentroid[1]) * normal[1]
+								+ (centroid[2] - meshCentroid[2]) * normal[2];
+		}
+		std::stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster & a, const TriangleCluster & b) {
+			return a.sortKey > b.sortKey;
+		});
+	}
+
+	std::vector<uint32_t> output;
+	output.reserve(static_cast<std::size_t>(triangleCount) * 3);
+	for(const auto & cluster : clusters) {
+		output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+	}
+	writeIndices(mesh, output);
+	report.after = calculateVertexCacheStatistics(output, vertexCount, cacheSize);
+	return report;
+}
+
+//! (internal) Swap the first and the last index of each triangle.
+template<typename index_t>
+static void reverseTriangles(index_t * indices, uint32_t indexCount) {
+	for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+		std::swap(indices[i], indices[i + 2]);
 }
 
 void reverseWinding(Mesh * mesh) {
@@ -1380,11 +2044,17 @@ void reverseWinding(Mesh * mesh) {
 		return;
 	}
 	MeshIndexData & id = mesh->openIndexData();
-	uint32_t * indices = id.data();
-	for (uint32_t i = 0; i < mesh->getIndexCount(); i += 3) {
-		uint32_t temp = indices[i];
-		indices[i] = indices[i + 2];
-		indices[i + 2] = temp;
+	// the indices keep their type
+	switch(id.getIndexType()) {
+		case GL_UNSIGNED_BYTE:
+			reverseTriangles(id.typedData<uint8_t>(), id.getIndexCount());
+			break;
+		case GL_UNSIGNED_SHORT:
+			reverseTriangles(id.typedData<uint16_t>(), id.getIndexCount());
+			break;
+		default:
+			reverseTriangles(id.typedData<uint32_t>(), id.getIndexCount());
+			break;
 	}
 	id.markAsChanged();
 }
@@ -1448,12 +2118,12 @@ void calculateTextureCoordinates_projection(Mesh * mesh, Util::StringIdentifier
 	vData.markAsChanged();
 }
 
-//!	(static)
-void calculateTangentVectors(Mesh * mesh, const Util::StringIdentifier uvName, const Util::StringIdentifier tangentVecName) {
-	using Geometry::Vec3;
-	using Geometry::Vec2;
+/*! (internal) Implementation of calculateTangentVectors(...) and calculateNormalsAndTangentVectors(...).
+	@param calculateNormals If true, the normals are calculated in the same passes over the mesh
+		and the tangents are orthogonalized against the new (unquantized) normals. */
+static void calculateTangentSpace(Mesh * mesh, const Util::StringIdentifier uvName, const Util::StringIdentifier tangentVecName,
+								  bool calculateNormals, NormalWeighting weighting) {
 	MeshVertexData & vertices(mesh->openVertexData());
-	const MeshIndexData & indices(mesh->openIndexData());
 
 	{ // assure mesh has the right form
 		if (mesh->getDrawMode() != Mesh::DRAW_TRIANGLES)
@@ -1462,17 +2132,22 @@ void calculateTangentVectors(Mesh * mesh, const Util::StringIdentifier uvName, c
 		if (vertices.getVertexDescription().getAttribute(VertexAttributeIds::POSITION).getDataType() != GL_FLOAT)
 			INVALID_ARGUMENT_EXCEPTION("addTangentVectors: No float positions.");
 
-		if (vertices.getVertexDescription().getAttribute(VertexAttributeIds::NORMAL).empty())
+		if (!calculateNormals && vertices.getVertexDescription().getAttribute(VertexAttributeIds::NORMAL).empty())
 			INVALID_ARGUMENT_EXCEPTION("addTangentVectors: No normals.");
 
 		if (vertices.getVertexDescription().getAttribute(uvName).getDataType() != GL_FLOAT
 				|| vertices.getVertexDescription().getAttribute(uvName).getNumValues() < 2)
 			INVALID_ARGUMENT_EXCEPTION("addTangentVectors: No or wrong texture coordinates.");
 
-		// add slot for 4 byte tangent vector
-		if (vertices.getVertexDescription().getAttribute(tangentVecName).empty()) {
+		// add slots for byte normals and the 4 byte tangent vector (converting the vertices only once)
+		const bool addNormals = vertices.getVertexDescription().getAttribute(VertexAttributeIds::NORMAL).empty();
+		const bool addTangents = vertices.getVertexDescription().getAttribute(tangentVecName).empty();
+		if (addNormals || addTangents) {
 			VertexDescription newVd = vertices.getVertexDescription();
-			newVd.appendAttribute(tangentVecName, 4, GL_BYTE, true);
+			if (addNormals)
+				newVd.appendNormalByte();
+			if (addTangents)
+				newVd.appendAttribute(tangentVecName, 4, GL_BYTE, true);
 			std::unique_ptr<MeshVertexData> newVertices(convertVertices(vertices, newVd));
 			vertices.swap(*newVertices.get());
 		}
@@ -1480,92 +2155,167 @@ void calculateTangentVectors(Mesh * mesh, const Util::StringIdentifier uvName, c
 				tangentVecName).getNumValues() != 4)
 			INVALID_ARGUMENT_EXCEPTION("createTextureCoordinates_boxProjection: Wrong tangent format.");
 
-	}
-	// calculate tangents and bitangents
-	const VertexDescription & vDesc = vertices.getVertexDescription();
-	const VertexAttribute & posAttr = vDesc.getAttribute(VertexAttributeIds::POSITION);
-	const VertexAttribute & normalAttr = vDesc.getAttribute(VertexAttributeIds::NORMAL);
-	const VertexAttribute & uvAttr = vDesc.getAttribute(uvName);
-	const VertexAttribute & tanAttr = vDesc.getAttribute(tangentVecName);
-
-	std::vector<Vec3> tan1(vertices.getVertexCount());
-	std::vector<Vec3> tan2(vertices.getVertexCount());
-
-	for (uint32_t i = 0; i < indices.getIndexCount(); i += 3) {
-		const uint32_t index1 = indices[i];
-		const uint32_t index2 = indices[i + 1];
-		const uint32_t index3 = indices[i + 2];
-
-		const Vec3 pos1(reinterpret_cast<float*> (vertices[index1] + posAttr.getOffset()));
-		const Vec3 pos2(reinterpret_cast<float*> (vertices[index2] + posAttr.getOffset()));
-		const Vec3 pos3(reinterpret_cast<float*> (vertices[index3] + posAttr.getOffset()));
-
-		const Vec2 uv1(reinterpret_cast<float*> (vertices[index1] + uvAttr.getOffset()));
-		const Vec2 uv2(reinterpret_cast<float*> (vertices[index2] + uvAttr.getOffset()));
-		const Vec2 uv3(reinterpret_cast<float*> (vertices[index3] + uvAttr.getOffset()));
-
-		const float x1 = pos2.x() - pos1.x();
-		const float x2 = pos3.x() - pos1.x();
-		const float y1 = pos2.y() - pos1.y();
-		const float y2 = pos3.y() - pos1.y();
-		const float z1 = pos2.z() - pos1.z();
-		const float z2 = pos3.z() - pos1.z();
-
-		const float s1 = uv2.x() - uv1.x();
-		const float s2 = uv3.x() - uv1.x();
-		const float t1 = uv2.y() - uv1.y();
-		const float t2 = uv3.y() - uv1.y();
-
-		const float r = 1.0f / (s1 * t2 - s2 * t1);
-		const Vec3 sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-		const Vec3 tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
-
-		tan1[index1] += sdir;
-		tan1[index2] += sdir;
-		tan1[index3] += sdir;
-
-		tan2[index1] += tdir;
-		tan2[index2] += tdir;
-		tan2[index3] += tdir;
-	}
-
-	if (normalAttr.getDataType() == GL_FLOAT) {
-		for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-			const Vec3 normal(reinterpret_cast<float*> (vertices[i] + normalAttr.getOffset()));
-			const Vec3 & t = tan1[i];
-			const Vec3 tan((t - normal * normal.dot(t)).getNormalized() * 127); // Gram-Schmidt orthogonalize
-
-			int8_t * const tPtr = reinterpret_cast<int8_t*> (vertices[i] + tanAttr.getOffset());
-			tPtr[0] = static_cast<int8_t> (tan.x());
-			tPtr[1] = static_cast<int8_t> (tan.y());
-			tPtr[2] = static_cast<int8_t> (tan.z());
-			tPtr[3] = (normal.cross(t).dot(tan2[i]) < 0.0f) ? -1 : 1; // Calculate handedness
+		if (calculateNormals)
+			assertNormalFormat(vertices.getVertexDescription().getAttribute(VertexAttributeIds::NORMAL), "addTangentVectors");
+	}
+	const uint32_t vertexCount = vertices.getVertexCount();
+	VertexCornerMap corners;
+	if (!corners.build(mesh->openIndexData(), vertexCount))
+		INVALID_ARGUMENT_EXCEPTION("addTangentVectors: Invalid vertex index.");
+	const uint32_t triangleCount = corners.getTriangleCount();
+
+	std::vector<Geometry::Vec3> positions(vertexCount);
+	std::vector<Geometry::Vec2> uvs(vertexCount);
+	std::vector<Geometry::Vec3> normals(calculateNormals ? 0 : vertexCount);
+	PositionAttributeAccessor::create(vertices, VertexAttributeIds::POSITION)->getPositions(0, vertexCount, positions.data());
+	TexCoordAttributeAccessor::create(vertices, uvName)->getCoordinates(0, vertexCount, uvs.data());
+	if (!calculateNormals)
+		NormalAttributeAccessor::create(static_cast<const MeshVertexData &>(vertices), VertexAttributeIds::NORMAL)->getNormals(0, vertexCount, normals.data());
+
+	// per triangle: tangent (sdir) and bitangent (tdir) directions, and the face normal if requested
+	std::vector<float> faceTangents(static_cast<std::size_t>(triangleCount) * 6);
+	std::vector<float> faceNormals(calculateNormals ? static_cast<std::size_t>(triangleCount) * 3 : 0);
+	std::vector<float> cornerAngles(calculateNormals && weighting == NormalWeighting::ANGLE ? corners.indices.size() : 0);
+	ParallelFor::forEachChunk(triangleCount, ParallelFor::getChunkCount(triangleCount, minTangentSpaceChunkSize), [&](uint32_t, std::size_t begin, std::size_t end) {
+		if (calculateNormals)
+			calculateFaceNormals(corners.indices, positions, weighting, begin, end, faceNormals.data(), cornerAngles.data());
+		for (std::size_t triangle = begin; triangle < end; ++triangle) {
+			const uint32_t index1 = corners.indices[triangle * 3 + 0];
+			const uint32_t index2 = corners.indices[triangle * 3 + 1];
+			const uint32_t index3 = corners.indices[triangle * 3 + 2];
+			const Geometry::Vec3 & pos1 = positions[index1];
+			const Geometry::Vec3 & pos2 = positions[index2];
+			const Geometry::Vec3 & pos3 = positions[index3];
+			const Geometry::Vec2 & uv1 = uvs[index1];
+			const Geometry::Vec2 & uv2 = uvs[index2];
+			const Geometry::Vec2 & uv3 = uvs[index3];
+
+			const float x1 = pos2.x() - pos1.x();
+			const float x2 = pos3.x() - pos1.x();
+			const float y1 = pos2.y() - pos1.y();
+			const float y2 = pos3.y() - pos1.y();
+			const float z1 = pos2.z() - pos1.z();
+			const float z2 = pos3.z() - pos1.z();
+
+			const float s1 = uv2.x() - uv1.x();
+			const float s2 = uv3.x() - uv1.x();
+			const float t1 = uv2.y() - uv1.y();
+			const float t2 = uv3.y() - uv1.y();
+
+			float * dirs = faceTangents.data() + triangle * 6;
+			const float denominator = s1 * t2 - s2 * t1;
+			if (denominator == 0.0f) { // degenerated texture coordinates
+				std::fill(dirs, dirs + 6, 0.0f);
+				continue;
+			}
+			const float r = 1.0f / denominator;
+			dirs[0] = (t2 * x1 - t1 * x2) * r, dirs[1] = (t2 * y1 - t1 * y2) * r, dirs[2] = (t2 * z1 - t1 * z2) * r;
+			dirs[3] = (s1 * x2 - s2 * x1) * r, dirs[4] = (s1 * y2 - s2 * y1) * r, dirs[5] = (s1 * z2 - s2 * z1) * r;
 		}
-	} else if (normalAttr.getDataType() == GL_BYTE) {
-		for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-			const int8_t * nPtr = reinterpret_cast<const int8_t*> (vertices[i] + normalAttr.getOffset());
-			const Vec3 normal((Vec3(nPtr[0], nPtr[1], nPtr[2])).normalize());
-			const Vec3 & t = tan1[i];
-			const Vec3 tan((t - normal * normal.dot(t)).getNormalized() * 127); // Gram-Schmidt orthogonalize
-
-			int8_t * const tPtr = reinterpret_cast<int8_t*> (vertices[i] + tanAttr.getOffset());
-			tPtr[0] = static_cast<int8_t> (tan.x());
-			tPtr[1] = static_cast<int8_t> (tan.y());
-			tPtr[2] = static_cast<int8_t> (tan.z());
-			tPtr[3] = (normal.cross(t).dot(tan2[i]) < 0.0f) ? -1 : 1; // Calculate handedness
+	});
+
+	// Requesting writable access copies shared or external data (once, before the threads write); the pointer
+	// stays valid while the threads write the tangents (and normals) of their vertices.
+	uint8_t * const base = vertices.data();
+	const VertexAttribute & tanAttr = vertices.getVertexDescription().getAttribute(tangentVecName);
+	uint8_t * const tangentData = base + vertices.getAttributeOffset(tanAttr);
+	const std::size_t tangentStride = vertices.getAttributeStride(tanAttr);
+	const VertexAttribute & normalAttr = vertices.getVertexDescription().getAttribute(VertexAttributeIds::NORMAL);
+	uint8_t * const normalData = base + vertices.getAttributeOffset(normalAttr);
+	const std::size_t normalStride = vertices.getAttributeStride(normalAttr);
+
+	// per vertex: sum the adjacent triangles in a fixed order, orthogonalize and store
+	ParallelFor::forEachChunk(vertexCount, ParallelFor::getChunkCount(vertexCount, minTangentSpaceChunkSize), [&](uint32_t, std::size_t begin, std::size_t end) {
+		for (std::size_t v = begin; v < end; ++v) {
+			float tan1[3] = {0.0f, 0.0f, 0.0f};
+			float tan2[3] = {0.0f, 0.0f, 0.0f};
+			for (uint32_t i = corners.cornerBegin[v]; i < corners.cornerBegin[v + 1]; ++i) {
+				const float * dirs = faceTangents.data() + (corners.vertexCorners[i] / 3) * 6;
+				tan1[0] += dirs[0], tan1[1] += dirs[1], tan1[2] += dirs[2];
+				tan2[0] += dirs[3], tan2[1] += dirs[4], tan2[2] += dirs[5];
+			}
+			float n[3];
+			if (calculateNormals) {
+				accumulateVertexNormal(corners, static_cast<uint32_t>(v), weighting, faceNormals, cornerAngles, n);
+			} else {
+				n[0] = normals[v].x(), n[1] = normals[v].y(), n[2] = normals[v].z();
+			}
+			normalizeIfNotZero(n);
+			if (calculateNormals)
+				storeNormal(normalAttr, n, normalData + v * normalStride);
+
+			// Gram-Schmidt orthogonalize
+			const float nDotT = n[0] * tan1[0] + n[1] * tan1[1] + n[2] * tan1[2];
+			float tan[3] = {tan1[0] - n[0] * nDotT, tan1[1] - n[1] * nDotT, tan1[2] - n[2] * nDotT};
+			normalizeIfNotZero(tan);
+			// Calculate handedness: (n x t) * tan2
+			const float handedness = (n[1] * tan1[2] - n[2] * tan1[1]) * tan2[0]
+									+ (n[2] * tan1[0] - n[0] * tan1[2]) * tan2[1]
+									+ (n[0] * tan1[1] - n[1] * tan1[0]) * tan2[2];
+
+			int8_t * const tPtr = reinterpret_cast<int8_t*> (tangentData + v * tangentStride);
+			tPtr[0] = static_cast<int8_t> (tan[0] * 127);
+			tPtr[1] = static_cast<int8_t> (tan[1] * 127);
+			tPtr[2] = static_cast<int8_t> (tan[2] * 127);
+			tPtr[3] = handedness < 0.0f ? -1 : 1;
 		}
-	}
+	});
+	vertices.markAsChanged();
+}
+
+//! (static)
+void calculateTangentVectors(Mesh * mesh, const Util::StringIdentifier uvName, const Util::StringIdentifier tangentVecName) {
+	calculateTangentSpace(mesh, uvName, tangentVecName, false, NormalWeighting::UNIFORM);
+}
+
+//! (static)
+void calculateNormalsAndTangentVectors(Mesh * mesh, const Util::StringIdentifier uvName, const Util::StringIdentifier tangentVecName, NormalWeighting weighting) {
+	calculateTangentSpace(mesh, uvName, tangentVecName, true, weighting);
 }
 
 inline bool isZero(float f, float tolerance=std::numeric_limits<float>::epsilon()) {
 	return std::abs(f) <= tolerance;
 }
 
+/**
+ * (internal) Return the vertex cutting the edge @a u - @a w of the triangle @a tIndex at @a blend.
+ * The vertex is only created if the triangle on the other side of the edge has not already created
+ * it, so both triangles share it. The vertices are stored in @a cutVertices under the corner at the
+ * beginning of the (directed) edge in each triangle.
+ */
+static RawVertex getCutVertex(const ConnectivityAccessor & connectivity, std::unordered_map<uint32_t, RawVertex> & cutVertices,
+							  uint32_t tIndex, const RawVertex & u, const RawVertex & w, float blend, const VertexDescription & vd) {
+	uint32_t from = u.getIndex();
+	uint32_t to = w.getIndex();
+	uint32_t corner = connectivity.getCorner(from, tIndex);
+	if(connectivity.getCornerVertex(connectivity.getNextTriangleCorner(corner)) != to) {
+		std::swap(from, to);
+		corner = connectivity.getCorner(from, tIndex);
+	}
+	const auto it = cutVertices.find(corner);
+	if(it != cutVertices.end())
+		return it->second;
+
+	const RawVertex v = RawVertex::interpolate(u, w, blend, vd);
+	cutVertices.emplace(corner, v);
+	// find the opposite edge (to -> from) of the adjacent triangle
+	const uint32_t first = connectivity.getVertexCorner(to);
+	uint32_t c = first;
+	do {
+		if(connectivity.getCornerTriangle(c) != tIndex && connectivity.getCornerVertex(connectivity.getNextTriangleCorner(c)) == from) {
+			cutVertices.emplace(c, v);
+			break;
+		}
+		c = connectivity.getNextVertexCorner(c);
+	} while(c != first);
+	return v;
+}
+
 //!	(static)
 void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<uint32_t> tIndices, float tolerance) {
 	const VertexDescription & vd = m->getVertexDescription();
 	const VertexAttribute & posAttr = vd.getAttribute(VertexAttributeIds::POSITION);
-	if (posAttr.getDataType() != GL_FLOAT || m->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+	if (posAttr.getDataType() != GL_FLOAT || m->getDrawMode() != Mesh::DRAW_TRIANGLES || !m->isUsingIndexData()) {
 		WARN("cutMesh: Unsupported vertex format.");
 		return;
 	}
@@ -1573,21 +2323,19 @@ void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<uint32_t> tIn
 	std::deque<SplitTriangle> triangles;
 	std::deque<SplitTriangle> trianglesOut;
 	std::deque<SplitTriangle> trianglesNew;
-	std::vector<RawVertex> vertexArray;
+
+	// adjacency of the triangles to cut, used to share the vertices created on their common edges
+	Util::Reference<ConnectivityAccessor> connectivity = tIndices.empty() ? ConnectivityAccessor::create(m) : ConnectivityAccessor::create(m, tIndices);
+	std::unordered_map<uint32_t, RawVertex> cutVertices;
 
 	MeshVertexData & vertices = m->openVertexData();
 	MeshIndexData & indices = m->openIndexData();
 
 	// extract triangles
-	size_t vertexSize = vd.getVertexSize();
-	for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-		auto tmpData = new uint8_t[vertexSize];
-		std::copy(vertices[i], vertices[i] + vertexSize, tmpData);
-		vertexArray.emplace_back(i, tmpData, vertexSize);
-	}
-	uint32_t * iData = indices.data();
-	for (unsigned i = 0; i < indices.getIndexCount(); i += 3)
-		triangles.push_back(SplitTriangle(vertexArray.at(iData[i + 0]), vertexArray.at(iData[i + 1]), vertexArray.at(iData[i + 2])));
+	RawVertexBuffer vertexBuffer(vertices);
+	const MeshIndexData & sourceIndices = indices; // read without converting the index type
+	for (unsigned i = 0; i < sourceIndices.getIndexCount(); i += 3)
+		triangles.push_back(SplitTriangle(RawVertex(sourceIndices[i + 0], vertexBuffer), RawVertex(sourceIndices[i + 1], vertexBuffer), RawVertex(sourceIndices[i + 2], vertexBuffer)));
 
 	// split triangles intersecting plane
 	uint32_t tIndex = 0;
@@ -1622,8 +2370,7 @@ void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<uint32_t> tIn
 			}
 
 			float blend = std::abs(pb)/(std::abs(pb) + std::abs(pc));
-			RawVertex d = RawVertex::interpolate(b, c, blend, vertexArray.size(), vd);
-			vertexArray.push_back(d);
+			RawVertex d = getCutVertex(*connectivity.get(), cutVertices, tIndex, b, c, blend, vd);
 			trianglesOut.push_back(SplitTriangle(a, b, d));
 			trianglesNew.push_back(SplitTriangle(a, d, c));
 		} else {
@@ -1640,10 +2387,8 @@ void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<uint32_t> tIn
 
 			float blend_ab = std::abs(pa)/(std::abs(pa) + std::abs(pb));
 			float blend_ac = std::abs(pa)/(std::abs(pa) + std::abs(pc));
-			RawVertex d_ab = RawVertex::interpolate(a, b, blend_ab, vertexArray.size(), vd);
-			vertexArray.push_back(d_ab);
-			RawVertex d_ac = RawVertex::interpolate(a, c, blend_ac, vertexArray.size(), vd);
-			vertexArray.push_back(d_ac);
+			RawVertex d_ab = getCutVertex(*connectivity.get(), cutVertices, tIndex, a, b, blend_ab, vd);
+			RawVertex d_ac = getCutVertex(*connectivity.get(), cutVertices, tIndex, a, c, blend_ac, vd);
 
 			trianglesOut.push_back(SplitTriangle(a, d_ab, d_ac));
 			trianglesNew.push_back(SplitTriangle(d_ab, b, c));
@@ -1654,6 +2399,7 @@ void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<uint32_t> tIn
 	for(auto t : trianglesNew)
 		trianglesOut.push_back(t);
 	trianglesNew.clear();
+	connectivity = nullptr; // the index data is replaced below
 
 	// reassemble mesh
 	// - indices
@@ -1669,16 +2415,7 @@ void cutMesh(Mesh* m, const Geometry::Plane& plane, const std::set<uint32_t> tIn
 	indices.updateIndexRange();
 
 	// - vertices
-	vertices.allocate(vertexArray.size(), vd);
-	for (size_t i = 0; i < vertexArray.size(); i++) {
-		std::copy(vertexArray.at(i).getData(), vertexArray.at(i).getData() + vertexSize, vertices[i]);
-	}
-	vertices.updateBoundingBox();
-
-	// cleanup
-	for (auto & rawVertex : vertexArray) {
-		delete[] rawVertex.getData();
-	}
+	vertexBuffer.writeTo(vertices, vd);
 }
 
 #define ADJ_AB 1
@@ -1716,58 +2453,67 @@ uint8_t getAdjacence(const SplitTriangle& t1, const SplitTriangle& t2, const Ver
 void extrudeTriangles(Mesh* m, const Geometry::Vec3& dir, const std::set<uint32_t> tIndices) {
 	const VertexDescription & vd = m->getVertexDescription();
 	const VertexAttribute & posAttr = vd.getAttribute(VertexAttributeIds::POSITION);
-	if (posAttr.getDataType() != GL_FLOAT || m->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+	if (posAttr.getDataType() != GL_FLOAT || m->getDrawMode() != Mesh::DRAW_TRIANGLES || !m->isUsingIndexData()) {
 		WARN("extrudeTriangles: Unsupported vertex format.");
 		return;
 	}
 
 	std::vector<SplitTriangle> triangles;
-	std::vector<RawVertex> vertexArray;
 
-	MeshVertexData & vertices = m->openVertexData();
-	MeshIndexData & indices = m->openIndexData();
+	// ignore invalid triangle indices
+	std::set<uint32_t> selected;
+	const uint32_t triangleCount = m->getIndexCount() / 3;
+	for(auto ti : tIndices)
+		if(ti < triangleCount)
+			selected.insert(ti);
 
-	// extract triangles
-	size_t vertexSize = vd.getVertexSize();
-	for (uint32_t i = 0; i < vertices.getVertexCount(); ++i) {
-		auto tmpData = new uint8_t[vertexSize];
-		std::copy(vertices[i], vertices[i] + vertexSize, tmpData);
-		vertexArray.emplace_back(i, tmpData, vertexSize);
+	// find adjacent triangles sharing their vertices
+	std::unordered_map<uint32_t, uint8_t> adjacencies;
+	std::vector<uint32_t> borderTriangles;
+	{
+		Util::Reference<ConnectivityAccessor> connectivity = ConnectivityAccessor::create(m, selected);
+		for(auto ti : selected) {
+			uint32_t a, b, c;
+			std::tie(a, b, c) = connectivity->getTriangle(ti);
+			uint8_t adj = 0;
+			if(!connectivity->isBorderEdge(a, b))
+				adj |= ADJ_AB;
+			if(!connectivity->isBorderEdge(b, c))
+				adj |= ADJ_BC;
+			if(!connectivity->isBorderEdge(c, a))
+				adj |= ADJ_CA;
+			adjacencies[ti] = adj;
+			if(adj != (ADJ_AB | ADJ_BC | ADJ_CA))
+				borderTriangles.push_back(ti);
+		}
 	}
-	uint32_t * iData = indices.data();
-	for (unsigned i = 0; i < indices.getIndexCount(); i += 3)
-		triangles.push_back(SplitTriangle(vertexArray.at(iData[i + 0]), vertexArray.at(iData[i + 1]), vertexArray.at(iData[i + 2])));
 
+	MeshVertexData & vertices = m->openVertexData();
+	MeshIndexData & indices = m->openIndexData();
 
-	// find adjacent triangles
-	std::unordered_map<uint32_t, uint8_t> adjacencies;
-	for(auto ti : tIndices) {
-		if(ti >= triangles.size())
-			continue;
-		adjacencies[ti] = 0;
-		for(auto tj : tIndices) {
-			if(tj >= triangles.size() || ti == tj)
-				continue;
-			uint8_t adj = getAdjacence(triangles[ti], triangles[tj], posAttr);
-			adjacencies[ti] |= adj;
-			//std::cout << ti << "-" << tj << " ab " << ((adj&ADJ_AB)>0) << " bc " << ((adj&ADJ_BC)>0) << " ca " << ((adj&ADJ_CA)>0) << std::endl;
+	// extract triangles
+	RawVertexBuffer vertexBuffer(vertices);
+	const MeshIndexData & sourceIndices = indices; // read without converting the index type
+	for (unsigned i = 0; i < sourceIndices.getIndexCount(); i += 3)
+		triangles.push_back(SplitTriangle(RawVertex(sourceIndices[i + 0], vertexBuffer), RawVertex(sourceIndices[i + 1], vertexBuffer), RawVertex(sourceIndices[i + 2], vertexBuffer)));
+
+	// find adjacent triangles with separate vertices at the same positions (only the remaining border edges are candidates)
+	for(auto ti : borderTriangles) {
+		for(auto tj : borderTriangles) {
+			if(ti != tj)
+				adjacencies[ti] |= getAdjacence(triangles[ti], triangles[tj], posAttr);
 		}
 	}
 
 	// extrude triangles
-	for(auto ti : tIndices) {
-		if(ti >= triangles.size())
-			continue;
+	for(auto ti : selected) {
 		RawVertex a = triangles[ti].a;
 		RawVertex b = triangles[ti].b;
 		RawVertex c = triangles[ti].c;
 
-		RawVertex an = RawVertex::move(a, dir, vertexArray.size(), vd);
-		vertexArray.push_back(an);
-		RawVertex bn = RawVertex::move(b, dir, vertexArray.size(), vd);
-		vertexArray.push_back(bn);
-		RawVertex cn = RawVertex::move(c, dir, vertexArray.size(), vd);
-		vertexArray.push_back(cn);
+		RawVertex an = RawVertex::move(a, dir, vd);
+		RawVertex bn = RawVertex::move(b, dir, vd);
+		RawVertex cn = RawVertex::move(c, dir, vd);
 		triangles[ti].a = an;
 		triangles[ti].b = bn;
 		triangles[ti].c = cn;
@@ -1805,16 +2551,7 @@ void extrudeTriangles(Mesh* m, const Geometry::Vec3& dir, const std::set<uint32_
 	}
 
 	// - vertices
-	vertices.allocate(vertexArray.size(), vd);
-	for (size_t i = 0; i < vertexArray.size(); i++) {
-		std::copy(vertexArray.at(i).getData(), vertexArray.at(i).getData() + vertexSize, vertices[i]);
-	}
-	vertices.updateBoundingBox();
-
-	// cleanup
-	for (auto & rawVertex : vertexArray) {
-		delete[] rawVertex.getData();
-	}
+	vertexBuffer.writeTo(vertices, vd);
 }
 
 //!	(static)
@@ -1825,7 +2562,7 @@ int32_t getFirstTriangleIntersectingRay(Mesh* m, const Geometry::Ray3& ray) {
 		return -1;
 	}
 	auto posAcc = PositionAttributeAccessor::create(m->openVertexData(), VertexAttributeIds::POSITION);
-	MeshIndexData & indices = m->openIndexData();
+	const MeshIndexData & indices = m->openIndexData();
 
 	float tLine, uTri, vTri;
 	int32_t closest = -1;
@@ -1848,84 +2585,189 @@ int32_t getFirstTriangleIntersectingRay(Mesh* m, const Geometry::Ray3& ray) {
 }
 
 
-//! (static)
-uint32_t mergeCloseVertices(Mesh * mesh, float tolerance) {
-	const VertexDescription & desc = mesh->getVertexDescription();
-	const uint32_t indexCount = mesh->getIndexCount();
+//! (internal) Union-find structure that can be used by several threads concurrently.
+class ConcurrentUnionFind {
+	public:
+		explicit ConcurrentUnionFind(std::size_t count) : parents(new std::atomic<uint32_t>[count]) {
+			for(std::size_t i = 0; i < count; ++i)
+				parents[i].store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+		}
+		//! Return the smallest element of the set containing @p x.
+		uint32_t find(uint32_t x) {
+			// path halving; parents[x] <= x always holds, so there are no cycles
+			while(true) {
+				uint32_t parent = parents[x].load(std::memory_order_relaxed);
+				if(parent == x)
+					return x;
+				const uint32_t grandParent = parents[parent].load(std::memory_order_relaxed);
+				if(parent != grandParent)
+					parents[x].compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+				x = grandParent;
+			}
+		}
+		void unite(uint32_t a, uint32_t b) {
+			while(true) {
+				a = find(a);
+				b = find(b);
+				if(a == b)
+					return;
+				if(a < b)
+					std::swap(a, b);
+				// link the larger root below the smaller one
+				uint32_t expected = a;
+				if(parents[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+					return;
+			}
+		}
+	private:
+		std::unique_ptr<std::atomic<uint32_t>[]> parents;
+};
 
-	auto posAcc = PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION);
-
-	auto comp = [&posAcc, &tolerance](const RawVertex& lhs, const RawVertex& rhs) -> bool {
-		auto v1 = posAcc->getPosition(lhs.getIndex());
-		auto v2 = posAcc->getPosition(rhs.getIndex());
-		if(std::abs(v1.x()-v2.x()) > tolerance)
-			return v1.x() < v2.x();
-		if(std::abs(v1.y()-v2.y()) > tolerance)
-			return v1.y() < v2.y();
-		if(std::abs(v1.z()-v2.z()) > tolerance)
-			return v1.z() < v2.z();
-		return false;
-	};
+//! (internal) Integer coordinates of a grid cell for mergeCloseVertices(...).
+struct GridCell {
+	int64_t x, y, z;
+	bool operator==(const GridCell & other) const	{	return x == other.x && y == other.y && z == other.z;	}
+	uint32_t hash() const {
+		uint64_t h = static_cast<uint64_t>(x) * 0x9E3779B97F4A7C15ull;
+		h ^= static_cast<uint64_t>(y) * 0xC2B2AE3D27D4EB4Full + (h >> 29);
+		h ^= static_cast<uint64_t>(z) * 0x165667B19E3779F9ull + (h >> 32);
+		return static_cast<uint32_t>(h ^ (h >> 32));
+	}
+};
 
-	uint32_t oldCount = mesh->getVertexCount();
+/*! (internal) Grid coordinate of the finite @p value for the given cell size; exact values are used if @p cellSize is zero.
+	The result is clamped to [-2^62, 2^62], so the coordinates of neighboring cells do not overflow.	*/
+static int64_t toGridCoordinate(float value, float cellSize) {
+	static const double limit = static_cast<double>(int64_t(1) << 62);
+	if(cellSize <= 0.0f) {
+		int32_t bits;
+		const float normalized = value + 0.0f; // -0 -> +0
+		std::memcpy(&bits, &normalized, sizeof(bits));
+		return bits;
+	}
+	return static_cast<int64_t>(std::max(-limit, std::min(limit, std::floor(static_cast<double>(value) / cellSize))));
+}
 
-	// Set of vertices used to create unique vertices.
-	std::set<RawVertex, decltype(comp)> rawVertices(comp);
-	// Mapping from old index to new index.
-	std::map<uint32_t, uint32_t> indexReplace;
+//! (static)
+uint32_t mergeCloseVertices(Mesh * mesh, float tolerance) {
+	const uint32_t oldCount = mesh->getVertexCount();
 
-	// Simply go over the indices and add one vertex after another.
-	{
-		const MeshVertexData & vertices = mesh->openVertexData();
-		const MeshIndexData & indices = mesh->openIndexData();
-		const std::size_t vertexSize = desc.getVertexSize();
+	std::vector<uint32_t> positionOfVertex;
+	std::vector<uint32_t> usedVertices;
+	collectUsedVertices(mesh->openIndexData(), oldCount, positionOfVertex, usedVertices);
+	const std::size_t usedCount = usedVertices.size();
 
-		for (uint32_t counter = 0; counter < indexCount; ++counter) {
-			const uint32_t index = indices[counter];
-			const uint8_t * vertex = vertices[index];
-			RawVertex raw(index, vertex, vertexSize);
-			auto it = rawVertices.insert(raw);
-			indexReplace.insert(std::make_pair(index, it.first->getIndex()));
+	std::vector<Geometry::Vec3> positions(usedCount);
+	{
+		Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION));
+		std::vector<Geometry::Vec3> allPositions(oldCount);
+		posAcc->getPositions(0, oldCount, allPositions.data());
+		for(std::size_t k = 0; k < usedCount; ++k)
+			positions[k] = allPositions[usedVertices[k]];
+	}
+
+	// Sort the vertices into a uniform grid with cells of the size of the tolerance.
+	// Two vertices within the tolerance are located in the same or in neighboring cells.
+	// Vertices with a non-finite coordinate are not close to any other vertex and are left out.
+	const float cellSize = tolerance > 0.0f ? tolerance : 0.0f;
+	const int64_t neighborRange = cellSize > 0.0f ? 1 : 0;
+	const uint32_t chunkCount = ParallelFor::getChunkCount(usedCount, 1 << 15);
+	std::vector<GridCell> cellOfVertex(usedCount);
+	std::vector<uint8_t> isFinite(usedCount);
+	ParallelFor::forEachChunk(usedCount, chunkCount, [&](uint32_t, std::size_t begin, std::size_t end) {
+		for(std::size_t k = begin; k < end; ++k) {
+			const Geometry::Vec3 & p = positions[k];
+			isFinite[k] = std::isfinite(p.x()) && std::isfinite(p.y()) && std::isfinite(p.z());
+			if(isFinite[k])
+				cellOfVertex[k] = {toGridCoordinate(p.x(), cellSize), toGridCoordinate(p.y(), cellSize), toGridCoordinate(p.z(), cellSize)};
 		}
+	});
+
+	// Open addressing hash table of the non-empty cells, and the vertices of each cell (compressed rows).
+	std::size_t capacity = 16;
+	while(capacity < 2 * usedCount)
+		capacity <<= 1;
+	const std::size_t mask = capacity - 1;
+	std::vector<uint32_t> cellTable(capacity, NO_VERTEX);
+	std::vector<GridCell> cells;
+	std::vector<uint32_t> cellIdOfVertex(usedCount);
+	std::vector<uint32_t> cellBegin;
+	for(std::size_t k = 0; k < usedCount; ++k) {
+		if(!isFinite[k])
+			continue;
+		const GridCell & cell = cellOfVertex[k];
+		std::size_t slot = cell.hash() & mask;
+		while(cellTable[slot] != NO_VERTEX && !(cells[cellTable[slot]] == cell))
+			slot = (slot + 1) & mask;
+		if(cellTable[slot] == NO_VERTEX) {
+			cellTable[slot] = static_cast<uint32_t>(cells.size());
+			cells.push_back(cell);
+			cellBegin.push_back(0);
+		}
+		cellIdOfVertex[k] = cellTable[slot];
+		++cellBegin[cellTable[slot]];
 	}
-
-	// Mapping from new index to vertex position.
-	std::map<uint32_t, uint32_t> indexPosition;
-
-	// Create the new mesh and add the rawVertices.
-	Util::Reference<Mesh> result = new Mesh;
-	result->setDataStrategy(mesh->getDataStrategy());
-
-	MeshVertexData & vertices = result->openVertexData();
-	vertices.allocate(rawVertices.size(), desc);
-
-	MeshIndexData & indices = result->openIndexData();
-	indices.allocate(indexCount);
-
+	cellBegin.push_back(0);
 	{
-		uint8_t * data = vertices.data();
-		uint32_t vertexPos = 0;
-		for(const auto & vertex : rawVertices) {
-			std::copy(vertex.getData(), vertex.getData() + vertex.getSize(), data);
-			data += vertex.getSize();
-			indexPosition.insert(std::make_pair(vertex.getIndex(), vertexPos));
-			++vertexPos;
+		uint32_t sum = 0;
+		for(auto & begin : cellBegin) {
+			const uint32_t count = begin;
+			begin = sum;
+			sum += count;
 		}
-		// Translate the indices.
-		const uint32_t * srcIndex = mesh->openIndexData().data();
-		uint32_t * dstIndex = indices.data();
-		for (uint32_t counter = 0; counter < indexCount; ++counter) {
-			const uint32_t newIndex = indexReplace.find(*srcIndex)->second;
-			*dstIndex = indexPosition.find(newIndex)->second;
-			++srcIndex;
-			++dstIndex;
+	}
+	std::vector<uint32_t> cellVertices(usedCount);
+	{
+		std::vector<uint32_t> fill(cellBegin.begin(), cellBegin.end() - 1);
+		for(uint32_t k = 0; k < usedCount; ++k) {
+			if(isFinite[k])
+				cellVertices[fill[cellIdOfVertex[k]]++] = k;
 		}
 	}
+	auto findCell = [&](const GridCell & cell) -> uint32_t {
+		std::size_t slot = cell.hash() & mask;
+		while(cellTable[slot] != NO_VERTEX) {
+			if(cells[cellTable[slot]] == cell)
+				return cellTable[slot];
+			slot = (slot + 1) & mask;
+		}
+		return NO_VERTEX;
+	};
 
-	vertices.updateBoundingBox();
-	indices.updateIndexRange();
+	// Unite all pairs of vertices within the tolerance; the smallest position of each set becomes its representative.
+	ConcurrentUnionFind sets(usedCount);
+	ParallelFor::forEachChunk(usedCount, chunkCount, [&](uint32_t, std::size_t begin, std::size_t end) {
+		for(std::size_t k = begin; k < end; ++k) {
+			if(!isFinite[k])
+				continue;
+			const Geometry::Vec3 & p = positions[k];
+			const GridCell & cell = cellOfVertex[k];
+			for(int64_t dx = -neighborRange; dx <= neighborRange; ++dx) {
+				for(int64_t dy = -neighborRange; dy <= neighborRange; ++dy) {
+					for(int64_t dz = -neighborRange; dz <= neighborRange; ++dz) {
+						const uint32_t cellId = findCell({cell.x + dx, cell.y + dy, cell.z + dz});
+						if(cellId == NO_VERTEX)
+							continue;
+						for(uint32_t i = cellBegin[cellId]; i < cellBegin[cellId + 1]; ++i) {
+							const uint32_t j = cellVertices[i];
+							// every pair is handled once (by its larger position)
+							if(j >= k)
+								continue;
+							const Geometry::Vec3 & q = positions[j];
+							if(std::abs(p.x() - q.x()) <= tolerance && std::abs(p.y() - q.y()) <= tolerance && std::abs(p.z() - q.z()) <= tolerance)
+								sets.unite(static_cast<uint32_t>(k), j);
+						}
+					}
+				}
+			}
+		}
+	});
 
-	mesh->swap(*result.get());
+	std::vector<uint32_t> representatives(usedCount);
+	for(std::size_t k = 0; k < usedCount; ++k)
+		representatives[k] = sets.find(static_cast<uint32_t>(k));
+
+	replaceByRepresentatives(mesh, usedVertices, positionOfVertex, representatives);
 
 	return oldCount-mesh->getVertexCount();
 }
@@ -72,15 +72,25 @@ uint32_t calculateHash(Mesh * mesh);
 //! Calculate a hash value for the given vertex description.
 uint32_t calculateHash(const VertexDescription & vd);
 
+//! Weighting of the face normals for calculateNormals(...)
+enum class NormalWeighting : uint8_t {
+	UNIFORM,	//!< All adjacent faces contribute equally.
+	AREA,		//!< The faces contribute proportional to their area.
+	ANGLE		//!< The faces contribute proportional to their interior angle at the vertex.
+};
+
 /**
  * calulates vertex normals for a given mesh calculation is done by
  * - first calculating face normals
- * - second calculating the unweighted average of the adjacent face normals for all vertices
+ * - second calculating the weighted average of the adjacent face normals for all vertices
+ * If the mesh has no normals, a byte normal attribute is added.
+ * Large meshes are processed in parallel.
  * @note if the mesh has already normals these are ignored and recalculated
  * @param m the mesh to be modified
+ * @param weighting weighting of the adjacent face normals
  * @author Ralf Petring
  */
-void calculateNormals(Mesh * m);
+void calculateNormals(Mesh * m, NormalWeighting weighting = NormalWeighting::UNIFORM);
 
 /**
  * Calculate and add tangent space vectors from the normals and uv-coordinates of the given mesh.
@@ -88,10 +98,20 @@ void calculateNormals(Mesh * m);
  * Terathon Software 3D Graphics Library, 2001. http://www.terathon.com/code/tangent.html
  * The bitangent can be calculated in the shader by:
  * float3 bitangent = cross(normal, tangent.xyz) * tangent.w;
+ * Large meshes are processed in parallel; the result does not depend on the number of threads.
  */
 void calculateTangentVectors(	Mesh * mesh, const Util::StringIdentifier uvName,
 const Util::StringIdentifier tangentVecName);
 
+/**
+ * Calculate the normals (see calculateNormals(...)) and the tangent space vectors
+ * (see calculateTangentVectors(...)) of the given mesh in the same passes over the mesh.
+ * This is faster than calling both functions and the tangents are orthogonalized against the
+ * exact normals instead of the stored (possibly quantized) ones.
+ */
+void calculateNormalsAndTangentVectors(Mesh * mesh, const Util::StringIdentifier uvName,
+const Util::StringIdentifier tangentVecName, NormalWeighting weighting = NormalWeighting::UNIFORM);
+
 
 //! Create texture coordinates by projecting the vertices with the given projection matrix.
 void calculateTextureCoordinates_projection( Mesh * mesh, Util::StringIdentifier attribName, const Geometry::Matrix4x4 & projection);
@@ -107,6 +127,16 @@ void calculateTextureCoordinates_projection( Mesh * mesh, Util::StringIdentifier
 Mesh * combineMeshes(const std::deque<Mesh *> & meshArray);
 Mesh * combineMeshes(const std::deque<Mesh *> & meshArray, const std::deque<Geometry::Matrix4x4> & transformations);
 
+/**
+ * Combine several meshes, each transformed by its matrix, into a single mesh.
+ * The vertex and index data of the result are allocated once, and the meshes are copied and
+ * transformed in parallel. Identity matrices are skipped; affine matrices applied to float
+ * positions and normals use SIMD code.
+ *
+ * @note All meshes must have the same VertexDescription; other meshes are skipped with a warning.
+ */
+Mesh * combineMeshes(const std::vector<std::pair<Mesh *, Geometry::Matrix4x4>> & meshes);
+
 /**
  * Splits the vertex data of a given mesh into multiple blocks of vertex data each containing @a chunkSize many vertices.
  *
@@ -145,14 +175,18 @@ void copyVertexAttribute(Mesh * mesh, Util::StringIdentifier from, Util::StringI
 /**
  * Remove vertices which are equal to each other from the mesh and
  * store them only once. The indices to the vertices are adjusted.
- * This function has runtime O(n * log(n)) where n is the
- * number of vertices in @a mesh.
+ * Vertices that are not referenced by an index are removed as well;
+ * the remaining vertices are ordered by their first use.
+ * This function has expected runtime O(n) where n is the
+ * number of indices of @a mesh (the vertices are compared in a hash table).
  *
  * @param mesh Mesh to do the elimination on.
+ * @param parallel If @c true, the hash table is split into partitions that are processed in parallel.
+ * @throw std::out_of_range if an index references a vertex that does not exist.
  *
  * @author Benjamin Eikel
  */
-void eliminateDuplicateVertices(Mesh * mesh);
+void eliminateDuplicateVertices(Mesh * mesh, bool parallel = false);
 
 /**
  * Clone the given mesh but remove all vertices which are
@@ -190,6 +224,31 @@ Mesh * eliminateZeroAreaTriangles(Mesh * m);
 
 float getLongestSideLength(Mesh * m);
 
+//! Result of a simulation of a FIFO post-transform vertex cache (see calculateVertexCacheStatistics(...)).
+struct VertexCacheStatistics {
+	//! Number of vertices that have to be transformed.
+	uint32_t transformedVertices;
+	//! Average cache miss ratio: transformed vertices per triangle (between 0.5 and 3 for triangle meshes).
+	float acmr;
+	//! Average transformed vertex ratio: transformed vertices per vertex of the mesh (optimal: 1).
+	float atvr;
+};
+
+//! Vertex cache statistics before and after an optimization pass.
+struct OptimizationReport {
+	VertexCacheStatistics before;
+	VertexCacheStatistics after;
+};
+
+/*! Simulate a FIFO post-transform vertex cache of the given size for the mesh's index data.
+	\throw std::out_of_range if an index references a vertex that does not exist.	*/
+VertexCacheStatistics calculateVertexCacheStatistics(Mesh * mesh, const uint_fast8_t cacheSize = 24);
+
+/*! Simulate a FIFO post-transform vertex cache of the given size for a list of triangle indices
+	referencing @p vertexCount vertices.
+	\throw std::out_of_range if an index is not smaller than @p vertexCount.	*/
+VertexCacheStatistics calculateVertexCacheStatistics(const std::vector<uint32_t> & indices, uint32_t vertexCount, uint32_t cacheSize);
+
 /**
  * Take the given mesh and optimize the indices stored there for
  * vertex cache optimality.
@@ -201,10 +260,43 @@ float getLongestSideLength(Mesh * m);
  * @param mesh Mesh whose indices will be optimized.
  * @param cacheSize Post-transform vertex cache size to optimize
  * for. This parameter is called @c k in the article.
+ * @return Vertex cache statistics before and after the optimization.
+ * @throw std::out_of_range if an index references a vertex that does not exist.
  * @see http://doi.acm.org/10.1145/1276377.1276489
  * @author Benjamin Eikel
  */
-void optimizeIndices(Mesh * mesh, const uint_fast8_t cacheSize =	24);
+OptimizationReport optimizeIndices(Mesh * mesh, const uint_fast8_t cacheSize =	24);
+
+/**
+ * Reorder the vertices of the given mesh in the order of their first use by the indices
+ * and adjust the indices. This improves the locality of the vertex fetches and should be
+ * done after the index order has been optimized (e.g. by optimizeIndices(...) and optimizeOverdraw(...)).
+ * Unused vertices are removed.
+ *
+ * @param mesh Mesh whose vertices will be reordered.
+ * @param cacheSize Vertex cache size used for the statistics of the report.
+ * @return Vertex cache statistics before and after the reordering.
+ * @throw std::out_of_range if an index references a vertex that does not exist.
+ */
+OptimizationReport optimizeVertexFetch(Mesh * mesh, const uint_fast8_t cacheSize = 24);
+
+/**
+ * Reorder the triangles of the given mesh to reduce overdraw while mostly keeping the
+ * vertex cache optimization. Should be called after optimizeIndices(...).
+ * The triangle sequence is split into clusters at points where the vertex cache is flushed
+ * and where splitting keeps the cache miss ratio of a cluster below @a threshold times the
+ * cache miss ratio of the unsplit cluster. The clusters are then sorted by the distance of their
+ * centroid from the mesh's centroid along the cluster's normal, so that outer clusters are drawn first.
+ * This function has runtime O(n + c * log(c)) where n is the number of indices and c the number of clusters.
+ *
+ * @param mesh Mesh whose indices will be reordered.
+ * @param cacheSize Post-transform vertex cache size (should be the same as for optimizeIndices(...)).
+ * @param threshold Allowed increase of the cache miss ratio (e.g. 1.05 allows 5% more vertex transformations).
+ * @return Vertex cache statistics before and after the optimization.
+ * @throw std::out_of_range if an index references a vertex that does not exist.
+ * @see Sander, Nehab and Barczak: Fast Triangle Reordering for Vertex Locality and Reduced Overdraw. http://doi.acm.org/10.1145/1276377.1276489
+ */
+OptimizationReport optimizeOverdraw(Mesh * mesh, const uint_fast8_t cacheSize = 24, float threshold = 1.05f);
 
 /**
  * removes the color information from a mesh
@@ -319,6 +411,7 @@ void extrudeTriangles(Mesh* m, const Geometry::Vec3& dir, const std::set<uint32_
 
 /**
  * Slow method for finding the first triangle in a mesh that intersects the given ray.
+ * For repeated queries on the same mesh (e.g. picking), build a MeshUtils::TriangleBVH instead.
  * @param m the mesh
  * @param ray the ray
  * @return -1 if no intersecting triangle was found, the triangle index otherwise.
@@ -329,11 +422,18 @@ int32_t getFirstTriangleIntersectingRay(Mesh* m, const Geometry::Ray3& ray);
 /**
  * Remove vertices which are close to each other from the mesh and
  * store them only once. The indices to the vertices are adjusted.
- * This function has runtime O(n * log(n)) where n is the
- * number of vertices in @a mesh.
+ * Two vertices are close if their positions differ by at most @a tolerance in each coordinate.
+ * Vertices with an infinite or NaN coordinate are never close to another vertex.
+ * All vertices that are connected by a chain of close vertices are merged
+ * into the one that is used first.
+ * Unused vertices are removed as well.
+ * The vertices are sorted into a uniform grid, so this function has expected runtime O(n)
+ * where n is the number of vertices in @a mesh; large meshes are processed in parallel.
  *
  * @param mesh Mesh to do the elimination on.
+ * @param tolerance Maximum distance per coordinate
  * @return number of merged vertices
+ * @throw std::out_of_range if an index references a vertex that does not exist.
  * @author Sascha Brandt
  */
 uint32_t mergeCloseVertices(Mesh * mesh, float tolerance=std::numeric_limits<float>::epsilon());
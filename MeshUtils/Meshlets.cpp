@@ -0,0 +1,261 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "Meshlets.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../RenderingContext/RenderingContext.h"
+
+#include <Geometry/BoundingSphere.h>
+#include <Geometry/Box.h>
+#include <Geometry/Frustum.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace Rendering {
+namespace MeshUtils {
+
+static const uint32_t NOT_IN_MESHLET = std::numeric_limits<uint32_t>::max();
+
+//! (internal) Calculate the bounding sphere and the normal cone of a meshlet.
+static void calculateCullingData(Meshlet & meshlet, const MeshletList & list, const std::vector<Geometry::Vec3> & positions) {
+	std::vector<Geometry::Vec3> meshletPositions;
+	meshletPositions.reserve(meshlet.vertexCount);
+	for(uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+		meshletPositions.push_back(positions[list.vertices[meshlet.vertexOffset + i]]);
+	}
+	meshlet.boundingSphere = Geometry::BoundingSphere::computeMiniball(meshletPositions);
+	const Geometry::Vec3 center = meshlet.boundingSphere.getCenter();
+
+	// normals and centroids of the triangles
+	std::vector<Geometry::Vec3> normals;
+	std::vector<Geometry::Vec3> centroids;
+	Geometry::Vec3 axis;
+	for(uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+		const uint8_t * triangle = list.localIndices.data() + (meshlet.triangleOffset + t) * 3;
+		const Geometry::Vec3 & a = meshletPositions[triangle[0]];
+		const Geometry::Vec3 & b = meshletPositions[triangle[1]];
+		const Geometry::Vec3 & c = meshletPositions[triangle[2]];
+		Geometry::Vec3 normal = (b - a).cross(c - a);
+		if(normal.isZero()) {
+			continue;
+		}
+		normal.normalize();
+		normals.push_back(normal);
+		centroids.push_back((a + b + c) / 3.0f);
+		axis += normal;
+	}
+	meshlet.coneApex = center;
+	meshlet.coneAxis = Geometry::Vec3(0.0f, 0.0f, 1.0f);
+	meshlet.coneCutoff = 2.0f;
+	if(normals.empty() || axis.isZero()) {
+		return;
+	}
+	axis.normalize();
+	float minDot = 1.0f;
+	for(const auto & normal : normals) {
+		minDot = std::min(minDot, normal.dot(axis));
+	}
+	if(minDot <= 0.0f) {
+		// the normals span more than a hemisphere
+		return;
+	}
+	// Move the apex behind all triangle planes along the axis, so that the cone contains all
+	// positions from which any triangle is front facing.
+	float maxT = 0.0f;
+	for(std::size_t i = 0; i < normals.size(); ++i) {
+		const float t = (center - centroids[i]).dot(normals[i]) / normals[i].dot(axis);
+		maxT = std::max(maxT, t);
+	}
+	meshlet.coneApex = center - axis * maxT;
+	meshlet.coneAxis = axis;
+	meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+//! (static)
+MeshletList createMeshlets(Mesh * mesh, uint32_t maxVertices, uint32_t maxTriangles) {
+	if(!mesh->isUsingIndexData() || mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+		throw std::invalid_argument("createMeshlets: Mesh is not a valid triangle mesh.");
+	}
+	if(maxVertices < 3 || maxVertices > 256 || maxTriangles < 1) {
+		throw std::invalid_argument("createMeshlets: Invalid meshlet size.");
+	}
+	const uint32_t vertexCount = mesh->getVertexCount();
+	MeshIndexData & indexData = mesh->openIndexData();
+	const MeshIndexData & sourceIndices = indexData;
+	const uint32_t triangleCount = sourceIndices.getIndexCount() / 3;
+	std::vector<uint32_t> indices(triangleCount * 3);
+	for(uint32_t i = 0; i < indices.size(); ++i) {
+		indices[i] = sourceIndices[i];
+		if(indices[i] >= vertexCount) {
+			throw std::invalid_argument("createMeshlets: Vertex index out of range.");
+		}
+	}
+
+	// vertex-triangle adjacency (compressed rows)
+	std::vector<uint32_t> triangleBegin(vertexCount + 1, 0);
+	for(const auto & index : indices) {
+		++triangleBegin[index + 1];
+	}
+	for(uint32_t v = 0; v < vertexCount; ++v) {
+		triangleBegin[v + 1] += triangleBegin[v];
+	}
+	std::vector<uint32_t> vertexTriangles(indices.size());
+	{
+		std::vector<uint32_t> fill(triangleBegin.begin(), triangleBegin.end() - 1);
+		for(uint32_t i = 0; i < indices.size(); ++i) {
+			vertexTriangles[fill[indices[i]]++] = i / 3;
+		}
+	}
+
+	MeshletList list;
+	std::vector<uint32_t> newIndices;
+	newIndices.reserve(indices.size());
+	std::vector<uint8_t> assigned(triangleCount, 0);
+	std::vector<uint32_t> localIndexOfVertex(vertexCount, NOT_IN_MESHLET);
+	//! Meshlet number + 1 for which a triangle has been added to the candidates.
+	std::vector<uint32_t> candidateOf(triangleCount, 0);
+	std::vector<uint32_t> candidates;
+
+	uint32_t seed = 0;
+	while(true) {
+		while(seed < triangleCount && assigned[seed]) {
+			++seed;
+		}
+		if(seed == triangleCount) {
+			break;
+		}
+		Meshlet meshlet;
+		meshlet.vertexOffset = static_cast<uint32_t>(list.vertices.size());
+		meshlet.vertexCount = 0;
+		meshlet.triangleOffset = static_cast<uint32_t>(list.localIndices.size() / 3);
+		meshlet.triangleCount = 0;
+		meshlet.firstIndex = static_cast<uint32_t>(newIndices.size());
+		const uint32_t meshletNumber = static_cast<uint32_t>(list.meshlets.size()) + 1;
+		candidates.clear();
+
+		uint32_t next = seed;
+		while(true) {
+			// add the triangle
+			assigned[next] = 1;
+			for(uint_fast8_t i = 0; i < 3; ++i) {
+				const uint32_t vertex = indices[next * 3 + i];
+				if(localIndexOfVertex[vertex] == NOT_IN_MESHLET) {
+					localIndexOfVertex[vertex] = meshlet.vertexCount++;
+					list.vertices.push_back(vertex);
+					// the unassigned neighbors become candidates
+					for(uint32_t j = triangleBegin[vertex]; j < triangleBegin[vertex + 1]; ++j) {
+						const uint32_t neighbor = vertexTriangles[j];
+						if(!assigned[neighbor] && candidateOf[neighbor] != meshletNumber) {
+							candidateOf[neighbor] = meshletNumber;
+							candidates.push_back(neighbor);
+						}
+					}
+				}
+				list.localIndices.push_back(static_cast<uint8_t>(localIndexOfVertex[vertex]));
+				newIndices.push_back(vertex);
+			}
+			++meshlet.triangleCount;
+			if(meshlet.triangleCount == maxTriangles) {
+				break;
+			}
+
+			// select the candidate adding the fewest new vertices (the first one for ties)
+			uint32_t best = NOT_IN_MESHLET;
+			uint32_t bestNewVertices = 4;
+			std::size_t kept = 0;
+			for(const auto & candidate : candidates) {
+				if(assigned[candidate]) {
+					continue;
+				}
+				candidates[kept++] = candidate;
+				uint32_t newVertices = 0;
+				for(uint_fast8_t i = 0; i < 3; ++i) {
+					if(localIndexOfVertex[indices[candidate * 3 + i]] == NOT_IN_MESHLET) {
+						++newVertices;
+					}
+				}
+				if(meshlet.vertexCount + newVertices <= maxVertices &&
+						(newVertices < bestNewVertices || (newVertices == bestNewVertices && candidate < best))) {
+					best = candidate;
+					bestNewVertices = newVertices;
+				}
+			}
+			candidates.resize(kept);
+			if(best == NOT_IN_MESHLET) {
+				break;
+			}
+			next = best;
+		}
+
+		for(uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+			localIndexOfVertex[list.vertices[meshlet.vertexOffset + i]] = NOT_IN_MESHLET;
+		}
+		list.meshlets.push_back(meshlet);
+	}
+
+	// store the triangles of each meshlet contiguously
+	MeshIndexData reorderedIndices;
+	reorderedIndices.allocate(static_cast<uint32_t>(newIndices.size()));
+	std::copy(newIndices.begin(), newIndices.end(), reorderedIndices.data());
+	reorderedIndices.markAsChanged();
+	reorderedIndices.updateIndexRange();
+	indexData.swap(reorderedIndices);
+
+	std::vector<Geometry::Vec3> positions(vertexCount);
+	{
+		Util::Reference<PositionAttributeAccessor> positionAccessor(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION));
+		positionAccessor->getPositions(0, vertexCount, positions.data());
+	}
+	for(auto & meshlet : list.meshlets) {
+		calculateCullingData(meshlet, list, positions);
+	}
+	return list;
+}
+
+//! (static)
+uint32_t displayMeshlets(RenderingContext & rc, Mesh * mesh, const MeshletList & meshlets,
+						 const Geometry::Frustum & frustum, const Geometry::Vec3 & cameraPosition) {
+	uint32_t drawnMeshlets = 0;
+	uint32_t rangeBegin = 0;
+	uint32_t rangeEnd = 0;
+	for(const auto & meshlet : meshlets.meshlets) {
+		if(meshlet.coneCutoff <= 1.0f && (meshlet.coneApex - cameraPosition).getNormalized().dot(meshlet.coneAxis) >= meshlet.coneCutoff) {
+			continue;
+		}
+		const Geometry::Vec3 & center = meshlet.boundingSphere.getCenter();
+		const float radius = meshlet.boundingSphere.getRadius();
+		const Geometry::Vec3 extent(radius, radius, radius);
+		if(frustum.isBoxInFrustum(Geometry::Box(center - extent, center + extent)) == Geometry::Frustum::OUTSIDE) {
+			continue;
+		}
+		++drawnMeshlets;
+		if(meshlet.firstIndex != rangeEnd) {
+			if(rangeEnd > rangeBegin) {
+				rc.displayMesh(mesh, rangeBegin, rangeEnd - rangeBegin);
+			}
+			rangeBegin = meshlet.firstIndex;
+		}
+		rangeEnd = meshlet.firstIndex + meshlet.triangleCount * 3;
+	}
+	if(rangeEnd > rangeBegin) {
+		rc.displayMesh(mesh, rangeBegin, rangeEnd - rangeBegin);
+	}
+	return drawnMeshlets;
+}
+
+}
+}
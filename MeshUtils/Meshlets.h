@@ -0,0 +1,94 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHLETS_H_
+#define RENDERING_MESHLETS_H_
+
+#include <Geometry/Sphere.h>
+#include <Geometry/Vec3.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+class Frustum;
+}
+namespace Rendering {
+class Mesh;
+class RenderingContext;
+namespace MeshUtils {
+
+/**
+ * Cluster of neighboring triangles of a mesh with a bounded number of vertices and triangles.
+ * The triangles of a meshlet are stored contiguously in the index data of the mesh.
+ */
+struct Meshlet {
+	//! Range of the meshlet's vertices in MeshletList::vertices.
+	uint32_t vertexOffset;
+	uint32_t vertexCount;
+	//! Range of the meshlet's triangles in MeshletList::localIndices (three local indices per triangle).
+	uint32_t triangleOffset;
+	uint32_t triangleCount;
+	//! Position of the meshlet's first index in the index data of the mesh; the meshlet uses 3*triangleCount indices.
+	uint32_t firstIndex;
+
+	//! Bounding sphere of the meshlet's vertices.
+	Geometry::Sphere_f boundingSphere;
+
+	/*! Normal cone for backface culling: the meshlet is completely backfacing for a viewer at position p if
+		(coneApex - p).getNormalized().dot(coneAxis) >= coneCutoff.
+		If coneCutoff is greater than one, the normals are spread too much for backface culling. */
+	Geometry::Vec3 coneApex;
+	Geometry::Vec3 coneAxis;
+	float coneCutoff;
+};
+
+//! Meshlets of a mesh with their vertex and index lists stored in shared arrays.
+struct MeshletList {
+	std::vector<Meshlet> meshlets;
+	//! Vertex indices of the mesh used by the meshlets.
+	std::vector<uint32_t> vertices;
+	//! Triangles of the meshlets as indices into the meshlet's part of @a vertices.
+	std::vector<uint8_t> localIndices;
+};
+
+/**
+ * Split the triangles of the given mesh into meshlets (e.g. for mesh shaders or for cluster culling).
+ * Starting with a seed triangle, a meshlet is grown by adding the adjacent triangle sharing the
+ * most vertices with the meshlet until no further triangle fits.
+ * The index data of the mesh is reordered, so that the triangles of each meshlet are stored contiguously.
+ * Should be called before or instead of optimizeIndices(...), as the triangle order is changed.
+ *
+ * @param mesh Indexed triangle mesh; its index data is reordered.
+ * @param maxVertices Maximal number of vertices of a meshlet (at most 256).
+ * @param maxTriangles Maximal number of triangles of a meshlet.
+ * @return The meshlets in the order of their triangles in the index data.
+ * @throw std::invalid_argument if the mesh is no indexed triangle mesh or the limits are invalid.
+ */
+MeshletList createMeshlets(Mesh * mesh, uint32_t maxVertices = 64, uint32_t maxTriangles = 124);
+
+/**
+ * Draw the meshlets of the given mesh that are not culled. A meshlet is culled if its bounding
+ * sphere is outside of the frustum or if its normal cone shows that it is completely backfacing.
+ * Neighboring visible meshlets are drawn with a single call of RenderingContext::displayMesh(mesh, first, count).
+ * @note The backface test assumes that backface culling is enabled.
+ *
+ * @param meshlets Result of createMeshlets(mesh) (the index data must not have been changed since).
+ * @param frustum View frustum in the mesh's coordinate system.
+ * @param cameraPosition Position of the camera in the mesh's coordinate system.
+ * @return Number of drawn meshlets.
+ */
+uint32_t displayMeshlets(RenderingContext & rc, Mesh * mesh, const MeshletList & meshlets,
+						 const Geometry::Frustum & frustum, const Geometry::Vec3 & cameraPosition);
+
+}
+}
+
+#endif /* RENDERING_MESHLETS_H_ */
@@ -0,0 +1,579 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "OutOfCoreSimplification.h"
+#include "../GLHeader.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/VertexDescription.h"
+#include "../Mesh/internal/ParallelFor.h"
+#include "../Serialization/Serialization.h"
+#include "../Serialization/StreamerMMF.h"
+#include "../Serialization/StreamerPLY.h"
+#include <Geometry/Box.h>
+#include <Util/IO/FileName.h>
+#include <Util/IO/FileUtils.h>
+#include <Util/Macros.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+namespace MeshUtils {
+namespace Simplification {
+
+//! (internal) Minimal number of triangles per thread when scanning the index data.
+static const std::size_t minScanChunkSize = 1 << 16;
+//! (internal) Maximal number of cells along an axis.
+static const uint32_t maxCellResolution = 1024;
+//! (internal) Marker for a vertex without an index.
+static const uint32_t NONE = 0xffffffff;
+
+namespace {
+//! (internal) Uniform grid of cubic cells over the bounding box of the input mesh.
+struct CellGrid {
+	float origin[3];
+	float inverseCellSize;
+	uint32_t resolution[3];
+
+	CellGrid(const Geometry::Box & box, uint32_t maxResolution) {
+		const float extent = box.getExtentMax();
+		const float cellSize = extent > 0.0f ? extent / maxResolution : 1.0f;
+		inverseCellSize = 1.0f / cellSize;
+		const float extents[3] = {box.getExtentX(), box.getExtentY(), box.getExtentZ()};
+		for(uint_fast8_t axis = 0; axis < 3; ++axis) {
+			origin[axis] = box.getMin()[axis];
+			resolution[axis] = std::max(1u, std::min(maxResolution, static_cast<uint32_t>(std::ceil(extents[axis] * inverseCellSize))));
+		}
+	}
+
+	uint64_t getCell(const float * position) const {
+		uint64_t coordinates[3];
+		for(uint_fast8_t axis = 0; axis < 3; ++axis) {
+			const float c = std::floor((position[axis] - origin[axis]) * inverseCellSize);
+			coordinates[axis] = c <= 0.0f ? 0 : std::min(static_cast<uint64_t>(c), static_cast<uint64_t>(resolution[axis] - 1));
+		}
+		return coordinates[0] + resolution[0] * (coordinates[1] + static_cast<uint64_t>(resolution[1]) * coordinates[2]);
+	}
+};
+
+//! (internal) Path of a temporary file that is removed when the object is destroyed.
+struct TemporaryFile {
+	const std::string path;
+	explicit TemporaryFile(std::string _path) : path(std::move(_path)) {
+	}
+	~TemporaryFile() {
+		std::remove(path.c_str());
+	}
+};
+
+/*! (internal) The finished part of the result: Its interleaved vertices and its indices are appended to two temporary
+	files, and they are copied into an .mmf file at the end, when their numbers and the bounding box are known. */
+class ResultFiles {
+	private:
+		TemporaryFile vertexFile;
+		TemporaryFile indexFile;
+		std::fstream vertices;
+		std::fstream indices;
+		const VertexDescription & vd;
+		const std::size_t vertexSize;
+		const std::size_t positionOffset;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t minIndex;
+		uint32_t maxIndex;
+		float min[3];
+		float max[3];
+
+		static void copyFile(std::fstream & file, std::ostream & output) {
+			file.flush();
+			file.seekg(0);
+			std::vector<char> buffer(1 << 20);
+			while(file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+				output.write(buffer.data(), file.gcount());
+			}
+			file.clear();
+		}
+
+	public:
+		ResultFiles(const std::string & pathPrefix, const VertexDescription & _vd) :
+				vertexFile(pathPrefix + ".ooc-vertices"), indexFile(pathPrefix + ".ooc-indices"),
+				vertices(vertexFile.path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc),
+				indices(indexFile.path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc),
+				vd(_vd), vertexSize(_vd.getVertexSize()), positionOffset(_vd.getAttribute(VertexAttributeIds::POSITION).getOffset()),
+				vertexCount(0), indexCount(0), minIndex(0), maxIndex(0), min(), max() {
+		}
+
+		bool good() const {
+			return vertices.good() && indices.good();
+		}
+		uint32_t getTriangleCount() const {
+			return indexCount / 3;
+		}
+
+		//! Append a vertex (given as interleaved data) and return its index.
+		uint32_t addVertex(const uint8_t * vertex) {
+			const float * position = reinterpret_cast<const float *>(vertex + positionOffset);
+			for(uint_fast8_t axis = 0; axis < 3; ++axis) {
+				min[axis] = vertexCount == 0 ? position[axis] : std::min(min[axis], position[axis]);
+				max[axis] = vertexCount == 0 ? position[axis] : std::max(max[axis], position[axis]);
+			}
+			vertices.write(reinterpret_cast<const char *>(vertex), vertexSize);
+			return vertexCount++;
+		}
+
+		void addTriangle(const uint32_t * triangle) {
+			for(uint_fast8_t i = 0; i < 3; ++i) {
+				minIndex = indexCount == 0 && i == 0 ? triangle[i] : std::min(minIndex, triangle[i]);
+				maxIndex = indexCount == 0 && i == 0 ? triangle[i] : std::max(maxIndex, triangle[i]);
+			}
+			indices.write(reinterpret_cast<const char *>(triangle), 3 * sizeof(uint32_t));
+			indexCount += 3;
+		}
+
+		//! Write the collected vertices and triangles as .mmf file to @p output.
+		bool write(std::ostream & output) {
+			StreamerMMF::writeHeader(output);
+			StreamerMMF::writeVertexBlockHeader(output, vd, vertexCount, Geometry::Box(min[0], max[0], min[1], max[1], min[2], max[2]));
+			copyFile(vertices, output);
+			StreamerMMF::writeIndexBlockHeader(output, indexCount, GL_TRIANGLES);
+			copyFile(indices, output);
+			if(indexCount > 0)
+				StreamerMMF::writeIndexRange(output, minIndex, maxIndex);
+			StreamerMMF::writeEnd(output);
+			return good() && output.good();
+		}
+};
+
+/*! (internal) The triangles along the cell borders, which are simplified again after all cells have been processed.
+	The locked vertices are shared by several cells and are merged. The other vertices are contained in one cell only; if they
+	are also used by a finished triangle (seam vertices), they already have an index in the result and must not be changed. */
+struct BorderPart {
+	const std::size_t vertexSize;
+	std::vector<uint8_t> vertices;
+	//! Index in the result for the seam vertices, NONE for the other vertices.
+	std::vector<uint32_t> resultIndices;
+	std::vector<uint32_t> indices;
+	//! Index of every locked vertex (given by its data).
+	std::unordered_map<std::string, uint32_t> lockedVertices;
+
+	explicit BorderPart(std::size_t _vertexSize) : vertexSize(_vertexSize) {
+	}
+
+	uint32_t getVertexCount() const {
+		return static_cast<uint32_t>(resultIndices.size());
+	}
+
+	uint32_t addVertex(const uint8_t * vertex, bool locked, uint32_t resultIndex) {
+		if(locked) {
+			const auto inserted = lockedVertices.emplace(std::string(reinterpret_cast<const char *>(vertex), vertexSize), getVertexCount());
+			if(!inserted.second) {
+				return inserted.first->second;
+			}
+		}
+		vertices.insert(vertices.end(), vertex, vertex + vertexSize);
+		resultIndices.push_back(resultIndex);
+		return getVertexCount() - 1;
+	}
+};
+}
+
+/**
+ * (internal) Create a mesh from the given triangles of the input mesh, containing copies of the used vertices.
+ * The vertices are read in place in the input's vertex layout and are stored interleaved in the new mesh.
+ * @param locked Set to the locked flags of the used vertices.
+ */
+static Mesh * createCellMesh(const MeshVertexData & vertices, const MeshIndexData & indices,
+							 const uint32_t * triangles, std::size_t triangleCount, const std::vector<std::atomic<uint64_t>> & lockedBits,
+							 std::vector<bool> & locked) {
+	std::vector<uint32_t> usedVertices;
+	usedVertices.reserve(triangleCount * 3);
+	for(std::size_t t = 0; t < triangleCount; ++t) {
+		usedVertices.push_back(indices[triangles[t] * 3 + 0]);
+		usedVertices.push_back(indices[triangles[t] * 3 + 1]);
+		usedVertices.push_back(indices[triangles[t] * 3 + 2]);
+	}
+	std::sort(usedVertices.begin(), usedVertices.end());
+	usedVertices.erase(std::unique(usedVertices.begin(), usedVertices.end()), usedVertices.end());
+
+	const VertexDescription & vd = vertices.getVertexDescription();
+	const std::size_t vertexSize = vd.getVertexSize();
+	Util::Reference<Mesh> cellMesh = new Mesh;
+	MeshVertexData & cellVertices = cellMesh->openVertexData();
+	cellVertices.allocate(static_cast<uint32_t>(usedVertices.size()), vd);
+	uint8_t * cellVertexData = cellVertices.data();
+	for(const auto & attr : vd.getAttributes()) {
+		if(attr.empty()) {
+			continue;
+		}
+		const uint8_t * source = vertices.getAttributeData(attr);
+		const std::size_t sourceStride = vertices.getAttributeStride(attr);
+		uint8_t * target = cellVertexData + attr.getOffset();
+		for(std::size_t i = 0; i < usedVertices.size(); ++i) {
+			std::memcpy(target + i * vertexSize, source + usedVertices[i] * sourceStride, attr.getDataSize());
+		}
+	}
+	locked.assign(usedVertices.size(), false);
+	for(std::size_t i = 0; i < usedVertices.size(); ++i) {
+		const uint32_t vertex = usedVertices[i];
+		locked[i] = (lockedBits[vertex / 64].load(std::memory_order_relaxed) & (static_cast<uint64_t>(1) << (vertex % 64))) != 0;
+	}
+	cellVertices.updateBoundingBox();
+
+	MeshIndexData & cellIndices = cellMesh->openIndexData();
+	cellIndices.allocate(static_cast<uint32_t>(triangleCount * 3));
+	uint32_t * cellIndexData = cellIndices.data();
+	for(std::size_t t = 0; t < triangleCount; ++t) {
+		for(uint_fast8_t corner = 0; corner < 3; ++corner) {
+			const uint32_t vertex = indices[triangles[t] * 3 + corner];
+			*cellIndexData++ = static_cast<uint32_t>(std::lower_bound(usedVertices.begin(), usedVertices.end(), vertex) - usedVertices.begin());
+		}
+	}
+	cellIndices.updateIndexRange();
+	return cellMesh.detachAndDecrease();
+}
+
+/*! (internal) Determine the vertices of the simplified @p cellMesh that are locked. As locked vertices are not changed by
+	simplifyMesh(...), they are identified by their data.
+	@param lockedVertices The data of the locked vertices of the cell before the simplification */
+static std::vector<bool> findLockedVertices(Mesh * cellMesh, const std::unordered_set<std::string> & lockedVertices) {
+	const MeshVertexData & vertices = cellMesh->openVertexData();
+	const std::size_t vertexSize = vertices.getVertexDescription().getVertexSize();
+	std::vector<bool> locked(vertices.getVertexCount(), false);
+	for(uint32_t v = 0; v < vertices.getVertexCount(); ++v) {
+		locked[v] = lockedVertices.count(std::string(reinterpret_cast<const char *>(vertices[v]), vertexSize)) > 0;
+	}
+	return locked;
+}
+
+/*! (internal) Append the triangles of the simplified @p cellMesh without locked vertices to @p result,
+	and the others to @p borderPart. */
+static void splitCell(Mesh * cellMesh, const std::vector<bool> & locked, ResultFiles & result, BorderPart & borderPart) {
+	const MeshVertexData & vertices = cellMesh->openVertexData();
+	const MeshIndexData & indices = cellMesh->openIndexData();
+	const uint32_t triangleCount = indices.getIndexCount() / 3;
+	std::vector<uint32_t> resultIndices(vertices.getVertexCount(), NONE);
+	std::vector<uint32_t> borderIndices(vertices.getVertexCount(), NONE);
+	std::vector<bool> borderTriangles(triangleCount, false);
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		const uint32_t triangle[3] = {indices[t * 3 + 0], indices[t * 3 + 1], indices[t * 3 + 2]};
+		borderTriangles[t] = locked[triangle[0]] || locked[triangle[1]] || locked[triangle[2]];
+		if(borderTriangles[t]) {
+			continue;
+		}
+		uint32_t resultTriangle[3];
+		for(uint_fast8_t corner = 0; corner < 3; ++corner) {
+			uint32_t & resultIndex = resultIndices[triangle[corner]];
+			if(resultIndex == NONE) {
+				resultIndex = result.addVertex(vertices[triangle[corner]]);
+			}
+			resultTriangle[corner] = resultIndex;
+		}
+		result.addTriangle(resultTriangle);
+	}
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		if(!borderTriangles[t]) {
+			continue;
+		}
+		for(uint_fast8_t corner = 0; corner < 3; ++corner) {
+			const uint32_t vertex = indices[t * 3 + corner];
+			uint32_t & borderIndex = borderIndices[vertex];
+			if(borderIndex == NONE) {
+				borderIndex = borderPart.addVertex(vertices[vertex], locked[vertex], resultIndices[vertex]);
+			}
+			borderPart.indices.push_back(borderIndex);
+		}
+	}
+}
+
+/*! (internal) Simplify the triangles along the cell borders to @p numberOfTriangles triangles, keeping the seam vertices,
+	and append them to @p result. */
+static void simplifyBorderPart(BorderPart & borderPart, const VertexDescription & vd, uint32_t numberOfTriangles,
+							   const OutOfCoreParameters & parameters, const weights_t & weights, ResultFiles & result) {
+	if(borderPart.indices.empty()) {
+		return;
+	}
+	Util::Reference<Mesh> borderMesh = new Mesh(vd, borderPart.getVertexCount(), static_cast<uint32_t>(borderPart.indices.size()));
+	MeshVertexData & borderVertices = borderMesh->openVertexData();
+	std::copy(borderPart.vertices.begin(), borderPart.vertices.end(), borderVertices.data());
+	borderVertices.updateBoundingBox();
+	MeshIndexData & borderIndices = borderMesh->openIndexData();
+	std::copy(borderPart.indices.begin(), borderPart.indices.end(), borderIndices.data());
+	borderIndices.updateIndexRange();
+
+	std::vector<bool> seamVertices(borderPart.getVertexCount());
+	std::unordered_map<std::string, uint32_t> seamResultIndices;
+	for(uint32_t v = 0; v < borderPart.getVertexCount(); ++v) {
+		seamVertices[v] = borderPart.resultIndices[v] != NONE;
+		if(seamVertices[v]) {
+			seamResultIndices.emplace(std::string(reinterpret_cast<const char *>(borderVertices[v]), borderPart.vertexSize), borderPart.resultIndices[v]);
+		}
+	}
+	std::vector<uint8_t>().swap(borderPart.vertices);
+	std::vector<uint32_t>().swap(borderPart.indices);
+	borderPart.lockedVertices.clear();
+
+	if(borderMesh->getPrimitiveCount() > numberOfTriangles) {
+		borderMesh = simplifyMesh(borderMesh.get(), numberOfTriangles, 0.0f, parameters.useOptimalPositioning, parameters.maxAngle, weights, seamVertices);
+	}
+
+	// the seam vertices are not changed by simplifyMesh(...), so they are identified by their data
+	const MeshVertexData & vertices = borderMesh->openVertexData();
+	const MeshIndexData & indices = borderMesh->openIndexData();
+	std::vector<uint32_t> resultIndices(vertices.getVertexCount());
+	for(uint32_t v = 0; v < vertices.getVertexCount(); ++v) {
+		const auto seamVertex = seamResultIndices.find(std::string(reinterpret_cast<const char *>(vertices[v]), borderPart.vertexSize));
+		resultIndices[v] = seamVertex != seamResultIndices.end() ? seamVertex->second : result.addVertex(vertices[v]);
+	}
+	for(uint32_t i = 0; i + 2 < indices.getIndexCount(); i += 3) {
+		const uint32_t triangle[3] = {resultIndices[indices[i]], resultIndices[indices[i + 1]], resultIndices[indices[i + 2]]};
+		result.addTriangle(triangle);
+	}
+}
+
+/*! (internal) Load the input mesh; its vertex and index data stay in the mapped file if possible.
+	A .ply file is converted to the .mmf file @p convertedFile first, which is then mapped. */
+static Mesh * loadInput(const Util::FileName & url, const TemporaryFile & convertedFile) {
+	if(url.getEnding() != StreamerPLY::fileExtension) {
+		return Serialization::loadMeshMapped(url);
+	}
+	{
+		auto input = Util::FileUtils::openForReading(url);
+		std::ofstream output(convertedFile.path, std::ios::out | std::ios::binary | std::ios::trunc);
+		if(!input || !output || !StreamerPLY::convertToMMF(*input, output)) {
+			return nullptr;
+		}
+	}
+	return StreamerMMF::loadMeshMapped(convertedFile.path);
+}
+
+bool simplifyMeshOutOfCore(const Util::FileName & url, uint32_t numberOfTriangles, const std::string & extension,
+						   std::ostream & output, const OutOfCoreParameters & parameters) {
+	const std::string temporaryPath = parameters.temporaryPath.empty() ? url.getPath() : parameters.temporaryPath;
+	const TemporaryFile convertedFile(temporaryPath + ".ooc-input.mmf");
+	Util::Reference<Mesh> mesh = loadInput(url, convertedFile);
+	if(mesh.isNull()) {
+		WARN("simplifyMeshOutOfCore: Could not load mesh \"" + url.toString() + "\".");
+		return false;
+	}
+	if(!mesh->isUsingIndexData() || mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+		throw std::invalid_argument("simplifyMeshOutOfCore: Mesh is not a valid triangle mesh.");
+	}
+	// only read-only access, which does not copy the memory mapped data
+	const MeshVertexData & vertices = mesh->openVertexData();
+	const MeshIndexData & indices = mesh->openIndexData();
+	const VertexAttribute & positionAttribute = vertices.getVertexDescription().getAttribute(VertexAttributeIds::POSITION);
+	if(positionAttribute.empty() || positionAttribute.getDataType() != GL_FLOAT || positionAttribute.getNumValues() < 3) {
+		throw std::invalid_argument("simplifyMeshOutOfCore: Mesh has no float positions.");
+	}
+	const uint32_t vertexCount = vertices.getVertexCount();
+	const uint32_t triangleCount = indices.getIndexCount() / 3;
+	if(triangleCount <= numberOfTriangles) {
+		WARN("simplifyMeshOutOfCore: Mesh already has less or equal as many triangles as requested.");
+		return Serialization::saveMesh(mesh.get(), extension, output);
+	}
+	const uint8_t * positionData = vertices.getAttributeData(positionAttribute);
+	const std::size_t positionStride = vertices.getAttributeStride(positionAttribute);
+	auto getPosition = [&](uint32_t vertex, float * position) {
+		std::memcpy(position, positionData + static_cast<std::size_t>(vertex) * positionStride, 3 * sizeof(float));
+	};
+	const uint32_t threadCount = parameters.threadCount > 0 ? parameters.threadCount : std::max(1u, std::thread::hardware_concurrency());
+
+	// The triangles are assumed to form a surface, so the number of occupied cells grows quadratically with the resolution.
+	const Geometry::Box & boundingBox = mesh->getBoundingBox();
+	const uint32_t maxResolution = std::max(1u, std::min(maxCellResolution,
+			static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(triangleCount) / std::max(1u, parameters.trianglesPerCell))))));
+	const CellGrid grid(boundingBox, maxResolution);
+	auto getTriangleCell = [&](uint32_t triangle) {
+		float a[3], b[3], c[3];
+		getPosition(indices[triangle * 3 + 0], a);
+		getPosition(indices[triangle * 3 + 1], b);
+		getPosition(indices[triangle * 3 + 2], c);
+		const float centroid[3] = {(a[0] + b[0] + c[0]) / 3.0f, (a[1] + b[1] + c[1]) / 3.0f, (a[2] + b[2] + c[2]) / 3.0f};
+		return grid.getCell(centroid);
+	};
+	const uint32_t scanChunkCount = std::min(threadCount, ParallelFor::getChunkCount(triangleCount, minScanChunkSize));
+
+	// First pass: count the triangles of every cell and lock the vertices used by a triangle of another cell than the vertex's own cell.
+	std::vector<std::atomic<uint64_t>> lockedBits((vertexCount + 63) / 64);
+	for(auto & bits : lockedBits) {
+		bits.store(0, std::memory_order_relaxed);
+	}
+	std::vector<std::unordered_map<uint64_t, uint32_t>> chunkCellCounts(scanChunkCount);
+	ParallelFor::forEachChunk(triangleCount, scanChunkCount, [&](uint32_t chunk, std::size_t begin, std::size_t end) {
+		auto & cellCounts = chunkCellCounts[chunk];
+		for(std::size_t t = begin; t < end; ++t) {
+			const uint32_t triangle = static_cast<uint32_t>(t);
+			for(uint_fast8_t corner = 0; corner < 3; ++corner) {
+				if(indices[triangle * 3 + corner] >= vertexCount) {
+					throw std::invalid_argument("simplifyMeshOutOfCore: Vertex index out of range.");
+				}
+			}
+			const uint64_t cell = getTriangleCell(triangle);
+			++cellCounts[cell];
+			for(uint_fast8_t corner = 0; corner < 3; ++corner) {
+				const uint32_t vertex = indices[triangle * 3 + corner];
+				float position[3];
+				getPosition(vertex, position);
+				if(grid.getCell(position) != cell) {
+					lockedBits[vertex / 64].fetch_or(static_cast<uint64_t>(1) << (vertex % 64), std::memory_order_relaxed);
+				}
+			}
+		}
+	});
+	std::vector<std::pair<uint64_t, uint32_t>> cells;
+	{
+		std::unordered_map<uint64_t, uint32_t> cellCounts;
+		for(const auto & chunkCounts : chunkCellCounts) {
+			for(const auto & entry : chunkCounts) {
+				cellCounts[entry.first] += entry.second;
+			}
+		}
+		cells.assign(cellCounts.begin(), cellCounts.end());
+	}
+	std::sort(cells.begin(), cells.end());
+
+	// Second pass: sort the triangles by their cells. Every chunk writes its triangles of a cell behind those of the
+	// previous chunks, so the triangles of every cell keep their original order.
+	std::vector<uint32_t> sortedTriangles(triangleCount);
+	{
+		std::unordered_map<uint64_t, uint32_t> nextPositions;
+		uint32_t cellBegin = 0;
+		for(const auto & cell : cells) {
+			nextPositions[cell.first] = cellBegin;
+			cellBegin += cell.second;
+		}
+		// replace the chunks' counts with the positions of their first triangle of the cells
+		for(auto & chunkCounts : chunkCellCounts) {
+			for(auto & entry : chunkCounts) {
+				uint32_t & position = nextPositions[entry.first];
+				const uint32_t count = entry.second;
+				entry.second = position;
+				position += count;
+			}
+		}
+	}
+	ParallelFor::forEachChunk(triangleCount, scanChunkCount, [&](uint32_t chunk, std::size_t begin, std::size_t end) {
+		auto & positions = chunkCellCounts[chunk];
+		for(std::size_t t = begin; t < end; ++t) {
+			const uint32_t triangle = static_cast<uint32_t>(t);
+			sortedTriangles[positions[getTriangleCell(triangle)]++] = triangle;
+		}
+	});
+	chunkCellCounts.clear();
+
+	Simplification::weights_t weights = parameters.weights;
+	if(boundingBox.getExtentMax() > 0.0f) {
+		weights[VERTEX_OFFSET] /= boundingBox.getExtentMax();
+	}
+	const double reduction = static_cast<double>(numberOfTriangles) / triangleCount;
+
+	// Process batches of consecutive cells, so that at most maxTrianglesInMemory input triangles are held at the same time.
+	// The finished triangles of every batch are appended to the result files immediately.
+	const VertexDescription & vd = vertices.getVertexDescription();
+	ResultFiles result(temporaryPath, vd);
+	BorderPart borderPart(vd.getVertexSize());
+	std::size_t batchTriangleBegin = 0;
+	for(std::size_t batchBegin = 0; batchBegin < cells.size(); ) {
+		std::size_t batchEnd = batchBegin;
+		std::size_t batchTriangleCount = 0;
+		do {
+			batchTriangleCount += cells[batchEnd].second;
+			++batchEnd;
+		} while(batchEnd < cells.size() && batchTriangleCount + cells[batchEnd].second <= parameters.maxTrianglesInMemory);
+
+		// the triangles of the batch's cells are stored consecutively in sortedTriangles
+		std::vector<std::size_t> cellTriangleBegins(batchEnd - batchBegin);
+		for(std::size_t i = batchBegin, begin = batchTriangleBegin; i < batchEnd; ++i) {
+			cellTriangleBegins[i - batchBegin] = begin;
+			begin += cells[i].second;
+		}
+
+		// simplify the cells in parallel; the threads take the next unprocessed cell
+		std::vector<Util::Reference<Mesh>> simplifiedCells(cellTriangleBegins.size());
+		std::vector<std::vector<bool>> simplifiedCellsLocked(cellTriangleBegins.size());
+		std::atomic<std::size_t> nextCell(0);
+		ParallelFor::forEachChunk(simplifiedCells.size(), std::min<uint32_t>(threadCount, static_cast<uint32_t>(simplifiedCells.size())),
+								  [&](uint32_t, std::size_t, std::size_t) {
+			for(std::size_t i = nextCell++; i < simplifiedCells.size(); i = nextCell++) {
+				std::vector<bool> locked;
+				Util::Reference<Mesh> cellMesh = createCellMesh(vertices, indices, sortedTriangles.data() + cellTriangleBegins[i],
+																cells[batchBegin + i].second, lockedBits, locked);
+				const uint32_t cellTriangleCount = cellMesh->getPrimitiveCount();
+				const uint32_t target = std::max(1u, static_cast<uint32_t>(std::round(cellTriangleCount * reduction)));
+				if(target < cellTriangleCount) {
+					std::unordered_set<std::string> lockedVertices;
+					const MeshVertexData & cellVertices = cellMesh->openVertexData();
+					for(uint32_t v = 0; v < cellVertices.getVertexCount(); ++v) {
+						if(locked[v]) {
+							lockedVertices.emplace(reinterpret_cast<const char *>(cellVertices[v]), vd.getVertexSize());
+						}
+					}
+					cellMesh = simplifyMesh(cellMesh.get(), target, 0.0f, parameters.useOptimalPositioning, parameters.maxAngle, weights, locked, false);
+					locked = findLockedVertices(cellMesh.get(), lockedVertices);
+				}
+				simplifiedCells[i] = cellMesh;
+				simplifiedCellsLocked[i].swap(locked);
+			}
+		});
+
+		// write the finished triangles of the batch
+		for(std::size_t i = 0; i < simplifiedCells.size(); ++i) {
+			splitCell(simplifiedCells[i].get(), simplifiedCellsLocked[i], result, borderPart);
+		}
+		if(!result.good()) {
+			WARN("simplifyMeshOutOfCore: Could not write the temporary files \"" + temporaryPath + ".ooc-*\".");
+			return false;
+		}
+
+		batchBegin = batchEnd;
+		batchTriangleBegin += batchTriangleCount;
+	}
+	std::vector<uint32_t>().swap(sortedTriangles);
+
+	// Stitch the cells by simplifying the triangles along the cell borders. The locked border vertices have been copied
+	// unchanged, so they are identical in adjacent cells.
+	const uint32_t finishedTriangleCount = result.getTriangleCount();
+	simplifyBorderPart(borderPart, vd, numberOfTriangles > finishedTriangleCount ? numberOfTriangles - finishedTriangleCount : 0,
+					   parameters, weights, result);
+
+	if(extension == StreamerMMF::fileExtension) {
+		return result.write(output);
+	}
+	// other formats need the complete mesh, which is mapped from a temporary .mmf file
+	const TemporaryFile resultFile(temporaryPath + ".ooc-result.mmf");
+	{
+		std::ofstream resultOutput(resultFile.path, std::ios::out | std::ios::binary | std::ios::trunc);
+		if(!result.write(resultOutput)) {
+			WARN("simplifyMeshOutOfCore: Could not write the temporary file \"" + resultFile.path + "\".");
+			return false;
+		}
+	}
+	Util::Reference<Mesh> resultMesh = StreamerMMF::loadMeshMapped(resultFile.path);
+	return resultMesh.isNotNull() && Serialization::saveMesh(resultMesh.get(), extension, output);
+}
+
+}
+}
+}
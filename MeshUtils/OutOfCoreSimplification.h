@@ -0,0 +1,85 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILS_OUTOFCORESIMPLIFICATION_H
+#define RENDERING_MESHUTILS_OUTOFCORESIMPLIFICATION_H
+
+#include "Simplification.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace Util {
+class FileName;
+}
+namespace Rendering {
+namespace MeshUtils {
+namespace Simplification {
+
+struct OutOfCoreParameters {
+	//! Parameters of simplifyMesh(...); the position weight is divided by the maximal extent of the mesh's bounding box.
+	bool useOptimalPositioning;
+	float maxAngle;
+	weights_t weights;
+
+	//! Average number of triangles of a cell that is simplified as a whole.
+	uint32_t trianglesPerCell;
+	/*! Maximal number of input triangles whose vertices are copied into memory at the same time (not counting
+		the simplified result and the four bytes per input triangle used to sort the triangles by their cells). */
+	uint32_t maxTrianglesInMemory;
+	//! Number of cells simplified in parallel; zero uses the number of hardware threads.
+	uint32_t threadCount;
+	//! Path prefix of the temporary files (a converted .ply input and the finished part of the result); empty uses the path of the input.
+	std::string temporaryPath;
+
+	OutOfCoreParameters() :
+		useOptimalPositioning(true), maxAngle(-1.0f), weights(),
+		trianglesPerCell(1 << 16), maxTrianglesInMemory(1 << 23), threadCount(0), temporaryPath() {
+		weights.fill(1.0f);
+	}
+};
+
+/**
+ * Simplify a mesh stored in a file that is too large to be loaded completely and write the result to a stream.
+ *
+ * The input is opened with Serialization::loadMeshMapped(...), so the vertex and index data of .mmf files
+ * stay in a memory mapped region and are only paged in while being read. A .ply file is converted to a temporary
+ * .mmf file in chunks (see StreamerPLY::convertToMMF(...)) and mapped afterwards; other formats are loaded completely.
+ * The space is partitioned into a uniform grid of cells (with about OutOfCoreParameters::trianglesPerCell
+ * triangles each, assuming the triangles form a surface), and every triangle is assigned to the cell
+ * containing its centroid. Two passes over the index data count the triangles of every cell and sort the triangle
+ * numbers by cell. The cells are then processed in batches of at most OutOfCoreParameters::maxTrianglesInMemory
+ * triangles, and the cells of a batch are simplified in parallel with simplifyMesh(...) without printing progress
+ * information. The vertex data is read in place in both vertex layouts. Vertices used by triangles of other cells are locked,
+ * so the cell borders stay unchanged. After every batch, the simplified triangles without locked vertices are finished and
+ * appended to temporary files; only the triangles along the cell borders are kept. Finally, these are stitched by merging
+ * the identical locked vertices and simplified again to remove the excess triangles along the borders, keeping the vertices
+ * shared with finished triangles. The temporary files are then copied to the output (formats other than .mmf are
+ * written from the mapped temporary result).
+ *
+ * @param url Address of the input mesh file (indexed triangles with float positions)
+ * @param numberOfTriangles Number of triangles of the result
+ * @param extension File extension specifying the format of the result (e.g. "mmf")
+ * @param output Stream to which the result is written
+ * @return @c true if successful, @c false otherwise
+ * @throw std::invalid_argument if the input does not consist of indexed triangles with float positions
+ */
+bool simplifyMeshOutOfCore(const Util::FileName & url,
+						   uint32_t numberOfTriangles,
+						   const std::string & extension,
+						   std::ostream & output,
+						   const OutOfCoreParameters & parameters = OutOfCoreParameters());
+
+}
+}
+}
+
+#endif // RENDERING_MESHUTILS_OUTOFCORESIMPLIFICATION_H
@@ -383,7 +383,6 @@ Mesh * createEdgeSubdivisionSphere(Mesh * platonicSolid, uint8_t subdivisions) {
 		const float * const oldVertices = reinterpret_cast<const float * const> (oldVd.data());
 		vertices = std::copy(oldVertices, oldVertices + 6 * numVertices, vertices);
 
-		const uint32_t * const oldIndices = oldId.data();
 		uint32_t nextIndex = oldId.getMaxIndex() + 1;
 		// Mapping from an edge (key.first < key.second) to the new vertex on that edge.
 		typedef std::pair<uint32_t, uint32_t> edge_t;
@@ -405,9 +404,9 @@ Mesh * createEdgeSubdivisionSphere(Mesh * platonicSolid, uint8_t subdivisions) {
 			 */
 			// Subdivide one triangle consisting of the vertices with indices o[0], o[1], o[2].
 			uint32_t o[3];
-			o[0] = oldIndices[i + 0];
-			o[1] = oldIndices[i + 1];
-			o[2] = oldIndices[i + 2];
+			o[0] = oldId[i + 0];
+			o[1] = oldId[i + 1];
+			o[2] = oldId[i + 2];
 
 			uint32_t n[3];
 			for(uint_fast8_t v = 0; v < 3; ++v) {
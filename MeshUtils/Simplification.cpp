@@ -3,9 +3,9 @@
 	Copyright (C) 2007-2013 Benjamin Eikel <benjamin@eikel.org>
 	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
 	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
-	
+
 	This library is subject to the terms of the Mozilla Public License, v. 2.0.
-	You should have received a copy of the MPL along with this library; see the 
+	You should have received a copy of the MPL along with this library; see the
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "Simplification.h"
@@ -13,23 +13,19 @@
 #include "../Mesh/Mesh.h"
 #include "../Mesh/VertexAttributeAccessors.h"
 #include "../Mesh/VertexAttributeIds.h"
-#include <Geometry/Point.h>
-#include <Geometry/PointOctree.h>
-#include <Geometry/Sphere.h>
-#include <Geometry/Triangle.h>
+#include <Geometry/Vec3.h>
 #include <Util/Macros.h>
 #include <Util/Numeric.h>
 #include <Util/ProgressIndicator.h>
-#include <Util/UpdatableHeap.h>
 #include <Util/Utils.h>
 #include <Util/References.h>
 #include <Util/Timer.h>
 #include <algorithm>
 #include <array>
-#include <deque>
-#include <set>
+#include <cmath>
+#include <limits>
+#include <memory>
 #include <stdexcept>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -37,223 +33,51 @@ namespace Rendering {
 namespace MeshUtils {
 namespace Simplification {
 
-struct heapData{
-	unsigned int vertex1;
-	unsigned int vertex2;
-	std::vector<float> optPos;
-
-	heapData() :
-		vertex1(std::numeric_limits<unsigned int>::max()), vertex2(std::numeric_limits<unsigned int>::max()), optPos() {
-	}
-	heapData(unsigned int v1, unsigned int v2) :
-		vertex1(v1), vertex2(v2), optPos() {
-	}
-};
-
-typedef Util::UpdatableHeap<float, heapData>::UpdatableHeapElement heapElement;
-typedef std::set<heapElement*>::iterator heapElementSetIterator;
-typedef std::set<unsigned int>::iterator uIntSetIterator;
-const float DONT_MERGE_COST = std::numeric_limits<float>::max();
+static const float DONT_MERGE_COST = std::numeric_limits<float>::max();
+static const uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
 
-struct VertexPoint : public Geometry::Point<Geometry::Vec3f> {
-	unsigned int data;
-
-	VertexPoint(const Geometry::Vec3f & pos, unsigned int index) :
-			Geometry::Point<Geometry::Vec3f>(pos), data(index) {
-	}
-};
+//! Maximal number of data entries of a vertex: position, normal, color and texture coordinate.
+static const std::size_t maxDataEntries = 12;
 
 /**
- * Storage of an upper triangular n-by-n square matrix.
- * Only the entries in the upper triangle and the diagonal are stored and no memory is used for the entries in the lower triangle.
- *
- * @author Benjamin Eikel
- * @date 2010-12-20
+ * The quadrics Q(v) = v^T A v + 2 b^T v + c of all vertices are stored in a single array.
+ * Every quadric is a block of getQuadricSize(n) floats: the upper triangle of the symmetric
+ * n-by-n matrix A (row by row), followed by the n entries of b and by c.
  */
-template<typename _T>
-class UpperTriangularMatrix {
-	private:
-		//! Dimension of the matrix
-		size_t n;
-		//! One-dimensional array containing the entries
-		std::vector<_T> data;
-		//! Return the number of entries in the @c data array.
-		size_t arraySize() const {
-			return n * (n + 1) / 2;
-		}
-		//! Calculate the index of an entry (i, j).
-		size_t calcIndex(size_t i, size_t j) const {
-			// index = j + n * i - ((i * (i + 1)) / 2) = 1/2 * i * (2 * n - i - 1)
-			return j + i * (2 * n - i - 1) / 2;
-		}
-	public:
-		/**
-		 * Construct a new square matrix of order n.
-		 * The elements are initialized to zero.
-		 *
-		 * @param size Matrix size n
-		 */
-		explicit UpperTriangularMatrix(size_t size) :
-			n(size), data(arraySize(), static_cast<_T>(0)) {
-		}
-
-		//! Return the dimension of the matrix.
-		size_t getSize() const {
-			return n;
-		}
-
-		/**
-		 * Return an entry of the matrix.
-		 *
-		 * @param i Row number from [0, n-1]
-		 * @param j Column number from [0, n-1]
-		 * @return Element (i, j) of the matrix if i <= j and 0 for i > j
-		 */
-		_T get(size_t i, size_t j) const {
-			if (i > j) {
-				return 0;
-			} else {
-				return data[calcIndex(i, j)];
-			}
-		}
-
-
-		/**
-		 * Set an entry of the matrix to the given value.
-		 * Attempts to set a value in the lower triangle with i > j are ignored.
-		 *
-		 * @param i Row number from [0, n-1]
-		 * @param j Column number from [0, n-1]
-		 * @param value New value
-		 */
-		void set(size_t i, size_t j, _T value) {
-			if (i <= j) {
-				data[calcIndex(i, j)] = value;
-			}
-		}
-
-
-		/**
-		 * Add the given value an entry of the matrix.
-		 * Attempts to add a value in the lower triangle with i > j are ignored.
-		 *
-		 * @param i Row number from [0, n-1]
-		 * @param j Column number from [0, n-1]
-		 * @param summand Summand to add
-		 */
-		void add(size_t i, size_t j, _T summand) {
-			if (i <= j) {
-				data[calcIndex(i, j)] += summand;
-			}
-		}
-
-		/**
-		 * Add a second matrix component-wise to this matrix.
-		 *
-		 * @param second Another upper triangular matrix.
-		 */
-		void operator+=(const UpperTriangularMatrix<_T> & second) {
-			if (second.n != n) {
-				throw std::invalid_argument("Second matrix has different size");
-			}
-			const size_t size = arraySize();
-			for (size_t i = 0; i < size; ++i) {
-				data[i] += second.data[i];
-			}
-		}
-};
-
-template<typename _T>
-struct Quadric {
-	UpperTriangularMatrix<_T> A;
-	std::vector<_T> b;
-	_T c;
-
-	explicit Quadric(size_t n) : A(n), b(n, static_cast<_T>(0)), c(static_cast<_T>(0)) {}
-
-	/**
-	 * Add a second quadric to this quadric by adding the three components.
-	 *
-	 * @param second Another quadric.
-	 */
-	void operator+=(const Quadric<_T> & second) {
-		A += second.A;
-		const size_t size = b.size();
-		for(size_t i = 0; i < size; ++i) {
-			b[i] += second.b[i];
-		}
-		c += second.c;
-	}
-
-	/**
-	 * Return the quadric value given by Q(v) = v^T A v + 2 b^T v + c.
-	 *
-	 * @param v Parameter vector
-	 * @return Value of the quadratic form evaluated using v
-	 */
-	_T getCost(const std::vector<_T> & v) const {
-		const size_t size = v.size();
-		if (size != A.getSize()) {
-			throw std::invalid_argument("Second vector has different size");
-		}
-		_T v_A_v = 0;
-		_T b_v = 0;
-		for(uint_fast8_t i = 0; i < size; ++i) {
-			_T sum = 0;
-			for(uint_fast8_t j = 0; j < size; ++j) {
-				if(i > j) {
-					// Switch row and column to simulate an access to a symmetric matrix.
-					sum += v[j] * A.get(j, i);
-				} else {
-					sum += v[j] * A.get(i, j);
-				}
-			}
-			v_A_v += sum * v[i];
+static inline std::size_t getQuadricSize(std::size_t n) {
+	return n * (n + 1) / 2 + n + 1;
+}
 
-			b_v += b[i] * v[i];
+//! Return the quadric value Q(v) = v^T A v + 2 b^T v + c.
+static float evaluateQuadric(const float * quadric, std::size_t n, const float * v) {
+	float v_A_v = 0.0f;
+	const float * a = quadric;
+	for(std::size_t i = 0; i < n; ++i) {
+		// diagonal entry once, entries of the upper triangle twice for the symmetric lower triangle
+		float sum = *a++ * v[i];
+		for(std::size_t j = i + 1; j < n; ++j) {
+			sum += 2.0f * *a++ * v[j];
 		}
-		return v_A_v + 2 * b_v + c;
+		v_A_v += sum * v[i];
 	}
-};
-
-struct vertex_t {
-	Quadric<float> q;
-	std::vector<float> data; // vertex data: VERTEX, NORMAL, COLOR, TEX0
-	std::set<heapElement*> inHeap;
-	std::deque<uint32_t> inIndex;
-	std::set<unsigned int> neighbors;
-
-	explicit vertex_t(size_t n) :
-		q(n), data(), inHeap(), inIndex(), neighbors() {
-		data.reserve(n);
+	const float * b = quadric + n * (n + 1) / 2;
+	float b_v = 0.0f;
+	for(std::size_t i = 0; i < n; ++i) {
+		b_v += b[i] * v[i];
 	}
-};
-
-/**
- * Modify the given @a container and make sure, that it only contains unique elements.
- *
- * @param container Random-access container (e.g. of type std::deque or std::vector).
- */
-template<typename ContainerType>
-inline static void make_unique(ContainerType & container) {
-	// First sort the container because std::unique only works like we expect it here on a sorted range.
-	std::sort(container.begin(), container.end());
-	// Re-order the container and move duplicate entries to the end. The iterator will point to the last element of the range of unique elements.
-	auto it = std::unique(container.begin(), container.end());
-	// Now really remove the duplicate elements at the end.
-	container.resize(static_cast<std::size_t>(std::distance(container.begin(), it)));
+	return v_A_v + 2.0f * b_v + b[n];
 }
 
 /**
  * Normalize a vector
- * 
- * @param normalVector Vector as array
+ *
+ * @param vector Vector with n entries
  * @return @c true if successful, @c false if the length is zero
  */
-static bool normalize(std::vector<float> & normalVector) {
+static bool normalize(float * vector, std::size_t n) {
 	float length = 0;
-	for(const auto & n : normalVector) {
-		length += n * n;
+	for(std::size_t i = 0; i < n; ++i) {
+		length += vector[i] * vector[i];
 	}
 	length = std::sqrt(length);
 
@@ -262,25 +86,23 @@ static bool normalize(std::vector<float> & normalVector) {
 	}
 
 	length = 1 / length;
-	for(auto & n : normalVector) {
-		n *= length;
+	for(std::size_t i = 0; i < n; ++i) {
+		vector[i] *= length;
 	}
 	return true;
 }
 
 /**
- * Calculate the normal of the triangle that is induced by three vertices.
- * 
- * @param vertexA First vertex
- * @param vertexB Second vertex
- * @param vertexC Third vertex
+ * Calculate the normal of the triangle that is induced by the positions of three vertices.
+ *
  * @return Normal of the triangle. If the direction has zero length before
  * normalization, a zero vector is returned.
  */
 static Geometry::Vec3f calcNormal(const float * vertexA, const float * vertexB, const float * vertexC) {
-	const auto triangle = Geometry::Triangle_f(Geometry::Vec3f(vertexA), Geometry::Vec3f(vertexB), Geometry::Vec3f(vertexC));
-	// Do not use calcNormal: Check for zero length before calling normalize.
-	const auto direction = triangle.getEdgeAB().cross(triangle.getEdgeAC());
+	const Geometry::Vec3f a(vertexA[0], vertexA[1], vertexA[2]);
+	const Geometry::Vec3f b(vertexB[0], vertexB[1], vertexB[2]);
+	const Geometry::Vec3f c(vertexC[0], vertexC[1], vertexC[2]);
+	const auto direction = (b - a).cross(c - a);
 	const auto length = direction.length();
 	if(length < 1.0e-6f) {
 		return Geometry::Vec3f();
@@ -289,75 +111,312 @@ static Geometry::Vec3f calcNormal(const float * vertexA, const float * vertexB,
 }
 
 /**
- * Adds quadric error metric from planes spanned by vertices p, q and r to
- * quadric q.
+ * Store the quadric error metric of the plane spanned by the vertices p, q and r
+ * (each with n entries) in @a quadric.
  */
-static void getQuadric(const std::vector<float> & p, const std::vector<float> & q, const std::vector<float> & r, Quadric<float> & quadric){
-	const size_t size = quadric.A.getSize();
-
+static void getQuadric(const float * p, const float * q, const float * r, std::size_t n, float * quadric) {
 	// e1 = (q - p) / ||q - p||
-	std::vector<float> e1;
-	e1.reserve(size);
-	for(uint_fast8_t i=0; i<size; ++i){
-		e1.push_back(q[i] - p[i]);
+	float e1[maxDataEntries];
+	for(std::size_t i = 0; i < n; ++i) {
+		e1[i] = q[i] - p[i];
 	}
-	normalize(e1);
+	normalize(e1, n);
 
 	// e2 = (r - p - (e1 * (r - p)) e1) / ||...||
-	std::vector<float> e2;
-	e2.reserve(size);
 	float r_p_e1 = 0.0f;
-	for(uint_fast8_t i=0; i<size; ++i){
+	for(std::size_t i = 0; i < n; ++i) {
 		r_p_e1 += (r[i] - p[i]) * e1[i];
 	}
-	for(uint_fast8_t i=0; i<size; ++i){
-		e2.push_back(r[i] - p[i] - r_p_e1 * e1[i]);
+	float e2[maxDataEntries];
+	for(std::size_t i = 0; i < n; ++i) {
+		e2[i] = r[i] - p[i] - r_p_e1 * e1[i];
 	}
-	normalize(e2);
+	normalize(e2, n);
 
 	float p_e1 = 0.0f;
 	float p_e2 = 0.0f;
 	float p_p = 0.0f;
+	for(std::size_t i = 0; i < n; ++i) {
+		p_e1 += p[i] * e1[i];
+		p_e2 += p[i] * e2[i];
+		p_p += p[i] * p[i];
+	}
 
 	// A = I - e1 e1^T - e2 e2^T
-	for(uint_fast8_t i=0; i<size; ++i){
-		for(uint_fast8_t j=0; j<size; ++j){
-			quadric.A.set(i, j, -e1[i]*e1[j]-e2[i]*e2[j]);
+	float * a = quadric;
+	for(std::size_t i = 0; i < n; ++i) {
+		for(std::size_t j = i; j < n; ++j) {
+			*a++ = (i == j ? 1.0f : 0.0f) - e1[i] * e1[j] - e2[i] * e2[j];
 		}
-		quadric.A.add(i, i, 1.0f);
+	}
+	// b = (p * e1) e1 + (p * e2) e2 - p
+	float * b = a;
+	for(std::size_t i = 0; i < n; ++i) {
+		b[i] = p_e1 * e1[i] + p_e2 * e2[i] - p[i];
+	}
+	// c = p * p - (p * e1)^2 - (p * e2)^2
+	b[n] = p_p - p_e1 * p_e1 - p_e2 * p_e2;
+}
 
-		p_e1 += p[i]*e1[i];
-		p_e2 += p[i]*e2[i];
-		p_p += p[i]*p[i];
+//! Add the quadric @a second to the quadric @a first.
+static inline void addQuadric(float * first, const float * second, std::size_t quadricSize) {
+	for(std::size_t i = 0; i < quadricSize; ++i) {
+		first[i] += second[i];
 	}
+}
 
-	// b = (p * e1) e1 + (p * e2) e2 - p
-	for(uint_fast8_t i=0; i<size; ++i){
-		quadric.b[i] = p_e1*e1[i]+p_e2*e2[i]-p[i];
+/**
+ * Calculate the optimal position and the cost for merging two vertices with the given data and quadrics.
+ * If the optimal position cannot be calculated (or is not requested), the best position of
+ * vertexA, vertexB and (vertexA+vertexB)/2 is used.
+ * @return cost
+ */
+static float getOptimalPosition(const float * quadricA, const float * quadricB, const float * dataA, const float * dataB,
+								std::size_t n, bool useOptPos, float * optPos) {
+	float sumQ[maxDataEntries * (maxDataEntries + 1) / 2 + maxDataEntries + 1];
+	const std::size_t quadricSize = getQuadricSize(n);
+	std::copy(quadricA, quadricA + quadricSize, sumQ);
+	addQuadric(sumQ, quadricB, quadricSize);
+	const float * b = sumQ + n * (n + 1) / 2;
+	const float c = b[n];
+
+	if(useOptPos) {
+		// the matrix A in the left half; the inverse is stored in the right half
+		const std::size_t rowSize = 2 * n;
+		float mInvert[maxDataEntries * 2 * maxDataEntries];
+		const float * a = sumQ;
+		for(std::size_t row = 0; row < n; ++row) {
+			for(std::size_t col = row; col < n; ++col) {
+				mInvert[row * rowSize + col] = *a;
+				mInvert[col * rowSize + row] = *a;
+				++a;
+			}
+			std::fill(mInvert + row * rowSize + n, mInvert + (row + 1) * rowSize, 0.0f);
+		}
+		if(Util::Numeric::invertMatrix(mInvert, n)) {
+			// Optimal position vBar = - A^-1 b
+			for(std::size_t row = 0; row < n; ++row) {
+				const float * inverseRow = mInvert + row * rowSize + n;
+				float sum = 0.0f;
+				for(std::size_t col = 0; col < n; ++col) {
+					sum += inverseRow[col] * b[col];
+				}
+				optPos[row] = -sum;
+			}
+			// Cost Q(vBar) = - b^T A^-1 b + c
+			float cost = c;
+			for(std::size_t col = 0; col < n; ++col) {
+				float sum = 0.0f;
+				for(std::size_t row = 0; row < n; ++row) {
+					sum += b[row] * mInvert[row * rowSize + n + col];
+				}
+				cost -= sum * b[col];
+			}
+			return cost;
+		}
 	}
 
-	// c = p * p - (p * e1)^2 - (p * e2)^2
-	quadric.c = p_p-p_e1*p_e1-p_e2*p_e2;
+	// matrix is not invertible => get best position of v1, v2 and (v1+v2)/2
+	float sumData[maxDataEntries];
+	for(std::size_t i = 0; i < n; ++i) {
+		sumData[i] = 0.5f * (dataA[i] + dataB[i]);
+	}
+	const float costV1 = evaluateQuadric(sumQ, n, dataA);
+	const float costV2 = evaluateQuadric(sumQ, n, dataB);
+	const float costV1V2div2 = evaluateQuadric(sumQ, n, sumData);
+	if(costV1 < costV2 && costV1 < costV1V2div2) {
+		std::copy(dataA, dataA + n, optPos);
+		return costV1;
+	} else if(costV2 < costV1 && costV2 < costV1V2div2) {
+		std::copy(dataB, dataB + n, optPos);
+		return costV2;
+	} else {
+		std::copy(sumData, sumData + n, optPos);
+		return costV1V2div2;
+	}
 }
 
 /**
- * Allocates memory for array and initializes matrices q
- * @return pointer to allocated array
+ * Binary min-heap of pair indices. The position of every pair in the heap is stored,
+ * so that the cost of any pair can be changed and any pair can be removed in logarithmic time.
+ * Pairs with equal costs are ordered by their index to get reproducible results.
  */
-static std::size_t initVertexArray(Mesh * mesh, 
-								   Util::ProgressIndicator & progress, 
+class PairHeap {
+	private:
+		std::vector<uint32_t> heap;
+		std::vector<float> costs;
+		std::vector<uint32_t> positions;
+
+		bool isLess(uint32_t pairA, uint32_t pairB) const {
+			return costs[pairA] < costs[pairB] || (costs[pairA] == costs[pairB] && pairA < pairB);
+		}
+		void place(uint32_t position, uint32_t pair) {
+			heap[position] = pair;
+			positions[pair] = position;
+		}
+		void siftUp(uint32_t position) {
+			const uint32_t pair = heap[position];
+			while(position > 0) {
+				const uint32_t parent = (position - 1) / 2;
+				if(!isLess(pair, heap[parent])) {
+					break;
+				}
+				place(position, heap[parent]);
+				position = parent;
+			}
+			place(position, pair);
+		}
+		void siftDown(uint32_t position) {
+			const uint32_t pair = heap[position];
+			const uint32_t size = static_cast<uint32_t>(heap.size());
+			while(true) {
+				uint32_t child = 2 * position + 1;
+				if(child >= size) {
+					break;
+				}
+				if(child + 1 < size && isLess(heap[child + 1], heap[child])) {
+					++child;
+				}
+				if(!isLess(heap[child], pair)) {
+					break;
+				}
+				place(position, heap[child]);
+				position = child;
+			}
+			place(position, pair);
+		}
+
+	public:
+		//! Create a heap containing all pairs with the given costs.
+		explicit PairHeap(std::vector<float> && pairCosts) :
+			heap(pairCosts.size()), costs(std::move(pairCosts)), positions(costs.size()) {
+			for(uint32_t pair = 0; pair < heap.size(); ++pair) {
+				place(pair, pair);
+			}
+			for(uint32_t position = static_cast<uint32_t>(heap.size() / 2); position > 0; --position) {
+				siftDown(position - 1);
+			}
+		}
+
+		bool empty() const							{	return heap.empty();	}
+		std::size_t size() const					{	return heap.size();	}
+		uint32_t top() const						{	return heap.front();	}
+		float getCost(uint32_t pair) const			{	return costs[pair];	}
+
+		void update(uint32_t pair, float cost) {
+			const float oldCost = costs[pair];
+			costs[pair] = cost;
+			if(cost < oldCost) {
+				siftUp(positions[pair]);
+			} else {
+				siftDown(positions[pair]);
+			}
+		}
+
+		void erase(uint32_t pair) {
+			const uint32_t position = positions[pair];
+			const uint32_t last = heap.back();
+			heap.pop_back();
+			positions[pair] = INVALID_INDEX;
+			if(last == pair) {
+				return;
+			}
+			place(position, last);
+			if(position > 0 && isLess(last, heap[(position - 1) / 2])) {
+				siftUp(position);
+			} else {
+				siftDown(position);
+			}
+		}
+};
+
+/**
+ * Lists of entries (triangles or pairs) for every vertex, stored in compressed rows of a single array.
+ * When a vertex is merged into another one, the entries of both are appended to the array as the new list
+ * of the remaining vertex. Entries that have become invalid are skipped lazily during these merges.
+ * The array is compacted when it has grown to twice its size after the last compaction.
+ */
+class VertexLists {
+	private:
+		std::vector<uint32_t> entries;
+		std::vector<uint32_t> begins;
+		std::vector<uint32_t> ends;
+		std::size_t compactedSize;
+
+		void compact() {
+			std::vector<uint32_t> compacted;
+			compacted.reserve(entries.size() / 2);
+			for(std::size_t v = 0; v < begins.size(); ++v) {
+				const uint32_t begin = static_cast<uint32_t>(compacted.size());
+				compacted.insert(compacted.end(), entries.begin() + begins[v], entries.begin() + ends[v]);
+				begins[v] = begin;
+				ends[v] = static_cast<uint32_t>(compacted.size());
+			}
+			entries.swap(compacted);
+			compactedSize = entries.size();
+		}
+
+	public:
+		//! Reserve space for counts[v] entries of vertex v; the entries are added by add(...).
+		explicit VertexLists(const std::vector<uint32_t> & counts) :
+			entries(), begins(counts.size()), ends(counts.size()), compactedSize(0) {
+			uint32_t sum = 0;
+			for(std::size_t v = 0; v < counts.size(); ++v) {
+				begins[v] = ends[v] = sum;
+				sum += counts[v];
+			}
+			entries.resize(sum);
+			compactedSize = sum;
+		}
+
+		void add(uint32_t vertex, uint32_t entry) {
+			entries[ends[vertex]++] = entry;
+		}
+
+		const uint32_t * begin(uint32_t vertex) const	{	return entries.data() + begins[vertex];	}
+		const uint32_t * end(uint32_t vertex) const		{	return entries.data() + ends[vertex];	}
+
+		//! Make the valid entries of @a target and @a source the list of @a target and clear the list of @a source.
+		template<typename IsValid>
+		void merge(uint32_t target, uint32_t source, IsValid isValid) {
+			const uint32_t newBegin = static_cast<uint32_t>(entries.size());
+			for(uint32_t i = begins[target]; i < ends[target]; ++i) {
+				if(isValid(entries[i])) {
+					entries.push_back(entries[i]);
+				}
+			}
+			for(uint32_t i = begins[source]; i < ends[source]; ++i) {
+				if(isValid(entries[i])) {
+					entries.push_back(entries[i]);
+				}
+			}
+			begins[target] = newBegin;
+			ends[target] = static_cast<uint32_t>(entries.size());
+			begins[source] = ends[source] = 0;
+			if(entries.size() > 2 * compactedSize) {
+				compact();
+			}
+		}
+};
+
+/**
+ * Read the weighted vertex data into a contiguous array with numDataEntries floats per vertex.
+ * @return numDataEntries
+ */
+static std::size_t initVertexArray(Mesh * mesh,
+								   Util::ProgressIndicator * progress,
 								   const weights_t & weights,
-								   std::vector<vertex_t> & vertices, 
-								   Geometry::PointOctree<VertexPoint> * vOctree) {
+								   std::vector<float> & vertexData,
+								   bool & hasPositions) {
 	const uint32_t vertexCount = mesh->getVertexCount();
-	MeshVertexData & vertexData = mesh->openVertexData();
+	MeshVertexData & meshVertexData = mesh->openVertexData();
 
 	std::size_t numDataEntries = 0;
 
 	Util::Reference<PositionAttributeAccessor> positionAccessor;
 	if(weights[VERTEX_OFFSET] > 0) {
 		try {
-			positionAccessor = PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION);
+			positionAccessor = PositionAttributeAccessor::create(meshVertexData, VertexAttributeIds::POSITION);
 			numDataEntries += 3;
 		} catch(...) {
 		}
@@ -365,7 +424,7 @@ static std::size_t initVertexArray(Mesh * mesh,
 	Util::Reference<NormalAttributeAccessor> normalAccessor;
 	if(weights[NORMAL_OFFSET] > 0) {
 		try {
-			normalAccessor = NormalAttributeAccessor::create(vertexData, VertexAttributeIds::NORMAL);
+			normalAccessor = NormalAttributeAccessor::create(meshVertexData, VertexAttributeIds::NORMAL);
 			numDataEntries += 3;
 		} catch(...) {
 		}
@@ -373,7 +432,7 @@ static std::size_t initVertexArray(Mesh * mesh,
 	Util::Reference<ColorAttributeAccessor> colorAccessor;
 	if(weights[COLOR_OFFSET] > 0) {
 		try {
-			colorAccessor = ColorAttributeAccessor::create(vertexData, VertexAttributeIds::COLOR);
+			colorAccessor = ColorAttributeAccessor::create(meshVertexData, VertexAttributeIds::COLOR);
 			numDataEntries += 4;
 		} catch(...) {
 		}
@@ -381,222 +440,111 @@ static std::size_t initVertexArray(Mesh * mesh,
 	Util::Reference<TexCoordAttributeAccessor> texCoordAccessor;
 	if(weights[TEX0_OFFSET] > 0) {
 		try {
-			texCoordAccessor = TexCoordAttributeAccessor::create(vertexData, VertexAttributeIds::TEXCOORD0);
+			texCoordAccessor = TexCoordAttributeAccessor::create(meshVertexData, VertexAttributeIds::TEXCOORD0);
 			numDataEntries += 2;
 		} catch(...) {
 		}
 	}
+	hasPositions = positionAccessor.isNotNull();
 
-	// allocate memory for array and values, get values for vertices and set matrix to 0
-	vertices.reserve(vertexCount);
+	vertexData.resize(numDataEntries * vertexCount);
+	auto dataIt = vertexData.begin();
 	for(uint_fast32_t v = 0; v < vertexCount; ++v) {
-		vertex_t vertex(numDataEntries);
-
 		if(positionAccessor.isNotNull()) {
 			const auto position = positionAccessor->getPosition(v) * weights[VERTEX_OFFSET];
-			vertex.data.push_back(position.getX());
-			vertex.data.push_back(position.getY());
-			vertex.data.push_back(position.getZ());
-
-			// build vertex octree
-			if(vOctree != nullptr) {
-				vOctree->insert(VertexPoint(position, v));
-			}
+			*dataIt++ = position.getX();
+			*dataIt++ = position.getY();
+			*dataIt++ = position.getZ();
 		}
 		if(normalAccessor.isNotNull()) {
 			const auto normal = normalAccessor->getNormal(v);
-			vertex.data.push_back(normal.getX() * weights[NORMAL_OFFSET]);
-			vertex.data.push_back(normal.getY() * weights[NORMAL_OFFSET]);
-			vertex.data.push_back(normal.getZ() * weights[NORMAL_OFFSET]);
+			*dataIt++ = normal.getX() * weights[NORMAL_OFFSET];
+			*dataIt++ = normal.getY() * weights[NORMAL_OFFSET];
+			*dataIt++ = normal.getZ() * weights[NORMAL_OFFSET];
 		}
 		if(colorAccessor.isNotNull()) {
 			const auto color = colorAccessor->getColor4f(v);
-			vertex.data.push_back(color.getR() * weights[COLOR_OFFSET]);
-			vertex.data.push_back(color.getG() * weights[COLOR_OFFSET]);
-			vertex.data.push_back(color.getB() * weights[COLOR_OFFSET]);
-			vertex.data.push_back(color.getA() * weights[COLOR_OFFSET]);
+			*dataIt++ = color.getR() * weights[COLOR_OFFSET];
+			*dataIt++ = color.getG() * weights[COLOR_OFFSET];
+			*dataIt++ = color.getB() * weights[COLOR_OFFSET];
+			*dataIt++ = color.getA() * weights[COLOR_OFFSET];
 		}
 		if(texCoordAccessor.isNotNull()) {
 			const auto texCoord = texCoordAccessor->getCoordinate(v);
-			vertex.data.push_back(texCoord.getX() * weights[TEX0_OFFSET]);
-			vertex.data.push_back(texCoord.getY() * weights[TEX0_OFFSET]);
+			*dataIt++ = texCoord.getX() * weights[TEX0_OFFSET];
+			*dataIt++ = texCoord.getY() * weights[TEX0_OFFSET];
+		}
+		if(progress != nullptr) {
+			progress->increment();
 		}
-
-		vertices.emplace_back(std::move(vertex));
-
-		progress.increment();
-	}
-
-	// initialize quadrics q
-	Quadric<float> tmpQ(numDataEntries);
-	const MeshIndexData & iData = mesh->openIndexData();
-
-	const uint32_t indexCount = iData.getIndexCount();
-
-	for (uint_fast32_t i = 0; i < indexCount; i += 3){
-		const uint32_t indexA = iData[i + 0];
-		const uint32_t indexB = iData[i + 1];
-		const uint32_t indexC = iData[i + 2];
-
-		// calculate plane equation
-		getQuadric(vertices[indexA].data, vertices[indexB].data, vertices[indexC].data, tmpQ);
-
-		// add face to vertex attribute
-		vertices[indexA].inIndex.push_back(i);
-		vertices[indexB].inIndex.push_back(i);
-		vertices[indexC].inIndex.push_back(i);
-
-		// add quadric distance matrix to q of vertices spanning this plane
-		vertices[indexA].q += tmpQ;
-		vertices[indexB].q += tmpQ;
-		vertices[indexC].q += tmpQ;
-		progress.increment();
-	}
-
-	for(auto & vertex : vertices) {
-		make_unique(vertex.inIndex);
 	}
-
 	return numDataEntries;
 }
 
-/**
- *  Adds neighbor vertices of vertex v to list n. Neighbors are all vertices
- *  connected via edges (and those with a distance smaller than the threshold).
- *  Attention: returns v as a neighbor of v and may return v as singleNeighbor
- *  @param mesh mesh to get index data from
- *  @param v vertex to get neighbors of
- *  @param threshold maximum distance between two non connected neighbors
- *  @param n returns set of neighbors in n
- *  @param singleNeighbors returns set of neighbors spanning exactly one face with v
- */
-static void getNeighboursOfVertex(Mesh * mesh, const vertex_t & v, Geometry::PointOctree<VertexPoint> * vOctree, float threshold, std::set<unsigned int> & n, std::set<std::pair<unsigned int, unsigned int> > & singleNeighbors){
-	const MeshIndexData & iData = mesh->openIndexData();
-	const uint32_t * indices = iData.data();
-	std::vector<bool> multiNeighbors(iData.getMaxIndex(), false);
-	for(auto & elem : v.inIndex){
-		if(!n.insert(indices[elem+0]).second){
-			// has been inserted before => is a multiple neighbor of v
-			multiNeighbors[indices[elem+0]] = true;
-		}
-		if(!n.insert(indices[elem+1]).second){
-			// has been inserted before => is a multiple neighbor of v
-			multiNeighbors[indices[elem+1]] = true;
-		}
-		if(!n.insert(indices[elem + 2]).second){
-			// has been inserted before => is a multiple neighbor of v
-			multiNeighbors[indices[elem+2]] = true;
-		}
-	}
-
-	// build single neighbor set
-	for(auto & elem : v.inIndex){
-		if(!multiNeighbors[indices[elem+0]]){
-			// iData[*it+0] is not a multiple neighbor => add to singleNeighbors
-			singleNeighbors.insert(std::make_pair(indices[elem+0], elem));
-		}
-		if(!multiNeighbors[indices[elem+1]]){
-			// iData[*it+1] is not a multiple neighbor => add to singleNeighbors
-			singleNeighbors.insert(std::make_pair(indices[elem+1], elem));
-		}
-		if(!multiNeighbors[indices[elem+2]]){
-			// iData[*it+2] is not a multiple neighbor => add to singleNeighbors
-			singleNeighbors.insert(std::make_pair(indices[elem+2], elem));
-		}
-	}
-
-	// add non connected vertices to neighbors
-	if(threshold > 0.0f) {
-		std::deque<VertexPoint> nonConnectedNeighbors;
-		vOctree->collectPointsWithinSphere(Geometry::Sphere_f(Geometry::Vec3f(v.data[0], v.data[1], v.data[2]), threshold), nonConnectedNeighbors);
-		for(auto & nonConnectedNeighbor : nonConnectedNeighbors) {
-			n.insert(nonConnectedNeighbor.data);
-		}
-	}
+//! Key of an unordered vertex pair.
+static inline uint64_t getPairKey(uint32_t a, uint32_t b) {
+	return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
 }
 
 /**
- * Calculated optimal position and cost for merging vertices v1 and v2
- * only compares v1, v2 and (v1+v2)/2 as new positions...
- * @return cost
+ * Add the keys of all pairs of vertices whose positions (the first three data entries)
+ * have a distance of at most @a threshold. The vertices are sorted into a uniform grid
+ * with a cell size of @a threshold, so only the neighboring cells have to be searched.
  */
-static float getOptimalPosition(const vertex_t & vertexA, const vertex_t & vertexB, std::vector<float> & optPos, std::size_t dataSize, bool useOptPos){
-	bool optPosSuccess=false;
-	float cost = 0;
-	if(useOptPos){
-		// allocate and initiate matrix for inversion
-		const auto rowSize = 2 * dataSize;
-		auto mInvert = new float[dataSize * rowSize];
-		for (std::size_t row = 0; row < dataSize; ++row) {
-			for (std::size_t col = 0; col < dataSize; ++col) {
-				const auto rowOffset = row * rowSize;
-				if (row <= col) {
-					mInvert[rowOffset + col] = vertexA.q.A.get(row, col) + vertexB.q.A.get(row, col);
-				} else {
-					mInvert[rowOffset + col] = vertexA.q.A.get(col, row) + vertexB.q.A.get(col, row);
-				}
-			}
-		}
-
-		if(Util::Numeric::invertMatrix(mInvert, dataSize)){
-			optPosSuccess = true;
-			// matrix inversion successful
-			// calculate & store optimal position
-			// Optimal position vBar = - A^-1 b
-			optPos.resize(dataSize);
-			for (uint_fast8_t row = 0; row < dataSize; ++row) {
-				const uint_fast8_t rowOffset = row * rowSize + dataSize;
-
-				float sum = 0.0f;
-				for(uint_fast8_t col = 0; col < dataSize; ++col) {
-					sum += mInvert[rowOffset + col] * (vertexA.q.b[col] + vertexB.q.b[col]);
-				}
-				optPos[row] = -sum;
-			}
-			// Cost Q(vBar) = - b^T A^-1 b + c
-			cost = vertexA.q.c + vertexB.q.c;
-			for(uint_fast8_t col = 0; col < dataSize; ++col) {
-				float sum = 0.0f;
-				for (uint_fast8_t row = 0; row < dataSize; ++row) {
-					const uint_fast8_t rowOffset = row * rowSize + dataSize;
-					sum += (vertexA.q.b[row] + vertexB.q.b[row]) * mInvert[rowOffset + col];
+static void collectClosePairs(const std::vector<float> & vertexData, std::size_t numDataEntries, uint32_t vertexCount,
+							  float threshold, std::vector<uint64_t> & pairKeys) {
+	// 21 bits per cell coordinate; clamped coordinates only lead to unnecessary distance tests.
+	const int64_t cellOffset = 1 << 20;
+	auto getCellCoordinate = [&](float value) {
+		return Util::Numeric::clamp<int64_t>(static_cast<int64_t>(std::floor(value / threshold)) + cellOffset, 0, 2 * cellOffset - 1);
+	};
+	auto getCellKey = [](int64_t x, int64_t y, int64_t z) {
+		return static_cast<uint64_t>(x) << 42 | static_cast<uint64_t>(y) << 21 | static_cast<uint64_t>(z);
+	};
+
+	std::vector<std::pair<uint64_t, uint32_t>> cells;
+	cells.reserve(vertexCount);
+	for(uint32_t v = 0; v < vertexCount; ++v) {
+		const float * position = vertexData.data() + v * numDataEntries;
+		cells.emplace_back(getCellKey(getCellCoordinate(position[0]), getCellCoordinate(position[1]), getCellCoordinate(position[2])), v);
+	}
+	std::sort(cells.begin(), cells.end());
+
+	const float squaredThreshold = threshold * threshold;
+	for(uint32_t v = 0; v < vertexCount; ++v) {
+		const float * position = vertexData.data() + v * numDataEntries;
+		const int64_t x = getCellCoordinate(position[0]);
+		const int64_t y = getCellCoordinate(position[1]);
+		const int64_t z = getCellCoordinate(position[2]);
+		for(int64_t dx = std::max<int64_t>(x - 1, 0); dx <= std::min(x + 1, 2 * cellOffset - 1); ++dx) {
+			for(int64_t dy = std::max<int64_t>(y - 1, 0); dy <= std::min(y + 1, 2 * cellOffset - 1); ++dy) {
+				for(int64_t dz = std::max<int64_t>(z - 1, 0); dz <= std::min(z + 1, 2 * cellOffset - 1); ++dz) {
+					const uint64_t key = getCellKey(dx, dy, dz);
+					auto it = std::lower_bound(cells.begin(), cells.end(), std::make_pair(key, v + 1));
+					for(; it != cells.end() && it->first == key; ++it) {
+						const float * other = vertexData.data() + it->second * numDataEntries;
+						const float distX = other[0] - position[0];
+						const float distY = other[1] - position[1];
+						const float distZ = other[2] - position[2];
+						if(distX * distX + distY * distY + distZ * distZ <= squaredThreshold) {
+							pairKeys.push_back(getPairKey(v, it->second));
+						}
+					}
 				}
-				cost -= sum * (vertexA.q.b[col] + vertexB.q.b[col]);
 			}
 		}
-
-		// free matrix memory
-		delete[] mInvert;
-	}
-	if(!optPosSuccess){
-		// matrix is not invertible => get best position of v1, v2 and (v1+v2)/2
-		Quadric<float> sumQ(vertexA.q);
-		sumQ += vertexB.q;
-
-		std::vector<float> sumData;
-		sumData.reserve(dataSize);
-		for (std::size_t i = 0; i < dataSize; ++i) {
-			sumData.push_back(0.5f * (vertexA.data[i] + vertexB.data[i]));
-		}
-		float costV1 = sumQ.getCost(vertexA.data);
-		float costV2 = sumQ.getCost(vertexB.data);
-		float costV1V2div2 = sumQ.getCost(sumData);
-		// use minimum of v1 and v2 as optimal position
-		if(costV1<costV2 && costV1<costV1V2div2){
-			cost = costV1;
-			optPos = vertexA.data;
-		}else if(costV2<costV1 && costV2<costV1V2div2){
-			cost = costV2;
-			optPos = vertexB.data;
-		} else{
-			cost = costV1V2div2;
-			optPos = sumData;
-		}
 	}
-	return cost;
 }
 
 Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold, bool useOptimalPositioning, float maxAngle, const weights_t & weights) {
+	return simplifyMesh(mesh, newNumberOfTriangles, threshold, useOptimalPositioning, maxAngle, weights, std::vector<bool>());
+}
+
+Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold, bool useOptimalPositioning, float maxAngle, const weights_t & weights,
+					const std::vector<bool> & lockedVertices, bool verbose) {
+	if(!lockedVertices.empty() && lockedVertices.size() != mesh->getVertexCount()) {
+		throw std::invalid_argument("simplifyMesh: The number of locked vertex flags differs from the number of vertices.");
+	}
 	if(mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
 		WARN("Mesh simplification can only be done with triangle meshes.");
 		return mesh;
@@ -605,310 +553,311 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 		WARN("Mesh already has less or equal as many triangles as requested.");
 		return mesh;
 	}
-	Util::info<<"\nSimplifying mesh from "<<mesh->getPrimitiveCount()<<" to "<<newNumberOfTriangles<<" triangles; threshold: "<<threshold<<"; optPos: "<<useOptimalPositioning<<"\n";
-	Util::info<<"Weights are: vertex="<<weights[0]<<" normal="<<weights[1]<<" color="<<weights[2]<<" tex0="<<weights[3]<<" boundary="<<weights[4]<<"\n";
-	Util::ProgressIndicator progress("Simplify progress",(mesh->getPrimitiveCount()-newNumberOfTriangles)+mesh->getPrimitiveCount()+3*mesh->getVertexCount(), 2);
+	std::unique_ptr<Util::ProgressIndicator> progress;
+	if(verbose) {
+		Util::info<<"\nSimplifying mesh from "<<mesh->getPrimitiveCount()<<" to "<<newNumberOfTriangles<<" triangles; threshold: "<<threshold<<"; optPos: "<<useOptimalPositioning<<"\n";
+		Util::info<<"Weights are: vertex="<<weights[0]<<" normal="<<weights[1]<<" color="<<weights[2]<<" tex0="<<weights[3]<<" boundary="<<weights[4]<<"\n";
+		progress.reset(new Util::ProgressIndicator("Simplify progress",(mesh->getPrimitiveCount()-newNumberOfTriangles)+mesh->getPrimitiveCount()+mesh->getVertexCount(), 2));
+	}
 	Util::Timer timer;
 	timer.reset();
 
 	// initialize vertex array
-	const Geometry::Box & meshBB = mesh->getBoundingBox();
-	const float octreeBoxMax = std::max(std::max(meshBB.getMaxX(), meshBB.getMaxY()), meshBB.getMaxZ()) * weights[VERTEX_OFFSET];
-	const float octreeBoxMin = std::min(std::min(meshBB.getMinX(), meshBB.getMinY()), meshBB.getMinZ()) * weights[VERTEX_OFFSET];
-	const Geometry::Box octreeBox(octreeBoxMin, octreeBoxMax, octreeBoxMin, octreeBoxMax, octreeBoxMin, octreeBoxMax);
-	threshold *= weights[VERTEX_OFFSET];
-	Geometry::PointOctree<VertexPoint> * vertexOctree = nullptr;
-	if(threshold > 0.0f) {
-		vertexOctree = new Geometry::PointOctree<VertexPoint>(octreeBox, threshold, 100);
-	}
-	std::vector<vertex_t> vertices;
-	const auto numDataEntries = initVertexArray(mesh, progress, weights, vertices, vertexOctree);
+	const uint32_t vertexCount = mesh->getVertexCount();
+	std::vector<float> vertices;
+	bool hasPositions;
+	const std::size_t numDataEntries = initVertexArray(mesh, progress.get(), weights, vertices, hasPositions);
 	if(numDataEntries == 0) {
 		WARN("Vertex data does not contain readable information, or weights prevent the data usage.");
 		return mesh;
 	}
+	threshold *= weights[VERTEX_OFFSET];
+	auto vertexDataOf = [&](uint32_t v) {
+		return vertices.data() + static_cast<std::size_t>(v) * numDataEntries;
+	};
 
-	// build heap
-	Util::UpdatableHeap<float, heapData> heap;
-
-	const uint32_t vertexCount = mesh->getVertexCount();
-	MeshIndexData iData = mesh->openIndexData();
-
-	// add boundary constraint planes and get neighbors
+	std::vector<uint32_t> indices;
 	{
-		Quadric<float> tmpQ(numDataEntries);
+		const MeshIndexData & iData = mesh->openIndexData();
+		indices.resize(iData.getIndexCount() / 3 * 3);
+		for(uint32_t i = 0; i < indices.size(); ++i) {
+			indices[i] = iData[i];
+		}
+	}
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+	// initialize quadrics
+	const std::size_t quadricSize = getQuadricSize(numDataEntries);
+	std::vector<float> quadrics(quadricSize * vertexCount, 0.0f);
+	auto quadricOf = [&](uint32_t v) {
+		return quadrics.data() + static_cast<std::size_t>(v) * quadricSize;
+	};
+	std::vector<float> tmpQ(quadricSize);
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		const uint32_t * triangle = indices.data() + t * 3;
+		getQuadric(vertexDataOf(triangle[0]), vertexDataOf(triangle[1]), vertexDataOf(triangle[2]), numDataEntries, tmpQ.data());
+		addQuadric(quadricOf(triangle[0]), tmpQ.data(), quadricSize);
+		addQuadric(quadricOf(triangle[1]), tmpQ.data(), quadricSize);
+		addQuadric(quadricOf(triangle[2]), tmpQ.data(), quadricSize);
+		if(progress != nullptr) {
+			progress->increment();
+		}
+	}
+
+	// edges with one of their triangles, sorted by their keys
+	std::vector<std::pair<uint64_t, uint32_t>> edges;
+	edges.reserve(indices.size());
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		for(uint_fast8_t corner = 0; corner < 3; ++corner) {
+			const uint32_t a = indices[t * 3 + corner];
+			const uint32_t b = indices[t * 3 + (corner + 1) % 3];
+			if(a != b) {
+				edges.emplace_back(getPairKey(a, b), t);
+			}
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+
+	// add boundary constraint planes to both vertices of edges having a single triangle
+	if(weights[BOUNDARY_OFFSET] && weights[VERTEX_OFFSET] && hasPositions) {
 		std::vector<float> v1(numDataEntries, 0.0f);
 		std::vector<float> v2(numDataEntries, 0.0f);
 		std::vector<float> v3(numDataEntries, 0.0f);
-		for(unsigned int i=0; i<vertexCount; ++i){
-			std::set<std::pair<unsigned int, unsigned int> > singleNeighbors;
-			getNeighboursOfVertex(mesh, vertices[i], vertexOctree, threshold, vertices[i].neighbors, singleNeighbors);
-
-			if(weights[BOUNDARY_OFFSET] && weights[VERTEX_OFFSET]){
-				// make sure to add a boundary plan to only once to both vertices i and *singleNeighborIterator.first by checking first<i
-				for(auto singleNeighborIterator=singleNeighbors.begin(); singleNeighborIterator->first<i && singleNeighborIterator!=singleNeighbors.end(); ++singleNeighborIterator){
-					// plane normal has to be perpendicular to edge between single neighbors and to normal of face spanned by this edge
-					// => plane has to lie in single neighbor vertices and one of those vertices+planeNormal
-					const auto normal = calcNormal(vertices[iData[singleNeighborIterator->second + 0]].data.data(),
-												   vertices[iData[singleNeighborIterator->second + 1]].data.data(),
-												   vertices[iData[singleNeighborIterator->second + 2]].data.data());
-
-					v1[0] = vertices[i].data[0];
-					v1[1] = vertices[i].data[1];
-					v1[2] = vertices[i].data[2];
-					v2[0] = vertices[singleNeighborIterator->first].data[0];
-					v2[1] = vertices[singleNeighborIterator->first].data[1];
-					v2[2] = vertices[singleNeighborIterator->first].data[2];
-					v3[0] = normal.getX() + vertices[i].data[0];
-					v3[1] = normal.getY() + vertices[i].data[1];
-					v3[2] = normal.getZ() + vertices[i].data[2];
-
-
-					//getQuadric(&vertices[i].data[0], &vertices[singleNeighborIterator->first].data[0], v3, tmp_quadric, 4);
-					getQuadric(v1, v2, v3, tmpQ);
-					for(std::size_t j=3; j<numDataEntries; ++j)
-						tmpQ.A.set(j, j, 0.0f);
-
-					// add boundary constraint plane to both vertices that are single neighbors
-					vertices[i].q += tmpQ;
-					vertices[singleNeighborIterator->first].q += tmpQ;
+		for(std::size_t i = 0; i < edges.size(); ) {
+			std::size_t next = i + 1;
+			while(next < edges.size() && edges[next].first == edges[i].first) {
+				++next;
+			}
+			if(next == i + 1) {
+				// plane normal has to be perpendicular to the edge and to the normal of the triangle
+				// => plane has to lie in the edge's vertices and one of those vertices+triangleNormal
+				const uint32_t a = static_cast<uint32_t>(edges[i].first >> 32);
+				const uint32_t b = static_cast<uint32_t>(edges[i].first & 0xffffffff);
+				const uint32_t * triangle = indices.data() + edges[i].second * 3;
+				const auto normal = calcNormal(vertexDataOf(triangle[0]), vertexDataOf(triangle[1]), vertexDataOf(triangle[2]));
+				for(uint_fast8_t k = 0; k < 3; ++k) {
+					v1[k] = vertexDataOf(a)[k];
+					v2[k] = vertexDataOf(b)[k];
+					v3[k] = normal[k] + vertexDataOf(a)[k];
+				}
+				getQuadric(v1.data(), v2.data(), v3.data(), numDataEntries, tmpQ.data());
+				// only the position part is constrained
+				float * diagonal = tmpQ.data();
+				for(std::size_t j = 0; j < numDataEntries; ++j) {
+					if(j >= 3) {
+						*diagonal = 0.0f;
+					}
+					diagonal += numDataEntries - j;
 				}
+				addQuadric(quadricOf(a), tmpQ.data(), quadricSize);
+				addQuadric(quadricOf(b), tmpQ.data(), quadricSize);
+			}
+			i = next;
+		}
+	}
+
+	// vertex pairs: edges and (if the threshold is positive) pairs of close vertices
+	std::vector<uint64_t> pairKeys;
+	pairKeys.reserve(edges.size() / 2);
+	for(std::size_t i = 0; i < edges.size(); ++i) {
+		if(i == 0 || edges[i].first != edges[i - 1].first) {
+			pairKeys.push_back(edges[i].first);
+		}
+	}
+	std::vector<std::pair<uint64_t, uint32_t>>().swap(edges);
+	if(threshold > 0.0f && hasPositions) {
+		collectClosePairs(vertices, numDataEntries, vertexCount, threshold, pairKeys);
+		std::sort(pairKeys.begin(), pairKeys.end());
+		pairKeys.erase(std::unique(pairKeys.begin(), pairKeys.end()), pairKeys.end());
+	}
+	const uint32_t pairCount = static_cast<uint32_t>(pairKeys.size());
+	std::vector<std::array<uint32_t, 2>> pairs(pairCount);
+	for(uint32_t p = 0; p < pairCount; ++p) {
+		pairs[p][0] = static_cast<uint32_t>(pairKeys[p] >> 32);
+		pairs[p][1] = static_cast<uint32_t>(pairKeys[p] & 0xffffffff);
+	}
+	std::vector<uint64_t>().swap(pairKeys);
+
+	// triangles and pairs of every vertex; a triangle is listed once for each of its distinct vertices
+	auto isFirstOccurrence = [&](uint32_t t, uint_fast8_t corner) {
+		const uint32_t * triangle = indices.data() + t * 3;
+		return corner == 0 || (triangle[corner] != triangle[0] && (corner == 1 || triangle[2] != triangle[1]));
+	};
+	std::vector<uint32_t> counts(vertexCount, 0);
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		for(uint_fast8_t corner = 0; corner < 3; ++corner) {
+			if(isFirstOccurrence(t, corner)) {
+				++counts[indices[t * 3 + corner]];
 			}
-			progress.increment();
-			// singleNeighbors is destroyed here
 		}
 	}
-
-	// build heap
-	for(unsigned int i=0; i<vertexCount; ++i){
-		// add unique neighbors to heap (by adding only pairs of (i,j) where i<j)
-		for(auto it=vertices[i].neighbors.upper_bound(i); it!=vertices[i].neighbors.end(); ++it){
-			heapData hd(i, *it);
-			float cost = getOptimalPosition(vertices[i], vertices[*it], hd.optPos, numDataEntries, useOptimalPositioning);
-			heapElement *h = heap.insert(cost, hd);
-			vertices[i].inHeap.insert(h);
-			vertices[*it].inHeap.insert(h);
+	VertexLists vertexTriangles(counts);
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		for(uint_fast8_t corner = 0; corner < 3; ++corner) {
+			if(isFirstOccurrence(t, corner)) {
+				vertexTriangles.add(indices[t * 3 + corner], t);
+			}
 		}
-		progress.increment();
 	}
+	std::fill(counts.begin(), counts.end(), 0);
+	for(const auto & pair : pairs) {
+		++counts[pair[0]];
+		++counts[pair[1]];
+	}
+	VertexLists vertexPairs(counts);
+	for(uint32_t p = 0; p < pairCount; ++p) {
+		vertexPairs.add(pairs[p][0], p);
+		vertexPairs.add(pairs[p][1], p);
+	}
+	std::vector<uint32_t>().swap(counts);
+
+	// Calculate the cost and the new position for merging a pair. A locked vertex is never moved,
+	// so it becomes the first vertex of the pair, which remains after merging.
+	auto isLocked = [&](uint32_t v) {
+		return !lockedVertices.empty() && lockedVertices[v];
+	};
+	auto calculatePairCost = [&](uint32_t p, float * position) {
+		auto & pair = pairs[p];
+		if(isLocked(pair[1])) {
+			std::swap(pair[0], pair[1]);
+		}
+		if(isLocked(pair[0])) {
+			if(isLocked(pair[1])) {
+				return DONT_MERGE_COST;
+			}
+			const float * data = vertexDataOf(pair[0]);
+			std::copy(data, data + numDataEntries, position);
+			return evaluateQuadric(quadricOf(pair[0]), numDataEntries, data) + evaluateQuadric(quadricOf(pair[1]), numDataEntries, data);
+		}
+		return getOptimalPosition(quadricOf(pair[0]), quadricOf(pair[1]), vertexDataOf(pair[0]), vertexDataOf(pair[1]),
+								  numDataEntries, useOptimalPositioning, position);
+	};
 
+	// build heap
+	float optPos[maxDataEntries];
+	std::vector<float> pairCosts(pairCount);
+	for(uint32_t p = 0; p < pairCount; ++p) {
+		pairCosts[p] = calculatePairCost(p, optPos);
+	}
+	PairHeap heap(std::move(pairCosts));
 
 	// merge vertices
+	std::vector<uint8_t> triangleDeleted(triangleCount, 0);
+	std::vector<uint8_t> pairDeleted(pairCount, 0);
+	std::vector<uint8_t> vertexDeleted(vertexCount, 0);
+	//! Number of the merge step in which a vertex has been seen as neighbor of the remaining vertex.
+	std::vector<uint32_t> visited(vertexCount, INVALID_INDEX);
+	uint32_t mergeStep = 0;
 	int flipcount = 0;
-	std::unordered_set<unsigned int> indexTrash;
-	std::vector<unsigned int> vertexTrash;
-	// rough estimate of the number of vertices that will be removed
-	vertexTrash.reserve((mesh->getPrimitiveCount() - newNumberOfTriangles) / 2);
-	unsigned int newTriangleCount = mesh->getPrimitiveCount();
-
-	{
-		while(newTriangleCount>newNumberOfTriangles && heap.size()!=0 && heap.top()->getCost()!=DONT_MERGE_COST /*&& iteration<threshold*/){
-			heapElement *heapHead = heap.top();
-			heapData &topData = heapHead->data;
-			std::set<heapElement*> heapTrash;
-
-			if(maxAngle != -1) {
-				// check if some normal flips
-				bool normalFlip = false;
-				// checking for vertex1.inIndex
-				for(const auto & triIndex : vertices[topData.vertex1].inIndex) {
-					if(!(iData[triIndex + 0] == topData.vertex2
-						|| iData[triIndex + 1] == topData.vertex2
-						|| iData[triIndex + 2] == topData.vertex2)) {
-						// face will not be deleted
-
-						// calculate normal before merging
-						const auto normalBefore = calcNormal(vertices[iData[triIndex + 0]].data.data(), 
-															 vertices[iData[triIndex + 1]].data.data(), 
-															 vertices[iData[triIndex + 2]].data.data());
-						if(normalBefore.isZero()) {
-							normalFlip = true;
-							break;
-						}
-
-						// calculate normal after merging
-						Geometry::Vec3f normalAfter;
-						if(iData[triIndex + 0] == topData.vertex1) {
-							normalAfter = calcNormal(topData.optPos.data(), 
-													 vertices[iData[triIndex + 1]].data.data(), 
-													 vertices[iData[triIndex + 2]].data.data());
-						} else if(iData[triIndex + 1] == topData.vertex1) {
-							normalAfter = calcNormal(vertices[iData[triIndex + 0]].data.data(), 
-													 topData.optPos.data(), 
-													 vertices[iData[triIndex + 2]].data.data());
-						} else {
-							normalAfter = calcNormal(vertices[iData[triIndex + 0]].data.data(), 
-													 vertices[iData[triIndex + 1]].data.data(), 
-													 topData.optPos.data());
-						}
-						if(normalAfter.isZero()) {
-							normalFlip = true;
-							break;
-						}
-
-						// check if normal has flipped
-						if(normalBefore.dot(normalAfter) < maxAngle) {
-							normalFlip = true;
-							break;
-						}
-					}
-				}
-				// checking for vertex2.inIndex
-				for(const auto & triIndex : vertices[topData.vertex2].inIndex) {
-					if(!(iData[triIndex + 0] == topData.vertex1
-						|| iData[triIndex + 1] == topData.vertex1
-						|| iData[triIndex + 2] == topData.vertex1)) {
-						// face will not be deleted
-
-						// calculate normal before merging
-						const auto normalBefore = calcNormal(vertices[iData[triIndex + 0]].data.data(),
-															 vertices[iData[triIndex + 1]].data.data(), 
-															 vertices[iData[triIndex + 2]].data.data());
-						if(normalBefore.isZero()) {
-							normalFlip = true;
-							break;
-						}
+	uint32_t newTriangleCount = triangleCount;
 
-						// calculate normal after merging
-						Geometry::Vec3f normalAfter;
-						if(iData[triIndex + 0] == topData.vertex2) {
-							normalAfter = calcNormal(topData.optPos.data(), 
-													 vertices[iData[triIndex + 1]].data.data(), 
-													 vertices[iData[triIndex + 2]].data.data());
-						} else if(iData[triIndex + 1] == topData.vertex2) {
-							normalAfter = calcNormal(vertices[iData[triIndex + 0]].data.data(), 
-													 topData.optPos.data(), 
-													 vertices[iData[triIndex + 2]].data.data());
-						} else {
-							normalAfter = calcNormal(vertices[iData[triIndex + 0]].data.data(), 
-													 vertices[iData[triIndex + 1]].data.data(), 
-													 topData.optPos.data());
-						}
-						if(normalAfter.isZero()) {
-							normalFlip = true;
-							break;
-						}
-
-						// check if normal has flipped
-						if(normalBefore.dot(normalAfter) < maxAngle) {
-							normalFlip = true;
-							break;
-						}
-					}
-				}
-				if(normalFlip){
-					flipcount++;
-					normalFlip = false;
-					heap.update(heapHead, DONT_MERGE_COST);
-					continue;
-				}
+	// Return true if a triangle of @a vertex not containing @a other would flip or degenerate when @a vertex is moved to optPos.
+	auto checkNormalFlip = [&](uint32_t vertex, uint32_t other) {
+		for(const uint32_t * it = vertexTriangles.begin(vertex); it != vertexTriangles.end(vertex); ++it) {
+			if(triangleDeleted[*it]) {
+				continue;
 			}
+			const uint32_t * triangle = indices.data() + *it * 3;
+			if(triangle[0] == other || triangle[1] == other || triangle[2] == other) {
+				// face will be deleted
+				continue;
+			}
+			const auto normalBefore = calcNormal(vertexDataOf(triangle[0]), vertexDataOf(triangle[1]), vertexDataOf(triangle[2]));
+			if(normalBefore.isZero()) {
+				return true;
+			}
+			const auto normalAfter = calcNormal(triangle[0] == vertex ? optPos : vertexDataOf(triangle[0]),
+												triangle[1] == vertex ? optPos : vertexDataOf(triangle[1]),
+												triangle[2] == vertex ? optPos : vertexDataOf(triangle[2]));
+			if(normalAfter.isZero() || normalBefore.dot(normalAfter) < maxAngle) {
+				return true;
+			}
+		}
+		return false;
+	};
+
+	while(newTriangleCount > newNumberOfTriangles && !heap.empty() && heap.getCost(heap.top()) != DONT_MERGE_COST) {
+		const uint32_t topPair = heap.top();
+		calculatePairCost(topPair, optPos);
+		const uint32_t vertex1 = pairs[topPair][0];
+		const uint32_t vertex2 = pairs[topPair][1];
+
+		if(maxAngle != -1 && hasPositions) {
+			if(checkNormalFlip(vertex1, vertex2) || checkNormalFlip(vertex2, vertex1)) {
+				++flipcount;
+				heap.update(topPair, DONT_MERGE_COST);
+				continue;
+			}
+		}
 
-			// merge vertex1 and vertex2 into vertex1
-			vertexTrash.push_back(topData.vertex2);
-
-			// update data of vertex1 to data of merged vertex
-			vertices[topData.vertex1].data = topData.optPos;
-
-			// update indexData of vertex2 to vertex1 and inIndex of vertex1
-			for(const auto & triIndex : vertices[topData.vertex2].inIndex) {
-				std::array<uint32_t, 3> vertexIndices;
-				vertexIndices[0] = iData[triIndex + 0];
-				vertexIndices[1] = iData[triIndex + 1];
-				vertexIndices[2] = iData[triIndex + 2];
-				if(vertexIndices[0] == topData.vertex1 || vertexIndices[1] == topData.vertex1 || vertexIndices[2] == topData.vertex1) {
-					// triangle uses vertex1 and vertex2 => no triangle after merging
-					if(indexTrash.insert(triIndex).second) {
-						// face was inserted => was not deleted before
-						for(const auto & vertexIndex : vertexIndices) {
-							if(vertexIndex != topData.vertex2) {
-								vertices[vertexIndex].inIndex.erase(std::remove(vertices[vertexIndex].inIndex.begin(), vertices[vertexIndex].inIndex.end(), triIndex),
-																	vertices[vertexIndex].inIndex.end());
-							}
-						}
-
-						--newTriangleCount;
-						progress.increment();
-					}
-				} else {
-					// only vertex2 is used in this triangle => update vertex2 to vertex1
-					if(vertexIndices[0] == topData.vertex2) {
-						iData[triIndex + 0] = topData.vertex1;
-					}
-					if(vertexIndices[1] == topData.vertex2) {
-						iData[triIndex + 1] = topData.vertex1;
-					}
-					if(vertexIndices[2] == topData.vertex2) {
-						iData[triIndex + 2] = topData.vertex1;
-					}
-
-					vertices[topData.vertex1].inIndex.push_back(triIndex);
+		// merge vertex1 and vertex2 into vertex1
+		vertexDeleted[vertex2] = 1;
+		std::copy(optPos, optPos + numDataEntries, vertexDataOf(vertex1));
+		addQuadric(quadricOf(vertex1), quadricOf(vertex2), quadricSize);
 
-					// Make inIndex unique again.
-					make_unique(vertices[topData.vertex1].inIndex);
-				}
+		// triangles using vertex1 and vertex2 are deleted; the other triangles of vertex2 now use vertex1
+		for(const uint32_t * it = vertexTriangles.begin(vertex2); it != vertexTriangles.end(vertex2); ++it) {
+			if(triangleDeleted[*it]) {
+				continue;
 			}
-
-			// update heap by replacing vertex2 by vertex1
-			for(auto & elem : vertices[topData.vertex2].inHeap) {
-				// update heapHead->vertex2 in heapElement to heapHead->vertex1 and make sure that heapElements are unique
-				if(elem->data.vertex1==topData.vertex2) {
-					// update vertex1 of heapElement
-					if(vertices[topData.vertex1].neighbors.insert(elem->data.vertex2).second) {
-						// new neighbor has been added => update heap normally
-						vertices[elem->data.vertex2].neighbors.insert(topData.vertex1);
-						vertices[topData.vertex1].inHeap.insert(elem);
-						elem->data.vertex1 = topData.vertex1;
-					} else {
-						// neighbors already existed => delete this heapElement so preserve uniqueness
-						heapTrash.insert(elem);
-					}
-				}else{
-					// update vertex2 of heapElement
-					if(vertices[topData.vertex1].neighbors.insert(elem->data.vertex1).second) {
-						// new neighbor has been added => update heap normally
-						vertices[elem->data.vertex1].neighbors.insert(topData.vertex1);
-						vertices[topData.vertex1].inHeap.insert(elem);
-						elem->data.vertex2 = topData.vertex1;
-					} else {
-						// neighbors already existed => delete this heapElement so preserve uniqueness
-						heapTrash.insert(elem);
+			uint32_t * triangle = indices.data() + *it * 3;
+			if(triangle[0] == vertex1 || triangle[1] == vertex1 || triangle[2] == vertex1) {
+				triangleDeleted[*it] = 1;
+				--newTriangleCount;
+				if(progress != nullptr) {
+					progress->increment();
+				}
+			} else {
+				for(uint_fast8_t corner = 0; corner < 3; ++corner) {
+					if(triangle[corner] == vertex2) {
+						triangle[corner] = vertex1;
 					}
 				}
 			}
+		}
+		vertexTriangles.merge(vertex1, vertex2, [&](uint32_t t) { return !triangleDeleted[t]; });
 
-			// update matrix q=(vertex1.q+vertex2.q) of vertex1
-			vertices[topData.vertex1].q += vertices[topData.vertex2].q;
-
-			// update cost of merge with other neighbors
-			for(auto & elem : vertices[topData.vertex1].inHeap) {
-				// only update heapElement if it will not be deleted
-				if(heapTrash.count(elem) == 0) {
-					float cost = getOptimalPosition(vertices[elem->data.vertex1], vertices[elem->data.vertex2], elem->data.optPos, numDataEntries, useOptimalPositioning);
-					heap.update(elem, cost);
-				}
+		// replace vertex2 by vertex1 in its pairs
+		for(const uint32_t * it = vertexPairs.begin(vertex2); it != vertexPairs.end(vertex2); ++it) {
+			auto & pair = pairs[*it];
+			if(pair[0] == vertex2) {
+				pair[0] = vertex1;
 			}
-
-			// delete heapElements in heapTrash (this is including heapHead)
-			for(auto & elem : heapTrash) {
-				vertices[elem->data.vertex1].inHeap.erase(elem);
-				vertices[elem->data.vertex2].inHeap.erase(elem);
-				heap.erase(elem);
+			if(pair[1] == vertex2) {
+				pair[1] = vertex1;
 			}
 		}
+		// remove the merged pair and pairs that became duplicates; update the costs of the others
+		++mergeStep;
+		auto updatePairs = [&](uint32_t vertex) {
+			for(const uint32_t * it = vertexPairs.begin(vertex); it != vertexPairs.end(vertex); ++it) {
+				const uint32_t p = *it;
+				if(pairDeleted[p]) {
+					continue;
+				}
+				const uint32_t other = pairs[p][0] == vertex1 ? pairs[p][1] : pairs[p][0];
+				if(other == vertex1 || visited[other] == mergeStep) {
+					pairDeleted[p] = 1;
+					heap.erase(p);
+					continue;
+				}
+				visited[other] = mergeStep;
+				float tmpPos[maxDataEntries];
+				heap.update(p, calculatePairCost(p, tmpPos));
+			}
+		};
+		updatePairs(vertex1);
+		updatePairs(vertex2);
+		vertexPairs.merge(vertex1, vertex2, [&](uint32_t p) { return !pairDeleted[p]; });
 	}
 
-	if(heap.size()!=0 && heap.top()->getCost()==DONT_MERGE_COST){
+	if(verbose && !heap.empty() && heap.getCost(heap.top()) == DONT_MERGE_COST) {
 		WARN("Could not merge any more due to constraints.");
 	}
 
 	// write vertex data
 	MeshVertexData vertexData = mesh->openVertexData();
 	{
-		// there should be no duplicates, but the function sorts the array
-		// sorted array is needed for binary_search below
-		make_unique(vertexTrash);
-
 		Util::Reference<PositionAttributeAccessor> positionAccessor;
 		if(weights[VERTEX_OFFSET] > 0) {
 			try {
@@ -938,13 +887,12 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 			}
 		}
 
-		for(unsigned int v = 0; v < vertexCount; ++v) {
-			const bool vertexDeleted = std::binary_search(vertexTrash.begin(), vertexTrash.end(), v);
-			if(vertexDeleted) {
-				// skip vertex
+		for(uint32_t v = 0; v < vertexCount; ++v) {
+			if(vertexDeleted[v] || isLocked(v)) {
+				// skip vertex; locked vertices keep their original data
 				continue;
 			}
-			auto dataIt = vertices[v].data.cbegin();
+			const float * dataIt = vertexDataOf(v);
 
 			if(positionAccessor.isNotNull()) {
 				Geometry::Vec3f position;
@@ -981,18 +929,14 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 		}
 	}
 
-	// copy indices to newMesh deleting/skipping indexTrash
+	// copy the remaining triangles to the new index data
 	MeshIndexData indexData;
 	{
-		uint32_t newIndexCount = mesh->getIndexCount() - indexTrash.size() * 3;
-		indexData.allocate(newIndexCount);
-
+		indexData.allocate(newTriangleCount * 3);
 		uint32_t * indexPointer = indexData.data();
-		for(unsigned int i = 0; i < iData.getIndexCount(); i += 3) {
-			const bool indexDeleted = (indexTrash.count(i) > 0);
-			if(!indexDeleted) {
-				// copy index
-				std::copy(iData.data() + i, iData.data() + i + 3, indexPointer);
+		for(uint32_t t = 0; t < triangleCount; ++t) {
+			if(!triangleDeleted[t]) {
+				std::copy(indices.data() + t * 3, indices.data() + t * 3 + 3, indexPointer);
 				indexPointer += 3;
 			}
 		}
@@ -1006,7 +950,9 @@ Mesh * simplifyMesh(Mesh * mesh, uint32_t newNumberOfTriangles, float threshold,
 	newMesh = nullptr;
 
 	timer.stop();
-	std::cout<<"time needed[ms]: "<< timer.getMilliseconds() <<"; "<<flipcount<<" flips\n";
+	if(verbose) {
+		Util::info<<"time needed[ms]: "<< timer.getMilliseconds() <<"; "<<flipcount<<" flips\n";
+	}
 
 	return returnMesh;
 }
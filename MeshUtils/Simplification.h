@@ -13,6 +13,7 @@
 
 #include <array>
 #include <cstdint>
+#include <vector>
 
 namespace Rendering {
 class Mesh;
@@ -31,6 +32,8 @@ static const int BOUNDARY_OFFSET = 4;
  * the parameters. This method will return a new mesh and leave the
  * original unchanged.
  * Hint: Vertex weight should contain normalization of vertex position (divide by BoundingBox.extendMax)
+ * The vertex pairs are kept in an indexed binary heap; quadrics, vertex data and adjacency
+ * are stored in flat arrays, so the memory usage grows linearly with the size of the mesh.
  *
  * @param mesh Mesh to be simplified
  * @param numberOfTriangles the number of polygons the returned mesh should have
@@ -48,6 +51,24 @@ Mesh * simplifyMesh(Mesh * mesh,
 					float maxAngle, 
 					const weights_t & weights);
 
+/**
+ * Simplify the given mesh like the function above, but keep the vertices for which
+ * @a lockedVertices is @c true: they are neither moved nor removed and their data is not changed
+ * (e.g. vertices on the border to adjacent parts of a larger mesh).
+ *
+ * @param lockedVertices Flag for every vertex of the mesh, or empty if no vertex is locked
+ * @param verbose If @c false, no progress, timing or constraint information is printed (e.g. when simplifying in several threads)
+ * @throw std::invalid_argument if the size of @a lockedVertices does not match the number of vertices
+ */
+Mesh * simplifyMesh(Mesh * mesh,
+					uint32_t numberOfTriangles,
+					float threshold,
+					bool useOptimalPositioning,
+					float maxAngle,
+					const weights_t & weights,
+					const std::vector<bool> & lockedVertices,
+					bool verbose = true);
+
 }
 }
 }
@@ -34,7 +34,7 @@ namespace MeshUtils {
 
 class TriangleAccessor : public Util::ReferenceCounter<TriangleAccessor> {
 private:
-	MeshIndexData& indices;
+	const MeshIndexData& indices;
 	Util::Reference<PositionAttributeAccessor> posAcc;
 	std::unique_ptr<LocalMeshDataHolder> meshDataHolder;
 protected:
@@ -0,0 +1,861 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TriangleBVH.h"
+#include "LocalMeshDataHolder.h"
+#include "../Mesh/Mesh.h"
+#include "../Mesh/MeshIndexData.h"
+#include "../Mesh/MeshVertexData.h"
+#include "../Mesh/VertexAttributeAccessors.h"
+#include "../Mesh/VertexAttributeIds.h"
+#include "../Mesh/internal/ParallelFor.h"
+
+#include <Geometry/Box.h>
+#include <Geometry/Frustum.h>
+#include <Geometry/Line.h>
+#include <Geometry/Vec3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define RENDERING_BVH_SSE
+#endif
+
+namespace Rendering {
+namespace MeshUtils {
+
+const uint32_t TriangleBVH::NO_HIT;
+
+//! Leaves with at most this number of triangles are not split if the SAH does not suggest it.
+static const uint32_t maxLeafSize = 16;
+//! Number of bins used for evaluating the SAH.
+static const uint32_t binCount = 16;
+//! Below this depth, nodes are split using the SAH; deeper nodes are split at the median to bound the depth.
+static const uint32_t maxSahDepth = 48;
+//! Enough for the maximal depth of maxSahDepth + 32 levels.
+static const uint32_t traversalStackSize = 128;
+//! Subtrees with at least this number of triangles are built by an own thread.
+static const uint32_t minParallelSubtreeSize = 1 << 14;
+
+// ------------------------------------------------------------------------------------------
+// building
+
+//! (internal)
+struct BuildTriangle {
+	float min[3];
+	float max[3];
+	float centroid[3];
+};
+
+//! (internal)
+struct BuildContext {
+	std::vector<BuildTriangle> triangles;
+	//! Triangles of the hierarchy; the triangles of every node form a contiguous range.
+	std::vector<uint32_t> order;
+	//! Subtrees below this depth are not built in parallel.
+	uint32_t parallelDepth;
+};
+
+//! (internal) Half of the surface area of a box.
+static inline float getHalfArea(const float * min, const float * max) {
+	const float dx = max[0] - min[0];
+	const float dy = max[1] - min[1];
+	const float dz = max[2] - min[2];
+	return dx * dy + dy * dz + dz * dx;
+}
+
+//! (internal)
+static inline void resetBounds(float * min, float * max) {
+	std::fill(min, min + 3, std::numeric_limits<float>::max());
+	std::fill(max, max + 3, std::numeric_limits<float>::lowest());
+}
+
+//! (internal)
+static inline void includeBounds(float * min, float * max, const float * otherMin, const float * otherMax) {
+	for(uint_fast8_t a = 0; a < 3; ++a) {
+		min[a] = std::min(min[a], otherMin[a]);
+		max[a] = std::max(max[a], otherMax[a]);
+	}
+}
+
+/*! (internal) Read the positions of all triangles of the mesh in mesh order (nine coordinates per triangle).
+	Throws an std::invalid_argument exception if the mesh does not consist of indexed triangles. */
+static std::vector<float> readMeshTriangles(Mesh * mesh) {
+	if(!mesh->isUsingIndexData() || mesh->getDrawMode() != Mesh::DRAW_TRIANGLES) {
+		throw std::invalid_argument("TriangleBVH: Mesh is not a valid triangle mesh.");
+	}
+	LocalMeshDataHolder localData(mesh);
+	const MeshVertexData & vertices = mesh->openVertexData();
+	const MeshIndexData & indices = mesh->openIndexData();
+	Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(vertices, VertexAttributeIds::POSITION));
+
+	const uint32_t vertexCount = vertices.getVertexCount();
+	std::vector<Geometry::Vec3> positions(vertexCount);
+	posAcc->getPositions(0, vertexCount, positions.data());
+
+	const uint32_t triangleCount = indices.getIndexCount() / 3;
+	std::vector<float> coordinates(static_cast<std::size_t>(triangleCount) * 9);
+	for(uint32_t i = 0; i < triangleCount * 3; ++i) {
+		const uint32_t index = indices[i];
+		if(index >= vertexCount) {
+			throw std::invalid_argument("TriangleBVH: Vertex index out of range.");
+		}
+		const Geometry::Vec3 & p = positions[index];
+		coordinates[static_cast<std::size_t>(i) * 3 + 0] = p.getX();
+		coordinates[static_cast<std::size_t>(i) * 3 + 1] = p.getY();
+		coordinates[static_cast<std::size_t>(i) * 3 + 2] = p.getZ();
+	}
+	return coordinates;
+}
+
+//! (internal) Bin of a triangle for the given axis; used for evaluating and for applying a split.
+static inline uint32_t getBin(const BuildTriangle & triangle, uint32_t axis, float centroidMin, float scale) {
+	const int32_t bin = static_cast<int32_t>((triangle.centroid[axis] - centroidMin) * scale);
+	return static_cast<uint32_t>(std::max(0, std::min(static_cast<int32_t>(binCount) - 1, bin)));
+}
+
+//! (internal) Build the subtree for the triangles order[begin, end) and append its nodes to @a nodes.
+static void buildNode(BuildContext & context, uint32_t begin, uint32_t end, uint32_t depth, std::vector<TriangleBVH::Node> & nodes) {
+	TriangleBVH::Node node;
+	float centroidMin[3], centroidMax[3];
+	resetBounds(node.min, node.max);
+	resetBounds(centroidMin, centroidMax);
+	for(uint32_t i = begin; i < end; ++i) {
+		const BuildTriangle & triangle = context.triangles[context.order[i]];
+		includeBounds(node.min, node.max, triangle.min, triangle.max);
+		includeBounds(centroidMin, centroidMax, triangle.centroid, triangle.centroid);
+	}
+	const uint32_t count = end - begin;
+
+	uint32_t largestAxis = 0;
+	for(uint32_t a = 1; a < 3; ++a) {
+		if(centroidMax[a] - centroidMin[a] > centroidMax[largestAxis] - centroidMin[largestAxis]) {
+			largestAxis = a;
+		}
+	}
+
+	uint32_t mid = begin;
+	uint32_t splitAxis = largestAxis;
+	bool medianSplit = false;
+	if(count > 2 && depth < maxSahDepth) {
+		// binned surface area heuristic
+		float bestCost = std::numeric_limits<float>::max();
+		uint32_t bestBin = 0;
+		for(uint32_t axis = 0; axis < 3; ++axis) {
+			const float extent = centroidMax[axis] - centroidMin[axis];
+			if(!(extent > 0.0f)) {
+				continue;
+			}
+			const float scale = binCount / extent;
+			uint32_t binCounts[binCount] = {};
+			float binMin[binCount][3], binMax[binCount][3];
+			for(uint32_t b = 0; b < binCount; ++b) {
+				resetBounds(binMin[b], binMax[b]);
+			}
+			for(uint32_t i = begin; i < end; ++i) {
+				const BuildTriangle & triangle = context.triangles[context.order[i]];
+				const uint32_t b = getBin(triangle, axis, centroidMin[axis], scale);
+				++binCounts[b];
+				includeBounds(binMin[b], binMax[b], triangle.min, triangle.max);
+			}
+			// sweep from the right to get the area and count right of each split position
+			float rightCost[binCount];
+			float min[3], max[3];
+			resetBounds(min, max);
+			uint32_t rightCount = 0;
+			for(uint32_t b = binCount - 1; b > 0; --b) {
+				rightCount += binCounts[b];
+				includeBounds(min, max, binMin[b], binMax[b]);
+				rightCost[b] = rightCount > 0 ? getHalfArea(min, max) * rightCount : 0.0f;
+			}
+			resetBounds(min, max);
+			uint32_t leftCount = 0;
+			for(uint32_t b = 1; b < binCount; ++b) {
+				leftCount += binCounts[b - 1];
+				includeBounds(min, max, binMin[b - 1], binMax[b - 1]);
+				if(leftCount == 0 || leftCount == count) {
+					continue;
+				}
+				const float cost = getHalfArea(min, max) * leftCount + rightCost[b];
+				if(cost < bestCost) {
+					bestCost = cost;
+					bestBin = b;
+					splitAxis = axis;
+				}
+			}
+		}
+		if(bestBin != 0) {
+			// costs relative to a leaf: one traversal step plus the expected number of triangle tests
+			const float nodeArea = getHalfArea(node.min, node.max);
+			const float splitCost = 1.0f + (nodeArea > 0.0f ? bestCost / nodeArea : static_cast<float>(count));
+			if(splitCost < count || count > maxLeafSize) {
+				const float scale = binCount / (centroidMax[splitAxis] - centroidMin[splitAxis]);
+				const float axisMin = centroidMin[splitAxis];
+				mid = static_cast<uint32_t>(std::partition(context.order.begin() + begin, context.order.begin() + end,
+						[&](uint32_t t) { return getBin(context.triangles[t], splitAxis, axisMin, scale) < bestBin; })
+						- context.order.begin());
+			}
+		}
+		// all centroids are equal
+		medianSplit = (mid == begin || mid == end) && count > maxLeafSize;
+	} else {
+		// the tree became too deep
+		medianSplit = count > 2;
+	}
+	if(medianSplit) {
+		splitAxis = largestAxis;
+		mid = begin + count / 2;
+		std::nth_element(context.order.begin() + begin, context.order.begin() + mid, context.order.begin() + end,
+				[&](uint32_t a, uint32_t b) { return context.triangles[a].centroid[largestAxis] < context.triangles[b].centroid[largestAxis]; });
+	}
+
+	if(mid == begin || mid == end) {
+		node.offset = begin;
+		node.triangleCount = static_cast<uint16_t>(count);
+		node.splitAxis = 0;
+		nodes.push_back(node);
+		return;
+	}
+	node.triangleCount = 0;
+	node.splitAxis = static_cast<uint16_t>(splitAxis);
+	const std::size_t nodeIndex = nodes.size();
+	nodes.push_back(node);
+	if(depth < context.parallelDepth && end - mid >= minParallelSubtreeSize && mid - begin >= minParallelSubtreeSize) {
+		// the second child is built by another thread into a separate array and appended afterwards
+		std::vector<TriangleBVH::Node> secondNodes;
+		auto secondChild = std::async(std::launch::async, [&]() {
+			buildNode(context, mid, end, depth + 1, secondNodes);
+		});
+		buildNode(context, begin, mid, depth + 1, nodes);
+		secondChild.get();
+		const uint32_t base = static_cast<uint32_t>(nodes.size());
+		for(auto secondNode : secondNodes) {
+			if(!secondNode.isLeaf()) {
+				secondNode.offset += base;
+			}
+			nodes.push_back(secondNode);
+		}
+		nodes[nodeIndex].offset = base;
+	} else {
+		buildNode(context, begin, mid, depth + 1, nodes);
+		nodes[nodeIndex].offset = static_cast<uint32_t>(nodes.size());
+		buildNode(context, mid, end, depth + 1, nodes);
+	}
+}
+
+TriangleBVH::TriangleBVH() : Util::ReferenceCounter<TriangleBVH>() {
+}
+
+TriangleBVH::~TriangleBVH() = default;
+
+//! (static)
+Util::Reference<TriangleBVH> TriangleBVH::create(Mesh * mesh, bool parallel) {
+	Util::Reference<TriangleBVH> bvh = new TriangleBVH;
+	bvh->build(mesh, parallel);
+	return bvh;
+}
+
+void TriangleBVH::build(Mesh * mesh, bool parallel) {
+	const std::vector<float> coordinates = readMeshTriangles(mesh);
+	const uint32_t triangleCount = static_cast<uint32_t>(coordinates.size() / 9);
+
+	BuildContext context;
+	context.triangles.resize(triangleCount);
+	context.order.resize(triangleCount);
+	context.parallelDepth = 0;
+	if(parallel) {
+		for(uint32_t threads = std::max(1u, std::thread::hardware_concurrency()); threads > 1; threads >>= 1) {
+			++context.parallelDepth;
+		}
+		++context.parallelDepth;
+	}
+	const uint32_t chunkCount = parallel ? ParallelFor::getChunkCount(triangleCount, minParallelSubtreeSize) : 1;
+	ParallelFor::forEachChunk(triangleCount, chunkCount, [&](uint32_t, std::size_t chunkBegin, std::size_t chunkEnd) {
+		for(std::size_t t = chunkBegin; t < chunkEnd; ++t) {
+			BuildTriangle & triangle = context.triangles[t];
+			const float * vertices = coordinates.data() + t * 9;
+			resetBounds(triangle.min, triangle.max);
+			for(uint_fast8_t v = 0; v < 3; ++v) {
+				includeBounds(triangle.min, triangle.max, vertices + v * 3, vertices + v * 3);
+			}
+			for(uint_fast8_t a = 0; a < 3; ++a) {
+				triangle.centroid[a] = (triangle.min[a] + triangle.max[a]) * 0.5f;
+			}
+			context.order[t] = static_cast<uint32_t>(t);
+		}
+	});
+
+	nodes.clear();
+	if(triangleCount > 0) {
+		nodes.reserve(2 * (triangleCount / 2 + 1));
+		buildNode(context, 0, triangleCount, 0, nodes);
+	}
+	nodes.shrink_to_fit();
+
+	triangleIndices.swap(context.order);
+	triangleVertices.resize(coordinates.size());
+	for(uint32_t i = 0; i < triangleCount; ++i) {
+		std::copy(coordinates.begin() + triangleIndices[i] * 9, coordinates.begin() + triangleIndices[i] * 9 + 9, triangleVertices.begin() + i * 9);
+	}
+}
+
+void TriangleBVH::refit(Mesh * mesh) {
+	const std::vector<float> coordinates = readMeshTriangles(mesh);
+	if(coordinates.size() != triangleVertices.size()) {
+		throw std::invalid_argument("TriangleBVH::refit: The number of triangles has changed.");
+	}
+	for(std::size_t i = 0; i < triangleIndices.size(); ++i) {
+		std::copy(coordinates.begin() + triangleIndices[i] * 9, coordinates.begin() + triangleIndices[i] * 9 + 9, triangleVertices.begin() + i * 9);
+	}
+	updateBounds();
+}
+
+void TriangleBVH::updateBounds() {
+	// children are stored behind their parent
+	for(std::size_t i = nodes.size(); i-- > 0;) {
+		Node & node = nodes[i];
+		resetBounds(node.min, node.max);
+		if(node.isLeaf()) {
+			const float * vertex = triangleVertices.data() + static_cast<std::size_t>(node.offset) * 9;
+			for(uint32_t v = 0; v < node.triangleCount * 3u; ++v, vertex += 3) {
+				includeBounds(node.min, node.max, vertex, vertex);
+			}
+		} else {
+			includeBounds(node.min, node.max, nodes[i + 1].min, nodes[i + 1].max);
+			includeBounds(node.min, node.max, nodes[node.offset].min, nodes[node.offset].max);
+		}
+	}
+}
+
+Geometry::Box TriangleBVH::getBounds() const {
+	if(nodes.empty()) {
+		Geometry::Box box;
+		box.invalidate();
+		return box;
+	}
+	const Node & root = nodes.front();
+	return Geometry::Box(Geometry::Vec3(root.min[0], root.min[1], root.min[2]), Geometry::Vec3(root.max[0], root.max[1], root.max[2]));
+}
+
+// ------------------------------------------------------------------------------------------
+// ray queries
+
+//! (internal)
+struct PreparedRay {
+	float origin[3];
+	float direction[3];
+	float inverseDirection[3];
+};
+
+//! (internal)
+static inline PreparedRay prepareRay(const Geometry::Ray3 & ray) {
+	PreparedRay r;
+	for(uint_fast8_t a = 0; a < 3; ++a) {
+		r.origin[a] = ray.getOrigin()[a];
+		r.direction[a] = ray.getDirection()[a];
+		// avoid infinities (and NaNs for origins on a slab) for axis-parallel rays
+		const float d = r.direction[a] != 0.0f ? r.direction[a] : 1.0e-30f;
+		r.inverseDirection[a] = 1.0f / d;
+	}
+	return r;
+}
+
+//! (internal) Slab test; @a tNear is set to the entry parameter.
+static inline bool intersectBox(const TriangleBVH::Node & node, const PreparedRay & r, float maxT, float & tNear) {
+	float tMin = 0.0f;
+	float tMax = maxT;
+	for(uint_fast8_t a = 0; a < 3; ++a) {
+		const float t1 = (node.min[a] - r.origin[a]) * r.inverseDirection[a];
+		const float t2 = (node.max[a] - r.origin[a]) * r.inverseDirection[a];
+		tMin = std::max(tMin, std::min(t1, t2));
+		tMax = std::min(tMax, std::max(t1, t2));
+	}
+	tNear = tMin;
+	return tMin <= tMax;
+}
+
+//! (internal) Möller-Trumbore ray triangle intersection for a hit in [0, maxT].
+static inline bool intersectTriangle(const float * vertices, const float * origin, const float * direction, float maxT, float & t, float & u, float & v) {
+	const float e1[3] = {vertices[3] - vertices[0], vertices[4] - vertices[1], vertices[5] - vertices[2]};
+	const float e2[3] = {vertices[6] - vertices[0], vertices[7] - vertices[1], vertices[8] - vertices[2]};
+	const float p[3] = {direction[1] * e2[2] - direction[2] * e2[1],
+						direction[2] * e2[0] - direction[0] * e2[2],
+						direction[0] * e2[1] - direction[1] * e2[0]};
+	const float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+	if(det == 0.0f) {
+		return false;
+	}
+	const float inverseDet = 1.0f / det;
+	const float s[3] = {origin[0] - vertices[0], origin[1] - vertices[1], origin[2] - vertices[2]};
+	u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inverseDet;
+	if(u < 0.0f || u > 1.0f) {
+		return false;
+	}
+	const float q[3] = {s[1] * e1[2] - s[2] * e1[1],
+						s[2] * e1[0] - s[0] * e1[2],
+						s[0] * e1[1] - s[1] * e1[0]};
+	v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) * inverseDet;
+	if(v < 0.0f || u + v > 1.0f) {
+		return false;
+	}
+	t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inverseDet;
+	return t >= 0.0f && t <= maxT;
+}
+
+template<bool anyHit>
+bool TriangleBVH::traceRay(const Geometry::Ray3 & ray, RayHit & hit, float maxT) const {
+	if(nodes.empty()) {
+		return false;
+	}
+	const PreparedRay r = prepareRay(ray);
+	float tNear;
+	if(!intersectBox(nodes.front(), r, maxT, tNear)) {
+		return false;
+	}
+	std::pair<uint32_t, float> stack[traversalStackSize];
+	uint32_t stackSize = 0;
+	uint32_t current = 0;
+	bool found = false;
+	while(true) {
+		const Node & node = nodes[current];
+		if(node.isLeaf()) {
+			for(uint32_t i = node.offset; i < node.offset + node.triangleCount; ++i) {
+				float t, u, v;
+				if(intersectTriangle(triangleVertices.data() + static_cast<std::size_t>(i) * 9, r.origin, r.direction, maxT, t, u, v)) {
+					found = true;
+					maxT = t;
+					hit.triangleIndex = triangleIndices[i];
+					hit.t = t;
+					hit.u = u;
+					hit.v = v;
+					if(anyHit) {
+						return true;
+					}
+				}
+			}
+		} else {
+			uint32_t first = current + 1;
+			uint32_t second = node.offset;
+			float tFirst, tSecond;
+			const bool hitFirst = intersectBox(nodes[first], r, maxT, tFirst);
+			const bool hitSecond = intersectBox(nodes[second], r, maxT, tSecond);
+			if(hitFirst && hitSecond) {
+				if(tSecond < tFirst) {
+					std::swap(first, second);
+					std::swap(tFirst, tSecond);
+				}
+				stack[stackSize++] = std::make_pair(second, tSecond);
+				current = first;
+				continue;
+			} else if(hitFirst) {
+				current = first;
+				continue;
+			} else if(hitSecond) {
+				current = second;
+				continue;
+			}
+		}
+		// skip nodes behind the closest hit found so far
+		do {
+			if(stackSize == 0) {
+				return found;
+			}
+			--stackSize;
+		} while(stack[stackSize].second > maxT);
+		current = stack[stackSize].first;
+	}
+}
+
+bool TriangleBVH::getClosestHit(const Geometry::Ray3 & ray, RayHit & hit, float maxT) const {
+	return traceRay<false>(ray, hit, maxT);
+}
+
+bool TriangleBVH::isHit(const Geometry::Ray3 & ray, float maxT) const {
+	RayHit hit;
+	return traceRay<true>(ray, hit, maxT);
+}
+
+//! (internal) Four rays in structure of arrays layout.
+struct RayPacket {
+	float origin[3][4];
+	float direction[3][4];
+	float inverseDirection[3][4];
+	//! Unused lanes and lanes that need no further traversal have a negative maximum.
+	float maxT[4];
+};
+
+//! (internal) Test the node against all rays of the packet; returns a bit mask of the rays hitting the node.
+static inline uint32_t intersectBox(const TriangleBVH::Node & node, const RayPacket & packet) {
+#if defined(RENDERING_BVH_SSE)
+	__m128 tMin = _mm_setzero_ps();
+	__m128 tMax = _mm_loadu_ps(packet.maxT);
+	for(uint_fast8_t a = 0; a < 3; ++a) {
+		const __m128 origin = _mm_loadu_ps(packet.origin[a]);
+		const __m128 inverseDirection = _mm_loadu_ps(packet.inverseDirection[a]);
+		const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min[a]), origin), inverseDirection);
+		const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max[a]), origin), inverseDirection);
+		tMin = _mm_max_ps(tMin, _mm_min_ps(t1, t2));
+		tMax = _mm_min_ps(tMax, _mm_max_ps(t1, t2));
+	}
+	return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tMin, tMax)));
+#else
+	uint32_t mask = 0;
+	for(uint_fast8_t lane = 0; lane < 4; ++lane) {
+		float tMin = 0.0f;
+		float tMax = packet.maxT[lane];
+		for(uint_fast8_t a = 0; a < 3; ++a) {
+			const float t1 = (node.min[a] - packet.origin[a][lane]) * packet.inverseDirection[a][lane];
+			const float t2 = (node.max[a] - packet.origin[a][lane]) * packet.inverseDirection[a][lane];
+			tMin = std::max(tMin, std::min(t1, t2));
+			tMax = std::min(tMax, std::max(t1, t2));
+		}
+		if(tMin <= tMax) {
+			mask |= 1u << lane;
+		}
+	}
+	return mask;
+#endif
+}
+
+template<bool anyHit>
+void TriangleBVH::tracePacket(const Geometry::Ray3 * rays, uint32_t count, RayHit * hits, float maxT) const {
+	RayPacket packet;
+	for(uint_fast8_t lane = 0; lane < 4; ++lane) {
+		const PreparedRay r = prepareRay(rays[std::min<uint32_t>(lane, count - 1)]);
+		for(uint_fast8_t a = 0; a < 3; ++a) {
+			packet.origin[a][lane] = r.origin[a];
+			packet.direction[a][lane] = r.direction[a];
+			packet.inverseDirection[a][lane] = r.inverseDirection[a];
+		}
+		packet.maxT[lane] = lane < count ? maxT : -1.0f;
+	}
+	if(nodes.empty()) {
+		return;
+	}
+	uint32_t stack[traversalStackSize];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while(stackSize > 0) {
+		const Node & node = nodes[stack[--stackSize]];
+		const uint32_t mask = intersectBox(node, packet);
+		if(mask == 0) {
+			continue;
+		}
+		if(node.isLeaf()) {
+			for(uint32_t lane = 0; lane < 4; ++lane) {
+				if((mask & (1u << lane)) == 0) {
+					continue;
+				}
+				const float origin[3] = {packet.origin[0][lane], packet.origin[1][lane], packet.origin[2][lane]};
+				const float direction[3] = {packet.direction[0][lane], packet.direction[1][lane], packet.direction[2][lane]};
+				for(uint32_t i = node.offset; i < node.offset + node.triangleCount; ++i) {
+					float t, u, v;
+					if(intersectTriangle(triangleVertices.data() + static_cast<std::size_t>(i) * 9, origin, direction, packet.maxT[lane], t, u, v)) {
+						RayHit & hit = hits[lane];
+						hit.triangleIndex = triangleIndices[i];
+						hit.t = t;
+						hit.u = u;
+						hit.v = v;
+						if(anyHit) {
+							packet.maxT[lane] = -1.0f;
+							break;
+						}
+						packet.maxT[lane] = t;
+					}
+				}
+			}
+		} else {
+			// the rays of a packet are assumed to be coherent: the order is chosen by the first ray
+			if(packet.direction[node.splitAxis][0] < 0.0f) {
+				stack[stackSize++] = static_cast<uint32_t>(&node - nodes.data()) + 1;
+				stack[stackSize++] = node.offset;
+			} else {
+				stack[stackSize++] = node.offset;
+				stack[stackSize++] = static_cast<uint32_t>(&node - nodes.data()) + 1;
+			}
+		}
+	}
+}
+
+//! (internal)
+static const uint32_t minRaysPerChunk = 256;
+
+void TriangleBVH::getClosestHits(const std::vector<Geometry::Ray3> & rays, std::vector<RayHit> & hits, float maxT, bool parallel) const {
+	RayHit noHit;
+	noHit.triangleIndex = NO_HIT;
+	noHit.t = std::numeric_limits<float>::infinity();
+	noHit.u = noHit.v = 0.0f;
+	hits.assign(rays.size(), noHit);
+
+	const std::size_t packetCount = (rays.size() + 3) / 4;
+	const uint32_t chunkCount = parallel ? ParallelFor::getChunkCount(packetCount, minRaysPerChunk / 4) : 1;
+	ParallelFor::forEachChunk(packetCount, chunkCount, [&](uint32_t, std::size_t begin, std::size_t end) {
+		for(std::size_t p = begin; p < end; ++p) {
+			tracePacket<false>(rays.data() + p * 4, static_cast<uint32_t>(std::min<std::size_t>(4, rays.size() - p * 4)), hits.data() + p * 4, maxT);
+		}
+	});
+}
+
+void TriangleBVH::getAnyHits(const std::vector<Geometry::Ray3> & rays, std::vector<bool> & hits, float maxT, bool parallel) const {
+	RayHit noHit;
+	noHit.triangleIndex = NO_HIT;
+	noHit.t = std::numeric_limits<float>::infinity();
+	noHit.u = noHit.v = 0.0f;
+	std::vector<RayHit> rayHits(rays.size(), noHit);
+
+	const std::size_t packetCount = (rays.size() + 3) / 4;
+	const uint32_t chunkCount = parallel ? ParallelFor::getChunkCount(packetCount, minRaysPerChunk / 4) : 1;
+	ParallelFor::forEachChunk(packetCount, chunkCount, [&](uint32_t, std::size_t begin, std::size_t end) {
+		for(std::size_t p = begin; p < end; ++p) {
+			tracePacket<true>(rays.data() + p * 4, static_cast<uint32_t>(std::min<std::size_t>(4, rays.size() - p * 4)), rayHits.data() + p * 4, maxT);
+		}
+	});
+
+	hits.resize(rays.size());
+	for(std::size_t i = 0; i < rays.size(); ++i) {
+		hits[i] = rayHits[i].triangleIndex != NO_HIT;
+	}
+}
+
+// ------------------------------------------------------------------------------------------
+// volume queries
+
+//! (internal) Separating axis test of a triangle and an axis-aligned box given by its center and its half extents.
+static bool intersectTriangleBox(const float * vertices, const float * center, const float * halfSize) {
+	float v[3][3];
+	for(uint_fast8_t i = 0; i < 3; ++i) {
+		for(uint_fast8_t a = 0; a < 3; ++a) {
+			v[i][a] = vertices[i * 3 + a] - center[a];
+		}
+	}
+	// box face normals
+	for(uint_fast8_t a = 0; a < 3; ++a) {
+		if(std::min(std::min(v[0][a], v[1][a]), v[2][a]) > halfSize[a] || std::max(std::max(v[0][a], v[1][a]), v[2][a]) < -halfSize[a]) {
+			return false;
+		}
+	}
+	float edges[3][3];
+	for(uint_fast8_t a = 0; a < 3; ++a) {
+		edges[0][a] = v[1][a] - v[0][a];
+		edges[1][a] = v[2][a] - v[1][a];
+		edges[2][a] = v[0][a] - v[2][a];
+	}
+	// cross products of the box axes and the triangle edges
+	for(uint_fast8_t e = 0; e < 3; ++e) {
+		const float * edge = edges[e];
+		const float axes[3][3] = {{0.0f, -edge[2], edge[1]}, {edge[2], 0.0f, -edge[0]}, {-edge[1], edge[0], 0.0f}};
+		for(const auto & axis : axes) {
+			const float p0 = axis[0] * v[0][0] + axis[1] * v[0][1] + axis[2] * v[0][2];
+			const float p1 = axis[0] * v[1][0] + axis[1] * v[1][1] + axis[2] * v[1][2];
+			const float p2 = axis[0] * v[2][0] + axis[1] * v[2][1] + axis[2] * v[2][2];
+			const float r = halfSize[0] * std::abs(axis[0]) + halfSize[1] * std::abs(axis[1]) + halfSize[2] * std::abs(axis[2]);
+			if(std::min(std::min(p0, p1), p2) > r || std::max(std::max(p0, p1), p2) < -r) {
+				return false;
+			}
+		}
+	}
+	// triangle plane
+	const float normal[3] = {edges[0][1] * edges[1][2] - edges[0][2] * edges[1][1],
+							 edges[0][2] * edges[1][0] - edges[0][0] * edges[1][2],
+							 edges[0][0] * edges[1][1] - edges[0][1] * edges[1][0]};
+	const float distance = normal[0] * v[0][0] + normal[1] * v[0][1] + normal[2] * v[0][2];
+	const float r = halfSize[0] * std::abs(normal[0]) + halfSize[1] * std::abs(normal[1]) + halfSize[2] * std::abs(normal[2]);
+	return std::abs(distance) <= r;
+}
+
+//! (internal) Squared distance between a point and a box given by its corners.
+static inline float getSquaredDistance(const TriangleBVH::Node & node, const float * point) {
+	float squaredDistance = 0.0f;
+	for(uint_fast8_t axis = 0; axis < 3; ++axis) {
+		const float d = std::max(std::max(node.min[axis] - point[axis], point[axis] - node.max[axis]), 0.0f);
+		squaredDistance += d * d;
+	}
+	return squaredDistance;
+}
+
+//! (internal) Squared distance between a point and a triangle (closest point computation by Ericson, Real-Time Collision Detection, 5.1.5).
+static float getSquaredDistanceToTriangle(const float * vertices, const float * point) {
+	const Geometry::Vec3 a(vertices[0], vertices[1], vertices[2]);
+	const Geometry::Vec3 b(vertices[3], vertices[4], vertices[5]);
+	const Geometry::Vec3 c(vertices[6], vertices[7], vertices[8]);
+	const Geometry::Vec3 p(point[0], point[1], point[2]);
+	const Geometry::Vec3 ab = b - a;
+	const Geometry::Vec3 ac = c - a;
+	const Geometry::Vec3 ap = p - a;
+	Geometry::Vec3 closest;
+	const float d1 = ab.dot(ap);
+	const float d2 = ac.dot(ap);
+	const Geometry::Vec3 bp = p - b;
+	const float d3 = ab.dot(bp);
+	const float d4 = ac.dot(bp);
+	const Geometry::Vec3 cp = p - c;
+	const float d5 = ab.dot(cp);
+	const float d6 = ac.dot(cp);
+	const float va = d3 * d6 - d5 * d4;
+	const float vb = d5 * d2 - d1 * d6;
+	const float vc = d1 * d4 - d3 * d2;
+	if(d1 <= 0.0f && d2 <= 0.0f) {
+		closest = a;
+	} else if(d3 >= 0.0f && d4 <= d3) {
+		closest = b;
+	} else if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+		closest = a + ab * (d1 / (d1 - d3));
+	} else if(d6 >= 0.0f && d5 <= d6) {
+		closest = c;
+	} else if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+		closest = a + ac * (d2 / (d2 - d6));
+	} else if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+		closest = b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	} else {
+		const float sum = va + vb + vc;
+		if(sum <= 0.0f) {
+			// degenerate triangle whose vertices are not handled by the cases above
+			closest = a;
+		} else {
+			closest = a + ab * (vb / sum) + ac * (vc / sum);
+		}
+	}
+	const Geometry::Vec3 difference = p - closest;
+	return difference.dot(difference);
+}
+
+uint32_t TriangleBVH::getClosestTriangle(const Geometry::Vec3 & point, float & distance, float maxDistance) const {
+	if(nodes.empty()) {
+		return NO_HIT;
+	}
+	const float p[3] = {point.getX(), point.getY(), point.getZ()};
+	float bestSquaredDistance = maxDistance * maxDistance;
+	uint32_t bestTriangle = NO_HIT;
+
+	std::pair<uint32_t, float> stack[traversalStackSize];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = std::make_pair(0u, getSquaredDistance(nodes.front(), p));
+	while(stackSize > 0) {
+		--stackSize;
+		if(stack[stackSize].second > bestSquaredDistance) {
+			continue;
+		}
+		const uint32_t nodeIndex = stack[stackSize].first;
+		const Node & node = nodes[nodeIndex];
+		if(node.isLeaf()) {
+			for(uint32_t i = node.offset; i < node.offset + node.triangleCount; ++i) {
+				const float squaredDistance = getSquaredDistanceToTriangle(triangleVertices.data() + static_cast<std::size_t>(i) * 9, p);
+				if(squaredDistance <= bestSquaredDistance) {
+					bestSquaredDistance = squaredDistance;
+					bestTriangle = triangleIndices[i];
+				}
+			}
+		} else {
+			// push the farther child first, so that the nearer one is visited next
+			std::pair<uint32_t, float> first(nodeIndex + 1, getSquaredDistance(nodes[nodeIndex + 1], p));
+			std::pair<uint32_t, float> second(node.offset, getSquaredDistance(nodes[node.offset], p));
+			if(second.second < first.second) {
+				std::swap(first, second);
+			}
+			if(second.second <= bestSquaredDistance) {
+				stack[stackSize++] = second;
+			}
+			if(first.second <= bestSquaredDistance) {
+				stack[stackSize++] = first;
+			}
+		}
+	}
+	if(bestTriangle != NO_HIT) {
+		distance = std::sqrt(bestSquaredDistance);
+	}
+	return bestTriangle;
+}
+
+std::vector<uint32_t> TriangleBVH::getTrianglesIntersectingBox(const Geometry::Box & box) const {
+	std::vector<uint32_t> result;
+	if(nodes.empty()) {
+		return result;
+	}
+	const float boxMin[3] = {box.getMinX(), box.getMinY(), box.getMinZ()};
+	const float boxMax[3] = {box.getMaxX(), box.getMaxY(), box.getMaxZ()};
+	const float center[3] = {(boxMin[0] + boxMax[0]) * 0.5f, (boxMin[1] + boxMax[1]) * 0.5f, (boxMin[2] + boxMax[2]) * 0.5f};
+	const float halfSize[3] = {(boxMax[0] - boxMin[0]) * 0.5f, (boxMax[1] - boxMin[1]) * 0.5f, (boxMax[2] - boxMin[2]) * 0.5f};
+
+	uint32_t stack[traversalStackSize];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while(stackSize > 0) {
+		const uint32_t nodeIndex = stack[--stackSize];
+		const Node & node = nodes[nodeIndex];
+		if(node.min[0] > boxMax[0] || node.max[0] < boxMin[0] ||
+				node.min[1] > boxMax[1] || node.max[1] < boxMin[1] ||
+				node.min[2] > boxMax[2] || node.max[2] < boxMin[2]) {
+			continue;
+		}
+		if(node.isLeaf()) {
+			for(uint32_t i = node.offset; i < node.offset + node.triangleCount; ++i) {
+				if(intersectTriangleBox(triangleVertices.data() + static_cast<std::size_t>(i) * 9, center, halfSize)) {
+					result.push_back(triangleIndices[i]);
+				}
+			}
+		} else {
+			stack[stackSize++] = node.offset;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+	}
+	return result;
+}
+
+std::vector<uint32_t> TriangleBVH::getTrianglesIntersectingFrustum(const Geometry::Frustum & frustum) const {
+	std::vector<uint32_t> result;
+	if(nodes.empty()) {
+		return result;
+	}
+	uint32_t stack[traversalStackSize];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while(stackSize > 0) {
+		const uint32_t nodeIndex = stack[--stackSize];
+		const Node & node = nodes[nodeIndex];
+		const Geometry::Box nodeBox(Geometry::Vec3(node.min[0], node.min[1], node.min[2]), Geometry::Vec3(node.max[0], node.max[1], node.max[2]));
+		const Geometry::Frustum::intersection_t intersection = frustum.isBoxInFrustum(nodeBox);
+		if(intersection == Geometry::Frustum::OUTSIDE) {
+			continue;
+		} else if(intersection == Geometry::Frustum::INSIDE) {
+			// the triangles of a subtree are stored contiguously: from its leftmost to its rightmost leaf
+			uint32_t first = nodeIndex;
+			while(!nodes[first].isLeaf()) {
+				++first;
+			}
+			uint32_t last = nodeIndex;
+			while(!nodes[last].isLeaf()) {
+				last = nodes[last].offset;
+			}
+			result.insert(result.end(), triangleIndices.begin() + nodes[first].offset, triangleIndices.begin() + nodes[last].offset + nodes[last].triangleCount);
+		} else if(node.isLeaf()) {
+			for(uint32_t i = node.offset; i < node.offset + node.triangleCount; ++i) {
+				const float * v = triangleVertices.data() + static_cast<std::size_t>(i) * 9;
+				const Geometry::Box triangleBox(Geometry::Vec3(std::min(std::min(v[0], v[3]), v[6]), std::min(std::min(v[1], v[4]), v[7]), std::min(std::min(v[2], v[5]), v[8])),
+												Geometry::Vec3(std::max(std::max(v[0], v[3]), v[6]), std::max(std::max(v[1], v[4]), v[7]), std::max(std::max(v[2], v[5]), v[8])));
+				if(frustum.isBoxInFrustum(triangleBox) != Geometry::Frustum::OUTSIDE) {
+					result.push_back(triangleIndices[i]);
+				}
+			}
+		} else {
+			stack[stackSize++] = node.offset;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+	}
+	return result;
+}
+
+}
+}
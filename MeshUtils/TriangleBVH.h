@@ -0,0 +1,144 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_TRIANGLEBVH_H_
+#define RENDERING_TRIANGLEBVH_H_
+
+#include <Util/ReferenceCounter.h>
+#include <Util/References.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Box;
+typedef _Box<float> Box;
+class Frustum;
+template<typename _T> class _Vec3;
+typedef _Vec3<float> Vec3;
+template<typename _T> class _Ray;
+typedef _Ray<Vec3> Ray3;
+}
+
+namespace Rendering {
+class Mesh;
+namespace MeshUtils {
+
+/**
+ * Bounding volume hierarchy over the triangles of a mesh for ray, box and frustum queries.
+ *
+ * The hierarchy is built top-down using the surface area heuristic and stored as a
+ * flat array of nodes in depth-first order. The triangle positions are copied into
+ * the hierarchy, so queries neither access the mesh nor use attribute accessors.
+ * After the vertex positions of the mesh have been changed (e.g. by MeshUtils::transform),
+ * the hierarchy can be adapted by refit(...) without rebuilding it.
+ *
+ * Triangles are identified by their index in the mesh (i.e. the first index of the triangle divided by three).
+ * All query functions are const and may be called from several threads concurrently.
+ */
+class TriangleBVH : public Util::ReferenceCounter<TriangleBVH> {
+	public:
+		//! Result of a ray query.
+		struct RayHit {
+			//! Index of the hit triangle or NO_HIT.
+			uint32_t triangleIndex;
+			//! Ray parameter of the hit point (origin + t * direction).
+			float t;
+			//! Barycentric coordinates of the hit point with respect to the second and third vertex.
+			float u, v;
+		};
+		static const uint32_t NO_HIT = 0xffffffff;
+
+		/*! (static factory)
+			Build a hierarchy for the given triangle mesh.
+			@param parallel If true, large subtrees are built by several threads.
+			If the mesh does not consist of indexed triangles, an std::invalid_argument exception is thrown. */
+		static Util::Reference<TriangleBVH> create(Mesh * mesh, bool parallel = false);
+
+		~TriangleBVH();
+
+		/*! Update the bounding volumes after the vertex positions of @a mesh have changed.
+			The index data of the mesh must not have changed since the hierarchy was built;
+			otherwise, an std::invalid_argument exception is thrown. */
+		void refit(Mesh * mesh);
+
+		/*! Find the closest triangle hit by @a ray with a ray parameter in [0, maxT].
+			@return true iff a triangle was hit; @a hit is only changed in that case. */
+		bool getClosestHit(const Geometry::Ray3 & ray, RayHit & hit, float maxT = std::numeric_limits<float>::infinity()) const;
+
+		//! Return true iff any triangle is hit by @a ray with a ray parameter in [0, maxT] (e.g. for shadow or visibility tests).
+		bool isHit(const Geometry::Ray3 & ray, float maxT = std::numeric_limits<float>::infinity()) const;
+
+		/*! Batched version of getClosestHit(...). The rays are traced in packets of four,
+			which is considerably faster for coherent rays (e.g. for picking in a screen region).
+			@param hits Resized to the number of rays; rays without hit get the triangleIndex NO_HIT.
+			@param parallel If true, large batches are distributed over several threads. */
+		void getClosestHits(const std::vector<Geometry::Ray3> & rays, std::vector<RayHit> & hits,
+							float maxT = std::numeric_limits<float>::infinity(), bool parallel = false) const;
+
+		//! Batched version of isHit(...); see getClosestHits(...).
+		void getAnyHits(const std::vector<Geometry::Ray3> & rays, std::vector<bool> & hits,
+						float maxT = std::numeric_limits<float>::infinity(), bool parallel = false) const;
+
+		/*! Find the triangle closest to @a point within a distance of at most @a maxDistance.
+			@param distance Set to the distance between @a point and the closest triangle if one is found.
+			@return Index of the closest triangle or NO_HIT. */
+		uint32_t getClosestTriangle(const Geometry::Vec3 & point, float & distance,
+									float maxDistance = std::numeric_limits<float>::infinity()) const;
+
+		//! Return the indices of all triangles intersecting the given box (in no particular order).
+		std::vector<uint32_t> getTrianglesIntersectingBox(const Geometry::Box & box) const;
+
+		/*! Return the indices of all triangles whose bounding box is not outside of the frustum (in no particular order).
+			The test is conservative: triangles close to the frustum may be reported although they are outside. */
+		std::vector<uint32_t> getTrianglesIntersectingFrustum(const Geometry::Frustum & frustum) const;
+
+		//! Bounding box of all triangles.
+		Geometry::Box getBounds() const;
+		uint32_t getTriangleCount() const					{	return static_cast<uint32_t>(triangleIndices.size());	}
+		uint32_t getNodeCount() const						{	return static_cast<uint32_t>(nodes.size());	}
+
+		//! (internal) Node of the hierarchy; the first child of an inner node directly follows its parent.
+		struct Node {
+			float min[3];
+			float max[3];
+			//! Leaf: position of the first triangle. Inner node: index of the second child.
+			uint32_t offset;
+			//! Number of triangles of a leaf; zero for inner nodes.
+			uint16_t triangleCount;
+			//! Axis along which the children of an inner node are separated.
+			uint16_t splitAxis;
+
+			bool isLeaf() const	{	return triangleCount != 0;	}
+		};
+
+	private:
+		TriangleBVH();
+
+		void build(Mesh * mesh, bool parallel);
+		void updateBounds();
+
+		template<bool anyHit>
+		bool traceRay(const Geometry::Ray3 & ray, RayHit & hit, float maxT) const;
+		template<bool anyHit>
+		void tracePacket(const Geometry::Ray3 * rays, uint32_t count, RayHit * hits, float maxT) const;
+
+		std::vector<Node> nodes;
+		//! Mesh triangle index for every triangle position in the hierarchy.
+		std::vector<uint32_t> triangleIndices;
+		//! Nine coordinates per triangle, ordered like triangleIndices.
+		std::vector<float> triangleVertices;
+};
+
+}
+}
+
+#endif /* RENDERING_TRIANGLEBVH_H_ */
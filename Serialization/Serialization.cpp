@@ -95,6 +95,17 @@ Mesh * loadMesh(const Util::FileName & url) {
 	return mesh.detachAndDecrease();
 }
 
+Mesh * loadMeshMapped(const Util::FileName & url) {
+	if(url.getFSName() == "file" && (StreamerMMF::queryCapabilities(url.getEnding()) & AbstractRenderingStreamer::CAP_LOAD_MESH) != 0) {
+		Util::Reference<Mesh> mesh = StreamerMMF::loadMeshMapped(url.getPath());
+		if(mesh.isNotNull()) {
+			mesh->setFileName(url);
+			return mesh.detachAndDecrease();
+		}
+	}
+	return loadMesh(url);
+}
+
 Mesh * loadMesh(const std::string & extension, const std::string & data) {
 	std::unique_ptr<AbstractRenderingStreamer> loader(createStreamer(extension, AbstractRenderingStreamer::CAP_LOAD_MESH));
 	if(loader.get() == nullptr) {
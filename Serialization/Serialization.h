@@ -68,6 +68,18 @@ extern const Util::StringIdentifier DESCRIPTION_MATERIAL_SHININESS;
  */
 Mesh * loadMesh(const Util::FileName & url);
 
+/**
+ * Load a single mesh from the given address, keeping its vertex and index data in a
+ * read-only memory mapped region of the file instead of copying it (see ExternalMeshBuffer).
+ * The data is copied when the mesh is modified.
+ * If the file cannot be mapped (unsupported file type, not a local file, or
+ * memory mapping not available), the mesh is loaded using loadMesh(url).
+ *
+ * @param file Address to the file containing the mesh data
+ * @return A single mesh
+ */
+Mesh * loadMeshMapped(const Util::FileName & url);
+
 /**
  * Create a single mesh from the given data.
  * The type of the mesh has to be given as parameter.
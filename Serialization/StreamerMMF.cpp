@@ -10,11 +10,21 @@
 */
 #include "StreamerMMF.h"
 #include "Serialization.h"
+#include "../GLHeader.h"
+#include "../Mesh/ExternalMeshBuffer.h"
 #include "../Mesh/Mesh.h"
 #include "../Mesh/VertexAttributeIds.h"
 #include "../Mesh/VertexDescription.h"
+#include <Geometry/Box.h>
 #include <Util/GenericAttribute.h>
+#include <Util/References.h>
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
 #include <vector>
 
 /// \todo Show compile error when using a machine without LITTLE-ENDIANness
@@ -24,6 +34,36 @@ namespace Rendering {
 
 const char * const StreamerMMF::fileExtension = "mmf";
 
+namespace {
+//! (internal) Read-only stream buffer working directly on a memory block (without copying it).
+class MemoryStreamBuffer : public std::streambuf {
+	public:
+		MemoryStreamBuffer(const uint8_t * data, std::size_t size) {
+			char * begin = const_cast<char *>(reinterpret_cast<const char *>(data));
+			setg(begin, begin, begin + size);
+		}
+	protected:
+		pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+			if((which & std::ios_base::in) == 0)
+				return pos_type(off_type(-1));
+			off_type base = 0;
+			if(dir == std::ios_base::cur) {
+				base = gptr() - eback();
+			} else if(dir == std::ios_base::end) {
+				base = egptr() - eback();
+			}
+			const off_type newPos = base + offset;
+			if(newPos < 0 || newPos > egptr() - eback())
+				return pos_type(off_type(-1));
+			setg(eback(), eback() + newPos, egptr());
+			return pos_type(newPos);
+		}
+		pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+			return seekoff(off_type(pos), std::ios_base::beg, which);
+		}
+};
+}
+
 uint32_t StreamerMMF::Reader::read_uint32() {
 	uint32_t x;
 	in.read(reinterpret_cast<char *> (&x), 4);
@@ -35,7 +75,7 @@ void StreamerMMF::Reader::read(uint8_t * data,size_t count) {
 }
 
 void StreamerMMF::Reader::skip(uint32_t size) {
-	in.seekg(std::ios_base::cur+size);
+	in.seekg(size, std::ios_base::cur);
 }
 
 //!	(static)
@@ -43,7 +83,28 @@ Mesh * StreamerMMF::loadMesh(std::istream & input) {
 
 //	std::cout << "\nloadMMF...";
 	Reader reader(input);
+	return readMesh(reader, nullptr);
+}
 
+//!	(static)
+Mesh * StreamerMMF::loadMeshMapped(const std::string & path) {
+	const auto mappedFile = ExternalMeshBuffer::mapFile(path);
+	if(!mappedFile)
+		return nullptr;
+	MemoryStreamBuffer buffer(mappedFile->data(), mappedFile->size());
+	std::istream input(&buffer);
+	Reader reader(input);
+	try {
+		return readMesh(reader, mappedFile);
+	} catch(const std::exception & e) {
+		WARN(std::string("LoaderMMF::loadMeshMapped: ") + e.what());
+		return nullptr;
+	}
+}
+
+//!	(internal,static)
+Mesh * StreamerMMF::readMesh(Reader & reader, const std::shared_ptr<ExternalMeshBuffer> & mappedFile) {
+	std::istream & input = reader.in;
 	uint32_t format = reader.read_uint32();
 	if(format!=MMF_HEADER)    {
 		WARN(std::string("wrong mesh format: ") + Util::StringUtils::toString(format));
@@ -55,17 +116,30 @@ Mesh * StreamerMMF::loadMesh(std::istream & input) {
 		return nullptr;
 	}
 
-	auto mesh = new Mesh;
+	Util::Reference<Mesh> mesh = new Mesh;
+	bool hasIndexRange = false;
+	uint32_t minIndex = 0;
+	uint32_t maxIndex = 0;
 	uint32_t blockType = reader.read_uint32();
 	while(blockType != StreamerMMF::MMF_END && input.good()) {
 		// blocksize is discarded.
 		uint32_t blockSize = reader.read_uint32();
 		switch(blockType) {
 			case StreamerMMF::MMF_VERTEX_DATA:
-				readVertexData(mesh, reader);
+				readVertexData(mesh.get(), reader, mappedFile);
 				break;
 			case StreamerMMF::MMF_INDEX_DATA:
-				readIndexData(mesh, reader);
+				readIndexData(mesh.get(), reader, mappedFile);
+				break;
+			case StreamerMMF::MMF_INDEX_RANGE:
+				if(blockSize != 2 * sizeof(uint32_t)) {
+					WARN("LoaderMMF::loadMesh: invalid index range block found.");
+					reader.skip(blockSize);
+					break;
+				}
+				minIndex = reader.read_uint32();
+				maxIndex = reader.read_uint32();
+				hasIndexRange = true;
 				break;
 			default:
 				WARN("LoaderMMF::loadMesh: unknown data block found.");
@@ -76,15 +150,27 @@ Mesh * StreamerMMF::loadMesh(std::istream & input) {
 		blockType = reader.read_uint32();
 	}
 
+	// Use the stored index range if available; for mapped files, this avoids touching every page of the index data.
+	if(mesh->isUsingIndexData()) {
+		MeshIndexData & indices = mesh->openIndexData();
+		if(hasIndexRange && indices.hasExternalData()) {
+			indices._setIndexRange(minIndex, maxIndex);
+		} else {
+			indices.updateIndexRange();
+		}
+	}
+
 //	std::cout << "done.\n";
-	return mesh;
+	return mesh.detachAndDecrease();
 }
 
 //!	(internal,static)
-void StreamerMMF::readVertexData(Mesh * mesh, Reader & in) {
+void StreamerMMF::readVertexData(Mesh * mesh, Reader & in, const std::shared_ptr<ExternalMeshBuffer> & mappedFile) {
 	static const std::string warningPrefix("LoaderMMF::readVertexData: ");
 
 	VertexDescription vd;
+	Geometry::Box boundingBox;
+	bool hasBoundingBox = false;
 
 	for(uint32_t attrId = in.read_uint32(); attrId != StreamerMMF::MMF_END ; attrId = in.read_uint32()) {
 		uint32_t numValues = in.read_uint32();
@@ -133,7 +219,7 @@ void StreamerMMF::readVertexData(Mesh * mesh, Reader & in) {
 			uint32_t extBlockSize=in.read_uint32();
 			extLength-=8;
 
-			if(extLength>extBlockSize) {
+			if(extBlockSize>extLength) {
 				WARN(warningPrefix+"Error in vertex block");
 				FAIL();
 			}
@@ -145,6 +231,11 @@ void StreamerMMF::readVertexData(Mesh * mesh, Reader & in) {
 			if(extBlockType==MMF_VERTEX_ATTR_EXT_NAME) {
 				name.assign(data.begin(), data.end());
 				name=name.substr(0,name.find('\0')); // remove additional zeros
+			} else if(extBlockType==MMF_VERTEX_ATTR_EXT_BOUNDING_BOX && attrId==0x00 && extBlockSize==6*sizeof(float)) {
+				float values[6];
+				std::memcpy(values, data.data(), sizeof(values));
+				boundingBox = Geometry::Box(values[0], values[1], values[2], values[3], values[4], values[5]);
+				hasBoundingBox = true;
 			} else {
 				WARN(warningPrefix+"Found unsupported ext data, skipping data.");
 			}
@@ -162,15 +253,26 @@ void StreamerMMF::readVertexData(Mesh * mesh, Reader & in) {
 	}
 	const uint32_t count = in.read_uint32();
 	MeshVertexData & vertices = mesh->openVertexData();
-	vertices.allocate(count,vd);
-
-	in.read( vertices.data(), vertices.dataSize());
+	if(mappedFile) {
+		const std::size_t offset = static_cast<std::size_t>(in.in.tellg());
+		const std::size_t size = static_cast<std::size_t>(vd.getVertexSize()) * count;
+		vertices.setExternalData(count, vd, ExternalMeshBuffer::createRange(mappedFile, offset, size));
+		in.in.seekg(static_cast<std::streamoff>(offset + size));
+	} else {
+		vertices.allocate(count,vd);
+		in.read( vertices.data(), vertices.dataSize());
+	}
 
-	vertices.updateBoundingBox();
+	// Use the stored bounding box if available; for mapped files, this avoids touching every page of the vertex data.
+	if(hasBoundingBox) {
+		vertices._setBoundingBox(boundingBox);
+	} else {
+		vertices.updateBoundingBox();
+	}
 }
 
 //!	(internal,static)
-void StreamerMMF::readIndexData(Mesh * mesh, Reader & in) {
+void StreamerMMF::readIndexData(Mesh * mesh, Reader & in, const std::shared_ptr<ExternalMeshBuffer> & mappedFile) {
 	const uint32_t count = in.read_uint32();
 	const uint32_t triangleMode = in.read_uint32();
 	mesh->setGLDrawMode(triangleMode);
@@ -182,10 +284,16 @@ void StreamerMMF::readIndexData(Mesh * mesh, Reader & in) {
 	}else{
 		mesh->setUseIndexData(true);
 		MeshIndexData & indices=mesh->openIndexData();
-		indices.allocate(count);
-
-		in.read(reinterpret_cast<uint8_t*>(indices.data()), indices.dataSize());
-		indices.updateIndexRange();
+		const std::size_t offset = mappedFile ? static_cast<std::size_t>(in.in.tellg()) : 0;
+		const std::size_t size = static_cast<std::size_t>(count) * sizeof(uint32_t);
+		if(mappedFile && (reinterpret_cast<std::uintptr_t>(mappedFile->data() + offset) % alignof(uint32_t)) == 0) {
+			indices.setExternalData(count, GL_UNSIGNED_INT, ExternalMeshBuffer::createRange(mappedFile, offset, size));
+			in.in.seekg(static_cast<std::streamoff>(offset + size));
+		} else {
+			indices.allocate(count);
+			in.read(reinterpret_cast<uint8_t*>(indices.data()), indices.dataSize());
+		}
+		// the index range is set by readMesh(...), as it may be stored in a following block
 	}
 }
 
@@ -203,14 +311,59 @@ Util::GenericAttributeList * StreamerMMF::loadGeneric(std::istream & input) {
 
 //!	(static)
 bool StreamerMMF::saveMesh(Mesh * mesh, std::ostream & output) {
-	/// Header
-	write(output, MMF_HEADER);
-	write(output, MMF_VERSION);
+	writeHeader(output);
 
 	/// VertexData
-	MeshVertexData & vertices = mesh->openVertexData();
-	const VertexDescription & vd = vertices.getVertexDescription();
+	const MeshVertexData & vertices = mesh->openVertexData();
+	writeVertexBlockHeader(output, vertices.getVertexDescription(), vertices.getVertexCount(), vertices.getBoundingBox());
+	if(vertices.getLayout() == VertexLayout::INTERLEAVED) {
+		output.write(reinterpret_cast<const char *> (vertices.data()), vertices.dataSize()); // data
+	} else {
+		MeshVertexData interleavedVertices(vertices);
+		interleavedVertices.setLayout(VertexLayout::INTERLEAVED);
+		output.write(reinterpret_cast<const char *> (interleavedVertices.data()), interleavedVertices.dataSize()); // data
+	}
+
+	/// IndexData
+	const MeshIndexData & indices = mesh->openIndexData();
+	const uint32_t indexCount = indices.hasLocalData() ? indices.getIndexCount() : 0;
+	writeIndexBlockHeader(output, indexCount, mesh->getGLDrawMode());
+	// the indices are always stored as 32bit values
+	if(indexCount > 0) {
+		uint32_t minIndex = indices[0];
+		uint32_t maxIndex = indices[0];
+		if(indices.getIndexType() == GL_UNSIGNED_INT) {
+			const uint32_t * indices32 = reinterpret_cast<const uint32_t *>(indices.rawData());
+			const auto range = std::minmax_element(indices32, indices32 + indexCount);
+			minIndex = *range.first;
+			maxIndex = *range.second;
+			output.write(reinterpret_cast<const char *> (indices32), indexCount * sizeof(uint32_t));
+		} else {
+			std::vector<uint32_t> indices32(indexCount);
+			for(uint32_t i = 0; i < indexCount; ++i) {
+				indices32[i] = indices[i];
+				minIndex = std::min(minIndex, indices32[i]);
+				maxIndex = std::max(maxIndex, indices32[i]);
+			}
+			output.write(reinterpret_cast<const char *> (indices32.data()), indexCount * sizeof(uint32_t));
+		}
+		// stored explicitly, as the index range of the mesh may be outdated
+		writeIndexRange(output, minIndex, maxIndex);
+	}
 
+	/// final END
+	writeEnd(output);
+	return true;
+}
+
+//!	(static)
+void StreamerMMF::writeHeader(std::ostream & output) {
+	write(output, MMF_HEADER);
+	write(output, MMF_VERSION);
+}
+
+//!	(static)
+void StreamerMMF::writeVertexBlockHeader(std::ostream & output, const VertexDescription & vd, uint32_t vertexCount, const Geometry::Box & boundingBox) {
 	// prepare header
 	std::ostringstream headerOut;
 	for(const auto & attr : vd.getAttributes()) {
@@ -240,34 +393,46 @@ bool StreamerMMF::saveMesh(Mesh * mesh, std::ostream & output) {
 			write(headerOut,MMF_VERTEX_ATTR_EXT_NAME); // extType
 			write(headerOut,name.length());		// stringLength
 			headerOut.write(name.c_str(),name.length()); // String
+		}else if(attrId==0x00){
+			const float values[6] = {boundingBox.getMinX(), boundingBox.getMaxX(), boundingBox.getMinY(),
+									 boundingBox.getMaxY(), boundingBox.getMinZ(), boundingBox.getMaxZ()};
+			write(headerOut,sizeof(values)+8);	// extLength = Box + 4 (extType) + 4 (boxLength)
+			write(headerOut,MMF_VERTEX_ATTR_EXT_BOUNDING_BOX); // extType
+			write(headerOut,sizeof(values));	// boxLength
+			headerOut.write(reinterpret_cast<const char *>(values),sizeof(values)); // Box
 		}else{
 			write(headerOut,0); 				// extLength = 0
 		}
 	}
 	write(headerOut,MMF_END);
-	write(headerOut,vertices.getVertexCount());
+	write(headerOut,vertexCount);
 	const std::string & header=headerOut.str();
 
-	// write data
 	write(output, MMF_VERTEX_DATA);
-	write(output,vertices.dataSize()+header.length()); // dataSize
+	write(output, static_cast<std::size_t>(vd.getVertexSize()) * vertexCount + header.length()); // dataSize
 	output.write(header.c_str(),header.length());		// header
-	output.write(reinterpret_cast<char *> (vertices.data()), vertices.dataSize()); // data
+}
 
-	/// IndexData Header
-	MeshIndexData & indices = mesh->openIndexData();
+//!	(static)
+void StreamerMMF::writeIndexBlockHeader(std::ostream & output, uint32_t indexCount, uint32_t drawMode) {
 	write(output, MMF_INDEX_DATA);
-	write(output, indices.dataSize()+sizeof(uint32_t)+sizeof(uint32_t)); // indexData length +indexCount +triangleMode
-	write(output, indices.getIndexCount());
-	write(output, mesh->getGLDrawMode());
-	output.write(reinterpret_cast<char *> (indices.data()), indices.dataSize());
-
-	/// final END
-	write(output, MMF_END);
-	return true;
+	write(output, indexCount * sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint32_t)); // indexData length +indexCount +triangleMode
+	write(output, indexCount);
+	write(output, drawMode);
 }
 
+//!	(static)
+void StreamerMMF::writeIndexRange(std::ostream & output, uint32_t minIndex, uint32_t maxIndex) {
+	write(output, MMF_INDEX_RANGE);
+	write(output, 2 * sizeof(uint32_t)); // dataSize
+	write(output, minIndex);
+	write(output, maxIndex);
+}
 
+//!	(static)
+void StreamerMMF::writeEnd(std::ostream & output) {
+	write(output, MMF_END);
+}
 
 //!	(internal,static)
 void StreamerMMF::write(std::ostream & out, uint32_t x) {
@@ -13,8 +13,16 @@
 
 #include "AbstractRenderingStreamer.h"
 #include <cstdint>
+#include <iosfwd>
+#include <memory>
 
+namespace Geometry {
+template<typename value_t> class _Box;
+typedef _Box<float> Box;
+}
 namespace Rendering {
+class ExternalMeshBuffer;
+class VertexDescription;
 
 /**
 
@@ -36,6 +44,8 @@ namespace Rendering {
 
 	DataBlock ::=   IndexBlock
 
+	DataBlock ::=   IndexRangeBlock
+
 	VertexBlock ::= Vertex-dataType (uint32 0x00),
 					uint32 dataSize,
 					VertexAttributeDescription *,
@@ -64,17 +74,32 @@ namespace Rendering {
 	VertexAttributeExtension ::=
 					VertexAttributeNameExtension
 
+	VertexAttributeExtension ::=
+					VertexAttributeBoundingBoxExtension
+
 	VertexAttributeNameExtension ::=
 					uint32 extension Type 0x03 ( MMF_VERTEX_ATTR_EXT_NAME )
 					uint32 length of name string including padding zeros
 					uint8* attrName (filled up with additional zeros until 32bit alignment is reached.
 
+	VertexAttributeBoundingBoxExtension ::= -- optional, only for the POSITION attribute
+					uint32 extension Type 0x04 ( MMF_VERTEX_ATTR_EXT_BOUNDING_BOX )
+					uint32 length (=24)
+					float minX, maxX, minY, maxY, minZ, maxZ -- bounding box of the vertex positions;
+						if present, it is used instead of computing the box from the (possibly mapped) vertex data.
+
 
 	IndexBlock ::=  Index-dataType (uint32 0x01),
 					uint32 dataSize,
 					uint32 indexCount -- the number of indices in the following datablock,
 					uint32 (=GLuint) indexMode -- the meaning of the indices (GL_TRIANGLES, GL_TRIANGLE_STRIP, ...),
 					uint8* indexData -- the index data
+
+	IndexRangeBlock ::= -- optional, follows the IndexBlock
+					IndexRange-dataType (uint32 0x02),
+					uint32 dataSize (=8),
+					uint32 minIndex, maxIndex -- smallest and largest value of the index data;
+						if present, they are used instead of computing the range from the (possibly mapped) index data.
 */
 class StreamerMMF : public AbstractRenderingStreamer {
 	public:
@@ -83,10 +108,12 @@ class StreamerMMF : public AbstractRenderingStreamer {
 
 		const static uint32_t MMF_VERTEX_DATA = 0x00;
 		const static uint32_t MMF_INDEX_DATA = 0x01;
+		const static uint32_t MMF_INDEX_RANGE = 0x02;
 		const static uint32_t MMF_END = 0xFFFFFFFF;
 
 		const static uint32_t MMF_CUSTOM_ATTR_ID = 0xFF;
 		const static uint32_t MMF_VERTEX_ATTR_EXT_NAME = 0x03;
+		const static uint32_t MMF_VERTEX_ATTR_EXT_BOUNDING_BOX = 0x04;
 
 		StreamerMMF() :
 			AbstractRenderingStreamer() {
@@ -98,6 +125,26 @@ class StreamerMMF : public AbstractRenderingStreamer {
 		Mesh * loadMesh(std::istream & input) override;
 		bool saveMesh(Mesh * mesh, std::ostream & output) override;
 
+		/*! (static) Load a mesh from the local file at @p path without copying its vertex and index data:
+			The file is mapped into memory and the mesh's local data references the mapped region
+			(see ExternalMeshBuffer). Index data that is not 32bit aligned inside the file is copied.
+			\return The mesh or nullptr if the file could not be mapped or is not a valid .mmf file.	*/
+		static Mesh * loadMeshMapped(const std::string & path);
+
+		/*! @name Writing a mesh piece by piece
+			Used to write a mesh that is not available in memory as a whole: Call writeHeader(...) and writeVertexBlockHeader(...),
+			write the interleaved vertex data, call writeIndexBlockHeader(...), write the 32bit indices, call writeIndexRange(...)
+			(optional; otherwise the range is computed when the file is loaded) and finish with writeEnd(...).
+			The size of the block headers only depends on the vertex description, so a header can be written again with the
+			final values (e.g. the bounding box) after seeking back to its position.	*/
+		// @{
+		static void writeHeader(std::ostream & output);
+		static void writeVertexBlockHeader(std::ostream & output, const VertexDescription & vd, uint32_t vertexCount, const Geometry::Box & boundingBox);
+		static void writeIndexBlockHeader(std::ostream & output, uint32_t indexCount, uint32_t drawMode);
+		static void writeIndexRange(std::ostream & output, uint32_t minIndex, uint32_t maxIndex);
+		static void writeEnd(std::ostream & output);
+		// @}
+
 		static uint8_t queryCapabilities(const std::string & extension);
 		static const char * const fileExtension;
 
@@ -110,8 +157,11 @@ class StreamerMMF : public AbstractRenderingStreamer {
 			void skip(uint32_t size);
 
 		};
-		static void readVertexData(Mesh * mesh, Reader & in);
-		static void readIndexData(Mesh * mesh, Reader & in);
+		static Mesh * readMesh(Reader & in, const std::shared_ptr<ExternalMeshBuffer> & mappedFile);
+		/*! If @p mappedFile is given, @p in has to read from its memory and the vertex data
+			references the mapped region instead of being copied.	*/
+		static void readVertexData(Mesh * mesh, Reader & in, const std::shared_ptr<ExternalMeshBuffer> & mappedFile);
+		static void readIndexData(Mesh * mesh, Reader & in, const std::shared_ptr<ExternalMeshBuffer> & mappedFile);
 
 
 		static void write(std::ostream & out, uint32_t x);
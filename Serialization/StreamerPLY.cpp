@@ -10,15 +10,19 @@
 */
 #include "StreamerPLY.h"
 #include "Serialization.h"
+#include "StreamerMMF.h"
 #include "../Mesh/Mesh.h"
 #include "../Mesh/VertexAttributeIds.h"
 #include "../Mesh/VertexDescription.h"
 #include "../GLHeader.h"
 #include "../Helper.h"
+#include <Geometry/Box.h>
 #include <Geometry/Convert.h>
 #include <Util/Graphics/Color.h>
 #include <Util/GenericAttribute.h>
+#include <Util/Macros.h>
 #include <Util/StringUtils.h>
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <map>
@@ -378,6 +382,227 @@ class PLY_Element {
 
 //-------------------------------------------------------------------------------------------------
 
+/*! (internal) Process a line of the header of a .ply file.
+	\return @c false if the line ends the header.	*/
+static bool readHeaderLine(const std::string & line, PLY_Element::format_t & format, std::vector<PLY_Element> & elements) {
+	if(Util::StringUtils::beginsWith(line.c_str(),"comment")) {
+		return true;
+	} else if(Util::StringUtils::beginsWith(line.c_str(),"element")) {
+		std::istringstream s(line,std::istringstream::in);
+		std::string dummy;
+		std::string elemType;
+		uint32_t count=0;
+		s>>dummy>>elemType>>count;
+		elements.emplace_back(elemType, format, count);
+
+	} else if(Util::StringUtils::beginsWith(line.c_str(),"property")) {
+		std::istringstream s(line,std::istringstream::in);
+		std::string dummy;
+		std::string dataType;
+		s>>dummy>>dataType;
+		if(dataType=="list"){
+			std::string countType;
+			std::string name;
+			s>>countType>>dataType>>name;
+			if(!elements.empty()) {
+				elements.back().addList(countType,dataType,name);
+			}
+		}else{
+			std::string name;
+			s>>name;
+			if(!elements.empty()) {
+				elements.back().addProperty(dataType,name);
+			}
+		}
+	} else if(Util::StringUtils::beginsWith(line.c_str(),"end_header")) {
+		return false;
+	} else if(Util::StringUtils::beginsWith(line.c_str(),"format")) {
+		std::istringstream is(line,std::istringstream::in);
+		std::string dummy;
+		std::string sformat;
+		std::string formatVersion;
+		is>>dummy>>sformat>>formatVersion;
+		format=PLY_Element::getFormatId(sformat);
+	} else {
+		// ignore unknown Lines
+	}
+	return true;
+}
+
+namespace {
+//! (internal) Conversion of the current values of a vertex element into an interleaved vertex.
+class PLY_VertexConverter {
+	public:
+		explicit PLY_VertexConverter(const PLY_Element & e) :
+				useVertexNormals(false), useVertexColor(false), useTex0(false) {
+			const VertexAttribute & posAttr = vFormat.appendPosition3D();
+			posOffset = posAttr.getOffset();
+
+			xIndex=e.getPropertyIndex("x");
+			yIndex=e.getPropertyIndex("y");
+			zIndex=e.getPropertyIndex("z");
+
+			nxIndex=e.getPropertyIndex("nx");
+			nyIndex=e.getPropertyIndex("ny");
+			nzIndex=e.getPropertyIndex("nz");
+			if(nxIndex>=0&&nyIndex>=0&&nzIndex>=0) {
+				useVertexNormals=true;
+				normalsOffset = vFormat.appendNormalByte().getOffset();
+			}
+			sIndex=e.getPropertyIndex("s");
+			tIndex=e.getPropertyIndex("t");
+			if(sIndex>=0&&tIndex>=0) {
+				useTex0=true;
+				tex0Offset = vFormat.appendTexCoord().getOffset();
+			}
+			redIndex=e.getPropertyIndex("red");
+			greenIndex=e.getPropertyIndex("green");
+			blueIndex=e.getPropertyIndex("blue");
+			alphaIndex=e.getPropertyIndex("alpha");
+			if(redIndex>=0&&greenIndex>=0&&blueIndex>=0) {
+				useVertexColor=true;
+				colorOffset = vFormat.appendColorRGBAByte().getOffset();
+			}
+		}
+
+		const VertexDescription & getVertexDescription() const {
+			return vFormat;
+		}
+
+		//! Write the current values of @p e (see PLY_Element::parseData(...)) to the vertex at @p vCursor.
+		void convert(const PLY_Element & e, uint8_t * vCursor) const {
+			*((reinterpret_cast<float *>(vCursor+posOffset))+0)=e.getProperty(xIndex).getCurrentValue<float>();
+			*((reinterpret_cast<float *>(vCursor+posOffset))+1)=e.getProperty(yIndex).getCurrentValue<float>();
+			*((reinterpret_cast<float *>(vCursor+posOffset))+2)=e.getProperty(zIndex).getCurrentValue<float>();
+			if(useVertexNormals) {
+
+				GLbyte nx,ny,nz;
+				if(e.getProperty(nxIndex).dataType==PLY_Element::TYPE_CHAR){
+					nx=e.getProperty(nxIndex).getCurrentValue<GLbyte>();
+					ny=e.getProperty(nyIndex).getCurrentValue<GLbyte>();
+					nz=e.getProperty(nzIndex).getCurrentValue<GLbyte>();
+				}else{
+					nx= Geometry::Convert::toSigned<int8_t>(e.getProperty(nxIndex).getCurrentValue<float>());
+					ny= Geometry::Convert::toSigned<int8_t>(e.getProperty(nyIndex).getCurrentValue<float>());
+					nz= Geometry::Convert::toSigned<int8_t>(e.getProperty(nzIndex).getCurrentValue<float>());
+				}
+				*((reinterpret_cast<GLbyte *>(vCursor+normalsOffset))+0)=nx;
+				*((reinterpret_cast<GLbyte *>(vCursor+normalsOffset))+1)=ny;
+				*((reinterpret_cast<GLbyte *>(vCursor+normalsOffset))+2)=nz;
+			}
+			if(useVertexColor) {
+				Util::Color4ub color;
+				if(e.getProperty(redIndex).dataType == PLY_Element::TYPE_FLOAT) {
+					Util::Color4f floatColor;
+					floatColor.setR(e.getProperty(redIndex).getCurrentValue<float>());
+					floatColor.setG(e.getProperty(greenIndex).getCurrentValue<float>());
+					floatColor.setB(e.getProperty(blueIndex).getCurrentValue<float>());
+					if(alphaIndex > 0) {
+						floatColor.setA(e.getProperty(alphaIndex).getCurrentValue<float>());
+					} else {
+						floatColor.setA(1.0f);
+					}
+					color = Util::Color4ub(floatColor);
+				} else { // most likely = TYPE_UCHAR
+					color.setR(e.getProperty(redIndex).getCurrentValue<GLubyte>());
+					color.setG(e.getProperty(greenIndex).getCurrentValue<GLubyte>());
+					color.setB(e.getProperty(blueIndex).getCurrentValue<GLubyte>());
+					if(alphaIndex > 0) {
+						color.setA(e.getProperty(alphaIndex).getCurrentValue<GLubyte>());
+					} else {
+						color.setA(255);
+					}
+				}
+				*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 0) = color.getR();
+				*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 1) = color.getG();
+				*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 2) = color.getB();
+				*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 3) = color.getA();
+			}
+			if(useTex0){
+				*((reinterpret_cast<float *>(vCursor+tex0Offset))+0)=e.getProperty(sIndex).getCurrentValue<float>();
+				*((reinterpret_cast<float *>(vCursor+tex0Offset))+1)=e.getProperty(tIndex).getCurrentValue<float>();
+			}
+		}
+
+	private:
+		VertexDescription vFormat;
+		bool useVertexNormals;
+		bool useVertexColor;
+		bool useTex0;
+		int xIndex, yIndex, zIndex;
+		int nxIndex, nyIndex, nzIndex;
+		int sIndex, tIndex;
+		int redIndex, greenIndex, blueIndex, alphaIndex;
+		std::size_t posOffset, normalsOffset, colorOffset, tex0Offset;
+};
+
+/*! (internal) Buffer for reading the data section of a .ply file in chunks.
+	At least maxRowSize bytes (or the rest of the data) are available behind the cursor, and the
+	available data is followed by a zero byte, so ASCII rows can be parsed directly from the buffer.	*/
+class PLY_ChunkReader {
+	public:
+		static const std::size_t chunkSize = 1 << 22;
+		static const std::size_t maxRowSize = 1 << 16;
+
+		explicit PLY_ChunkReader(std::istream & _input) :
+				input(_input), buffer(chunkSize + maxRowSize + 1), cursor(0), end(0) {
+			fill();
+		}
+
+		//! Pointer to the data of the next row.
+		const uint8_t * data() {
+			if(end - cursor < maxRowSize) {
+				fill();
+			}
+			return buffer.data() + cursor;
+		}
+
+		//! Advance the cursor behind a row of @p rowSize bytes; @return @c false if the row exceeded the data.
+		bool consume(std::size_t rowSize) {
+			cursor += rowSize;
+			return cursor <= end;
+		}
+
+	private:
+		std::istream & input;
+		std::vector<uint8_t> buffer;
+		std::size_t cursor;
+		std::size_t end;
+
+		void fill() {
+			std::copy(buffer.begin() + cursor, buffer.begin() + end, buffer.begin());
+			end -= cursor;
+			cursor = 0;
+			if(input.good()) {
+				input.read(reinterpret_cast<char *>(buffer.data() + end), chunkSize + maxRowSize - end);
+				end += static_cast<std::size_t>(input.gcount());
+			}
+			buffer[end] = 0;
+		}
+};
+}
+
+/*! (internal) Store the triangles of the current face of @p e (see PLY_Element::parseData(...)) in @p triangleIndices.
+	A quad is split into two triangles; of other polygons, only the first triangle is used.
+	\return The number of stored indices (0, 3 or 6).	*/
+static uint32_t getFaceTriangles(const PLY_Element & e, int vertex_indicesIndex, uint32_t * triangleIndices) {
+	const PLY_Element::Property & vertexIndices = e.getProperty(vertex_indicesIndex);
+	const int numpoints=vertexIndices.currentDataCount;
+	if(numpoints<3) return 0;
+	const uint32_t p1=vertexIndices.getCurrentValue<uint32_t>(0);
+	const uint32_t p2=vertexIndices.getCurrentValue<uint32_t>(1);
+	const uint32_t p3=vertexIndices.getCurrentValue<uint32_t>(2);
+	triangleIndices[0]=p1;
+	triangleIndices[1]=p2;
+	triangleIndices[2]=p3;
+	if(numpoints!=4) return 3;
+	const uint32_t p4=vertexIndices.getCurrentValue<uint32_t>(3);
+	triangleIndices[3]=p3;
+	triangleIndices[4]=p4;
+	triangleIndices[5]=p1;
+	return 6;
+}
+
 Mesh * StreamerPLY::loadMesh(std::istream & input) {
 	int cursor=0;
 
@@ -393,59 +618,14 @@ Mesh * StreamerPLY::loadMesh(std::istream & input) {
 		return nullptr;
 	}
 	PLY_Element::format_t format=PLY_Element::ASCII;
-	std::string formatVersion="1.0";
 
 	std::vector<PLY_Element> elements;
 
 	while (Util::StringUtils::nextLine(buffer.data(), cursor)) {
-		std::string line=Util::StringUtils::getLine(buffer.data() + cursor);
-		if(Util::StringUtils::beginsWith(buffer.data() + cursor,"comment"))
-			continue;
-		else if(Util::StringUtils::beginsWith(buffer.data() + cursor,"element")) {
-			std::istringstream s(line,std::istringstream::in);
-			std::string dummy;
-			std::string elemType;
-			uint32_t count=0;
-			s>>dummy>>elemType>>count;
-			elements.emplace_back(elemType, format, count);
-
-		} else if(Util::StringUtils::beginsWith(buffer.data() + cursor,"property")) {
-			std::istringstream s(line,std::istringstream::in);
-			std::string dummy;
-			std::string dataType;
-			s>>dummy>>dataType;
-			if(dataType=="list"){
-				std::string countType;
-				std::string name;
-				s>>countType>>dataType>>name;
-				if(!elements.empty()) {
-					elements.back().addList(countType,dataType,name);
-				}
-			}else{
-				std::string name;
-				s>>name;
-				if(!elements.empty()) {
-					elements.back().addProperty(dataType,name);
-				}
-			}
-		} else if(Util::StringUtils::beginsWith(buffer.data() + cursor,"end_header")) {
+		if(!readHeaderLine(Util::StringUtils::getLine(buffer.data() + cursor), format, elements))
 			break;
-		} else if(Util::StringUtils::beginsWith(buffer.data() + cursor,"format")) {
-			std::istringstream is(line,std::istringstream::in);
-			std::string dummy;
-			std::string sformat;
-			is>>dummy>>sformat>>formatVersion;
-			format=PLY_Element::getFormatId(sformat);
-		} else {
-			// ignore unknown Lines
-			// std::cout <<"#"<<line<<"\n";
-		}
 	}
-//    std::cout << "\nFormat: "<<format<< " "<<formatVersion<<"\n";
-
-//    std::cout << "\nCursor at "<<(void*)cursor<<(char)buffer[cursor]<<(char)buffer[cursor+1];
 	Util::StringUtils::nextLine(buffer.data(), cursor);
-//    std::cout << "\nCursor at "<<(void*)cursor<<(char)buffer[cursor]<<(char)buffer[cursor+1];
 	if(cursor >= static_cast<int>(buffer.size())) return nullptr;
 
 
@@ -453,115 +633,22 @@ Mesh * StreamerPLY::loadMesh(std::istream & input) {
 
 	auto mesh = new Mesh;
 
-	bool useVertexColor=false;
-	bool useVertexNormals=false;
-	bool useTex0=false;
-
 	for(auto & e : elements) {
 		
 		if(e.name=="vertex") {
 			uint32_t numVertices=e.count;
 
-			VertexDescription vFormat;
-			const VertexAttribute & posAttr = vFormat.appendPosition3D();
-
-			int xIndex=e.getPropertyIndex("x");
-			int yIndex=e.getPropertyIndex("y");
-			int zIndex=e.getPropertyIndex("z");
-
-			int nxIndex=e.getPropertyIndex("nx");
-			int nyIndex=e.getPropertyIndex("ny");
-			int nzIndex=e.getPropertyIndex("nz");
-
-			VertexAttribute normalAttr;
-			if(nxIndex>=0&&nyIndex>=0&&nzIndex>=0) {
-				useVertexNormals=true;
-				normalAttr = vFormat.appendNormalByte();
-			}
-			VertexAttribute tex0Attr;
-			int sIndex=e.getPropertyIndex("s");
-			int tIndex=e.getPropertyIndex("t");
-			if(sIndex>=0&&tIndex>=0) {
-				useTex0=true;
-				tex0Attr = vFormat.appendTexCoord();
-			}
-			VertexAttribute colorAttr;
-			int redIndex=e.getPropertyIndex("red");
-			int greenIndex=e.getPropertyIndex("green");
-			int blueIndex=e.getPropertyIndex("blue");
-			int alphaIndex=e.getPropertyIndex("alpha");
-//#ifdef PLY_LOADER_USE_VERTEX_NORMALS
-			if(redIndex>=0&&greenIndex>=0&&blueIndex>=0) {
-				useVertexColor=true;
-				colorAttr = vFormat.appendColorRGBAByte();
-			}
-//#endif
+			const PLY_VertexConverter converter(e);
+			const VertexDescription & vFormat = converter.getVertexDescription();
 			int vertexSize=vFormat.getVertexSize();
-			const int posOffset=posAttr.getOffset();
-			const int normalsOffset=normalAttr.getOffset();
-			const int colorOffset=colorAttr.getOffset();
-			const int tex0Offset=tex0Attr.getOffset();
 			MeshVertexData & vertices=mesh->openVertexData();
 			vertices.allocate(numVertices,vFormat);
 
 			uint8_t * vCursor= vertices.data();
 			for(uint32_t j=0;j<numVertices;++j) {
-//				std::cout << "<"<<j;
 				int rowSize=e.parseData(reinterpret_cast<uint8_t *>(buffer.data() + cursor));
 				cursor+=rowSize;
-//
-				*((reinterpret_cast<float *>(vCursor+posOffset))+0)=e.getProperty(xIndex).getCurrentValue<float>();
-				*((reinterpret_cast<float *>(vCursor+posOffset))+1)=e.getProperty(yIndex).getCurrentValue<float>();
-				*((reinterpret_cast<float *>(vCursor+posOffset))+2)=e.getProperty(zIndex).getCurrentValue<float>();
-				if(useVertexNormals) {
-
-					GLbyte nx,ny,nz;
-					if(e.getProperty(nxIndex).dataType==PLY_Element::TYPE_CHAR){
-						nx=e.getProperty(nxIndex).getCurrentValue<GLbyte>();
-						ny=e.getProperty(nyIndex).getCurrentValue<GLbyte>();
-						nz=e.getProperty(nzIndex).getCurrentValue<GLbyte>();
-//                        normal=Geometry::Vec3(values[indices[nxIndex]],values[indices[nyIndex]],values[indices[nzIndex]]);
-					}else{
-						nx= Geometry::Convert::toSigned<int8_t>(e.getProperty(nxIndex).getCurrentValue<float>());
-						ny= Geometry::Convert::toSigned<int8_t>(e.getProperty(nyIndex).getCurrentValue<float>());
-						nz= Geometry::Convert::toSigned<int8_t>(e.getProperty(nzIndex).getCurrentValue<float>());
-					}
-					*((reinterpret_cast<GLbyte *>(vCursor+normalsOffset))+0)=nx;
-					*((reinterpret_cast<GLbyte *>(vCursor+normalsOffset))+1)=ny;
-					*((reinterpret_cast<GLbyte *>(vCursor+normalsOffset))+2)=nz;
-				}
-				if(useVertexColor) {
-					Util::Color4ub color;
-					if(e.getProperty(redIndex).dataType == PLY_Element::TYPE_FLOAT) {
-						Util::Color4f floatColor;
-						floatColor.setR(e.getProperty(redIndex).getCurrentValue<float>());
-						floatColor.setG(e.getProperty(greenIndex).getCurrentValue<float>());
-						floatColor.setB(e.getProperty(blueIndex).getCurrentValue<float>());
-						if(alphaIndex > 0) {
-							floatColor.setA(e.getProperty(alphaIndex).getCurrentValue<float>());
-						} else {
-							floatColor.setA(1.0f);
-						}
-						color = Util::Color4ub(floatColor);
-					} else { // most likely = TYPE_UCHAR
-						color.setR(e.getProperty(redIndex).getCurrentValue<GLubyte>());
-						color.setG(e.getProperty(greenIndex).getCurrentValue<GLubyte>());
-						color.setB(e.getProperty(blueIndex).getCurrentValue<GLubyte>());
-						if(alphaIndex > 0) {
-							color.setA(e.getProperty(alphaIndex).getCurrentValue<GLubyte>());
-						} else {
-							color.setA(255);
-						}
-					}
-					*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 0) = color.getR();
-					*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 1) = color.getG();
-					*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 2) = color.getB();
-					*((reinterpret_cast<GLubyte *> (vCursor + colorOffset)) + 3) = color.getA();
-				}
-				if(useTex0){
-					*((reinterpret_cast<float *>(vCursor+tex0Offset))+0)=e.getProperty(sIndex).getCurrentValue<float>();
-					*((reinterpret_cast<float *>(vCursor+tex0Offset))+1)=e.getProperty(tIndex).getCurrentValue<float>();
-				}
+				converter.convert(e, vCursor);
 				if(cursor > static_cast<int>(buffer.size())) {
 					std::cerr <<"!!! Buffer overrun!";
 					return nullptr;
@@ -577,9 +664,7 @@ Mesh * StreamerPLY::loadMesh(std::istream & input) {
 			int vertex_indicesIndex=e.getPropertyIndex("vertex_indices");
 
 			unsigned int numIndices=0;
-#define PLY_LOADER_PROCESS_QUADS 1
-
-#ifdef PLY_LOADER_PROCESS_QUADS
+			uint32_t triangleIndices[6];
 			int cursorBackup=cursor;
 			for(unsigned int j=0;j<numFaces;j++) {
 				int rowSize = e.parseData(reinterpret_cast<uint8_t *> (buffer.data() + cursor));
@@ -589,14 +674,9 @@ Mesh * StreamerPLY::loadMesh(std::istream & input) {
 					std::cerr <<"!!! Buffer overrun!";
 					break;
 				}
-				int numpoints=e.getProperty(vertex_indicesIndex).currentDataCount;
-				if(numpoints==3) numIndices+=3;
-				else if(numpoints==4) numIndices+=6;
+				numIndices+=getFaceTriangles(e, vertex_indicesIndex, triangleIndices);
 			}
 			cursor=cursorBackup;
-#else
-			numIndices=numFaces*3;
-#endif
 
 			// read indices
 			MeshIndexData & indices=mesh->openIndexData();
@@ -612,29 +692,7 @@ Mesh * StreamerPLY::loadMesh(std::istream & input) {
 					std::cerr <<"!!! Buffer overrun!";
 					break;
 				}
-				int numpoints=e.getProperty(vertex_indicesIndex).currentDataCount;
-
-				if(numpoints<3) continue;
-				uint32_t p1=e.getProperty(vertex_indicesIndex).getCurrentValue<uint32_t>(0);
-				uint32_t p2=e.getProperty(vertex_indicesIndex).getCurrentValue<uint32_t>(1);
-				uint32_t p3=e.getProperty(vertex_indicesIndex).getCurrentValue<uint32_t>(2);
-
-				vIndeces[vertexNr++]=p1;
-				vIndeces[vertexNr++]=p2;
-				vIndeces[vertexNr++]=p3;
-////                if(useFaceColor) {
-////                    colors[j*3+0]=(float)(values[indices[redIndex]]/256.0);
-////                    colors[j*3+1]=(float)(values[indices[greenIndex]]/256.0);
-////                    colors[j*3+2]=(float)(values[indices[blueIndex]]/256.0);
-////                }
-#ifdef PLY_LOADER_PROCESS_QUADS
-				if(numpoints==4){
-					int p4=e.getProperty(vertex_indicesIndex).getCurrentValue<uint32_t>(3);
-					vIndeces[vertexNr++]=p3;
-					vIndeces[vertexNr++]=p4;
-					vIndeces[vertexNr++]=p1;
-				}
-#endif
+				vertexNr+=getFaceTriangles(e, vertex_indicesIndex, vIndeces+vertexNr);
 			}
 			indices.updateIndexRange();
 		} else {
@@ -645,6 +703,116 @@ Mesh * StreamerPLY::loadMesh(std::istream & input) {
 	return mesh;
 }
 
+//! (static)
+bool StreamerPLY::convertToMMF(std::istream & input, std::ostream & output) {
+	// ---- read header ---
+	std::string line;
+	if(!std::getline(input, line) || !Util::StringUtils::beginsWith(line.c_str(), "ply")) {
+		WARN("StreamerPLY::convertToMMF: Invalid ply header.");
+		return false;
+	}
+	PLY_Element::format_t format=PLY_Element::ASCII;
+	std::vector<PLY_Element> elements;
+	bool headerComplete=false;
+	while(std::getline(input, line)) {
+		if(!readHeaderLine(line, format, elements)) {
+			headerComplete=true;
+			break;
+		}
+	}
+	if(!headerComplete) {
+		WARN("StreamerPLY::convertToMMF: Incomplete ply header.");
+		return false;
+	}
+
+	// ---- convert data -----
+	PLY_ChunkReader reader(input);
+	StreamerMMF::writeHeader(output);
+	bool hasVertices=false;
+	for(auto & e : elements) {
+		if(e.name=="vertex" && !hasVertices) {
+			hasVertices=true;
+			const uint32_t numVertices=e.count;
+			const PLY_VertexConverter converter(e);
+			const VertexDescription & vFormat = converter.getVertexDescription();
+			const VertexAttribute & posAttr = vFormat.getAttribute(VertexAttributeIds::POSITION);
+
+			// the header is written again when the bounding box is known
+			const std::streampos headerPos = output.tellp();
+			StreamerMMF::writeVertexBlockHeader(output, vFormat, numVertices, Geometry::Box());
+
+			std::vector<uint8_t> vertex(vFormat.getVertexSize());
+			float min[3] = {0.0f, 0.0f, 0.0f};
+			float max[3] = {0.0f, 0.0f, 0.0f};
+			for(uint32_t j=0;j<numVertices;++j) {
+				if(!reader.consume(e.parseData(reader.data()))) {
+					WARN("StreamerPLY::convertToMMF: Unexpected end of vertex data.");
+					return false;
+				}
+				converter.convert(e, vertex.data());
+				const float * position = reinterpret_cast<const float *>(vertex.data() + posAttr.getOffset());
+				for(uint_fast8_t axis = 0; axis < 3; ++axis) {
+					min[axis] = j == 0 ? position[axis] : std::min(min[axis], position[axis]);
+					max[axis] = j == 0 ? position[axis] : std::max(max[axis], position[axis]);
+				}
+				output.write(reinterpret_cast<const char *>(vertex.data()), vertex.size());
+			}
+			const std::streampos dataEndPos = output.tellp();
+			output.seekp(headerPos);
+			StreamerMMF::writeVertexBlockHeader(output, vFormat, numVertices, Geometry::Box(min[0], max[0], min[1], max[1], min[2], max[2]));
+			output.seekp(dataEndPos);
+		} else if(e.name=="face" && hasVertices) {
+			const int vertex_indicesIndex=e.getPropertyIndex("vertex_indices");
+			if(vertex_indicesIndex<0) {
+				WARN("StreamerPLY::convertToMMF: Faces without vertex indices.");
+				return false;
+			}
+
+			// the header is written again when the number of indices is known
+			const std::streampos headerPos = output.tellp();
+			StreamerMMF::writeIndexBlockHeader(output, 0, GL_TRIANGLES);
+			uint32_t numIndices=0;
+			uint32_t minIndex=0;
+			uint32_t maxIndex=0;
+			uint32_t triangleIndices[6];
+			for(int j=0;j<e.count;++j) {
+				if(!reader.consume(e.parseData(reader.data()))) {
+					WARN("StreamerPLY::convertToMMF: Unexpected end of face data.");
+					return false;
+				}
+				const uint32_t count=getFaceTriangles(e, vertex_indicesIndex, triangleIndices);
+				for(uint32_t i=0;i<count;++i) {
+					minIndex = numIndices+i == 0 ? triangleIndices[i] : std::min(minIndex, triangleIndices[i]);
+					maxIndex = numIndices+i == 0 ? triangleIndices[i] : std::max(maxIndex, triangleIndices[i]);
+				}
+				output.write(reinterpret_cast<const char *>(triangleIndices), count * sizeof(uint32_t));
+				numIndices+=count;
+			}
+			const std::streampos dataEndPos = output.tellp();
+			output.seekp(headerPos);
+			StreamerMMF::writeIndexBlockHeader(output, numIndices, GL_TRIANGLES);
+			output.seekp(dataEndPos);
+			if(numIndices>0)
+				StreamerMMF::writeIndexRange(output, minIndex, maxIndex);
+			break;
+		} else {
+			// skip other elements (that are not referenced)
+			for(int j=0;j<e.count;++j) {
+				if(!reader.consume(e.parseData(reader.data()))) {
+					WARN("StreamerPLY::convertToMMF: Unexpected end of data.");
+					return false;
+				}
+			}
+		}
+	}
+	if(!hasVertices) {
+		WARN("StreamerPLY::convertToMMF: No vertices found.");
+		return false;
+	}
+	StreamerMMF::writeEnd(output);
+	return output.good();
+}
+
 /**
  * ---|> GenericLoader
  */
@@ -731,16 +899,21 @@ bool StreamerPLY::saveMesh(Mesh * mesh, std::ostream & output) {
 	output << "property list uchar int vertex_indices" << std::endl;
 	output << "end_header" << std::endl;
 
-	MeshVertexData & vertices = mesh->openVertexData();
-	output.write(reinterpret_cast<char *> (vertices.data()), vertices.dataSize());
+	const MeshVertexData & vertices = mesh->openVertexData();
+	if(vertices.getLayout() == VertexLayout::INTERLEAVED) {
+		output.write(reinterpret_cast<const char *> (vertices.data()), vertices.dataSize());
+	} else {
+		MeshVertexData interleavedVertices(vertices);
+		interleavedVertices.setLayout(VertexLayout::INTERLEAVED);
+		output.write(reinterpret_cast<const char *> (interleavedVertices.data()), interleavedVertices.dataSize());
+	}
 
 	char c  = 3;
-	char * cp = reinterpret_cast<char *> (mesh->openIndexData().data());
-
-	const size_t entryByteSize=3*sizeof(uint32_t); // =12
+	const MeshIndexData & indices = mesh->openIndexData();
 	for(unsigned int i=0;i<mesh->getIndexCount()/3;i++) {
+		const uint32_t face[3] = {indices[i*3+0], indices[i*3+1], indices[i*3+2]};
 		output.write(&c, 1);
-		output.write(cp+(i*entryByteSize), entryByteSize);
+		output.write(reinterpret_cast<const char *>(face), sizeof(face));
 	}
 
 	return true;
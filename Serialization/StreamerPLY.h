@@ -27,6 +27,14 @@ class StreamerPLY : public AbstractRenderingStreamer {
 		Mesh * loadMesh(std::istream & input) override;
 		bool saveMesh(Mesh * mesh, std::ostream & output) override;
 
+		/*! (static) Convert the .ply data read from @p input into an .mmf file (see StreamerMMF) written to @p output.
+			In contrast to loadMesh(...), the data is read in chunks and the converted vertices and indices are written
+			immediately, so the mesh is never held in memory (e.g. for Serialization::loadMeshMapped(...) afterwards).
+			The vertices and faces are converted like by loadMesh(...).
+			\note @p output has to support seeking (e.g. a file stream), as the block headers are completed at the end.
+			\return @c true if successful.	*/
+		static bool convertToMMF(std::istream & input, std::ostream & output);
+
 		static uint8_t queryCapabilities(const std::string & extension);
 		static const char * const fileExtension;
 };
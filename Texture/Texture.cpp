@@ -13,6 +13,7 @@
 #include "../BufferObject.h"
 #include "../Helper.h"
 #include "../RenderingContext/RenderingContext.h"
+#include "../UploadScheduler.h"
 #include "TextureUtils.h"
 #include <Util/Graphics/Bitmap.h>
 #include <Util/Graphics/PixelFormat.h>
@@ -131,6 +132,7 @@ Texture::Texture(Format _format):
 
 //! [dtor]
 Texture::~Texture() {
+	UploadScheduler::getInstance().cancelUpload(this);
 	removeGLData();
 }
 
@@ -208,6 +210,15 @@ void Texture::createMipmaps(RenderingContext & context) {
 	}
 }
 
+uint32_t Texture::_prepareForBinding(RenderingContext & context){
+	if( (!glId || dataHasChanged) &&
+			(localBitmap.isNull() || UploadScheduler::getInstance().requestUpload(this, localBitmap->getDataSize())) )
+		_uploadGLTexture(context);
+	if(mipmapCreationIsPlanned && glId && !dataHasChanged)
+		createMipmaps(context);
+	return glId;
+}
+
 void Texture::_uploadGLTexture(RenderingContext & context) {
 	GLint activeTexture;
 	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
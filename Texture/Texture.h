@@ -102,14 +102,10 @@ class Texture: public Util::ReferenceCounter<Texture>	{
 		
 		void dataChanged()									{	dataHasChanged = true;	}
 
-		//! (internal) uploads the texture if necessary; returns the glId or 0 if the texture is invalid.
-		uint32_t _prepareForBinding(RenderingContext & context){
-			if(!glId || dataHasChanged)
-				_uploadGLTexture(context);
-			if(mipmapCreationIsPlanned)
-				createMipmaps(context);
-			return glId;
-		}
+		/*! (internal) uploads the texture if necessary; returns the glId or 0 if the texture is invalid.
+			\note The upload of local data may be postponed by the UploadScheduler. Until then, the old
+				data is used or 0 is returned.	*/
+		uint32_t _prepareForBinding(RenderingContext & context);
 
 		bool isGLTextureValid()const;
 		bool isGLTextureResident()const;
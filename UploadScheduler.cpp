@@ -0,0 +1,124 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "UploadScheduler.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Rendering {
+
+//! (static)
+UploadScheduler & UploadScheduler::getInstance() {
+	static UploadScheduler scheduler;
+	return scheduler;
+}
+
+UploadScheduler::UploadScheduler() :
+	mutex(), bytesPerFrame(std::numeric_limits<std::size_t>::max()), uploadedBytes(0), lastFrameUploadedBytes(0), reservedBytes(0),
+	pending(), granted(), importances() {
+}
+
+void UploadScheduler::setBytesPerFrame(std::size_t bytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	bytesPerFrame = bytes;
+}
+
+std::size_t UploadScheduler::getBytesPerFrame() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return bytesPerFrame;
+}
+
+void UploadScheduler::beginFrame() {
+	std::lock_guard<std::mutex> lock(mutex);
+	lastFrameUploadedBytes = uploadedBytes;
+	uploadedBytes = 0;
+	granted.clear();
+	reservedBytes = 0;
+
+	std::vector<std::pair<const void *, Request>> requests(pending.begin(), pending.end());
+	std::stable_sort(requests.begin(), requests.end(),
+					[](const std::pair<const void *, Request> & a, const std::pair<const void *, Request> & b) {
+						return a.second.importance > b.second.importance;
+					});
+	for(const auto & request : requests) {
+		if(!granted.empty() && reservedBytes + request.second.bytes > bytesPerFrame)
+			continue;
+		granted.emplace(request.first, request.second.bytes);
+		reservedBytes += request.second.bytes;
+	}
+	// requests that have not been granted are repeated by their objects if they are still drawn
+	pending.clear();
+	importances.clear();
+}
+
+void UploadScheduler::setImportance(const void * object, float importance) {
+	std::lock_guard<std::mutex> lock(mutex);
+	importances[object] = importance;
+	const auto it = pending.find(object);
+	if(it != pending.end())
+		it->second.importance = importance;
+}
+
+bool UploadScheduler::requestUpload(const void * object, std::size_t bytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto grantedIt = granted.find(object);
+	if(grantedIt != granted.end()) {
+		reservedBytes -= grantedIt->second;
+		granted.erase(grantedIt);
+		uploadedBytes += bytes;
+		return true;
+	}
+	const std::size_t usedBytes = uploadedBytes + reservedBytes;
+	if(bytesPerFrame == std::numeric_limits<std::size_t>::max() || usedBytes == 0 || (usedBytes <= bytesPerFrame && bytes <= bytesPerFrame - usedBytes)) {
+		uploadedBytes += bytes;
+		return true;
+	}
+	const auto importanceIt = importances.find(object);
+	Request & request = pending[object];
+	request.bytes = bytes;
+	request.importance = importanceIt != importances.end() ? importanceIt->second : 0.0f;
+	return false;
+}
+
+void UploadScheduler::cancelUpload(const void * object) {
+	std::lock_guard<std::mutex> lock(mutex);
+	pending.erase(object);
+	const auto grantedIt = granted.find(object);
+	if(grantedIt != granted.end()) {
+		reservedBytes -= grantedIt->second;
+		granted.erase(grantedIt);
+	}
+	importances.erase(object);
+}
+
+bool UploadScheduler::isPending(const void * object) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return pending.count(object) != 0 || granted.count(object) != 0;
+}
+
+std::size_t UploadScheduler::getQueueDepth() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return pending.size() + granted.size();
+}
+
+std::size_t UploadScheduler::getUploadedBytes() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return uploadedBytes;
+}
+
+std::size_t UploadScheduler::getLastFrameUploadedBytes() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return lastFrameUploadedBytes;
+}
+
+}
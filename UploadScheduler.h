@@ -0,0 +1,96 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_UPLOADSCHEDULER_H
+#define RENDERING_UPLOADSCHEDULER_H
+
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+namespace Rendering {
+
+/**
+ * Global limit for the amount of data that is uploaded into graphics memory per frame.
+ * Uploads that are done implicitly when an object is drawn (e.g. the VBO creation in
+ * SimpleMeshDataStrategy::prepare(...) and the texture upload in Texture::_prepareForBinding(...))
+ * ask the scheduler for permission first. If the budget of the current frame is used up, the upload
+ * is queued and the object's previously uploaded data is used; if there is none, the object is not drawn.
+ * At the beginning of the next frame, the queued uploads are granted in the order of their importance
+ * (see setImportance(...)).
+ *
+ * Explicit calls of e.g. MeshVertexData::upload() are not affected.
+ * By default, the budget is unlimited.
+ * @note The application has to call beginFrame() once per frame when it sets a limit with setBytesPerFrame(...);
+ *	otherwise, the byte count is never reset and queued uploads are never granted.
+ * @note The uploads are requested from the gl-thread. As meshes and textures may be destroyed by other threads
+ *	(e.g. by worker threads creating and discarding meshes), cancelUpload(...) may be called from any thread;
+ *	therefore, all member functions are synchronized.
+ */
+class UploadScheduler {
+	public:
+		//! Return the global scheduler.
+		static UploadScheduler & getInstance();
+
+		UploadScheduler();
+
+		//! Maximum number of bytes per frame; use std::numeric_limits<std::size_t>::max() for no limit.
+		void setBytesPerFrame(std::size_t bytes);
+		std::size_t getBytesPerFrame()const;
+
+		/*! Start a new frame: Reset the byte count and grant the queued uploads with the
+			highest importance that fit into the budget (at least one upload is granted).
+			The importance values are reset.	*/
+		void beginFrame();
+
+		/*! Set the importance of the upload for @p object in the current frame (default: 0).
+			Queued uploads with a higher importance are granted first.	*/
+		void setImportance(const void * object, float importance);
+
+		/*! Ask for the permission to upload @p bytes for @p object now.
+			@return true if the upload may be done (the bytes are counted); false if the
+				upload has been queued. The caller has to ask again in a later frame.	*/
+		bool requestUpload(const void * object, std::size_t bytes);
+
+		/*! Remove the queued or granted upload and the importance of @p object
+			(e.g. when the object is destroyed before the upload is done).
+			\note May be called from any thread.	*/
+		void cancelUpload(const void * object);
+
+		//! Returns true iff an upload for @p object has been queued or granted, but not yet done.
+		bool isPending(const void * object)const;
+
+		//! Number of uploads that are queued or granted, but not yet done.
+		std::size_t getQueueDepth()const;
+		//! Number of bytes uploaded in the current frame.
+		std::size_t getUploadedBytes()const;
+		//! Number of bytes uploaded in the previous frame.
+		std::size_t getLastFrameUploadedBytes()const;
+
+	private:
+		struct Request {
+			std::size_t bytes;
+			float importance;
+		};
+		//! Guards all of the following members
+		mutable std::mutex mutex;
+		std::size_t bytesPerFrame;
+		std::size_t uploadedBytes;
+		std::size_t lastFrameUploadedBytes;
+		//! Sum of the bytes of all granted uploads
+		std::size_t reservedBytes;
+		std::unordered_map<const void *, Request> pending;
+		std::unordered_map<const void *, std::size_t> granted;
+		std::unordered_map<const void *, float> importances;
+};
+
+}
+
+#endif /* RENDERING_UPLOADSCHEDULER_H */
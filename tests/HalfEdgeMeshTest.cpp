@@ -0,0 +1,200 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "HalfEdgeMeshTest.h"
+#include <cppunit/TestAssert.h>
+#include <Geometry/Vec3.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/MeshIndexData.h>
+#include <Rendering/Mesh/MeshVertexData.h>
+#include <Rendering/Mesh/VertexAttributeAccessors.h>
+#include <Rendering/Mesh/VertexAttributeIds.h>
+#include <Rendering/Mesh/VertexDescription.h>
+#include <Rendering/MeshUtils/HalfEdgeMesh.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <utility>
+CPPUNIT_TEST_SUITE_REGISTRATION(HalfEdgeMeshTest);
+
+using namespace Rendering;
+using MeshUtils::HalfEdgeMesh;
+
+/*! Create a grid of @p width x @p height quads in the xy-plane. Vertex (x, y) has the index y * (width + 1) + x,
+	quad (x, y) consists of the faces 2 * (y * width + x) and 2 * (y * width + x) + 1,
+	and the diagonal of each quad goes from its lower left to its upper right corner. */
+static Mesh * createGridMesh(uint32_t width, uint32_t height) {
+	VertexDescription vd;
+	vd.appendPosition3D();
+	const uint32_t rowLength = width + 1;
+	Mesh * mesh = new Mesh(vd, rowLength * (height + 1), width * height * 6);
+	Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION));
+	for(uint32_t y = 0; y <= height; ++y) {
+		for(uint32_t x = 0; x < rowLength; ++x)
+			posAcc->setPosition(y * rowLength + x, Geometry::Vec3(static_cast<float>(x), static_cast<float>(y), 0.0f));
+	}
+	MeshIndexData & indices = mesh->openIndexData();
+	uint32_t i = 0;
+	for(uint32_t y = 0; y < height; ++y) {
+		for(uint32_t x = 0; x < width; ++x) {
+			const uint32_t corner = y * rowLength + x;
+			const uint32_t quadIndices[6] = {corner, corner + 1, corner + rowLength + 1, corner, corner + rowLength + 1, corner + rowLength};
+			for(const auto & index : quadIndices)
+				indices[i++] = index;
+		}
+	}
+	indices.updateIndexRange();
+	mesh->openVertexData().updateBoundingBox();
+	return mesh;
+}
+
+/*! Write @p heMesh to a mesh and check the result: it has the expected number of vertices and faces, no degenerate
+	faces, consistently oriented faces with every directed edge used only once, only manifold vertices, and the expected
+	Euler characteristic (vertices - edges + faces). */
+static void checkWrittenMesh(const HalfEdgeMesh & heMesh, uint32_t vertexCount, uint32_t faceCount, int32_t eulerCharacteristic) {
+	CPPUNIT_ASSERT_EQUAL(vertexCount, heMesh.getVertexCount());
+	CPPUNIT_ASSERT_EQUAL(faceCount, heMesh.getFaceCount());
+
+	Util::Reference<Mesh> mesh = createGridMesh(1, 1);
+	heMesh.writeToMesh(mesh.get());
+	CPPUNIT_ASSERT_EQUAL(vertexCount, mesh->getVertexCount());
+	CPPUNIT_ASSERT_EQUAL(faceCount * 3, mesh->getIndexCount());
+
+	const MeshIndexData & indices = mesh->openIndexData();
+	std::set<std::pair<uint32_t, uint32_t>> directedEdges;
+	std::set<std::pair<uint32_t, uint32_t>> edges;
+	for(uint32_t f = 0; f < faceCount; ++f) {
+		for(uint32_t i = 0; i < 3; ++i) {
+			const uint32_t origin = indices[f * 3 + i];
+			const uint32_t target = indices[f * 3 + (i + 1) % 3];
+			CPPUNIT_ASSERT(origin < vertexCount);
+			CPPUNIT_ASSERT(origin != target);
+			CPPUNIT_ASSERT(directedEdges.emplace(origin, target).second);
+			edges.emplace(std::min(origin, target), std::max(origin, target));
+		}
+	}
+	CPPUNIT_ASSERT_EQUAL(eulerCharacteristic, static_cast<int32_t>(vertexCount) - static_cast<int32_t>(edges.size()) + static_cast<int32_t>(faceCount));
+
+	Util::Reference<HalfEdgeMesh> written = HalfEdgeMesh::create(mesh.get());
+	CPPUNIT_ASSERT_EQUAL(faceCount, written->getFaceCount());
+	for(uint32_t v = 0; v < vertexCount; ++v)
+		CPPUNIT_ASSERT(written->isManifoldVertex(v));
+}
+
+void HalfEdgeMeshTest::testSplitEdge() {
+	Util::Reference<Mesh> mesh = createGridMesh(3, 3);
+	Util::Reference<HalfEdgeMesh> heMesh = HalfEdgeMesh::create(mesh.get());
+	checkWrittenMesh(*heMesh.get(), 16, 18, 1);
+
+	// inner edge: both faces are split
+	const uint32_t inner = heMesh->findHalfEdge(5, 10);
+	CPPUNIT_ASSERT(inner != HalfEdgeMesh::INVALID);
+	CPPUNIT_ASSERT(!heMesh->isBorder(inner));
+	const uint32_t innerVertex = heMesh->splitEdge(inner);
+	CPPUNIT_ASSERT(heMesh->getPosition(innerVertex) == Geometry::Vec3(1.5f, 1.5f, 0.0f));
+	CPPUNIT_ASSERT(!heMesh->isBorderVertex(innerVertex));
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(4), heMesh->getAdjacentVertices(innerVertex).size());
+	CPPUNIT_ASSERT_EQUAL(HalfEdgeMesh::INVALID, heMesh->findHalfEdge(5, 10));
+	checkWrittenMesh(*heMesh.get(), 17, 20, 1);
+
+	// border edge: only one face is split
+	const uint32_t border = heMesh->findHalfEdge(0, 1);
+	CPPUNIT_ASSERT(border != HalfEdgeMesh::INVALID);
+	CPPUNIT_ASSERT(heMesh->isBorder(border));
+	const uint32_t borderVertex = heMesh->splitEdge(border, 0.25f);
+	CPPUNIT_ASSERT(heMesh->getPosition(borderVertex) == Geometry::Vec3(0.25f, 0.0f, 0.0f));
+	CPPUNIT_ASSERT(heMesh->isBorderVertex(borderVertex));
+	checkWrittenMesh(*heMesh.get(), 18, 21, 1);
+}
+
+void HalfEdgeMeshTest::testFlipEdge() {
+	Util::Reference<Mesh> mesh = createGridMesh(3, 3);
+	Util::Reference<HalfEdgeMesh> heMesh = HalfEdgeMesh::create(mesh.get());
+
+	// the diagonal of quad (1, 1) is replaced by the other diagonal
+	CPPUNIT_ASSERT(heMesh->flipEdge(heMesh->findHalfEdge(5, 10)));
+	CPPUNIT_ASSERT_EQUAL(HalfEdgeMesh::INVALID, heMesh->findHalfEdge(5, 10));
+	CPPUNIT_ASSERT_EQUAL(HalfEdgeMesh::INVALID, heMesh->findHalfEdge(10, 5));
+	CPPUNIT_ASSERT(heMesh->findHalfEdge(6, 9) != HalfEdgeMesh::INVALID);
+	CPPUNIT_ASSERT(heMesh->findHalfEdge(9, 6) != HalfEdgeMesh::INVALID);
+	checkWrittenMesh(*heMesh.get(), 16, 18, 1);
+
+	// flipping back restores the original edge
+	CPPUNIT_ASSERT(heMesh->flipEdge(heMesh->findHalfEdge(6, 9)));
+	CPPUNIT_ASSERT(heMesh->findHalfEdge(5, 10) != HalfEdgeMesh::INVALID);
+	checkWrittenMesh(*heMesh.get(), 16, 18, 1);
+
+	// border edges cannot be flipped
+	CPPUNIT_ASSERT(!heMesh->flipEdge(heMesh->findHalfEdge(0, 1)));
+	checkWrittenMesh(*heMesh.get(), 16, 18, 1);
+}
+
+void HalfEdgeMeshTest::testCollapseEdge() {
+	{	// inner vertex 5 is merged into inner vertex 10
+		Util::Reference<Mesh> mesh = createGridMesh(3, 3);
+		Util::Reference<HalfEdgeMesh> heMesh = HalfEdgeMesh::create(mesh.get());
+		const uint32_t hIndex = heMesh->findHalfEdge(5, 10);
+		CPPUNIT_ASSERT(heMesh->isCollapseAllowed(hIndex));
+		CPPUNIT_ASSERT(heMesh->collapseEdge(hIndex));
+		CPPUNIT_ASSERT(heMesh->isVertexDeleted(5));
+		CPPUNIT_ASSERT(heMesh->getPosition(10) == Geometry::Vec3(2.0f, 2.0f, 0.0f));
+		CPPUNIT_ASSERT(heMesh->findHalfEdge(10, 0) != HalfEdgeMesh::INVALID);
+		checkWrittenMesh(*heMesh.get(), 15, 16, 1);
+	}
+	{	// border vertex 0 is merged into inner vertex 5
+		Util::Reference<Mesh> mesh = createGridMesh(3, 3);
+		Util::Reference<HalfEdgeMesh> heMesh = HalfEdgeMesh::create(mesh.get());
+		const uint32_t hIndex = heMesh->findHalfEdge(0, 5);
+		CPPUNIT_ASSERT(heMesh->isCollapseAllowed(hIndex));
+		CPPUNIT_ASSERT(heMesh->collapseEdge(hIndex));
+		CPPUNIT_ASSERT(heMesh->isBorderVertex(5));
+		checkWrittenMesh(*heMesh.get(), 15, 16, 1);
+	}
+	{	// in a single row of quads, every inner edge connects two border vertices
+		Util::Reference<Mesh> mesh = createGridMesh(3, 1);
+		Util::Reference<HalfEdgeMesh> heMesh = HalfEdgeMesh::create(mesh.get());
+		for(const auto & edge : {std::make_pair(1u, 6u), std::make_pair(1u, 5u), std::make_pair(5u, 1u)}) {
+			const uint32_t hIndex = heMesh->findHalfEdge(edge.first, edge.second);
+			CPPUNIT_ASSERT(hIndex != HalfEdgeMesh::INVALID);
+			CPPUNIT_ASSERT(!heMesh->isCollapseAllowed(hIndex));
+			CPPUNIT_ASSERT(!heMesh->collapseEdge(hIndex));
+		}
+		checkWrittenMesh(*heMesh.get(), 8, 6, 1);
+
+		// border edges of the strip can be collapsed
+		const uint32_t hIndex = heMesh->findHalfEdge(1, 2);
+		CPPUNIT_ASSERT(heMesh->isCollapseAllowed(hIndex));
+		CPPUNIT_ASSERT(heMesh->collapseEdge(hIndex));
+		checkWrittenMesh(*heMesh.get(), 7, 5, 1);
+	}
+}
+
+void HalfEdgeMeshTest::testDeleteFace() {
+	Util::Reference<Mesh> mesh = createGridMesh(3, 3);
+	Util::Reference<HalfEdgeMesh> heMesh = HalfEdgeMesh::create(mesh.get());
+
+	// a hole in the middle: the vertices of the face become border vertices
+	heMesh->deleteFace(8);
+	CPPUNIT_ASSERT(heMesh->isFaceDeleted(8));
+	CPPUNIT_ASSERT(heMesh->isBorderVertex(5));
+	CPPUNIT_ASSERT(heMesh->isBorder(heMesh->findHalfEdge(5, 10)));
+	checkWrittenMesh(*heMesh.get(), 16, 17, 0);
+
+	// filling the hole reuses the face slot
+	CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(8), heMesh->addFace(5, 6, 10));
+	CPPUNIT_ASSERT(!heMesh->isBorderVertex(5));
+	checkWrittenMesh(*heMesh.get(), 16, 18, 1);
+
+	// removing both faces at a corner keeps the corner as an unused vertex
+	heMesh->deleteFace(0);
+	heMesh->deleteFace(1);
+	CPPUNIT_ASSERT(!heMesh->isVertexDeleted(0));
+	CPPUNIT_ASSERT_EQUAL(HalfEdgeMesh::INVALID, heMesh->getVertexHalfEdge(0));
+	checkWrittenMesh(*heMesh.get(), 16, 16, 2);
+}
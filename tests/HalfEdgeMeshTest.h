@@ -0,0 +1,30 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_HALFEDGEMESHTEST_H
+#define RENDERING_HALFEDGEMESHTEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class HalfEdgeMeshTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(HalfEdgeMeshTest);
+	CPPUNIT_TEST(testSplitEdge);
+	CPPUNIT_TEST(testFlipEdge);
+	CPPUNIT_TEST(testCollapseEdge);
+	CPPUNIT_TEST(testDeleteFace);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void testSplitEdge();
+		void testFlipEdge();
+		void testCollapseEdge();
+		void testDeleteFace();
+};
+
+#endif /* RENDERING_HALFEDGEMESHTEST_H */
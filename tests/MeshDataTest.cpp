@@ -0,0 +1,464 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MeshDataTest.h"
+#include <cppunit/TestAssert.h>
+#include <Geometry/Box.h>
+#include <Geometry/Triangle.h>
+#include <Geometry/Vec2.h>
+#include <Geometry/Vec3.h>
+#include <Rendering/GLHeader.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/MeshIndexData.h>
+#include <Rendering/Mesh/MeshVertexData.h>
+#include <Rendering/Mesh/VertexAttributeAccessors.h>
+#include <Rendering/Mesh/VertexAttributeIds.h>
+#include <Rendering/Mesh/VertexDescription.h>
+#include <Rendering/MeshUtils/ConnectivityAccessor.h>
+#include <Rendering/MeshUtils/MeshUtils.h>
+#include <Rendering/MeshUtils/TriangleAccessor.h>
+#include <Rendering/Serialization/StreamerMMF.h>
+#include <Util/Graphics/Color.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+CPPUNIT_TEST_SUITE_REGISTRATION(MeshDataTest);
+
+using namespace Rendering;
+
+static Mesh * createMesh(uint32_t vertexCount) {
+	VertexDescription vd;
+	vd.appendPosition3D();
+	vd.appendNormalFloat();
+	Mesh * mesh = new Mesh(vd, vertexCount, vertexCount);
+	Util::Reference<PositionAttributeAccessor> positions(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION));
+	MeshIndexData & indices = mesh->openIndexData();
+	for(uint32_t i = 0; i < vertexCount; ++i) {
+		positions->setPosition(i, Geometry::Vec3(static_cast<float>(i), 0.0f, 0.0f));
+		indices[i] = i;
+	}
+	indices.updateIndexRange();
+	mesh->openVertexData().updateBoundingBox();
+	return mesh;
+}
+
+void MeshDataTest::testCopyOnWrite() {
+	Util::Reference<Mesh> original = createMesh(8);
+	const uint8_t * originalData = static_cast<const MeshVertexData &>(original->_getVertexData()).data();
+
+	{ // a copy shares the data; read-only access does not copy it
+		Util::Reference<Mesh> copy = original->clone();
+		const MeshVertexData & constVertices = copy->_getVertexData();
+		CPPUNIT_ASSERT(constVertices.hasSharedData());
+		CPPUNIT_ASSERT(copy->_getIndexData().hasSharedData());
+		CPPUNIT_ASSERT(constVertices.data() == originalData);
+
+		Util::Reference<PositionAttributeAccessor> reader(PositionAttributeAccessor::create(constVertices, VertexAttributeIds::POSITION));
+		CPPUNIT_ASSERT(reader->isReadOnly());
+		CPPUNIT_ASSERT_EQUAL(3.0f, reader->getPosition(3).x());
+		CPPUNIT_ASSERT(constVertices.hasSharedData());
+		CPPUNIT_ASSERT_THROW(reader->setPosition(3, Geometry::Vec3(0.0f, 0.0f, 0.0f)), std::logic_error);
+
+		// the first write copies the data of the written mesh only
+		Util::Reference<PositionAttributeAccessor> writer(PositionAttributeAccessor::create(copy->openVertexData(), VertexAttributeIds::POSITION));
+		CPPUNIT_ASSERT(constVertices.hasSharedData());
+		writer->setPosition(3, Geometry::Vec3(-1.0f, 0.0f, 0.0f));
+		CPPUNIT_ASSERT(!constVertices.hasSharedData());
+		CPPUNIT_ASSERT(constVertices.data() != originalData);
+		CPPUNIT_ASSERT_EQUAL(-1.0f, reader->getPosition(3).x());
+		CPPUNIT_ASSERT_EQUAL(-1.0f, writer->getPosition(3).x());
+	}
+	CPPUNIT_ASSERT(!original->_getVertexData().hasSharedData());
+
+	{ // an accessor created before the mesh is copied must not write into the copy
+		Util::Reference<PositionAttributeAccessor> writer(PositionAttributeAccessor::create(original->openVertexData(), VertexAttributeIds::POSITION));
+		Util::Reference<Mesh> copy = original->clone();
+		writer->setPosition(5, Geometry::Vec3(-5.0f, 0.0f, 0.0f));
+		Util::Reference<PositionAttributeAccessor> copyReader(PositionAttributeAccessor::create(static_cast<const MeshVertexData &>(copy->_getVertexData()), VertexAttributeIds::POSITION));
+		CPPUNIT_ASSERT_EQUAL(5.0f, copyReader->getPosition(5).x());
+		CPPUNIT_ASSERT_EQUAL(-5.0f, writer->getPosition(5).x());
+	}
+
+	{ // the batch functions copy shared data before the first write, too
+		const MeshVertexData & originalVertices = original->_getVertexData();
+		Util::Reference<PositionAttributeAccessor> originalReader(PositionAttributeAccessor::create(originalVertices, VertexAttributeIds::POSITION));
+		std::vector<Geometry::Vec3> originalPositions(8);
+		originalReader->getPositions(0, 8, originalPositions.data());
+
+		Util::Reference<Mesh> copy = original->clone();
+		Util::Reference<PositionAttributeAccessor> writer(PositionAttributeAccessor::create(copy->openVertexData(), VertexAttributeIds::POSITION));
+		const std::vector<Geometry::Vec3> newPositions(6, Geometry::Vec3(7.0f, 0.0f, 0.0f));
+		writer->setPositions(2, 6, newPositions.data());
+		CPPUNIT_ASSERT(!originalVertices.hasSharedData());
+
+		std::vector<Geometry::Vec3> positions(8);
+		originalReader->getPositions(0, 8, positions.data());
+		CPPUNIT_ASSERT(positions == originalPositions);
+		writer->getPositions(0, 8, positions.data());
+		CPPUNIT_ASSERT(positions[1] == originalPositions[1]);
+		CPPUNIT_ASSERT(std::equal(newPositions.begin(), newPositions.end(), positions.begin() + 2));
+	}
+
+	{ // writing indices copies them
+		Util::Reference<Mesh> copy = original->clone();
+		copy->openIndexData()[2] = 7;
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(2), static_cast<const MeshIndexData &>(original->_getIndexData())[2]);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(7), static_cast<const MeshIndexData &>(copy->_getIndexData())[2]);
+	}
+}
+
+void MeshDataTest::testIndexTypes() {
+	{ // 32bit indices are narrowed to 16bit; reading them keeps the type
+		Util::Reference<Mesh> mesh = createMesh(300);
+		const MeshIndexData & indices = mesh->_getIndexData();
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(GL_UNSIGNED_SHORT), indices.getIndexType());
+		CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(600), indices.dataSize());
+		const uint8_t * narrowedData = indices.rawData();
+
+		MeshUtils::getLongestSideLength(mesh.get());
+		Util::Reference<MeshUtils::TriangleAccessor> triangles(MeshUtils::TriangleAccessor::create(mesh.get()));
+		CPPUNIT_ASSERT_EQUAL(297.0f, triangles->getTriangle(99).getVertexA().x());
+		Util::Reference<MeshUtils::ConnectivityAccessor> connectivity(MeshUtils::ConnectivityAccessor::create(mesh.get()));
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(299), connectivity->getCornerVertex(connectivity->getVertexCorner(299)));
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(GL_UNSIGNED_SHORT), indices.getIndexType());
+		CPPUNIT_ASSERT(indices.rawData() == narrowedData);
+
+		// 300 does not fit into 8bit
+		CPPUNIT_ASSERT_THROW(mesh->openIndexData().setIndexType(GL_UNSIGNED_BYTE), std::invalid_argument);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(GL_UNSIGNED_SHORT), indices.getIndexType());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(299), indices[299]);
+	}
+	{ // access through a non-const reference keeps the type; only the typed pointer of the stored type is available
+		Util::Reference<Mesh> mesh = createMesh(300);
+		MeshIndexData & indices = mesh->openIndexData();
+		const uint8_t * narrowedData = indices.rawData();
+		const uint32_t value = indices[298];
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(298), value);
+		indices[0] = indices[299];
+		indices[1] = 65535;
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(GL_UNSIGNED_SHORT), indices.getIndexType());
+		CPPUNIT_ASSERT(indices.rawData() == narrowedData);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(299), static_cast<const MeshIndexData &>(indices)[0]);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(65535), static_cast<const MeshIndexData &>(indices)[1]);
+
+		CPPUNIT_ASSERT_THROW(indices.data(), std::logic_error);
+		CPPUNIT_ASSERT_THROW(indices.typedData<uint8_t>(), std::logic_error);
+		CPPUNIT_ASSERT(indices.typedData<uint16_t>() == reinterpret_cast<const uint16_t *>(narrowedData));
+
+		MeshUtils::reverseWinding(mesh.get());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(GL_UNSIGNED_SHORT), indices.getIndexType());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(2), static_cast<const MeshIndexData &>(indices)[0]);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(299), static_cast<const MeshIndexData &>(indices)[2]);
+	}
+	{ // 8bit -> 32bit (by writing) -> 16bit (by updateIndexRange)
+		Util::Reference<Mesh> mesh = createMesh(200);
+		MeshIndexData & indices = mesh->openIndexData();
+		indices.setIndexType(GL_UNSIGNED_BYTE);
+		CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(200), indices.dataSize());
+		for(uint32_t i = 0; i < 200; ++i)
+			CPPUNIT_ASSERT_EQUAL(i, static_cast<const MeshIndexData &>(indices)[i]);
+
+		indices[10] = 70000;
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(GL_UNSIGNED_INT), indices.getIndexType());
+		indices.updateIndexRange();
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(GL_UNSIGNED_INT), indices.getIndexType());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(70000), indices.getMaxIndex());
+
+		indices[10] = 10;
+		indices.updateIndexRange();
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(GL_UNSIGNED_SHORT), indices.getIndexType());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(199), indices.getMaxIndex());
+		for(uint32_t i = 0; i < 200; ++i)
+			CPPUNIT_ASSERT_EQUAL(i, static_cast<const MeshIndexData &>(indices)[i]);
+	}
+}
+
+void MeshDataTest::testMappedIndexRange() {
+	Util::Reference<Mesh> mesh = createMesh(300);
+	std::vector<uint32_t> indices32(300);
+	{ // the index range of the mesh is outdated on purpose
+		MeshIndexData & indices = mesh->openIndexData();
+		for(uint32_t i = 0; i < 300; ++i) {
+			indices32[i] = 5 + i % 290;
+			indices[i] = indices32[i];
+		}
+	}
+	const std::string path = "MeshDataTest_mapped.mmf";
+	auto loadMapped = [&path](const std::string & fileData) {
+		std::ofstream(path, std::ios::binary).write(fileData.data(), fileData.size());
+		Mesh * loaded = StreamerMMF::loadMeshMapped(path);
+		std::remove(path.c_str());
+		return loaded;
+	};
+	{ // saveMesh stores the actual range
+		std::ostringstream output;
+		CPPUNIT_ASSERT(StreamerMMF().saveMesh(mesh.get(), output));
+		Util::Reference<Mesh> loaded = loadMapped(output.str());
+		CPPUNIT_ASSERT(loaded.isNotNull());
+		const MeshIndexData & indices = loaded->_getIndexData();
+		CPPUNIT_ASSERT(indices.hasExternalData());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(5), indices.getMinIndex());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(294), indices.getMaxIndex());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(294), indices[289]);
+	}
+	auto writeFile = [&](bool withRange) {
+		std::ostringstream output;
+		const MeshVertexData & vertices = mesh->_getVertexData();
+		StreamerMMF::writeHeader(output);
+		StreamerMMF::writeVertexBlockHeader(output, vertices.getVertexDescription(), vertices.getVertexCount(), vertices.getBoundingBox());
+		output.write(reinterpret_cast<const char *>(vertices.data()), vertices.dataSize());
+		StreamerMMF::writeIndexBlockHeader(output, 300, GL_TRIANGLES);
+		output.write(reinterpret_cast<const char *>(indices32.data()), 300 * sizeof(uint32_t));
+		if(withRange)
+			StreamerMMF::writeIndexRange(output, 1, 2);
+		// unknown blocks are skipped
+		const uint32_t unknownBlock[4] = {0x10, 8, 0, 0};
+		output.write(reinterpret_cast<const char *>(unknownBlock), sizeof(unknownBlock));
+		StreamerMMF::writeEnd(output);
+		return output.str();
+	};
+	{ // the stored range is used as it is, without reading the indices
+		Util::Reference<Mesh> loaded = loadMapped(writeFile(true));
+		CPPUNIT_ASSERT(loaded.isNotNull());
+		CPPUNIT_ASSERT(loaded->_getIndexData().hasExternalData());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(1), loaded->_getIndexData().getMinIndex());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(2), loaded->_getIndexData().getMaxIndex());
+	}
+	{ // without a stored range (older files), the range is computed
+		Util::Reference<Mesh> loaded = loadMapped(writeFile(false));
+		CPPUNIT_ASSERT(loaded.isNotNull());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(300), loaded->getIndexCount());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(5), loaded->_getIndexData().getMinIndex());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(294), loaded->_getIndexData().getMaxIndex());
+	}
+}
+
+void MeshDataTest::testAttributeBatches() {
+	VertexDescription byteDescription;
+	byteDescription.appendPosition3D();
+	byteDescription.appendNormalByte();
+	byteDescription.appendColorRGBAByte();
+	byteDescription.appendTexCoord();
+	VertexDescription floatDescription;
+	floatDescription.appendPosition3D();
+	floatDescription.appendNormalFloat();
+	floatDescription.appendColorRGBAFloat();
+	floatDescription.appendTexCoord();
+
+	const uint32_t vertexCount = 37;
+	const uint32_t begin = 5;
+	const uint32_t count = 29;
+	std::vector<Geometry::Vec3> positions;
+	std::vector<Geometry::Vec3> normals;
+	std::vector<Util::Color4f> colors;
+	std::vector<Geometry::Vec2> coordinates;
+	for(uint32_t i = 0; i < count; ++i) {
+		const float f = static_cast<float>(i);
+		positions.emplace_back(f, 0.5f * f, -f);
+		normals.push_back(Geometry::Vec3(std::sin(f), std::cos(f), 0.5f).getNormalized());
+		colors.emplace_back(f / count, 1.0f - f / count, 0.25f, 0.5f);
+		coordinates.emplace_back(0.1f * f, 1.0f - 0.1f * f);
+	}
+
+	for(const auto & vd : {byteDescription, floatDescription}) {
+		// set the values vertex by vertex ...
+		MeshVertexData serialVertices;
+		serialVertices.allocate(vertexCount, vd);
+		{
+			Util::Reference<PositionAttributeAccessor> positionAcc = PositionAttributeAccessor::create(serialVertices, VertexAttributeIds::POSITION);
+			Util::Reference<NormalAttributeAccessor> normalAcc = NormalAttributeAccessor::create(serialVertices, VertexAttributeIds::NORMAL);
+			Util::Reference<ColorAttributeAccessor> colorAcc = ColorAttributeAccessor::create(serialVertices, VertexAttributeIds::COLOR);
+			Util::Reference<TexCoordAttributeAccessor> coordinateAcc = TexCoordAttributeAccessor::create(serialVertices, VertexAttributeIds::TEXCOORD0);
+			for(uint32_t i = 0; i < count; ++i) {
+				positionAcc->setPosition(begin + i, positions[i]);
+				normalAcc->setNormal(begin + i, normals[i]);
+				colorAcc->setColor(begin + i, colors[i]);
+				coordinateAcc->setCoordinate(begin + i, coordinates[i]);
+			}
+		}
+
+		// ... and as batches, which has to give the same data
+		MeshVertexData batchVertices;
+		batchVertices.allocate(vertexCount, vd);
+		Util::Reference<PositionAttributeAccessor> positionAcc = PositionAttributeAccessor::create(batchVertices, VertexAttributeIds::POSITION);
+		Util::Reference<NormalAttributeAccessor> normalAcc = NormalAttributeAccessor::create(batchVertices, VertexAttributeIds::NORMAL);
+		Util::Reference<ColorAttributeAccessor> colorAcc = ColorAttributeAccessor::create(batchVertices, VertexAttributeIds::COLOR);
+		Util::Reference<TexCoordAttributeAccessor> coordinateAcc = TexCoordAttributeAccessor::create(batchVertices, VertexAttributeIds::TEXCOORD0);
+		positionAcc->setPositions(begin, count, positions.data());
+		normalAcc->setNormals(begin, count, normals.data());
+		colorAcc->setColors(begin, count, colors.data());
+		coordinateAcc->setCoordinates(begin, count, coordinates.data());
+		CPPUNIT_ASSERT_EQUAL(serialVertices.dataSize(), batchVertices.dataSize());
+		CPPUNIT_ASSERT(std::equal(batchVertices.data(), batchVertices.data() + batchVertices.dataSize(), serialVertices.data()));
+
+		// reading batches gives the values of the single vertices
+		std::vector<Geometry::Vec3> batchPositions(vertexCount);
+		std::vector<Geometry::Vec3> batchNormals(vertexCount);
+		std::vector<Util::Color4f> batchColors(vertexCount);
+		std::vector<Geometry::Vec2> batchCoordinates(vertexCount);
+		positionAcc->getPositions(0, vertexCount, batchPositions.data());
+		normalAcc->getNormals(0, vertexCount, batchNormals.data());
+		colorAcc->getColors(0, vertexCount, batchColors.data());
+		coordinateAcc->getCoordinates(0, vertexCount, batchCoordinates.data());
+		const VertexAttributeView<const float> positionView(static_cast<const MeshVertexData &>(batchVertices), vd.getAttribute(VertexAttributeIds::POSITION));
+		CPPUNIT_ASSERT_EQUAL(vertexCount, positionView.size());
+		for(uint32_t v = 0; v < vertexCount; ++v) {
+			CPPUNIT_ASSERT(batchPositions[v] == positionAcc->getPosition(v));
+			CPPUNIT_ASSERT(batchNormals[v] == normalAcc->getNormal(v));
+			CPPUNIT_ASSERT(batchColors[v] == colorAcc->getColor4f(v));
+			CPPUNIT_ASSERT(batchCoordinates[v] == coordinateAcc->getCoordinate(v));
+			CPPUNIT_ASSERT(batchPositions[v] == Geometry::Vec3(positionView[v][0], positionView[v][1], positionView[v][2]));
+		}
+
+		// batches have to lie completely inside of the vertex data
+		CPPUNIT_ASSERT_THROW(positionAcc->getPositions(vertexCount - 1, 2, batchPositions.data()), std::range_error);
+		CPPUNIT_ASSERT_THROW(normalAcc->setNormals(1, vertexCount, normals.data()), std::range_error);
+		CPPUNIT_ASSERT_THROW(colorAcc->getColors(vertexCount + 1, 0, batchColors.data()), std::range_error);
+	}
+
+	// a view requires the matching data type
+	MeshVertexData vertices;
+	vertices.allocate(vertexCount, byteDescription);
+	CPPUNIT_ASSERT_THROW(VertexAttributeView<float>(vertices, byteDescription.getAttribute(VertexAttributeIds::NORMAL)), std::invalid_argument);
+	CPPUNIT_ASSERT_THROW(VertexAttributeView<float>(vertices, byteDescription.getAttribute(VertexAttributeIds::TANGENT)), std::invalid_argument);
+}
+
+void MeshDataTest::testBoundsAndIndexRange() {
+	std::mt19937 engine(42);
+	std::uniform_real_distribution<float> coordinateDist(-1000.0f, 1000.0f);
+	// small counts check the remainders of the vectorized loops, large counts are split into several chunks
+	const std::vector<uint32_t> counts = {1, 3, 7, 16, 17, 33, 3 * (1 << 18) + 7};
+
+	VertexDescription vd;
+	vd.appendPosition3D();
+	vd.appendColorRGBAByte();
+	for(const auto count : counts) {
+		MeshVertexData vertices;
+		vertices.allocate(count, vd);
+		Util::Reference<PositionAttributeAccessor> positionAcc = PositionAttributeAccessor::create(vertices, VertexAttributeIds::POSITION);
+		float min[3] = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+		float max[3] = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+		for(uint32_t v = 0; v < count; ++v) {
+			Geometry::Vec3 position(coordinateDist(engine), coordinateDist(engine), coordinateDist(engine));
+			if(v % 11 == 5) // NaNs are ignored
+				position.setY(std::numeric_limits<float>::quiet_NaN());
+			positionAcc->setPosition(v, position);
+			for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+				if(position[dim] < min[dim])
+					min[dim] = position[dim];
+				if(position[dim] > max[dim])
+					max[dim] = position[dim];
+			}
+		}
+		vertices.updateBoundingBox();
+		const Geometry::Box & box = vertices.getBoundingBox();
+		CPPUNIT_ASSERT_EQUAL(min[0], box.getMinX());
+		CPPUNIT_ASSERT_EQUAL(max[0], box.getMaxX());
+		CPPUNIT_ASSERT_EQUAL(min[1], box.getMinY());
+		CPPUNIT_ASSERT_EQUAL(max[1], box.getMaxY());
+		CPPUNIT_ASSERT_EQUAL(min[2], box.getMinZ());
+		CPPUNIT_ASSERT_EQUAL(max[2], box.getMaxZ());
+	}
+
+	for(const auto indexType : {GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT}) {
+		const uint32_t maxValue = indexType == GL_UNSIGNED_BYTE ? 255 : (indexType == GL_UNSIGNED_SHORT ? 65535 : 5000000);
+		std::uniform_int_distribution<uint32_t> indexDist(3, maxValue - 3);
+		for(const auto count : counts) {
+			MeshIndexData indices;
+			indices.allocate(count);
+			std::vector<uint32_t> values;
+			for(uint32_t i = 0; i < count; ++i) {
+				values.push_back(indexDist(engine));
+				indices.setIndex(i, values.back());
+			}
+			indices.setIndexType(indexType);
+			indices.updateIndexRange();
+			const auto range = std::minmax_element(values.begin(), values.end());
+			CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(indexType), indices.getIndexType());
+			CPPUNIT_ASSERT_EQUAL(*range.first, indices.getMinIndex());
+			CPPUNIT_ASSERT_EQUAL(*range.second, indices.getMaxIndex());
+		}
+	}
+}
+
+void MeshDataTest::testVertexDescriptionIds() {
+	std::vector<VertexDescription> descriptions(4);
+	descriptions[0].appendPosition3D();
+	descriptions[1].appendPosition3D();
+	descriptions[1].appendNormalByte();
+	descriptions[2].appendPosition3D();
+	descriptions[2].appendNormalFloat();
+	descriptions[3].appendPosition2D();
+	// descriptions that are only used in this test, registered by several threads at once
+	for(uint32_t i = 0; i < 16; ++i) {
+		VertexDescription vd;
+		vd.appendPosition3D();
+		vd.appendAttribute("testVertexDescriptionIds" + std::to_string(i / 2), 1 + i % 2, GL_FLOAT, false);
+		descriptions.push_back(vd);
+	}
+	descriptions.push_back(descriptions[1]);
+	descriptions.push_back(descriptions[5]);
+
+	std::vector<std::vector<uint32_t>> threadIds(4);
+	std::vector<std::vector<const VertexDescription *>> threadDescriptions(4);
+	{
+		std::vector<std::thread> threads;
+		for(std::size_t t = 0; t < threadIds.size(); ++t) {
+			threads.emplace_back([&, t]() {
+				for(std::size_t d = 0; d < descriptions.size(); ++d) {
+					// every thread uses another order
+					const VertexDescription & vd = descriptions[(d * (2 * t + 1)) % descriptions.size()];
+					MeshVertexData vertices;
+					vertices.allocate(2, vd);
+					threadIds[t].push_back(vertices.getVertexDescriptionId());
+					threadDescriptions[t].push_back(&vertices.getVertexDescription());
+				}
+			});
+		}
+		for(auto & thread : threads)
+			thread.join();
+	}
+
+	// ids and registered descriptions are equal iff the descriptions are equal
+	std::vector<uint32_t> ids(descriptions.size());
+	std::vector<const VertexDescription *> registered(descriptions.size());
+	for(std::size_t t = 0; t < threadIds.size(); ++t) {
+		for(std::size_t d = 0; d < descriptions.size(); ++d) {
+			const std::size_t index = (d * (2 * t + 1)) % descriptions.size();
+			if(t == 0) {
+				ids[index] = threadIds[t][d];
+				registered[index] = threadDescriptions[t][d];
+			}
+			CPPUNIT_ASSERT_EQUAL(ids[index], threadIds[t][d]);
+			CPPUNIT_ASSERT(registered[index] == threadDescriptions[t][d]);
+		}
+	}
+	for(std::size_t a = 0; a < descriptions.size(); ++a) {
+		CPPUNIT_ASSERT(*registered[a] == descriptions[a]);
+		for(std::size_t b = 0; b < descriptions.size(); ++b) {
+			CPPUNIT_ASSERT_EQUAL(descriptions[a] == descriptions[b], ids[a] == ids[b]);
+			CPPUNIT_ASSERT_EQUAL(descriptions[a] == descriptions[b], registered[a] == registered[b]);
+		}
+	}
+
+	// copies keep the id
+	Util::Reference<Mesh> mesh = createMesh(4);
+	Util::Reference<Mesh> copy = mesh->clone();
+	CPPUNIT_ASSERT_EQUAL(mesh->getVertexDescriptionId(), copy->getVertexDescriptionId());
+	CPPUNIT_ASSERT(&mesh->getVertexDescription() == &copy->getVertexDescription());
+}
@@ -0,0 +1,34 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHDATATEST_H
+#define RENDERING_MESHDATATEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class MeshDataTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(MeshDataTest);
+	CPPUNIT_TEST(testCopyOnWrite);
+	CPPUNIT_TEST(testIndexTypes);
+	CPPUNIT_TEST(testMappedIndexRange);
+	CPPUNIT_TEST(testAttributeBatches);
+	CPPUNIT_TEST(testBoundsAndIndexRange);
+	CPPUNIT_TEST(testVertexDescriptionIds);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void testCopyOnWrite();
+		void testIndexTypes();
+		void testMappedIndexRange();
+		void testAttributeBatches();
+		void testBoundsAndIndexRange();
+		void testVertexDescriptionIds();
+};
+
+#endif /* RENDERING_MESHDATATEST_H */
@@ -0,0 +1,1301 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MeshUtilsTest.h"
+#include <cppunit/TestAssert.h>
+#include <Geometry/Box.h>
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Plane.h>
+#include <Geometry/Triangle.h>
+#include <Geometry/Vec2.h>
+#include <Geometry/Vec3.h>
+#include <Rendering/GLHeader.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/MeshDataStrategy.h>
+#include <Rendering/Mesh/MeshIndexData.h>
+#include <Rendering/Mesh/MeshVertexData.h>
+#include <Rendering/Mesh/VertexAttributeAccessors.h>
+#include <Rendering/Mesh/VertexAttributeIds.h>
+#include <Rendering/Mesh/VertexDescription.h>
+#include <Rendering/MeshUtils/AsyncLoadingMeshDataStrategy.h>
+#include <Rendering/MeshUtils/BudgetMeshDataStrategy.h>
+#include <Rendering/MeshUtils/ConnectivityAccessor.h>
+#include <Rendering/MeshUtils/MeshAnalysis.h>
+#include <Rendering/MeshUtils/MeshLOD.h>
+#include <Rendering/MeshUtils/MeshUtils.h>
+#include <Rendering/MeshUtils/Meshlets.h>
+#include <Rendering/MeshUtils/OutOfCoreSimplification.h>
+#include <Rendering/MeshUtils/PlatonicSolids.h>
+#include <Rendering/MeshUtils/Simplification.h>
+#include <Rendering/Serialization/Serialization.h>
+#include <Util/IO/FileName.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+CPPUNIT_TEST_SUITE_REGISTRATION(MeshUtilsTest);
+
+using namespace Rendering;
+
+//! Create a triangle mesh with one vertex per index; vertex i is placed at @p positions[i].
+static Mesh * createMesh(const std::vector<Geometry::Vec3> & positions) {
+	VertexDescription vd;
+	vd.appendPosition3D();
+	const uint32_t count = static_cast<uint32_t>(positions.size());
+	Mesh * mesh = new Mesh(vd, count, count);
+	Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION));
+	MeshIndexData & indices = mesh->openIndexData();
+	for(uint32_t i = 0; i < count; ++i) {
+		posAcc->setPosition(i, positions[i]);
+		indices[i] = i;
+	}
+	indices.updateIndexRange();
+	mesh->openVertexData().updateBoundingBox();
+	return mesh;
+}
+
+//! Create a grid of @p size x @p size quads whose triangles are ordered badly for the vertex cache.
+static Mesh * createGridMesh(uint32_t size) {
+	VertexDescription vd;
+	vd.appendPosition3D();
+	const uint32_t rowLength = size + 1;
+	const uint32_t quadCount = size * size;
+	Mesh * mesh = new Mesh(vd, rowLength * rowLength, quadCount * 6);
+	Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION));
+	for(uint32_t y = 0; y < rowLength; ++y) {
+		for(uint32_t x = 0; x < rowLength; ++x)
+			posAcc->setPosition(y * rowLength + x, Geometry::Vec3(static_cast<float>(x), static_cast<float>(y), 0.0f));
+	}
+	MeshIndexData & indices = mesh->openIndexData();
+	for(uint32_t q = 0; q < quadCount; ++q) {
+		const uint32_t quad = (q * 7919) % quadCount; // 7919 is prime, so every quad is used once
+		const uint32_t corner = (quad / size) * rowLength + quad % size;
+		const uint32_t quadIndices[6] = {corner, corner + 1, corner + rowLength + 1, corner, corner + rowLength + 1, corner + rowLength};
+		for(uint32_t i = 0; i < 6; ++i)
+			indices[q * 6 + i] = quadIndices[i];
+	}
+	indices.updateIndexRange();
+	mesh->openVertexData().updateBoundingBox();
+	return mesh;
+}
+
+//! Create a grid of @p size x @p size quads (see createGridMesh(...)) on a wavy surface.
+static Mesh * createWavyGridMesh(uint32_t size) {
+	Mesh * mesh = createGridMesh(size);
+	MeshVertexData & vertices = mesh->openVertexData();
+	Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(vertices, VertexAttributeIds::POSITION));
+	for(uint32_t v = 0; v < vertices.getVertexCount(); ++v) {
+		Geometry::Vec3 position = posAcc->getPosition(v);
+		position.setZ(std::sin(position.x() * 0.3f) * std::cos(position.y() * 0.2f));
+		posAcc->setPosition(v, position);
+	}
+	vertices.updateBoundingBox();
+	return mesh;
+}
+
+//! Return the position referenced by every index of @p mesh.
+static std::vector<Geometry::Vec3> getIndexedPositions(Mesh * mesh) {
+	const MeshVertexData & vertices = mesh->openVertexData();
+	const MeshIndexData & indices = mesh->openIndexData();
+	Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(vertices, VertexAttributeIds::POSITION));
+	std::vector<Geometry::Vec3> result;
+	for(uint32_t i = 0; i < indices.getIndexCount(); ++i)
+		result.push_back(posAcc->getPosition(indices[i]));
+	return result;
+}
+
+/*! Create a mesh with @p vertexCount vertices with random data and 3 * @p vertexCount random indices.
+	The indices are stored with the given type, the vertices with the given layout.	*/
+static Mesh * createRandomMesh(const VertexDescription & vd, uint32_t vertexCount, uint32_t indexType, VertexLayout layout, std::mt19937 & engine) {
+	Mesh * mesh = new Mesh(vd, vertexCount, 3 * vertexCount);
+	MeshVertexData & vertices = mesh->openVertexData();
+	std::uniform_int_distribution<uint32_t> byteDistribution(0, 255);
+	uint8_t * bytes = vertices.data();
+	for(std::size_t i = 0; i < vertices.dataSize(); ++i)
+		bytes[i] = static_cast<uint8_t>(byteDistribution(engine));
+	// positions and normals get finite values, as they are transformed
+	std::uniform_real_distribution<float> coordinateDistribution(-10.0f, 10.0f);
+	Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(vertices, VertexAttributeIds::POSITION));
+	for(uint32_t i = 0; i < vertexCount; ++i)
+		posAcc->setPosition(i, Geometry::Vec3(coordinateDistribution(engine), coordinateDistribution(engine), coordinateDistribution(engine)));
+	if(vd.hasAttribute(VertexAttributeIds::NORMAL)) {
+		std::uniform_real_distribution<float> normalDistribution(-1.0f, 1.0f);
+		Util::Reference<NormalAttributeAccessor> normalAcc(NormalAttributeAccessor::create(vertices, VertexAttributeIds::NORMAL));
+		for(uint32_t i = 0; i < vertexCount; ++i)
+			normalAcc->setNormal(i, Geometry::Vec3(normalDistribution(engine), normalDistribution(engine), normalDistribution(engine)));
+	}
+	vertices.updateBoundingBox();
+	vertices.setLayout(layout);
+
+	MeshIndexData & indices = mesh->openIndexData();
+	std::uniform_int_distribution<uint32_t> indexDistribution(0, vertexCount - 1);
+	for(uint32_t i = 0; i < indices.getIndexCount(); ++i)
+		indices[i] = indexDistribution(engine);
+	indices.updateIndexRange();
+	indices.setIndexType(indexType);
+	return mesh;
+}
+
+/*! Combine the meshes like MeshUtils::combineMeshes did before it was parallelized: one mesh after the other
+	is appended, and its vertices are transformed by MeshUtils::transformCoordinates and MeshUtils::transformNormals.	*/
+static Mesh * combineMeshesSerially(const std::vector<std::pair<Mesh *, Geometry::Matrix4x4>> & meshes) {
+	Mesh * firstMesh = meshes.front().first;
+	const VertexDescription & vd = firstMesh->getVertexDescription();
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	for(const auto & entry : meshes) {
+		if(entry.first->getVertexDescriptionId() == firstMesh->getVertexDescriptionId()) {
+			vertexCount += entry.first->getVertexCount();
+			indexCount += entry.first->getIndexCount();
+		}
+	}
+	Mesh * combined = new Mesh(vd, vertexCount, indexCount);
+	MeshVertexData & vertices = combined->openVertexData();
+	MeshIndexData & indices = combined->openIndexData();
+	uint32_t vertexPointer = 0;
+	uint32_t indexPointer = 0;
+	for(const auto & entry : meshes) {
+		if(entry.first->getVertexDescriptionId() != firstMesh->getVertexDescriptionId())
+			continue;
+		const MeshIndexData & currentIndices = entry.first->openIndexData();
+		for(uint32_t i = 0; i < currentIndices.getIndexCount(); ++i)
+			indices[indexPointer + i] = currentIndices[i] + vertexPointer;
+		indexPointer += currentIndices.getIndexCount();
+
+		MeshVertexData currentVertices(entry.first->openVertexData());
+		currentVertices.setLayout(VertexLayout::INTERLEAVED);
+		const uint32_t currentVertexCount = currentVertices.getVertexCount();
+		const uint8_t * begin = static_cast<const MeshVertexData &>(currentVertices).data();
+		std::copy(begin, begin + currentVertexCount * vd.getVertexSize(), vertices.data() + vertexPointer * vd.getVertexSize());
+		if(entry.second != Geometry::Matrix4x4()) {
+			MeshUtils::transformCoordinates(vertices, VertexAttributeIds::POSITION, entry.second, vertexPointer, currentVertexCount);
+			if(vd.hasAttribute(VertexAttributeIds::NORMAL))
+				MeshUtils::transformNormals(vertices, VertexAttributeIds::NORMAL, entry.second, vertexPointer, currentVertexCount);
+		}
+		vertexPointer += currentVertexCount;
+	}
+	vertices.updateBoundingBox();
+	indices.updateIndexRange();
+	return combined;
+}
+
+/*! Check that @p actual contains the same indices and vertices as @p expected. Transformed float positions and normals
+	may differ by rounding; all other attributes have to be equal byte by byte.	*/
+static void checkCombinedMesh(Mesh * expected, Mesh * actual) {
+	CPPUNIT_ASSERT(actual != nullptr);
+	CPPUNIT_ASSERT_EQUAL(expected->getVertexDescriptionId(), actual->getVertexDescriptionId());
+	CPPUNIT_ASSERT_EQUAL(expected->getVertexCount(), actual->getVertexCount());
+	CPPUNIT_ASSERT_EQUAL(expected->getIndexCount(), actual->getIndexCount());
+
+	const MeshIndexData & expectedIndices = expected->openIndexData();
+	const MeshIndexData & actualIndices = actual->openIndexData();
+	for(uint32_t i = 0; i < expectedIndices.getIndexCount(); ++i)
+		CPPUNIT_ASSERT_EQUAL(expectedIndices[i], actualIndices[i]);
+
+	const MeshVertexData & expectedVertices = expected->openVertexData();
+	const MeshVertexData & actualVertices = actual->openVertexData();
+	CPPUNIT_ASSERT(actualVertices.getLayout() == VertexLayout::INTERLEAVED);
+	for(const auto & attr : expectedVertices.getVertexDescription().getAttributes()) {
+		const bool transformed = attr.getDataType() == GL_FLOAT &&
+				(attr.getNameId() == VertexAttributeIds::POSITION || attr.getNameId() == VertexAttributeIds::NORMAL);
+		for(uint32_t v = 0; v < expectedVertices.getVertexCount(); ++v) {
+			const uint8_t * expectedValue = expectedVertices[v] + attr.getOffset();
+			const uint8_t * actualValue = actualVertices[v] + attr.getOffset();
+			if(!transformed) {
+				CPPUNIT_ASSERT(std::equal(expectedValue, expectedValue + attr.getDataSize(), actualValue));
+				continue;
+			}
+			for(uint8_t c = 0; c < attr.getNumValues(); ++c) {
+				const float e = reinterpret_cast<const float *>(expectedValue)[c];
+				const float a = reinterpret_cast<const float *>(actualValue)[c];
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(e, a, 1.0e-5 * std::max(1.0f, std::abs(e)));
+			}
+		}
+	}
+}
+
+void MeshUtilsTest::testCombineMeshes() {
+	std::mt19937 engine(7);
+	VertexDescription vd;
+	vd.appendPosition3D();
+	vd.appendNormalFloat();
+	vd.appendColorRGBAByte();
+	vd.appendTexCoord();
+
+	// Enough vertices to combine the meshes in several threads, with all index types and both layouts.
+	const uint32_t indexTypes[3] = {GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT};
+	std::vector<Util::Reference<Mesh>> sources;
+	for(uint32_t i = 0; i < 30; ++i) {
+		const uint32_t indexType = indexTypes[i % 3];
+		const uint32_t vertexCount = indexType == GL_UNSIGNED_BYTE ? 200 + i : 5000 + 97 * i;
+		sources.emplace_back(createRandomMesh(vd, vertexCount, indexType, i % 4 == 1 ? VertexLayout::SEPARATE : VertexLayout::INTERLEAVED, engine));
+	}
+	// a mesh with another vertex description is skipped
+	VertexDescription otherVd;
+	otherVd.appendPosition3D();
+	sources.insert(sources.begin() + 5, createRandomMesh(otherVd, 100, GL_UNSIGNED_SHORT, VertexLayout::INTERLEAVED, engine));
+
+	// identity, affine and projective transformations (w stays within [0.7, 1.3])
+	const Geometry::Matrix4x4 identity;
+	const Geometry::Matrix4x4 affine(0.0f, -2.0f, 0.0f, 1.0f, 2.0f, 0.0f, 0.0f, -3.0f, 0.0f, 0.0f, 0.5f, 7.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	const Geometry::Matrix4x4 projective(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.01f, 0.02f, 0.0f, 1.0f);
+	const Geometry::Matrix4x4 * matrices[3] = {&identity, &affine, &projective};
+
+	std::deque<Mesh *> meshArray;
+	std::deque<Geometry::Matrix4x4> transformations;
+	std::vector<std::pair<Mesh *, Geometry::Matrix4x4>> untransformedMeshes;
+	std::vector<std::pair<Mesh *, Geometry::Matrix4x4>> transformedMeshes;
+	std::vector<uint32_t> sourceIndexTypes;
+	std::vector<VertexLayout> sourceLayouts;
+	for(uint32_t i = 0; i < sources.size(); ++i) {
+		Mesh * source = sources[i].get();
+		meshArray.push_back(source);
+		transformations.push_back(*matrices[i % 3]);
+		untransformedMeshes.emplace_back(source, identity);
+		transformedMeshes.emplace_back(source, *matrices[i % 3]);
+		sourceIndexTypes.push_back(source->_getIndexData().getIndexType());
+		sourceLayouts.push_back(source->_getVertexData().getLayout());
+	}
+
+	{
+		Util::Reference<Mesh> expected = combineMeshesSerially(untransformedMeshes);
+		Util::Reference<Mesh> combined = MeshUtils::combineMeshes(meshArray);
+		checkCombinedMesh(expected.get(), combined.get());
+	}
+	{
+		Util::Reference<Mesh> expected = combineMeshesSerially(transformedMeshes);
+		Util::Reference<Mesh> combinedDeque = MeshUtils::combineMeshes(meshArray, transformations);
+		checkCombinedMesh(expected.get(), combinedDeque.get());
+		Util::Reference<Mesh> combinedVector = MeshUtils::combineMeshes(transformedMeshes);
+		checkCombinedMesh(expected.get(), combinedVector.get());
+	}
+	// the source meshes keep their index types and layouts
+	for(uint32_t i = 0; i < sources.size(); ++i) {
+		CPPUNIT_ASSERT_EQUAL(sourceIndexTypes[i], sources[i]->_getIndexData().getIndexType());
+		CPPUNIT_ASSERT(sourceLayouts[i] == sources[i]->_getVertexData().getLayout());
+	}
+
+	{ // byte normals are transformed by the accessors
+		VertexDescription byteNormalVd;
+		byteNormalVd.appendPosition3D();
+		byteNormalVd.appendNormalByte();
+		Util::Reference<Mesh> first = createRandomMesh(byteNormalVd, 300, GL_UNSIGNED_SHORT, VertexLayout::INTERLEAVED, engine);
+		Util::Reference<Mesh> second = createRandomMesh(byteNormalVd, 500, GL_UNSIGNED_INT, VertexLayout::SEPARATE, engine);
+		Util::Reference<Mesh> third = createRandomMesh(byteNormalVd, 100, GL_UNSIGNED_BYTE, VertexLayout::INTERLEAVED, engine);
+		const std::vector<std::pair<Mesh *, Geometry::Matrix4x4>> meshes = {
+			std::make_pair(first.get(), affine), std::make_pair(second.get(), projective), std::make_pair(third.get(), identity)
+		};
+		Util::Reference<Mesh> expected = combineMeshesSerially(meshes);
+		Util::Reference<Mesh> combined = MeshUtils::combineMeshes(meshes);
+		checkCombinedMesh(expected.get(), combined.get());
+	}
+}
+
+void MeshUtilsTest::testEliminateDuplicateVertices() {
+	// Enough vertices to split the hash table into several partitions. Most vertices have only a few
+	// distinct values, so the partitions are filled very unevenly.
+	std::vector<Geometry::Vec3> positions;
+	const uint32_t vertexCount = 3 * 200000;
+	for(uint32_t i = 0; i < vertexCount; ++i) {
+		if(i % 4 == 0)
+			positions.emplace_back(static_cast<float>(i), 1.0f, 2.0f);
+		else
+			positions.emplace_back(static_cast<float>(i % 3), 0.0f, 0.0f);
+	}
+	const uint32_t distinctCount = vertexCount / 4 + 3;
+
+	for(const bool parallel : {false, true}) {
+		Util::Reference<Mesh> mesh = createMesh(positions);
+		MeshUtils::eliminateDuplicateVertices(mesh.get(), parallel);
+		CPPUNIT_ASSERT_EQUAL(distinctCount, mesh->getVertexCount());
+		CPPUNIT_ASSERT_EQUAL(vertexCount, mesh->getIndexCount());
+		CPPUNIT_ASSERT(getIndexedPositions(mesh.get()) == positions);
+		// the vertices are ordered by their first use
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(0), static_cast<const MeshIndexData &>(mesh->_getIndexData())[0]);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(1), static_cast<const MeshIndexData &>(mesh->_getIndexData())[1]);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(2), static_cast<const MeshIndexData &>(mesh->_getIndexData())[5]);
+	}
+
+	{ // only equal vertices
+		Util::Reference<Mesh> mesh = createMesh(std::vector<Geometry::Vec3>(vertexCount, Geometry::Vec3(1.0f, 2.0f, 3.0f)));
+		MeshUtils::eliminateDuplicateVertices(mesh.get(), true);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(1), mesh->getVertexCount());
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(0), mesh->_getIndexData().getMaxIndex());
+	}
+
+	{ // an index referencing a non-existing vertex
+		Util::Reference<Mesh> mesh = createMesh(std::vector<Geometry::Vec3>(6, Geometry::Vec3(0.0f, 0.0f, 0.0f)));
+		mesh->openIndexData()[4] = 6;
+		CPPUNIT_ASSERT_THROW(MeshUtils::eliminateDuplicateVertices(mesh.get()), std::out_of_range);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(6), mesh->getVertexCount());
+	}
+}
+
+void MeshUtilsTest::testMergeCloseVertices() {
+	const float inf = std::numeric_limits<float>::infinity();
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	const float max = std::numeric_limits<float>::max();
+
+	{ // chains of close vertices, also across cell borders and the origin
+		const std::vector<Geometry::Vec3> positions = {
+			Geometry::Vec3(0.0f, 0.0f, 0.0f), Geometry::Vec3(0.04f, 0.0f, 0.0f), Geometry::Vec3(0.08f, 0.0f, 0.0f),
+			Geometry::Vec3(0.99f, 1.0f, 1.0f), Geometry::Vec3(1.01f, 1.0f, 1.0f), Geometry::Vec3(-0.01f, 0.01f, 0.0f),
+			Geometry::Vec3(5.0f, 5.0f, 5.0f), Geometry::Vec3(5.0f, 5.0f, 5.06f), Geometry::Vec3(-5.0f, -5.0f, -5.0f)
+		};
+		Util::Reference<Mesh> mesh = createMesh(positions);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(4), MeshUtils::mergeCloseVertices(mesh.get(), 0.05f));
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(5), mesh->getVertexCount());
+		const std::vector<Geometry::Vec3> merged = getIndexedPositions(mesh.get());
+		// the vertices are merged into the one that is used first
+		CPPUNIT_ASSERT(merged[1] == positions[0] && merged[2] == positions[0] && merged[5] == positions[0]);
+		CPPUNIT_ASSERT(merged[4] == positions[3]);
+		CPPUNIT_ASSERT(merged[6] == positions[6] && merged[7] == positions[7] && merged[8] == positions[8]);
+	}
+
+	{ // vertices with non-finite coordinates are kept, even with an infinite tolerance
+		const std::vector<Geometry::Vec3> positions = {
+			Geometry::Vec3(nan, 0.0f, 0.0f), Geometry::Vec3(nan, 0.0f, 0.0f), Geometry::Vec3(inf, inf, inf),
+			Geometry::Vec3(inf, inf, inf), Geometry::Vec3(0.0f, -inf, 0.0f), Geometry::Vec3(max, max, max),
+			Geometry::Vec3(-max, -max, -max), Geometry::Vec3(max, max, max), Geometry::Vec3(0.0f, 0.0f, 0.0f)
+		};
+		for(const float tolerance : {0.0f, 0.05f, max, inf}) {
+			Util::Reference<Mesh> mesh = createMesh(positions);
+			MeshUtils::mergeCloseVertices(mesh.get(), tolerance);
+			// with a huge tolerance, the finite vertices are connected by the vertex at the origin
+			const uint32_t finiteCount = tolerance >= max ? 1 : 3;
+			CPPUNIT_ASSERT_EQUAL(5 + finiteCount, mesh->getVertexCount());
+			CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(9), mesh->getIndexCount());
+		}
+	}
+
+	{ // exact comparison for a zero tolerance; tiny tolerances with huge coordinates
+		const std::vector<Geometry::Vec3> positions = {
+			Geometry::Vec3(0.0f, 0.0f, 0.0f), Geometry::Vec3(-0.0f, 0.0f, -0.0f), Geometry::Vec3(std::numeric_limits<float>::denorm_min(), 0.0f, 0.0f),
+			Geometry::Vec3(1.0e30f, 0.0f, 0.0f), Geometry::Vec3(1.0e30f, 0.0f, 0.0f), Geometry::Vec3(1.0000001e30f, 0.0f, 0.0f),
+			Geometry::Vec3(-1.0e30f, 0.0f, 0.0f), Geometry::Vec3(-1.0e30f, 0.0f, 0.0f), Geometry::Vec3(-max, 0.0f, 0.0f)
+		};
+		for(const float tolerance : {0.0f, std::numeric_limits<float>::denorm_min()}) {
+			Util::Reference<Mesh> mesh = createMesh(positions);
+			const uint32_t expectedCount = tolerance == 0.0f ? 6 : 5;
+			CPPUNIT_ASSERT_EQUAL(9 - expectedCount, MeshUtils::mergeCloseVertices(mesh.get(), tolerance));
+			CPPUNIT_ASSERT_EQUAL(expectedCount, mesh->getVertexCount());
+		}
+	}
+
+	{ // an index referencing a non-existing vertex
+		Util::Reference<Mesh> mesh = createMesh(std::vector<Geometry::Vec3>(6, Geometry::Vec3(0.0f, 0.0f, 0.0f)));
+		mesh->openIndexData()[4] = 6;
+		CPPUNIT_ASSERT_THROW(MeshUtils::mergeCloseVertices(mesh.get()), std::out_of_range);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(6), mesh->getVertexCount());
+	}
+}
+
+void MeshUtilsTest::testEliminateTriangles() {
+	VertexDescription vd;
+	vd.appendNormalFloat();
+	vd.appendPosition3D();
+	vd.appendColorRGBAByte();
+	std::mt19937 interleavedEngine(11);
+	std::mt19937 separateEngine(11);
+	Util::Reference<Mesh> interleaved = createRandomMesh(vd, 300, GL_UNSIGNED_INT, VertexLayout::INTERLEAVED, interleavedEngine);
+	Util::Reference<Mesh> separate = createRandomMesh(vd, 300, GL_UNSIGNED_SHORT, VertexLayout::SEPARATE, separateEngine);
+	// some degenerate triangles
+	for(uint32_t i = 0; i < 30; i += 3) {
+		interleaved->openIndexData()[i + 1] = interleaved->openIndexData()[i];
+		separate->openIndexData()[i + 1] = separate->openIndexData()[i];
+	}
+	const std::vector<Geometry::Vec3> positions = getIndexedPositions(interleaved.get());
+	CPPUNIT_ASSERT(positions == getIndexedPositions(separate.get()));
+	const uint32_t triangleCount = static_cast<uint32_t>(positions.size() / 3);
+
+	{ // the remaining vertices keep all of their attributes
+		Util::Reference<Mesh> fromInterleaved = MeshUtils::eliminateUnusedVertices(interleaved.get());
+		Util::Reference<Mesh> fromSeparate = MeshUtils::eliminateUnusedVertices(separate.get());
+		const MeshIndexData & indices = interleaved->openIndexData();
+		std::set<uint32_t> usedVertices;
+		for(uint32_t i = 0; i < indices.getIndexCount(); ++i)
+			usedVertices.insert(indices[i]);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(usedVertices.size()), fromInterleaved->getVertexCount());
+		CPPUNIT_ASSERT(positions == getIndexedPositions(fromInterleaved.get()));
+		checkCombinedMesh(fromInterleaved.get(), fromSeparate.get());
+	}
+	{
+		const Geometry::Plane plane(Geometry::Vec3(1.0f, 0.0f, 0.0f), Geometry::Vec3(1.0f, 1.0f, 0.0f));
+		std::vector<Geometry::Vec3> expected;
+		for(uint32_t t = 0; t < triangleCount; ++t) {
+			if(plane.planeTest(positions[3 * t]) >= 0.0f && plane.planeTest(positions[3 * t + 1]) >= 0.0f && plane.planeTest(positions[3 * t + 2]) >= 0.0f)
+				expected.insert(expected.end(), positions.begin() + 3 * t, positions.begin() + 3 * t + 3);
+		}
+		CPPUNIT_ASSERT(!expected.empty() && expected.size() < positions.size());
+		Util::Reference<Mesh> fromInterleaved = MeshUtils::eliminateTrianglesBehindPlane(interleaved.get(), plane);
+		Util::Reference<Mesh> fromSeparate = MeshUtils::eliminateTrianglesBehindPlane(separate.get(), plane);
+		CPPUNIT_ASSERT(expected == getIndexedPositions(fromInterleaved.get()));
+		CPPUNIT_ASSERT(expected == getIndexedPositions(fromSeparate.get()));
+	}
+	{
+		std::vector<Geometry::Vec3> expected;
+		for(uint32_t t = 0; t < triangleCount; ++t) {
+			if(!Geometry::Triangle<Geometry::Vec3f>(positions[3 * t], positions[3 * t + 1], positions[3 * t + 2]).isDegenerate())
+				expected.insert(expected.end(), positions.begin() + 3 * t, positions.begin() + 3 * t + 3);
+		}
+		CPPUNIT_ASSERT(expected.size() <= positions.size() - 30);
+		Util::Reference<Mesh> fromInterleaved = MeshUtils::eliminateZeroAreaTriangles(interleaved.get());
+		Util::Reference<Mesh> fromSeparate = MeshUtils::eliminateZeroAreaTriangles(separate.get());
+		CPPUNIT_ASSERT(expected == getIndexedPositions(fromInterleaved.get()));
+		CPPUNIT_ASSERT(expected == getIndexedPositions(fromSeparate.get()));
+	}
+	{
+		Util::Reference<Mesh> fromInterleaved = MeshUtils::eliminateLongTriangles(interleaved.get(), 3.0f);
+		Util::Reference<Mesh> fromSeparate = MeshUtils::eliminateLongTriangles(separate.get(), 3.0f);
+		CPPUNIT_ASSERT(fromInterleaved->getIndexCount() > 0 && fromInterleaved->getIndexCount() < positions.size());
+		checkCombinedMesh(fromInterleaved.get(), fromSeparate.get());
+	}
+	{
+		Util::Reference<Mesh> fromInterleaved = MeshUtils::removeSkinsWithHoleCovering(interleaved.get(), 0.5f, 0.1f);
+		Util::Reference<Mesh> fromSeparate = MeshUtils::removeSkinsWithHoleCovering(separate.get(), 0.5f, 0.1f);
+		CPPUNIT_ASSERT(fromInterleaved->getIndexCount() > 0 && fromInterleaved->getIndexCount() < positions.size());
+		CPPUNIT_ASSERT(fromSeparate->openVertexData().getLayout() == VertexLayout::SEPARATE);
+		CPPUNIT_ASSERT(getIndexedPositions(fromInterleaved.get()) == getIndexedPositions(fromSeparate.get()));
+		CPPUNIT_ASSERT(getIndexedPositions(fromInterleaved.get()) != getIndexedPositions(interleaved.get()));
+	}
+}
+
+void MeshUtilsTest::testVertexCacheStatistics() {
+	{ // FIFO cache
+		const std::vector<uint32_t> indices = {0, 1, 2, 0, 1, 2};
+		const MeshUtils::VertexCacheStatistics large = MeshUtils::calculateVertexCacheStatistics(indices, 3, 3);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(3), large.transformedVertices);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(1.5, large.acmr, 1.0e-6);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, large.atvr, 1.0e-6);
+		const MeshUtils::VertexCacheStatistics small = MeshUtils::calculateVertexCacheStatistics(indices, 3, 2);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(6), small.transformedVertices);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, small.acmr, 1.0e-6);
+		// cache sizes beyond 8 bit
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(3), MeshUtils::calculateVertexCacheStatistics(indices, 3, 1000).transformedVertices);
+	}
+
+	Util::Reference<Mesh> mesh = createGridMesh(32);
+	const uint32_t vertexCount = mesh->getVertexCount();
+	const MeshUtils::VertexCacheStatistics unoptimized = MeshUtils::calculateVertexCacheStatistics(mesh.get(), 16);
+	CPPUNIT_ASSERT(unoptimized.transformedVertices >= vertexCount);
+
+	const MeshUtils::OptimizationReport indicesReport = MeshUtils::optimizeIndices(mesh.get(), 16);
+	CPPUNIT_ASSERT_EQUAL(unoptimized.transformedVertices, indicesReport.before.transformedVertices);
+	CPPUNIT_ASSERT(indicesReport.after.transformedVertices < indicesReport.before.transformedVertices);
+	CPPUNIT_ASSERT(indicesReport.after.transformedVertices >= vertexCount);
+	CPPUNIT_ASSERT_EQUAL(indicesReport.after.transformedVertices, MeshUtils::calculateVertexCacheStatistics(mesh.get(), 16).transformedVertices);
+
+	const MeshUtils::OptimizationReport overdrawReport = MeshUtils::optimizeOverdraw(mesh.get(), 16, 1.05f);
+	CPPUNIT_ASSERT_EQUAL(indicesReport.after.transformedVertices, overdrawReport.before.transformedVertices);
+	CPPUNIT_ASSERT_EQUAL(overdrawReport.after.transformedVertices, MeshUtils::calculateVertexCacheStatistics(mesh.get(), 16).transformedVertices);
+
+	const MeshUtils::OptimizationReport fetchReport = MeshUtils::optimizeVertexFetch(mesh.get(), 16);
+	CPPUNIT_ASSERT_EQUAL(fetchReport.before.transformedVertices, fetchReport.after.transformedVertices);
+	CPPUNIT_ASSERT_EQUAL(vertexCount, mesh->getVertexCount());
+	CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(32 * 32 * 6), mesh->getIndexCount());
+
+	// indices referencing non-existing vertices are rejected before the mesh is changed
+	mesh->openIndexData()[7] = vertexCount;
+	CPPUNIT_ASSERT_THROW(MeshUtils::calculateVertexCacheStatistics(mesh.get(), 16), std::out_of_range);
+	CPPUNIT_ASSERT_THROW(MeshUtils::optimizeIndices(mesh.get(), 16), std::out_of_range);
+	CPPUNIT_ASSERT_THROW(MeshUtils::optimizeOverdraw(mesh.get(), 16, 1.05f), std::out_of_range);
+	CPPUNIT_ASSERT_THROW(MeshUtils::optimizeVertexFetch(mesh.get(), 16), std::out_of_range);
+	CPPUNIT_ASSERT_EQUAL(vertexCount, static_cast<const MeshIndexData &>(mesh->_getIndexData())[7]);
+}
+
+void MeshUtilsTest::testSimplifyMeshLockedVertices() {
+	const uint32_t size = 16;
+	Util::Reference<Mesh> mesh = createWavyGridMesh(size);
+	MeshUtils::calculateNormals(mesh.get());
+	const MeshVertexData & vertices = mesh->_getVertexData();
+	const std::size_t vertexSize = vertices.getVertexDescription().getVertexSize();
+
+	// lock the border of the grid
+	const uint32_t rowLength = size + 1;
+	std::vector<bool> lockedVertices(vertices.getVertexCount(), false);
+	std::vector<std::vector<uint8_t>> lockedData;
+	for(uint32_t v = 0; v < vertices.getVertexCount(); ++v) {
+		const uint32_t x = v % rowLength;
+		const uint32_t y = v / rowLength;
+		if(x == 0 || y == 0 || x == size || y == size) {
+			lockedVertices[v] = true;
+			lockedData.emplace_back(vertices[v], vertices[v] + vertexSize);
+		}
+	}
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(4 * size), lockedData.size());
+
+	MeshUtils::Simplification::weights_t weights;
+	weights.fill(1.0f);
+	const uint32_t target = 200;
+	Util::Reference<Mesh> result = MeshUtils::Simplification::simplifyMesh(mesh.get(), target, 0.0f, true, -1.0f, weights, lockedVertices, false);
+	CPPUNIT_ASSERT(result.isNotNull());
+	CPPUNIT_ASSERT_EQUAL(target, result->getPrimitiveCount());
+
+	// every locked vertex is still used and its data is unchanged
+	const MeshVertexData & resultVertices = result->_getVertexData();
+	CPPUNIT_ASSERT(resultVertices.getVertexDescription() == vertices.getVertexDescription());
+	std::set<std::vector<uint8_t>> resultData;
+	for(uint32_t v = 0; v < resultVertices.getVertexCount(); ++v)
+		resultData.emplace(resultVertices[v], resultVertices[v] + vertexSize);
+	for(const auto & data : lockedData)
+		CPPUNIT_ASSERT(resultData.count(data) == 1);
+
+	// a mismatching number of flags is rejected
+	lockedVertices.pop_back();
+	CPPUNIT_ASSERT_THROW(MeshUtils::Simplification::simplifyMesh(mesh.get(), target, 0.0f, true, -1.0f, weights, lockedVertices, false), std::invalid_argument);
+}
+
+void MeshUtilsTest::testSimplifyMeshOutOfCore() {
+	// wavy surface with 2 * 64 * 64 triangles
+	Util::Reference<Mesh> mesh = createWavyGridMesh(64);
+	const Geometry::Box & inputBox = mesh->getBoundingBox();
+	const std::string path = "MeshUtilsTest_outOfCore";
+	CPPUNIT_ASSERT(Serialization::saveMesh(mesh.get(), Util::FileName(path + ".mmf")));
+	CPPUNIT_ASSERT(Serialization::saveMesh(mesh.get(), Util::FileName(path + ".ply")));
+
+	MeshUtils::Simplification::OutOfCoreParameters parameters;
+	parameters.trianglesPerCell = 2048;
+	parameters.maxTrianglesInMemory = 2100; // one cell per batch
+	parameters.threadCount = 2;
+	parameters.temporaryPath = path;
+	const uint32_t target = 2000;
+	std::ostringstream mmfResult;
+	CPPUNIT_ASSERT(MeshUtils::Simplification::simplifyMeshOutOfCore(Util::FileName(path + ".mmf"), target, "mmf", mmfResult, parameters));
+	std::ostringstream plyResult;
+	CPPUNIT_ASSERT(MeshUtils::Simplification::simplifyMeshOutOfCore(Util::FileName(path + ".ply"), target, "mmf", plyResult, parameters));
+	std::remove((path + ".mmf").c_str());
+	std::remove((path + ".ply").c_str());
+	// the temporary files are removed
+	CPPUNIT_ASSERT(!std::ifstream(path + ".ooc-vertices"));
+	CPPUNIT_ASSERT(!std::ifstream(path + ".ooc-input.mmf"));
+	// the .ply file is converted to the same data
+	CPPUNIT_ASSERT(mmfResult.str() == plyResult.str());
+
+	Util::Reference<Mesh> result = Serialization::loadMesh("mmf", mmfResult.str());
+	CPPUNIT_ASSERT(result.isNotNull());
+	CPPUNIT_ASSERT(result->getPrimitiveCount() <= target);
+	CPPUNIT_ASSERT(result->getPrimitiveCount() + 10 >= target);
+	// the borders of the surface are kept
+	const Geometry::Box & resultBox = result->getBoundingBox();
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(inputBox.getMinX(), resultBox.getMinX(), 1.0e-4);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(inputBox.getMaxX(), resultBox.getMaxX(), 1.0e-4);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(inputBox.getMinY(), resultBox.getMinY(), 1.0e-4);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(inputBox.getMaxY(), resultBox.getMaxY(), 1.0e-4);
+	CPPUNIT_ASSERT(resultBox.getMinZ() >= inputBox.getMinZ() - 0.1f && resultBox.getMaxZ() <= inputBox.getMaxZ() + 0.1f);
+	// all vertices are used and the bounding box stored in the file is correct
+	MeshVertexData & resultVertices = result->openVertexData();
+	std::vector<bool> used(resultVertices.getVertexCount(), false);
+	const MeshIndexData & resultIndices = result->openIndexData();
+	for(uint32_t i = 0; i < resultIndices.getIndexCount(); ++i)
+		used[resultIndices[i]] = true;
+	CPPUNIT_ASSERT(std::find(used.begin(), used.end(), false) == used.end());
+	const Geometry::Box storedBox = resultBox;
+	resultVertices.updateBoundingBox();
+	CPPUNIT_ASSERT(storedBox == resultVertices.getBoundingBox());
+}
+
+void MeshUtilsTest::testConnectivityAccessor() {
+	const uint32_t invalid = 0xffffffff;
+	Util::Reference<Mesh> mesh = createGridMesh(16);
+	const uint32_t triangleCount = mesh->getPrimitiveCount();
+	Util::Reference<MeshUtils::ConnectivityAccessor> full(MeshUtils::ConnectivityAccessor::create(mesh.get()));
+
+	// the triangles of the quads in [4, 10] x [4, 10]
+	std::set<uint32_t> patch;
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		uint32_t a, b, c;
+		std::tie(a, b, c) = full->getTriangle(t);
+		bool inside = true;
+		for(const uint32_t v : {a, b, c}) {
+			const Geometry::Vec3 position = full->getVertex(v);
+			inside = inside && position.x() >= 4.0f && position.x() <= 10.0f && position.y() >= 4.0f && position.y() <= 10.0f;
+		}
+		if(inside)
+			patch.insert(t);
+	}
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(2 * 6 * 6), patch.size());
+	Util::Reference<MeshUtils::ConnectivityAccessor> partial(MeshUtils::ConnectivityAccessor::create(mesh.get(), patch));
+
+	auto restrictToPatch = [&patch](const std::vector<uint32_t> & triangles) {
+		std::vector<uint32_t> result;
+		for(const auto t : triangles)
+			if(patch.count(t) > 0)
+				result.push_back(t);
+		return result;
+	};
+
+	// vertex adjacency is the full adjacency restricted to the patch
+	for(uint32_t v = 0; v < mesh->getVertexCount(); ++v) {
+		const std::vector<uint32_t> expected = restrictToPatch(full->getVertexAdjacentTriangles(v));
+		CPPUNIT_ASSERT(expected == partial->getVertexAdjacentTriangles(v));
+		std::set<uint32_t> expectedVertices;
+		for(const auto t : expected) {
+			uint32_t a, b, c;
+			std::tie(a, b, c) = full->getTriangle(t);
+			expectedVertices.insert({a, b, c});
+		}
+		expectedVertices.erase(v);
+		CPPUNIT_ASSERT(std::vector<uint32_t>(expectedVertices.begin(), expectedVertices.end()) == partial->getVertexAdjacentVertices(v));
+		if(expected.empty()) {
+			CPPUNIT_ASSERT_EQUAL(invalid, partial->getVertexCorner(v));
+		} else {
+			CPPUNIT_ASSERT_EQUAL(v, partial->getCornerVertex(partial->getVertexCorner(v)));
+		}
+	}
+
+	// triangle adjacency and border edges
+	std::set<std::pair<uint32_t, uint32_t>> patchEdges;
+	for(const auto t : patch) {
+		uint32_t a, b, c;
+		std::tie(a, b, c) = full->getTriangle(t);
+		patchEdges.insert({std::make_pair(a, b), std::make_pair(b, c), std::make_pair(c, a)});
+	}
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		if(patch.count(t) == 0) {
+			CPPUNIT_ASSERT_EQUAL(invalid, partial->getNextVertexCorner(t * 3));
+			CPPUNIT_ASSERT(full->getNextVertexCorner(t * 3) != invalid);
+			continue;
+		}
+		CPPUNIT_ASSERT(restrictToPatch(full->getAdjacentTriangles(t)) == partial->getAdjacentTriangles(t));
+		uint32_t a, b, c;
+		std::tie(a, b, c) = full->getTriangle(t);
+		for(const auto & edge : {std::make_pair(a, b), std::make_pair(b, c), std::make_pair(c, a)}) {
+			const bool patchBorder = patchEdges.count(std::make_pair(edge.second, edge.first)) == 0;
+			CPPUNIT_ASSERT_EQUAL(patchBorder, partial->isBorderEdge(edge.first, edge.second));
+		}
+	}
+
+	{ // cutting along x = 5.5 creates one vertex per cut edge, shared by both triangles of the edge
+		Util::Reference<Mesh> cut = createGridMesh(16);
+		MeshUtils::cutMesh(cut.get(), Geometry::Plane(Geometry::Vec3(5.5f, 0.0f, 0.0f), Geometry::Vec3(1.0f, 0.0f, 0.0f)));
+		// 17 horizontal edges and 16 diagonals are cut; the 32 triangles in between are split into three triangles each
+		CPPUNIT_ASSERT_EQUAL(17u * 17u + 17u + 16u, cut->getVertexCount());
+		CPPUNIT_ASSERT_EQUAL(triangleCount + 2 * 32, cut->getPrimitiveCount());
+		Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(cut->openVertexData(), VertexAttributeIds::POSITION));
+		for(uint32_t v = 17 * 17; v < cut->getVertexCount(); ++v)
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(5.5, posAcc->getPosition(v).x(), 1.0e-5);
+		float area = 0.0f;
+		const MeshIndexData & indices = cut->openIndexData();
+		for(uint32_t i = 0; i < indices.getIndexCount(); i += 3)
+			area += Geometry::Triangle<Geometry::Vec3>(posAcc->getPosition(indices[i]), posAcc->getPosition(indices[i + 1]), posAcc->getPosition(indices[i + 2])).calcArea();
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(256.0, area, 1.0e-3);
+	}
+	{ // extruding the patch adds two triangles per edge of its border (24 edges), with shared or with separate vertices
+		Util::Reference<Mesh> extruded = createGridMesh(16);
+		MeshUtils::extrudeTriangles(extruded.get(), Geometry::Vec3(0.0f, 0.0f, 1.0f), patch);
+		CPPUNIT_ASSERT_EQUAL(triangleCount + 2 * 24, extruded->getPrimitiveCount());
+
+		std::vector<Geometry::Vec3> positions;
+		for(uint32_t t = 0; t < triangleCount; ++t) {
+			uint32_t a, b, c;
+			std::tie(a, b, c) = full->getTriangle(t);
+			positions.insert(positions.end(), {full->getVertex(a), full->getVertex(b), full->getVertex(c)});
+		}
+		Util::Reference<Mesh> separate = createMesh(positions);
+		MeshUtils::extrudeTriangles(separate.get(), Geometry::Vec3(0.0f, 0.0f, 1.0f), patch);
+		CPPUNIT_ASSERT_EQUAL(triangleCount + 2 * 24, separate->getPrimitiveCount());
+	}
+}
+
+//! Serial implementation of calculateTangentVectors(...) (Lengyel); returns the four tangent bytes of every vertex.
+static std::vector<int8_t> calculateTangentsSerially(const std::vector<Geometry::Vec3> & positions, const std::vector<Geometry::Vec2> & uvs,
+													 const std::vector<Geometry::Vec3> & normals, const MeshIndexData & indices) {
+	std::vector<Geometry::Vec3> tan1(positions.size());
+	std::vector<Geometry::Vec3> tan2(positions.size());
+	for(uint32_t i = 0; i < indices.getIndexCount(); i += 3) {
+		const uint32_t index[3] = {indices[i], indices[i + 1], indices[i + 2]};
+		const Geometry::Vec3 edge1 = positions[index[1]] - positions[index[0]];
+		const Geometry::Vec3 edge2 = positions[index[2]] - positions[index[0]];
+		const Geometry::Vec2 uvEdge1 = uvs[index[1]] - uvs[index[0]];
+		const Geometry::Vec2 uvEdge2 = uvs[index[2]] - uvs[index[0]];
+		const float r = 1.0f / (uvEdge1.x() * uvEdge2.y() - uvEdge2.x() * uvEdge1.y());
+		const Geometry::Vec3 sdir = (edge1 * uvEdge2.y() - edge2 * uvEdge1.y()) * r;
+		const Geometry::Vec3 tdir = (edge2 * uvEdge1.x() - edge1 * uvEdge2.x()) * r;
+		for(const auto v : index) {
+			tan1[v] += sdir;
+			tan2[v] += tdir;
+		}
+	}
+	std::vector<int8_t> tangents;
+	for(std::size_t v = 0; v < positions.size(); ++v) {
+		const Geometry::Vec3 & n = normals[v];
+		const Geometry::Vec3 tangent = (tan1[v] - n * n.dot(tan1[v])).getNormalized() * 127.0f;
+		tangents.push_back(static_cast<int8_t>(tangent.x()));
+		tangents.push_back(static_cast<int8_t>(tangent.y()));
+		tangents.push_back(static_cast<int8_t>(tangent.z()));
+		tangents.push_back(n.cross(tan1[v]).dot(tan2[v]) < 0.0f ? -1 : 1);
+	}
+	return tangents;
+}
+
+//! Return the four tangent bytes of every vertex.
+static std::vector<int8_t> getTangents(Mesh * mesh, Util::StringIdentifier tangentName) {
+	const MeshVertexData & vertices = mesh->_getVertexData();
+	const VertexAttribute & attr = vertices.getVertexDescription().getAttribute(tangentName);
+	std::vector<int8_t> tangents;
+	for(uint32_t v = 0; v < vertices.getVertexCount(); ++v) {
+		const int8_t * tangent = reinterpret_cast<const int8_t *>(vertices.getAttributeData(attr) + v * vertices.getAttributeStride(attr));
+		tangents.insert(tangents.end(), tangent, tangent + 4);
+	}
+	return tangents;
+}
+
+void MeshUtilsTest::testTangentSpace() {
+	const Util::StringIdentifier tangentName("sg_Tangent");
+	// wavy grid with distorted texture coordinates and without normals
+	Util::Reference<Mesh> mesh;
+	{
+		Util::Reference<Mesh> grid = createGridMesh(64);
+		VertexDescription vd;
+		vd.appendPosition3D();
+		vd.appendTexCoord();
+		mesh = new Mesh(vd, grid->getVertexCount(), grid->getIndexCount());
+		Util::Reference<PositionAttributeAccessor> gridPositions(PositionAttributeAccessor::create(grid->openVertexData(), VertexAttributeIds::POSITION));
+		Util::Reference<PositionAttributeAccessor> positions(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION));
+		Util::Reference<TexCoordAttributeAccessor> uvs(TexCoordAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::TEXCOORD0));
+		for(uint32_t v = 0; v < mesh->getVertexCount(); ++v) {
+			const Geometry::Vec3 position = gridPositions->getPosition(v);
+			positions->setPosition(v, Geometry::Vec3(position.x(), position.y(), std::sin(position.x() * 0.3f) * std::cos(position.y() * 0.2f)));
+			uvs->setCoordinate(v, Geometry::Vec2(position.x() / 64.0f + 0.01f * std::sin(position.y()), position.y() / 64.0f));
+		}
+		MeshIndexData gridIndices(grid->_getIndexData());
+		mesh->openIndexData().swap(gridIndices);
+		mesh->openVertexData().updateBoundingBox();
+	}
+	const uint32_t vertexCount = mesh->getVertexCount();
+	std::vector<Geometry::Vec3> positions(vertexCount);
+	std::vector<Geometry::Vec2> uvs(vertexCount);
+	PositionAttributeAccessor::create(mesh->_getVertexData(), VertexAttributeIds::POSITION)->getPositions(0, vertexCount, positions.data());
+	TexCoordAttributeAccessor::create(mesh->_getVertexData(), VertexAttributeIds::TEXCOORD0)->getCoordinates(0, vertexCount, uvs.data());
+
+	// normals and tangents together; a copy sharing the data is not changed
+	Util::Reference<Mesh> combined = mesh->clone();
+	MeshUtils::calculateNormalsAndTangentVectors(combined.get(), VertexAttributeIds::TEXCOORD0, tangentName);
+	CPPUNIT_ASSERT(!mesh->getVertexDescription().hasAttribute(VertexAttributeIds::NORMAL));
+
+	// the normals are the same as those of calculateNormals
+	Util::Reference<Mesh> separate = mesh->clone();
+	MeshUtils::calculateNormals(separate.get());
+	std::vector<Geometry::Vec3> normals(vertexCount);
+	std::vector<Geometry::Vec3> combinedNormals(vertexCount);
+	NormalAttributeAccessor::create(separate->_getVertexData(), VertexAttributeIds::NORMAL)->getNormals(0, vertexCount, normals.data());
+	NormalAttributeAccessor::create(combined->_getVertexData(), VertexAttributeIds::NORMAL)->getNormals(0, vertexCount, combinedNormals.data());
+	CPPUNIT_ASSERT(normals == combinedNormals);
+
+	// the tangents from the stored normals are the same as those of the serial implementation (up to rounding)
+	MeshUtils::calculateTangentVectors(separate.get(), VertexAttributeIds::TEXCOORD0, tangentName);
+	const std::vector<int8_t> expected = calculateTangentsSerially(positions, uvs, normals, separate->_getIndexData());
+	const std::vector<int8_t> actual = getTangents(separate.get(), tangentName);
+	CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+	for(std::size_t i = 0; i < expected.size(); ++i)
+		CPPUNIT_ASSERT(std::abs(expected[i] - actual[i]) <= 1);
+
+	// the tangents orthogonalized against the exact normals differ only slightly
+	const std::vector<int8_t> combinedTangents = getTangents(combined.get(), tangentName);
+	for(std::size_t i = 0; i < expected.size(); ++i)
+		CPPUNIT_ASSERT(i % 4 == 3 ? expected[i] == combinedTangents[i] : std::abs(expected[i] - combinedTangents[i]) <= 3);
+
+	{ // separate vertex layout
+		Util::Reference<Mesh> separateLayout = mesh->clone();
+		separateLayout->openVertexData().setLayout(VertexLayout::SEPARATE);
+		MeshUtils::calculateNormalsAndTangentVectors(separateLayout.get(), VertexAttributeIds::TEXCOORD0, tangentName);
+		CPPUNIT_ASSERT(combinedTangents == getTangents(separateLayout.get(), tangentName));
+		std::vector<Geometry::Vec3> separateNormals(vertexCount);
+		NormalAttributeAccessor::create(separateLayout->_getVertexData(), VertexAttributeIds::NORMAL)->getNormals(0, vertexCount, separateNormals.data());
+		CPPUNIT_ASSERT(combinedNormals == separateNormals);
+	}
+}
+
+//! Return the corner positions of the triangles in the index range [@p firstIndex, @p firstIndex + @p indexCount) of @p mesh.
+static std::vector<Geometry::Vec3> getTrianglePositions(Mesh * mesh, uint32_t firstIndex, uint32_t indexCount) {
+	Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(mesh->_getVertexData(), VertexAttributeIds::POSITION));
+	const MeshIndexData & indices = mesh->_getIndexData();
+	std::vector<Geometry::Vec3> positions;
+	for(uint32_t i = firstIndex; i < firstIndex + indexCount; ++i)
+		positions.push_back(posAcc->getPosition(indices[i]));
+	return positions;
+}
+
+void MeshUtilsTest::testMeshLOD() {
+	Util::Reference<Mesh> meshA = createWavyGridMesh(32);
+	Util::Reference<Mesh> meshB = createWavyGridMesh(24);
+	MeshUtils::MeshLOD::Parameters parameters;
+	parameters.maxLevelCount = 4;
+	parameters.minTriangleCount = 64;
+
+	Util::Reference<MeshUtils::MeshLOD> lodA = MeshUtils::MeshLOD::create(meshA.get(), parameters);
+	Util::Reference<MeshUtils::MeshLOD> lodB = MeshUtils::MeshLOD::create(meshB.get(), parameters);
+	for(const auto & lod : {lodA, lodB}) {
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(4), lod->getLevelCount());
+		CPPUNIT_ASSERT(!lod->isSharingVertexData());
+		CPPUNIT_ASSERT_EQUAL(0.0f, lod->getError(0));
+		for(uint32_t level = 1; level < lod->getLevelCount(); ++level) {
+			CPPUNIT_ASSERT(lod->getTriangleCount(level) <= lod->getTriangleCount(level - 1) / 2);
+			CPPUNIT_ASSERT(lod->getTriangleCount(level) >= parameters.minTriangleCount);
+			CPPUNIT_ASSERT_EQUAL(lod->getMesh(level)->getPrimitiveCount(), lod->getTriangleCount(level));
+			CPPUNIT_ASSERT(lod->getError(level) > lod->getError(level - 1));
+		}
+	}
+	CPPUNIT_ASSERT(lodA->getMesh(0) == meshA.get());
+	CPPUNIT_ASSERT_EQUAL(meshA->getPrimitiveCount(), lodA->getTriangleCount(0));
+
+	// several meshes processed in parallel give the same levels as single meshes
+	const std::vector<Util::Reference<MeshUtils::MeshLOD>> lods = MeshUtils::MeshLOD::create(std::vector<Mesh *>{meshA.get(), meshB.get()}, parameters);
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(2), lods.size());
+	for(std::size_t i = 0; i < lods.size(); ++i) {
+		const Util::Reference<MeshUtils::MeshLOD> & expected = i == 0 ? lodA : lodB;
+		CPPUNIT_ASSERT_EQUAL(expected->getLevelCount(), lods[i]->getLevelCount());
+		for(uint32_t level = 0; level < expected->getLevelCount(); ++level) {
+			CPPUNIT_ASSERT_EQUAL(expected->getError(level), lods[i]->getError(level));
+			CPPUNIT_ASSERT(getTrianglePositions(expected->getMesh(level), 0, expected->getIndexCount(level))
+							== getTrianglePositions(lods[i]->getMesh(level), 0, lods[i]->getIndexCount(level)));
+		}
+	}
+
+	// with shared vertex data, every level is an index range of one mesh containing the same triangles
+	parameters.shareVertexData = true;
+	const std::vector<Util::Reference<MeshUtils::MeshLOD>> sharedLods = MeshUtils::MeshLOD::create(std::vector<Mesh *>{meshA.get(), meshB.get()}, parameters);
+	for(std::size_t i = 0; i < sharedLods.size(); ++i) {
+		const Util::Reference<MeshUtils::MeshLOD> & expected = i == 0 ? lodA : lodB;
+		const Util::Reference<MeshUtils::MeshLOD> & shared = sharedLods[i];
+		CPPUNIT_ASSERT(shared->isSharingVertexData());
+		CPPUNIT_ASSERT_EQUAL(expected->getLevelCount(), shared->getLevelCount());
+		uint32_t firstIndex = 0;
+		for(uint32_t level = 0; level < shared->getLevelCount(); ++level) {
+			CPPUNIT_ASSERT(shared->getMesh(level) == shared->getMesh(0));
+			CPPUNIT_ASSERT_EQUAL(firstIndex, shared->getFirstIndex(level));
+			CPPUNIT_ASSERT_EQUAL(expected->getError(level), shared->getError(level));
+			CPPUNIT_ASSERT(getTrianglePositions(expected->getMesh(level), 0, expected->getIndexCount(level))
+							== getTrianglePositions(shared->getMesh(level), shared->getFirstIndex(level), shared->getIndexCount(level)));
+			firstIndex += shared->getIndexCount(level);
+		}
+		CPPUNIT_ASSERT_EQUAL(firstIndex, shared->getMesh(0)->getIndexCount());
+		CPPUNIT_ASSERT(shared->getMesh(0)->getVertexDescription() == meshA->getVertexDescription());
+	}
+}
+
+//! Count the memory of @p meshes like BudgetMeshDataStrategy: shared data and buffers once, main memory usage first.
+static std::pair<std::size_t, std::size_t> countMemoryUsage(const std::vector<Mesh *> & meshes) {
+	std::set<const void *> counted;
+	std::size_t mainMemory = meshes.size() * sizeof(Mesh);
+	std::size_t graphicsMemory = 0;
+	for(const auto & mesh : meshes) {
+		const MeshVertexData & vertices = mesh->_getVertexData();
+		const MeshIndexData & indices = mesh->_getIndexData();
+		if(vertices.dataSize() > 0 && counted.insert(vertices.data()).second)
+			mainMemory += vertices.dataSize();
+		if(indices.dataSize() > 0 && counted.insert(indices.rawData()).second)
+			mainMemory += indices.dataSize();
+		if(vertices.isUploaded() && counted.insert(vertices._getBufferId()).second)
+			graphicsMemory += vertices.getVertexCount() * vertices.getVertexDescription().getVertexSize();
+		if(indices.isUploaded() && counted.insert(indices._getBufferId()).second)
+			graphicsMemory += indices.getIndexCount() * indices.getIndexSize();
+	}
+	return std::make_pair(mainMemory, graphicsMemory);
+}
+
+void MeshUtilsTest::testBudgetMeshDataStrategy() {
+	std::unique_ptr<BudgetMeshDataStrategy> strategy(new BudgetMeshDataStrategy(std::numeric_limits<std::size_t>::max(), std::numeric_limits<std::size_t>::max()));
+	const auto checkUsage = [&strategy](const std::vector<Mesh *> & meshes) {
+		const std::pair<std::size_t, std::size_t> usage = countMemoryUsage(meshes);
+		CPPUNIT_ASSERT_EQUAL(meshes.size(), strategy->getMeshCount());
+		CPPUNIT_ASSERT_EQUAL(usage.first, strategy->getMainMemoryUsage());
+		CPPUNIT_ASSERT_EQUAL(usage.second, strategy->getGraphicsMemoryUsage());
+	};
+
+	Util::Reference<Mesh> meshA = createGridMesh(8);
+	Util::Reference<Mesh> meshC = createGridMesh(5);
+	const std::vector<uint8_t> verticesA(meshA->_getVertexData().data(), meshA->_getVertexData().data() + meshA->_getVertexData().dataSize());
+	meshA->setDataStrategy(strategy.get());
+	strategy->prepare(meshA.get());
+	// the copy shares the local data and the buffers
+	Util::Reference<Mesh> meshB = meshA->clone();
+	meshB->setDataStrategy(strategy.get());
+	strategy->prepare(meshB.get());
+	meshC->setDataStrategy(strategy.get());
+	strategy->prepare(meshC.get());
+	CPPUNIT_ASSERT(meshA->_getVertexData().isUploaded() && meshC->_getIndexData().isUploaded());
+	checkUsage({meshA.get(), meshB.get(), meshC.get()});
+
+	// exceeding the main memory budget releases the uploaded local data
+	strategy->setBudgets(3 * sizeof(Mesh), std::numeric_limits<std::size_t>::max());
+	strategy->enforceBudgets(nullptr);
+	checkUsage({meshA.get(), meshB.get(), meshC.get()});
+	CPPUNIT_ASSERT_EQUAL(3 * sizeof(Mesh), strategy->getMainMemoryUsage());
+	CPPUNIT_ASSERT(!meshA->_getVertexData().hasLocalData() && !meshB->_getIndexData().hasLocalData());
+
+	// accessing the data downloads it again
+	MeshVertexData & downloadedVertices = meshA->openVertexData();
+	CPPUNIT_ASSERT(std::equal(verticesA.begin(), verticesA.end(), static_cast<const MeshVertexData &>(downloadedVertices).data()));
+	checkUsage({meshA.get(), meshB.get(), meshC.get()});
+
+	// exceeding the graphics memory budget removes buffers that have a local copy; every mesh keeps one copy of its data
+	meshB->openIndexData();
+	meshC->openVertexData();
+	strategy->setBudgets(std::numeric_limits<std::size_t>::max(), 0);
+	strategy->enforceBudgets(meshC.get());
+	checkUsage({meshA.get(), meshB.get(), meshC.get()});
+	for(const auto & mesh : {meshA, meshB, meshC}) {
+		CPPUNIT_ASSERT(mesh->_getVertexData().hasLocalData() || mesh->_getVertexData().isUploaded());
+		CPPUNIT_ASSERT(mesh->_getIndexData().hasLocalData() || mesh->_getIndexData().isUploaded());
+	}
+	CPPUNIT_ASSERT(meshC->_getVertexData().isUploaded());
+
+	// destroyed meshes are removed; the remaining meshes return to the default strategy when the strategy is destroyed
+	meshB = nullptr;
+	checkUsage({meshA.get(), meshC.get()});
+	strategy.reset();
+	CPPUNIT_ASSERT(meshA->getDataStrategy() == MeshDataStrategy::getDefaultStrategy());
+	CPPUNIT_ASSERT(meshC->getDataStrategy() == MeshDataStrategy::getDefaultStrategy());
+}
+
+//! Return @c true if the local vertex and index data of @p meshA and @p meshB are equal.
+static bool haveEqualData(Mesh * meshA, Mesh * meshB) {
+	const MeshVertexData & verticesA = meshA->openVertexData();
+	const MeshVertexData & verticesB = meshB->openVertexData();
+	const MeshIndexData & indicesA = meshA->openIndexData();
+	const MeshIndexData & indicesB = meshB->openIndexData();
+	return verticesA.getVertexDescription() == verticesB.getVertexDescription()
+			&& verticesA.dataSize() == verticesB.dataSize() && std::equal(verticesA.data(), verticesA.data() + verticesA.dataSize(), verticesB.data())
+			&& indicesA.getIndexType() == indicesB.getIndexType()
+			&& indicesA.dataSize() == indicesB.dataSize() && std::equal(indicesA.rawData(), indicesA.rawData() + indicesA.dataSize(), indicesB.rawData());
+}
+
+void MeshUtilsTest::testAsyncLoadingMeshDataStrategy() {
+	const uint32_t fileCount = 6;
+	std::vector<Util::FileName> fileNames;
+	for(uint32_t i = 0; i < fileCount; ++i) {
+		Util::Reference<Mesh> mesh = createWavyGridMesh(4 + i);
+		fileNames.emplace_back("MeshUtilsTest_async" + std::to_string(i) + ".mmf");
+		CPPUNIT_ASSERT(Serialization::saveMesh(mesh.get(), fileNames.back()));
+	}
+
+	std::unique_ptr<AsyncLoadingMeshDataStrategy> strategy(new AsyncLoadingMeshDataStrategy(3));
+	std::vector<Util::Reference<Mesh>> meshes;
+	for(const auto & fileName : fileNames) {
+		meshes.emplace_back(new Mesh);
+		meshes.back()->setFileName(fileName);
+		meshes.back()->setDataStrategy(strategy.get());
+		strategy->requestLoading(meshes.back().get());
+	}
+	// a file that does not exist is not counted as pending once its loading has failed
+	Util::Reference<Mesh> missingMesh = new Mesh;
+	missingMesh->setFileName(Util::FileName("MeshUtilsTest_async_missing.mmf"));
+	missingMesh->setDataStrategy(strategy.get());
+	strategy->requestLoading(missingMesh.get());
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(fileCount + 1), strategy->getPendingCount());
+	missingMesh->openVertexData();
+	CPPUNIT_ASSERT(missingMesh->empty());
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(fileCount), strategy->getPendingCount());
+
+	// the uploads are limited per frame; at least one mesh is uploaded per frame
+	strategy->setUploadBudget(1, 1000.0);
+	uint32_t frameCount = 0;
+	for(bool allUploaded = false; !allUploaded; ++frameCount) {
+		CPPUNIT_ASSERT(frameCount < 10000);
+		strategy->beginFrame();
+		uint32_t uploadedCount = 0;
+		allUploaded = true;
+		for(const auto & mesh : meshes) {
+			const bool wasUploaded = mesh->_getVertexData().isUploaded();
+			strategy->prepare(mesh.get());
+			if(!wasUploaded && mesh->_getVertexData().isUploaded())
+				++uploadedCount;
+			allUploaded = allUploaded && mesh->_getVertexData().isUploaded() && mesh->_getIndexData().isUploaded();
+		}
+		CPPUNIT_ASSERT(uploadedCount <= 1);
+	}
+	CPPUNIT_ASSERT(frameCount >= fileCount);
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(0), strategy->getPendingCount());
+
+	// the local data is released after the upload; accessing it gives the data of the file
+	for(uint32_t i = 0; i < fileCount; ++i) {
+		CPPUNIT_ASSERT(!meshes[i]->_getVertexData().hasLocalData());
+		Util::Reference<Mesh> expected = Serialization::loadMesh(fileNames[i]);
+		CPPUNIT_ASSERT(haveEqualData(meshes[i].get(), expected.get()));
+	}
+
+	// destroying a mesh cancels its loading; the strategy can be destroyed before its meshes
+	Util::Reference<Mesh> pendingMesh = new Mesh;
+	pendingMesh->setFileName(fileNames.front());
+	pendingMesh->setDataStrategy(strategy.get());
+	strategy->requestLoading(pendingMesh.get());
+	pendingMesh = nullptr;
+	strategy.reset();
+	for(const auto & mesh : meshes)
+		CPPUNIT_ASSERT(mesh->getDataStrategy() == MeshDataStrategy::getDefaultStrategy());
+	CPPUNIT_ASSERT(missingMesh->getDataStrategy() == MeshDataStrategy::getDefaultStrategy());
+	for(const auto & fileName : fileNames)
+		std::remove(fileName.getPath().c_str());
+}
+
+void MeshUtilsTest::testMeshAnalysis() {
+	{ // closed convex mesh without defects
+		Util::Reference<Mesh> cube = MeshUtils::PlatonicSolids::createCube();
+		const MeshUtils::MeshAnalysis analysis = MeshUtils::analyzeMesh(cube.get(), {4, 16}, 64);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(8), analysis.vertexCount);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(36), analysis.indexCount);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(12), analysis.triangleCount);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(0), analysis.invalidPrimitives);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(0), analysis.unusedVertices);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(0), analysis.duplicateVertices);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(0), analysis.degenerateTriangles);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(0), analysis.zeroAreaTriangles);
+
+		// the cache statistics are the ones of the whole mesh
+		CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(2), analysis.vertexCache.size());
+		for(const auto & cache : analysis.vertexCache) {
+			const MeshUtils::VertexCacheStatistics expected = MeshUtils::calculateVertexCacheStatistics(cube.get(), cache.first);
+			CPPUNIT_ASSERT_EQUAL(expected.transformedVertices, cache.second.transformedVertices);
+			CPPUNIT_ASSERT_EQUAL(expected.acmr, cache.second.acmr);
+			CPPUNIT_ASSERT_EQUAL(expected.atvr, cache.second.atvr);
+		}
+
+		// 8 vertices with position and normal fit into three cache lines that are fetched once
+		const std::size_t vertexSize = cube->getVertexDescription().getVertexSize();
+		CPPUNIT_ASSERT_EQUAL(8 * vertexSize, analysis.vertexBytes);
+		CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(36 * cube->_getIndexData().getIndexSize()), analysis.indexBytes);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(192), analysis.fetchedVertexBytes);
+		CPPUNIT_ASSERT_EQUAL(static_cast<float>(192) / (8 * vertexSize), analysis.vertexFetchOverfetch);
+		CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(2), analysis.attributeCosts.size());
+		CPPUNIT_ASSERT_EQUAL(analysis.vertexBytes, analysis.attributeCosts[0].totalBytes + analysis.attributeCosts[1].totalBytes);
+
+		// the front faces of a convex mesh do not overlap
+		CPPUNIT_ASSERT(analysis.coveredPixels > 0);
+		CPPUNIT_ASSERT(analysis.overdraw >= 1.0f && analysis.overdraw < 1.05f);
+	}
+	{ // mesh with one defect of each kind
+		VertexDescription vd;
+		vd.appendPosition3D();
+		Util::Reference<Mesh> mesh = new Mesh(vd, 6, 15);
+		Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION));
+		posAcc->setPosition(0, Geometry::Vec3(0.0f, 0.0f, 0.0f));
+		posAcc->setPosition(1, Geometry::Vec3(1.0f, 0.0f, 0.0f));
+		posAcc->setPosition(2, Geometry::Vec3(0.0f, 1.0f, 0.0f));
+		posAcc->setPosition(3, Geometry::Vec3(1.0f, 0.0f, 0.0f)); // duplicate of vertex 1
+		posAcc->setPosition(4, Geometry::Vec3(2.0f, 0.0f, 0.0f)); // on the line through vertices 0 and 1
+		posAcc->setPosition(5, Geometry::Vec3(5.0f, 5.0f, 5.0f)); // unused
+		const uint32_t indices[15] = {
+			0, 1, 2,
+			0, 3, 2,
+			0, 0, 1, // degenerate
+			0, 1, 4, // zero area
+			0, 1, 9 // invalid
+		};
+		MeshIndexData & indexData = mesh->openIndexData();
+		for(uint32_t i = 0; i < 15; ++i)
+			indexData[i] = indices[i];
+		indexData.updateIndexRange();
+		mesh->openVertexData().updateBoundingBox();
+
+		const MeshUtils::MeshAnalysis analysis = MeshUtils::analyzeMesh(mesh.get(), {8}, 0);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(4), analysis.triangleCount);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(1), analysis.invalidPrimitives);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(1), analysis.unusedVertices);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(1), analysis.duplicateVertices);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(1), analysis.degenerateTriangles);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(1), analysis.zeroAreaTriangles);
+		// the invalid triangle is not simulated
+		const std::vector<uint32_t> validIndices(indices, indices + 12);
+		const MeshUtils::VertexCacheStatistics expected = MeshUtils::calculateVertexCacheStatistics(validIndices, 6, 8);
+		CPPUNIT_ASSERT_EQUAL(expected.transformedVertices, analysis.vertexCache.front().second.transformedVertices);
+		CPPUNIT_ASSERT_EQUAL(0.0f, analysis.overdraw);
+	}
+}
+
+void MeshUtilsTest::testMeshlets() {
+	Util::Reference<Mesh> mesh = createWavyGridMesh(24);
+	const uint32_t triangleCount = mesh->getPrimitiveCount();
+	// the triangles with the smallest index first, to compare them independently of their order
+	auto getTriangles = [](Mesh * m) {
+		const MeshIndexData & indices = m->_getIndexData();
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for(uint32_t i = 0; i + 2 < indices.getIndexCount(); i += 3) {
+			std::array<uint32_t, 3> triangle = {{indices[i], indices[i + 1], indices[i + 2]}};
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+	const std::vector<std::array<uint32_t, 3>> originalTriangles = getTriangles(mesh.get());
+
+	const uint32_t maxVertices = 32;
+	const uint32_t maxTriangles = 40;
+	const MeshUtils::MeshletList list = MeshUtils::createMeshlets(mesh.get(), maxVertices, maxTriangles);
+	// the triangles have only been reordered
+	CPPUNIT_ASSERT(getTriangles(mesh.get()) == originalTriangles);
+	CPPUNIT_ASSERT(list.meshlets.size() >= triangleCount / maxTriangles);
+
+	std::vector<Geometry::Vec3> positions(mesh->getVertexCount());
+	{
+		Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(mesh->_getVertexData(), VertexAttributeIds::POSITION));
+		posAcc->getPositions(0, mesh->getVertexCount(), positions.data());
+	}
+	const MeshIndexData & indices = mesh->_getIndexData();
+	std::mt19937 engine(7);
+	std::uniform_real_distribution<float> coordinateDist(-40.0f, 40.0f);
+	std::vector<Geometry::Vec3> viewers;
+	for(uint32_t i = 0; i < 64; ++i)
+		viewers.emplace_back(coordinateDist(engine), coordinateDist(engine), coordinateDist(engine));
+
+	uint32_t firstIndex = 0;
+	uint32_t culledCount = 0;
+	for(const auto & meshlet : list.meshlets) {
+		// the meshlets are stored contiguously and within the limits
+		CPPUNIT_ASSERT_EQUAL(firstIndex, meshlet.firstIndex);
+		firstIndex += 3 * meshlet.triangleCount;
+		CPPUNIT_ASSERT(meshlet.vertexCount >= 3 && meshlet.vertexCount <= maxVertices);
+		CPPUNIT_ASSERT(meshlet.triangleCount >= 1 && meshlet.triangleCount <= maxTriangles);
+		const std::set<uint32_t> meshletVertices(list.vertices.begin() + meshlet.vertexOffset, list.vertices.begin() + meshlet.vertexOffset + meshlet.vertexCount);
+		CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(meshlet.vertexCount), meshletVertices.size());
+
+		// the local indices reference the triangles of the index data
+		for(uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+			for(uint32_t corner = 0; corner < 3; ++corner) {
+				const uint8_t localIndex = list.localIndices[(meshlet.triangleOffset + t) * 3 + corner];
+				CPPUNIT_ASSERT(localIndex < meshlet.vertexCount);
+				CPPUNIT_ASSERT_EQUAL(indices[meshlet.firstIndex + 3 * t + corner], list.vertices[meshlet.vertexOffset + localIndex]);
+			}
+		}
+
+		// the bounding sphere contains the vertices
+		const float radius = meshlet.boundingSphere.getRadius();
+		for(const auto & vertex : meshletVertices)
+			CPPUNIT_ASSERT(meshlet.boundingSphere.getCenter().distance(positions[vertex]) <= radius * 1.0001f + 1.0e-5f);
+
+		// a meshlet is only culled if all of its triangles are backfacing
+		for(const auto & viewer : viewers) {
+			if(meshlet.coneCutoff > 1.0f || (meshlet.coneApex - viewer).getNormalized().dot(meshlet.coneAxis) < meshlet.coneCutoff)
+				continue;
+			++culledCount;
+			for(uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+				const Geometry::Vec3 & a = positions[indices[meshlet.firstIndex + 3 * t]];
+				const Geometry::Vec3 & b = positions[indices[meshlet.firstIndex + 3 * t + 1]];
+				const Geometry::Vec3 & c = positions[indices[meshlet.firstIndex + 3 * t + 2]];
+				const Geometry::Vec3 normal = (b - a).cross(c - a).getNormalized();
+				CPPUNIT_ASSERT(normal.dot(viewer - a) <= 1.0e-4f);
+			}
+		}
+	}
+	CPPUNIT_ASSERT_EQUAL(3 * triangleCount, firstIndex);
+	CPPUNIT_ASSERT(culledCount > 0);
+
+	CPPUNIT_ASSERT_THROW(MeshUtils::createMeshlets(mesh.get(), 257, maxTriangles), std::invalid_argument);
+	CPPUNIT_ASSERT_THROW(MeshUtils::createMeshlets(mesh.get(), maxVertices, 0), std::invalid_argument);
+}
+
+//! Return the surface area of the triangles of @p mesh.
+static double getSurfaceArea(Mesh * mesh) {
+	const std::vector<Geometry::Vec3> positions = getTrianglePositions(mesh, 0, mesh->getIndexCount());
+	double area = 0.0;
+	for(std::size_t i = 0; i + 2 < positions.size(); i += 3)
+		area += 0.5 * (positions[i + 1] - positions[i]).cross(positions[i + 2] - positions[i]).length();
+	return area;
+}
+
+//! Return the indices of the triangles of @p mesh whose centers fulfill @p predicate.
+template<typename predicate_t>
+static std::set<uint32_t> selectTriangles(Mesh * mesh, predicate_t predicate) {
+	const std::vector<Geometry::Vec3> positions = getTrianglePositions(mesh, 0, mesh->getIndexCount());
+	std::set<uint32_t> selected;
+	for(uint32_t t = 0; 3 * t + 2 < positions.size(); ++t) {
+		if(predicate((positions[3 * t] + positions[3 * t + 1] + positions[3 * t + 2]) / 3.0f))
+			selected.insert(t);
+	}
+	return selected;
+}
+
+void MeshUtilsTest::testSplitCutAndExtrude() {
+	const uint32_t size = 4;
+	const double gridArea = size * size;
+	{ // splitting keeps the surface and bounds the edge lengths
+		Util::Reference<Mesh> mesh = createGridMesh(size);
+		const Geometry::Box box = mesh->getBoundingBox();
+		const float maxSideLength = 0.6f;
+		MeshUtils::splitLargeTriangles(mesh.get(), maxSideLength);
+		CPPUNIT_ASSERT(mesh->getPrimitiveCount() > 2 * size * size);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(gridArea, getSurfaceArea(mesh.get()), 1.0e-4);
+		const std::vector<Geometry::Vec3> positions = getTrianglePositions(mesh.get(), 0, mesh->getIndexCount());
+		for(std::size_t i = 0; i < positions.size(); i += 3) {
+			for(std::size_t corner = 0; corner < 3; ++corner) {
+				CPPUNIT_ASSERT(positions[i + corner].distance(positions[i + (corner + 1) % 3]) <= maxSideLength);
+				CPPUNIT_ASSERT(box.contains(positions[i + corner]));
+			}
+		}
+
+		// a mesh without triangles is not changed
+		VertexDescription vd;
+		vd.appendPosition3D();
+		Util::Reference<Mesh> emptyMesh = new Mesh(vd, 0, 0);
+		MeshUtils::splitLargeTriangles(emptyMesh.get(), maxSideLength);
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(0), emptyMesh->getIndexCount());
+	}
+	{ // cutting keeps the surface; the triangles sharing a cut edge share the new vertex
+		const Geometry::Plane plane(Geometry::Vec3(1.5f, 0.0f, 0.0f), Geometry::Vec3(1.0f, 0.0f, 0.0f));
+		Util::Reference<Mesh> mesh = createGridMesh(size);
+		const uint32_t vertexCount = mesh->getVertexCount();
+		MeshUtils::cutMesh(mesh.get(), plane);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(gridArea, getSurfaceArea(mesh.get()), 1.0e-4);
+		// each row has two cut horizontal edges and one cut diagonal
+		CPPUNIT_ASSERT_EQUAL(vertexCount + 2 * size + 1, mesh->getVertexCount());
+		const std::vector<Geometry::Vec3> positions = getTrianglePositions(mesh.get(), 0, mesh->getIndexCount());
+		for(std::size_t i = 0; i < positions.size(); i += 3) {
+			const float pa = plane.planeTest(positions[i]);
+			const float pb = plane.planeTest(positions[i + 1]);
+			const float pc = plane.planeTest(positions[i + 2]);
+			CPPUNIT_ASSERT((pa >= -1.0e-5f && pb >= -1.0e-5f && pc >= -1.0e-5f) || (pa <= 1.0e-5f && pb <= 1.0e-5f && pc <= 1.0e-5f));
+		}
+
+		// only the selected triangles of the lowest row are cut
+		Util::Reference<Mesh> partialMesh = createGridMesh(size);
+		const std::set<uint32_t> lowestRow = selectTriangles(partialMesh.get(), [](const Geometry::Vec3 & center) { return center.y() < 1.0f; });
+		CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(2 * size), lowestRow.size());
+		MeshUtils::cutMesh(partialMesh.get(), plane, lowestRow);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(gridArea, getSurfaceArea(partialMesh.get()), 1.0e-4);
+		CPPUNIT_ASSERT_EQUAL(vertexCount + 3, partialMesh->getVertexCount());
+		// the two triangles crossing the plane are split into three triangles each
+		CPPUNIT_ASSERT_EQUAL(2 * size * size + 4, partialMesh->getPrimitiveCount());
+	}
+	{ // extruding a 2x2 block of quads adds walls at its eight border edges
+		const Geometry::Vec3 dir(0.0f, 0.0f, 2.0f);
+		Util::Reference<Mesh> mesh = createGridMesh(size);
+		const auto isInBlock = [](const Geometry::Vec3 & center) { return center.x() > 1.0f && center.x() < 3.0f && center.y() > 1.0f && center.y() < 3.0f; };
+		const std::set<uint32_t> block = selectTriangles(mesh.get(), isInBlock);
+		CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(8), block.size());
+		MeshUtils::extrudeTriangles(mesh.get(), dir, block);
+		CPPUNIT_ASSERT_EQUAL(2 * size * size + 8 * 2, mesh->getPrimitiveCount());
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(gridArea + 8 * 2.0, getSurfaceArea(mesh.get()), 1.0e-4);
+		const std::vector<Geometry::Vec3> positions = getTrianglePositions(mesh.get(), 0, mesh->getIndexCount());
+		for(const auto t : block) {
+			for(uint32_t corner = 0; corner < 3; ++corner)
+				CPPUNIT_ASSERT_EQUAL(2.0f, positions[3 * t + corner].z());
+		}
+
+		// triangles with separate vertices at the same positions are adjacent as well
+		Util::Reference<Mesh> separateMesh = createMesh({Geometry::Vec3(0.0f, 0.0f, 0.0f), Geometry::Vec3(1.0f, 0.0f, 0.0f), Geometry::Vec3(1.0f, 1.0f, 0.0f),
+														 Geometry::Vec3(0.0f, 0.0f, 0.0f), Geometry::Vec3(1.0f, 1.0f, 0.0f), Geometry::Vec3(0.0f, 1.0f, 0.0f)});
+		MeshUtils::extrudeTriangles(separateMesh.get(), dir, {0, 1, 7});
+		CPPUNIT_ASSERT_EQUAL(static_cast<uint32_t>(2 + 4 * 2), separateMesh->getPrimitiveCount());
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0 + 4 * 2.0, getSurfaceArea(separateMesh.get()), 1.0e-4);
+	}
+}
@@ -0,0 +1,52 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_MESHUTILSTEST_H
+#define RENDERING_MESHUTILSTEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class MeshUtilsTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(MeshUtilsTest);
+	CPPUNIT_TEST(testCombineMeshes);
+	CPPUNIT_TEST(testEliminateDuplicateVertices);
+	CPPUNIT_TEST(testMergeCloseVertices);
+	CPPUNIT_TEST(testEliminateTriangles);
+	CPPUNIT_TEST(testVertexCacheStatistics);
+	CPPUNIT_TEST(testSimplifyMeshLockedVertices);
+	CPPUNIT_TEST(testSimplifyMeshOutOfCore);
+	CPPUNIT_TEST(testConnectivityAccessor);
+	CPPUNIT_TEST(testTangentSpace);
+	CPPUNIT_TEST(testMeshLOD);
+	CPPUNIT_TEST(testBudgetMeshDataStrategy);
+	CPPUNIT_TEST(testAsyncLoadingMeshDataStrategy);
+	CPPUNIT_TEST(testMeshAnalysis);
+	CPPUNIT_TEST(testMeshlets);
+	CPPUNIT_TEST(testSplitCutAndExtrude);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void testCombineMeshes();
+		void testEliminateDuplicateVertices();
+		void testMergeCloseVertices();
+		void testEliminateTriangles();
+		void testVertexCacheStatistics();
+		void testSimplifyMeshLockedVertices();
+		void testSimplifyMeshOutOfCore();
+		void testConnectivityAccessor();
+		void testTangentSpace();
+		void testMeshLOD();
+		void testBudgetMeshDataStrategy();
+		void testAsyncLoadingMeshDataStrategy();
+		void testMeshAnalysis();
+		void testMeshlets();
+		void testSplitCutAndExtrude();
+};
+
+#endif /* RENDERING_MESHUTILSTEST_H */
@@ -0,0 +1,269 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "TriangleBVHTest.h"
+#include <cppunit/TestAssert.h>
+#include <Geometry/Box.h>
+#include <Geometry/Frustum.h>
+#include <Geometry/Line.h>
+#include <Geometry/Vec3.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/MeshIndexData.h>
+#include <Rendering/Mesh/MeshVertexData.h>
+#include <Rendering/Mesh/VertexAttributeAccessors.h>
+#include <Rendering/Mesh/VertexAttributeIds.h>
+#include <Rendering/Mesh/VertexDescription.h>
+#include <Rendering/MeshUtils/TriangleBVH.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+CPPUNIT_TEST_SUITE_REGISTRATION(TriangleBVHTest);
+
+using namespace Rendering;
+using MeshUtils::TriangleBVH;
+
+//! Create a mesh of @p triangleCount separate, randomly placed and oriented triangles.
+static Mesh * createTriangleSoup(uint32_t triangleCount, std::mt19937 & engine) {
+	std::uniform_real_distribution<float> centerDistribution(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> offsetDistribution(-1.0f, 1.0f);
+	VertexDescription vd;
+	vd.appendPosition3D();
+	Mesh * mesh = new Mesh(vd, triangleCount * 3, triangleCount * 3);
+	Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION));
+	MeshIndexData & indices = mesh->openIndexData();
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		const Geometry::Vec3 center(centerDistribution(engine), centerDistribution(engine), centerDistribution(engine));
+		for(uint32_t corner = 0; corner < 3; ++corner) {
+			// the triangles reference their vertices in reverse order
+			const uint32_t vertex = (triangleCount - 1 - t) * 3 + corner;
+			posAcc->setPosition(vertex, center + Geometry::Vec3(offsetDistribution(engine), offsetDistribution(engine), offsetDistribution(engine)));
+			indices[t * 3 + corner] = vertex;
+		}
+	}
+	indices.updateIndexRange();
+	mesh->openVertexData().updateBoundingBox();
+	return mesh;
+}
+
+//! Return the three positions of every triangle of @p mesh.
+static std::vector<Geometry::Vec3> getTrianglePositions(Mesh * mesh) {
+	const MeshVertexData & vertices = mesh->openVertexData();
+	const MeshIndexData & indices = mesh->openIndexData();
+	Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(vertices, VertexAttributeIds::POSITION));
+	std::vector<Geometry::Vec3> result;
+	for(uint32_t i = 0; i < indices.getIndexCount(); ++i)
+		result.push_back(posAcc->getPosition(indices[i]));
+	return result;
+}
+
+//! Möller-Trumbore test of one triangle; sets @p t if the ray hits the triangle with a parameter in [0, maxT].
+static bool intersectRay(const Geometry::Ray3 & ray, const Geometry::Vec3 * triangle, float maxT, float & t) {
+	const Geometry::Vec3 & origin = ray.getOrigin();
+	const Geometry::Vec3 & direction = ray.getDirection();
+	const Geometry::Vec3 e1 = triangle[1] - triangle[0];
+	const Geometry::Vec3 e2 = triangle[2] - triangle[0];
+	const Geometry::Vec3 p = direction.cross(e2);
+	const float det = e1.dot(p);
+	if(det == 0.0f)
+		return false;
+	const float inverseDet = 1.0f / det;
+	const Geometry::Vec3 s = origin - triangle[0];
+	const float u = s.dot(p) * inverseDet;
+	if(u < 0.0f || u > 1.0f)
+		return false;
+	const Geometry::Vec3 q = s.cross(e1);
+	const float v = direction.dot(q) * inverseDet;
+	if(v < 0.0f || u + v > 1.0f)
+		return false;
+	t = e2.dot(q) * inverseDet;
+	return t >= 0.0f && t <= maxT;
+}
+
+//! Index of the closest triangle hit by @p ray by testing all triangles, or TriangleBVH::NO_HIT.
+static uint32_t getClosestHit(const std::vector<Geometry::Vec3> & triangles, const Geometry::Ray3 & ray, float maxT, float & closestT) {
+	uint32_t closest = TriangleBVH::NO_HIT;
+	for(uint32_t i = 0; i < triangles.size() / 3; ++i) {
+		float t;
+		if(intersectRay(ray, triangles.data() + i * 3, maxT, t)) {
+			closest = i;
+			maxT = t;
+			closestT = t;
+		}
+	}
+	return closest;
+}
+
+//! Separating axis test of a triangle and an axis-aligned box.
+static bool intersectBox(const Geometry::Vec3 * triangle, const Geometry::Box & box) {
+	const Geometry::Vec3 center = box.getCenter();
+	const Geometry::Vec3 halfSize(box.getExtentX() * 0.5f, box.getExtentY() * 0.5f, box.getExtentZ() * 0.5f);
+	const Geometry::Vec3 v[3] = {triangle[0] - center, triangle[1] - center, triangle[2] - center};
+	const Geometry::Vec3 edges[3] = {v[1] - v[0], v[2] - v[1], v[0] - v[2]};
+	std::vector<Geometry::Vec3> axes = {Geometry::Vec3(1.0f, 0.0f, 0.0f), Geometry::Vec3(0.0f, 1.0f, 0.0f), Geometry::Vec3(0.0f, 0.0f, 1.0f),
+										edges[0].cross(edges[1])};
+	for(uint32_t a = 0; a < 3; ++a) {
+		for(const auto & edge : edges)
+			axes.push_back(axes[a].cross(edge));
+	}
+	for(const auto & axis : axes) {
+		const float p0 = v[0].dot(axis);
+		const float p1 = v[1].dot(axis);
+		const float p2 = v[2].dot(axis);
+		const float radius = halfSize.getX() * std::abs(axis.getX()) + halfSize.getY() * std::abs(axis.getY()) + halfSize.getZ() * std::abs(axis.getZ());
+		if(std::min(std::min(p0, p1), p2) > radius || std::max(std::max(p0, p1), p2) < -radius)
+			return false;
+	}
+	return true;
+}
+
+//! Bounding box of one triangle.
+static Geometry::Box getTriangleBox(const Geometry::Vec3 * triangle) {
+	Geometry::Box box;
+	box.invalidate();
+	for(uint32_t corner = 0; corner < 3; ++corner)
+		box.include(triangle[corner]);
+	return box;
+}
+
+//! Compare all queries of @p bvh with the results of testing every triangle.
+static void checkQueries(const TriangleBVH & bvh, const std::vector<Geometry::Vec3> & triangles, std::mt19937 & engine) {
+	const uint32_t triangleCount = static_cast<uint32_t>(triangles.size() / 3);
+	CPPUNIT_ASSERT_EQUAL(triangleCount, bvh.getTriangleCount());
+
+	Geometry::Box bounds;
+	bounds.invalidate();
+	for(const auto & position : triangles)
+		bounds.include(position);
+	CPPUNIT_ASSERT(bvh.getBounds() == bounds);
+
+	std::uniform_real_distribution<float> positionDistribution(-15.0f, 15.0f);
+	auto randomPosition = [&]() {
+		return Geometry::Vec3(positionDistribution(engine), positionDistribution(engine), positionDistribution(engine));
+	};
+
+	// rays; a number that is not a multiple of the packet size, including axis-parallel rays
+	std::vector<Geometry::Ray3> rays;
+	for(uint32_t i = 0; i < 401; ++i) {
+		const Geometry::Vec3 origin = randomPosition();
+		rays.emplace_back(origin, randomPosition() - origin);
+	}
+	for(uint32_t i = 0; i < 6; ++i) {
+		Geometry::Vec3 direction(0.0f, 0.0f, 0.0f);
+		direction[i % 3] = i < 3 ? 1.0f : -1.0f;
+		rays.emplace_back(randomPosition(), direction);
+	}
+	uint32_t hitCount = 0;
+	for(const float maxT : {std::numeric_limits<float>::infinity(), 0.5f}) {
+		std::vector<TriangleBVH::RayHit> packetHits;
+		std::vector<bool> packetAnyHits;
+		bvh.getClosestHits(rays, packetHits, maxT, true);
+		bvh.getAnyHits(rays, packetAnyHits, maxT, true);
+		CPPUNIT_ASSERT_EQUAL(rays.size(), packetHits.size());
+		CPPUNIT_ASSERT_EQUAL(rays.size(), packetAnyHits.size());
+		for(std::size_t r = 0; r < rays.size(); ++r) {
+			float expectedT = 0.0f;
+			const uint32_t expected = getClosestHit(triangles, rays[r], maxT, expectedT);
+			TriangleBVH::RayHit hit;
+			hit.triangleIndex = TriangleBVH::NO_HIT;
+			CPPUNIT_ASSERT_EQUAL(expected != TriangleBVH::NO_HIT, bvh.getClosestHit(rays[r], hit, maxT));
+			CPPUNIT_ASSERT_EQUAL(expected, hit.triangleIndex);
+			CPPUNIT_ASSERT_EQUAL(expected, packetHits[r].triangleIndex);
+			CPPUNIT_ASSERT_EQUAL(expected != TriangleBVH::NO_HIT, bvh.isHit(rays[r], maxT));
+			CPPUNIT_ASSERT_EQUAL(expected != TriangleBVH::NO_HIT, static_cast<bool>(packetAnyHits[r]));
+			if(expected != TriangleBVH::NO_HIT) {
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(expectedT, hit.t, 1.0e-5f);
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(expectedT, packetHits[r].t, 1.0e-5f);
+				++hitCount;
+			}
+		}
+	}
+	CPPUNIT_ASSERT(hitCount > 0);
+
+	// boxes of different sizes
+	std::uniform_real_distribution<float> sizeDistribution(0.0f, 8.0f);
+	for(uint32_t i = 0; i < 30; ++i) {
+		const Geometry::Vec3 min = randomPosition();
+		const Geometry::Box box(min, min + Geometry::Vec3(sizeDistribution(engine), sizeDistribution(engine), sizeDistribution(engine)));
+		std::vector<uint32_t> expected;
+		for(uint32_t t = 0; t < triangleCount; ++t) {
+			if(intersectBox(triangles.data() + t * 3, box))
+				expected.push_back(t);
+		}
+		std::vector<uint32_t> result = bvh.getTrianglesIntersectingBox(box);
+		std::sort(result.begin(), result.end());
+		CPPUNIT_ASSERT(expected == result);
+	}
+
+	// frustum: the bounding boxes of the triangles are tested
+	const Geometry::Frustum frustum;
+	std::vector<uint32_t> expected;
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		if(frustum.isBoxInFrustum(getTriangleBox(triangles.data() + t * 3)) != Geometry::Frustum::OUTSIDE)
+			expected.push_back(t);
+	}
+	std::vector<uint32_t> result = bvh.getTrianglesIntersectingFrustum(frustum);
+	std::sort(result.begin(), result.end());
+	CPPUNIT_ASSERT(expected == result);
+}
+
+void TriangleBVHTest::testQueries() {
+	std::mt19937 engine(42);
+	Util::Reference<Mesh> mesh = createTriangleSoup(3000, engine);
+	const std::vector<Geometry::Vec3> triangles = getTrianglePositions(mesh.get());
+	for(const bool parallel : {false, true}) {
+		Util::Reference<TriangleBVH> bvh = TriangleBVH::create(mesh.get(), parallel);
+		CPPUNIT_ASSERT(bvh->getNodeCount() > 1);
+		checkQueries(*bvh.get(), triangles, engine);
+	}
+
+	{ // an empty mesh
+		VertexDescription vd;
+		vd.appendPosition3D();
+		Util::Reference<Mesh> emptyMesh = new Mesh(vd, 0, 0);
+		Util::Reference<TriangleBVH> bvh = TriangleBVH::create(emptyMesh.get());
+		TriangleBVH::RayHit hit;
+		CPPUNIT_ASSERT(!bvh->getClosestHit(Geometry::Ray3(Geometry::Vec3(0.0f, 0.0f, 0.0f), Geometry::Vec3(0.0f, 0.0f, 1.0f)), hit));
+		CPPUNIT_ASSERT(bvh->getTrianglesIntersectingBox(Geometry::Box(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f)).empty());
+	}
+
+	{ // an index referencing a non-existing vertex
+		Util::Reference<Mesh> invalidMesh = createTriangleSoup(2, engine);
+		invalidMesh->openIndexData()[4] = 6;
+		CPPUNIT_ASSERT_THROW(TriangleBVH::create(invalidMesh.get()), std::invalid_argument);
+	}
+}
+
+void TriangleBVHTest::testRefit() {
+	std::mt19937 engine(7);
+	Util::Reference<Mesh> mesh = createTriangleSoup(2000, engine);
+	Util::Reference<TriangleBVH> bvh = TriangleBVH::create(mesh.get(), true);
+	const uint32_t nodeCount = bvh->getNodeCount();
+
+	// move, scale and deform the triangles without changing the indices
+	{
+		std::uniform_real_distribution<float> jitterDistribution(-2.0f, 2.0f);
+		Util::Reference<PositionAttributeAccessor> posAcc(PositionAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::POSITION));
+		for(uint32_t v = 0; v < mesh->getVertexCount(); ++v) {
+			const Geometry::Vec3 jitter(jitterDistribution(engine), jitterDistribution(engine), jitterDistribution(engine));
+			posAcc->setPosition(v, posAcc->getPosition(v) * 0.75f + Geometry::Vec3(3.0f, -2.0f, 1.0f) + jitter);
+		}
+		mesh->openVertexData().updateBoundingBox();
+	}
+	bvh->refit(mesh.get());
+	CPPUNIT_ASSERT_EQUAL(nodeCount, bvh->getNodeCount());
+	checkQueries(*bvh.get(), getTrianglePositions(mesh.get()), engine);
+
+	// the number of triangles must not change
+	Util::Reference<Mesh> otherMesh = createTriangleSoup(1999, engine);
+	CPPUNIT_ASSERT_THROW(bvh->refit(otherMesh.get()), std::invalid_argument);
+}
@@ -0,0 +1,26 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_TRIANGLEBVHTEST_H
+#define RENDERING_TRIANGLEBVHTEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class TriangleBVHTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(TriangleBVHTest);
+	CPPUNIT_TEST(testQueries);
+	CPPUNIT_TEST(testRefit);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void testQueries();
+		void testRefit();
+};
+
+#endif /* RENDERING_TRIANGLEBVHTEST_H */
@@ -0,0 +1,103 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "UploadSchedulerTest.h"
+#include <cppunit/TestAssert.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/UploadScheduler.h>
+#include <Util/References.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+CPPUNIT_TEST_SUITE_REGISTRATION(UploadSchedulerTest);
+
+using namespace Rendering;
+
+void UploadSchedulerTest::setUp() {
+	UploadScheduler & scheduler = UploadScheduler::getInstance();
+	scheduler.setBytesPerFrame(100);
+	scheduler.beginFrame();
+}
+
+void UploadSchedulerTest::tearDown() {
+	UploadScheduler & scheduler = UploadScheduler::getInstance();
+	scheduler.setBytesPerFrame(std::numeric_limits<std::size_t>::max());
+	scheduler.beginFrame();
+	scheduler.beginFrame();
+}
+
+void UploadSchedulerTest::testQueue() {
+	UploadScheduler & scheduler = UploadScheduler::getInstance();
+	const int a = 0, b = 0, c = 0;
+
+	// the first upload of a frame is always allowed
+	CPPUNIT_ASSERT(scheduler.requestUpload(&a, 80));
+	CPPUNIT_ASSERT(!scheduler.requestUpload(&b, 30));
+	CPPUNIT_ASSERT(!scheduler.requestUpload(&c, 80));
+	CPPUNIT_ASSERT(scheduler.isPending(&b) && scheduler.isPending(&c));
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(2), scheduler.getQueueDepth());
+
+	// the more important upload is granted first; the other one has to be requested again
+	scheduler.setImportance(&c, 1.0f);
+	scheduler.beginFrame();
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(80), scheduler.getLastFrameUploadedBytes());
+	CPPUNIT_ASSERT(scheduler.isPending(&c));
+	CPPUNIT_ASSERT(!scheduler.isPending(&b));
+
+	// a cancelled upload releases its reserved bytes
+	scheduler.cancelUpload(&c);
+	CPPUNIT_ASSERT(!scheduler.isPending(&c));
+	CPPUNIT_ASSERT(scheduler.requestUpload(&b, 30));
+	CPPUNIT_ASSERT(scheduler.requestUpload(&a, 60));
+	CPPUNIT_ASSERT(!scheduler.requestUpload(&c, 80));
+	scheduler.cancelUpload(&c);
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(0), scheduler.getQueueDepth());
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(90), scheduler.getUploadedBytes());
+}
+
+void UploadSchedulerTest::testDestroyMeshesInOtherThreads() {
+	UploadScheduler & scheduler = UploadScheduler::getInstance();
+	const uint32_t threadCount = 4;
+	const uint32_t meshCount = 4000;
+	const int other = 0;
+
+	std::vector<Util::Reference<Mesh>> meshes;
+	CPPUNIT_ASSERT(scheduler.requestUpload(&other, 100));
+	for(uint32_t i = 0; i < meshCount; ++i) {
+		meshes.emplace_back(new Mesh);
+		CPPUNIT_ASSERT(!scheduler.requestUpload(meshes.back().get(), 10));
+	}
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(meshCount), scheduler.getQueueDepth());
+
+	// The meshes are destroyed by other threads while the scheduler is used by this thread;
+	// destroying a mesh cancels its pending upload.
+	std::atomic<uint32_t> finishedThreads(0);
+	std::vector<std::thread> threads;
+	for(uint32_t t = 0; t < threadCount; ++t) {
+		threads.emplace_back([&meshes, &finishedThreads, t, threadCount, meshCount]() {
+			for(uint32_t i = t; i < meshCount; i += threadCount)
+				meshes[i] = nullptr;
+			++finishedThreads;
+		});
+	}
+	while(finishedThreads < threadCount) {
+		scheduler.setImportance(&other, 1.0f);
+		scheduler.requestUpload(&other, 20);
+		scheduler.isPending(&other);
+		scheduler.getQueueDepth();
+		scheduler.beginFrame();
+	}
+	for(auto & thread : threads)
+		thread.join();
+
+	scheduler.cancelUpload(&other);
+	CPPUNIT_ASSERT_EQUAL(static_cast<std::size_t>(0), scheduler.getQueueDepth());
+}
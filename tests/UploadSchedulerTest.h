@@ -0,0 +1,29 @@
+/*
+	This file is part of the Rendering library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef RENDERING_UPLOADSCHEDULERTEST_H
+#define RENDERING_UPLOADSCHEDULERTEST_H
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+class UploadSchedulerTest : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(UploadSchedulerTest);
+	CPPUNIT_TEST(testQueue);
+	CPPUNIT_TEST(testDestroyMeshesInOtherThreads);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void setUp() override;
+		void tearDown() override;
+
+		void testQueue();
+		void testDestroyMeshesInOtherThreads();
+};
+
+#endif /* RENDERING_UPLOADSCHEDULERTEST_H */